@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file Scanner of the processes of a node.
+ *
+ * Reads /proc directly, with a single read of /proc/<pid>/stat per process,
+ * instead of running ps and parsing its output. Each process is described by
+ * a fixed size, trivially copyable, ProcRecord.
+ */
+#pragma once
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pwd.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/unordered_map.hpp>
+#include <string>
+#include <vector>
+
+/** Description of one process. */
+struct ProcRecord
+{
+    uint64_t rss;      /**< Resident set size (in kB) */
+    uint64_t cpu;      /**< User plus system CPU time (in clock ticks) */
+    uint32_t pid;      /**< Process id */
+    uint32_t ppid;     /**< Parent process id */
+    uint32_t uid;      /**< Effective user id */
+    char state;        /**< State (R, S, D, Z, T, ...) */
+    char comm[16];     /**< Command name, null-terminated */
+};
+
+typedef std::vector<ProcRecord> ProcRecordVec;
+
+/**
+ * Parse the contents of /proc/<pid>/stat into a process record.
+ *
+ * @param line      Contents of the file, null-terminated.
+ * @param record    Record to be filled in, except for the user id.
+ * @return          Boolean flag indicating if the contents could be parsed.
+ */
+inline bool parseProcStat(const char* line, ProcRecord& record)
+{
+    // The command name is in parentheses and may itself contain spaces or
+    // parentheses, so the fields that follow are found from the last ')'.
+    const char* open = strchr(line, '(');
+    const char* close = strrchr(line, ')');
+    if ((open == NULL) || (close == NULL) || (close < open) ||
+        (close[1] != ' ')) {
+        return false;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.pid = strtoul(line, NULL, 10);
+    size_t length = close - open - 1;
+    if (length >= sizeof(record.comm)) {
+        length = sizeof(record.comm) - 1;
+    }
+    memcpy(record.comm, open + 1, length);
+
+    // Fields are numbered as in proc(5): state is 3, ppid 4, utime 14,
+    // stime 15 and rss 24.
+    const char* field = close + 2;
+    record.state = *field;
+    uint64_t utime = 0, stime = 0;
+    for (int number = 3; number <= 24; ++number) {
+        if (*field == '\0') {
+            return false;
+        }
+        switch (number) {
+        case 4: record.ppid = strtoul(field, NULL, 10); break;
+        case 14: utime = strtoull(field, NULL, 10); break;
+        case 15: stime = strtoull(field, NULL, 10); break;
+        case 24: record.rss = strtoull(field, NULL, 10); break;
+        default: break;
+        }
+        field = strchr(field, ' ');
+        if (field == NULL) {
+            if (number < 24) {
+                return false;
+            }
+            break;
+        }
+        ++field;
+    }
+    record.cpu = utime + stime;
+    record.rss *= sysconf(_SC_PAGESIZE) / 1024;
+    return true;
+}
+
+/**
+ * Scan the processes of this node.
+ *
+ * Processes that exit during the scan are skipped.
+ *
+ * @param records    Vector to which a record is appended for each process.
+ * @param root       Directory to be scanned (normally /proc).
+ * @return           Boolean flag indicating if the directory could be read.
+ */
+inline bool scanProcesses(ProcRecordVec& records, const char* root = "/proc")
+{
+    DIR* directory = opendir(root);
+    if (directory == NULL) {
+        return false;
+    }
+
+    int fd = dirfd(directory);
+    char path[NAME_MAX + 8];
+    char line[1024];
+
+    for (struct dirent* entry = readdir(directory);
+         entry != NULL; entry = readdir(directory)) {
+        if ((entry->d_name[0] < '0') || (entry->d_name[0] > '9') ||
+            (strlen(entry->d_name) > 32)) {
+            continue;
+        }
+
+        // The owner of /proc/<pid> is the effective user of the process
+        struct stat status;
+        if (fstatat(fd, entry->d_name, &status, 0) != 0) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/stat", entry->d_name);
+        int stat_fd = openat(fd, path, O_RDONLY);
+        if (stat_fd == -1) {
+            continue;
+        }
+        ssize_t n = read(stat_fd, line, sizeof(line) - 1);
+        close(stat_fd);
+        if (n <= 0) {
+            continue;
+        }
+        line[n] = '\0';
+
+        ProcRecord record;
+        if (parseProcStat(line, record)) {
+            record.uid = status.st_uid;
+            records.push_back(record);
+        }
+    }
+
+    closedir(directory);
+    return true;
+}
+
+/** Cache of the user names of the user ids found by a scan. */
+class ProcUserNames
+{
+
+public:
+
+    /** Get the name of the specified user id, or the id if it has none. */
+    const std::string& operator()(uint32_t uid)
+    {
+        boost::unordered_map<uint32_t, std::string>::iterator
+            i = names.find(uid);
+        if (i != names.end()) {
+            return i->second;
+        }
+
+        struct passwd entry;
+        struct passwd* result = NULL;
+        char buffer[4096];
+        std::string name;
+        if ((getpwuid_r(uid, &entry, buffer, sizeof(buffer), &result) == 0) &&
+            (result != NULL)) {
+            name = result->pw_name;
+        } else {
+            char id[16];
+            snprintf(id, sizeof(id), "%u", uid);
+            name = id;
+        }
+        return names.insert(std::make_pair(uid, name)).first->second;
+    }
+
+private:
+
+    boost::unordered_map<uint32_t, std::string> names;
+
+}; // class ProcUserNames
@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file Plugin that scans the processes of a backend node. */
+#pragma once
+
+#include <boost/bind.hpp>
+#include <string>
+#include <typeinfo>
+
+#include <KrellInstitute/CBTF/Component.hpp>
+#include <KrellInstitute/CBTF/Type.hpp>
+#include <KrellInstitute/CBTF/Version.hpp>
+
+#include "ProcScan.hpp"
+
+using namespace KrellInstitute::CBTF;
+
+/**
+ * Component that scans /proc when given the name of a command on its "in"
+ * input, and emits a ProcRecord for each process whose command name contains
+ * it (or for every process when the name is empty) on its "out" output.
+ */
+class __attribute__ ((visibility ("hidden"))) ProcScan :
+    public Component
+{
+
+public:
+    /** Factory function for this component type. */
+    static Component::Instance factoryFunction()
+    {
+        return Component::Instance(
+          reinterpret_cast<Component*>(new ProcScan())
+        );
+    }
+
+private:
+    /** Default constructor. */
+    ProcScan() :
+        Component(Type(typeid(ProcScan)), Version(1, 0, 0))
+    {
+        declareInput<std::string>(
+            "in", boost::bind(&ProcScan::inHandler, this, _1)
+            );
+        declareOutput<ProcRecordVec>("out");
+    }
+
+    /** Handler for the "in" input.*/
+    void inHandler(const std::string& in)
+    {
+        ProcRecordVec records;
+        scanProcesses(records);
+
+        if (!in.empty()) {
+            ProcRecordVec::iterator last = records.begin();
+            for (ProcRecordVec::const_iterator
+                     i = records.begin(); i != records.end(); ++i) {
+                if (strstr(i->comm, in.c_str()) != NULL) {
+                    *last++ = *i;
+                }
+            }
+            records.erase(last, records.end());
+        }
+
+        emitOutput<ProcRecordVec>("out", records);
+    }
+}; // end class ProcScan
@@ -0,0 +1,184 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Local benchmark of the /proc scanner used by psCmd and ProcScan against the
+ * ps command it replaces. Creates a synthetic process tree, of the given depth
+ * and fanout, of sleeping processes; checks that a scan finds every one of
+ * them with the right parent; then times scans of /proc and runs of ps.
+ *
+ * Usage: benchProcScan [depth] [fanout] [iterations]
+ *
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <boost/unordered_map.hpp>
+
+#include "../components/backends/procscan/ProcScan.hpp"
+
+
+
+namespace {
+
+    double now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + (ts.tv_nsec / 1e9);
+    }
+
+    /** Fork the subtree below this process, then sleep. */
+    void grow(int depth, int fanout)
+    {
+        while (depth > 0) {
+            int i = 0;
+            while ((i < fanout) && (fork() != 0)) {
+                ++i;
+            }
+            if (i == fanout) {
+                break; // Every child was forked
+            }
+            --depth;   // This is a child, fork its own children
+        }
+        while (true) {
+            pause();
+        }
+    }
+
+    /** Count the processes of a scan that descend from the given root. */
+    unsigned descendants(const ProcRecordVec& records, pid_t root)
+    {
+        boost::unordered_map<uint32_t, std::vector<uint32_t> > children;
+        for (ProcRecordVec::const_iterator
+                 i = records.begin(); i != records.end(); ++i) {
+            children[i->ppid].push_back(i->pid);
+        }
+
+        unsigned count = 0;
+        std::vector<uint32_t> pending(1, root);
+        while (!pending.empty()) {
+            uint32_t pid = pending.back();
+            pending.pop_back();
+            std::vector<uint32_t>& next = children[pid];
+            count += next.size();
+            pending.insert(pending.end(), next.begin(), next.end());
+        }
+        return count;
+    }
+
+    /** Run ps as psCmd did, returning the number of lines it listed. */
+    unsigned ps()
+    {
+        char buffer[100];
+        unsigned lines = 0;
+        FILE* p = popen("hostname; ps -e -o comm= -o euser=", "r");
+        if (p != NULL) {
+            while (fgets(buffer, sizeof(buffer), p) != NULL) {
+                lines++;
+            }
+            pclose(p);
+        }
+        return lines;
+    }
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    int depth = (argc > 1) ? atoi(argv[1]) : 3;
+    int fanout = (argc > 2) ? atoi(argv[2]) : 8;
+    int iterations = (argc > 3) ? atoi(argv[3]) : 100;
+
+    unsigned expected = 0;
+    for (int level = 1, width = 1; level <= depth; ++level) {
+        width *= fanout;
+        expected += width;
+    }
+
+    // The root of the tree leads its own process group so it can be killed
+    pid_t root = fork();
+    if (root == 0) {
+        setpgid(0, 0);
+        grow(depth, fanout);
+    }
+    setpgid(root, root);
+
+    // Wait for the whole tree to be forked
+    ProcRecordVec records;
+    unsigned found = 0;
+    for (int wait = 0; (found < expected) && (wait < 1000); ++wait) {
+        records.clear();
+        scanProcesses(records);
+        found = descendants(records, root);
+        if (found < expected) {
+            usleep(10000);
+        }
+    }
+
+    unsigned processes = 0;
+    double t = now();
+    for (int i = 0; i < iterations; ++i) {
+        records.clear();
+        scanProcesses(records);
+        processes = records.size();
+    }
+    double scan = (now() - t) / iterations;
+
+    ProcUserNames userNames;
+    t = now();
+    for (int i = 0; i < iterations; ++i) {
+        records.clear();
+        scanProcesses(records);
+        std::vector<std::string> output;
+        for (ProcRecordVec::const_iterator
+                 j = records.begin(); j != records.end(); ++j) {
+            output.push_back(std::string(j->comm) + " " +
+                             userNames(j->uid) + "\n");
+        }
+    }
+    double format = (now() - t) / iterations;
+
+    unsigned lines = 0;
+    int ps_iterations = (iterations < 10) ? iterations : 10;
+    t = now();
+    for (int i = 0; i < ps_iterations; ++i) {
+        lines = ps();
+    }
+    double popen = (now() - t) / ps_iterations;
+
+    kill(-root, SIGKILL);
+    waitpid(root, NULL, 0);
+
+    printf("synthetic tree of %u processes (depth %d, fanout %d): "
+           "%u found by scan\n", expected, depth, fanout, found);
+    printf("scan          %8.3f ms  %6u processes\n", scan * 1e3, processes);
+    printf("scan+format   %8.3f ms\n", format * 1e3);
+    printf("hostname; ps  %8.3f ms  %6u lines\n", popen * 1e3, lines);
+    printf("speedup %.1fx\n", popen / format);
+
+    return (found == expected) ? 0 : 1;
+}
@@ -21,6 +21,8 @@
 
 
 #include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <typeinfo>
 #include <iostream>
 #include <stdio.h>
@@ -32,11 +34,35 @@
 #include <KrellInstitute/CBTF/Type.hpp>
 #include <KrellInstitute/CBTF/Version.hpp>
 
+#include "../components/backends/procscan/ProcScan.hpp"
+
 typedef std::vector<std::string> sameVec;
 typedef std::vector<std::string> diffVec;
 
 using namespace KrellInstitute::CBTF;
 
+/**
+ * Count the number of nodes running each proc. A proc listed more than once
+ * by the same node is only counted once for that node.
+ */
+static void countNodes(const std::vector<std::vector<std::string> >& inVec,
+                       boost::unordered_map<std::string, int>& nodeCount)
+{
+  for(std::vector<std::vector<std::string> >::const_iterator
+         procVec = inVec.begin(); procVec != inVec.end(); ++procVec)
+  {
+    boost::unordered_set<std::string> seen;
+    for(std::vector<std::string>::const_iterator proc = procVec->begin();
+          proc != procVec->end(); ++proc)
+    {
+      if(seen.insert(*proc).second)
+      {
+        nodeCount[*proc]++;
+      }
+    }
+  }
+}
+
 
 class __attribute__ ((visibility ("hidden"))) psFE :
     public Component
@@ -170,80 +196,29 @@ private:
       // save the ps output for this node
       inVec.push_back(in);
 
-      // once all nodes have responded search through the inVec to see
-      // what procs are the same on all nodes
+      // once all nodes have responded count the nodes running each proc,
+      // the same procs are the ones running on every node
       if(runNum >= nodes) {
-        // check if a proc on one node is running on any other
-        // grab each vector of procs
-        int found;
+        boost::unordered_map<std::string, int> nodeCount;
+        countNodes(inVec, nodeCount);
+
+        // save each of them once, in the order they were first listed
+        // (a lone node has no other node to have the same procs as)
+        boost::unordered_set<std::string> saved;
         for(std::vector<std::vector<std::string> >::const_iterator
                procVec = inVec.begin();
                procVec != inVec.end();
                ++procVec)
         {
-          // take one proc
           for(std::vector<std::string>::const_iterator proc = procVec->begin(); 
 	        proc != procVec->end(); ++proc)
           {
-            found = 0;
-            // for all the other vector of procs
-            for(std::vector<std::vector<std::string> >::const_iterator
-                    procVecOther = inVec.begin();
-                    procVecOther != inVec.end();
-                    ++procVecOther)
+            if((inVec.size() > 1) &&
+               (nodeCount[*proc] == static_cast<int>(inVec.size())) &&
+               saved.insert(*proc).second)
             {
-              // don't check itself
-              if(procVecOther != procVec)
-              {
-                found = 0;
-                // look at each of the procs in the other vectors
-                for(std::vector<std::string>::const_iterator
-                        procOther = procVecOther->begin();
-                        procOther != procVecOther->end();
-                        ++procOther)
-                {
-                // check to see if the original proc is the same as any other
-                // if it is stop looking
-                if(*proc == *procOther)
-                {
-                    found = 1;
-                    break;
-                  } 
-                }  //procOther
-
-                // if the proc was found then continue checking the others
-                // else don't bother searching the others
-                if(found == 0) 
-                {
-                  break;
-                }
-              }// if procVecOther != procVec
-            } //procVecOther
-
-            // after looking through all the procs on the other nodes
-            // if found is 1 then it was found on every node
-            // if found is 0 then it was not on every node
-            if(found) 
-            {
-              // this proc was found on every node so save it
-              // but don't save it twice
-              for(sameVec::const_iterator outProc = outVec.begin();
-                      outProc != outVec.end(); ++outProc) 
-              {
-                // if the proc is already in the list don't save it
-                if(*outProc == *proc)
-                {
-                  found = 0;
-                  break;
-                }
-              }
-
-              // this proc hasn't been saved yet so save it
-              if(found)
-              {
-                outVec.push_back(*proc);
-              }
-            }// end found
+              outVec.push_back(*proc);
+            }
           } // proc
         } //procVec
 
@@ -317,68 +292,22 @@ private:
       // save the ps output for this node
       inVec.push_back(in);
 
-      // once all nodes have responded search through the inVec to see
-      // what procs are the same on all nodes
+      // once all nodes have responded count the nodes running each proc,
+      // the diff procs are the ones running on only one node
       if(runNum >= nodes) {
-        // check if a proc on one node is running on any other
-        // grab each vector of procs
-        int found;
+        boost::unordered_map<std::string, int> nodeCount;
+        countNodes(inVec, nodeCount);
+
         for(std::vector<std::vector<std::string> >::const_iterator
                 procVec = inVec.begin();
                 procVec != inVec.end();
                 ++procVec)
         {
-          // take one proc
           for(std::vector<std::string>::const_iterator proc = procVec->begin(); 
 	        proc != procVec->end(); ++proc)
           {
-            found = 0;
-            // for all the other vector of procs
-            for(std::vector<std::vector<std::string> >::const_iterator
-	           procVecOther = inVec.begin();
-                   procVecOther != inVec.end();
-                   ++procVecOther)
+            if(nodeCount[*proc] == 1)
             {
-              // don't check itself
-              if (procVecOther != procVec)
-              { 
-                found = 0;
-                // look at each of the procs in the other vectors
-                for(std::vector<std::string>::const_iterator
-                    procOther = procVecOther->begin();
-                    procOther != procVecOther->end();
-		    ++procOther)
-                {
-                  // check to see if the original proc is the same as any other
-                  // if it is stop looking
-                  if(*proc == *procOther)
-                  {
-                    found = 1;
-                    break;
-                  } 
-                }  //procOther
-
-                // if the proc was found stop don't want it
-                // else continue checking the others
-                if(found == 1) 
-                {
-                  break;
-                }
-              } //end if procVecOther != procVec
-
-              if(found == 1) 
-                {
-                  break;
-                }
-            } //procVecOther
-
-            // after looking through all the procs on the other nodes
-            // if found is 1 then it was found on more then one node don't want
-            // if found is 0 then it was only found on 1 node save it
-            if(found == 0) 
-            {
-              // this proc was found on only one node so save it
-              //std::cerr << "PSDIFF proc only on one node: " << *proc << std::endl;
               outVec.push_back(*proc);
             }
           } // proc
@@ -429,27 +358,31 @@ private:
         declareOutput<std::vector <std::string> >("out");
     }
 
+    // names of the users running the procs
+    ProcUserNames userNames;
+
     /** Handler for the "in" input.*/
     // Apparently the FE client sends a std::string "start"
     // to this input.
     void inHandler(const std::string& in)
     { 
-      char buffer[100];
-      memset(&buffer,0,sizeof(buffer));
-      FILE *p = NULL;
-      std::string outline = "";
       std::vector<std::string> output;
 
-      // get ps
-      p = popen("hostname; ps -e -o comm= -o euser=", "r");
-      if(p != NULL) {
-	while(fgets(buffer, sizeof(buffer), p) != NULL)
-        {
-          outline.assign(buffer);
-          output.push_back(outline);
-        }
-        pclose(p);
-      } //end if p for hostname
+      // the hostname followed by "comm euser" for each proc, as
+      // "hostname; ps -e -o comm= -o euser=" would list them
+      char hostname[MAXHOSTNAMELEN + 1];
+      memset(&hostname,0,sizeof(hostname));
+      gethostname(hostname, MAXHOSTNAMELEN);
+      output.push_back(std::string(hostname) + "\n");
+
+      ProcRecordVec records;
+      scanProcesses(records);
+      for(ProcRecordVec::const_iterator
+            record = records.begin(); record != records.end(); ++record)
+      {
+        output.push_back(std::string(record->comm) + " " +
+                         userNames(record->uid) + "\n");
+      }
 
       emitOutput<std::vector<std::string> >("out", output );
     }
@@ -0,0 +1,351 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file Call-prefix tree of the stacks of many tasks.
+ *
+ * Every stack sampled on a backend is added to the tree from its outermost
+ * frame inwards, so that stacks sharing a prefix share the nodes of that
+ * prefix, and each node records the set of tasks whose stacks pass through
+ * it. Trees from different nodes are merged the same way as they travel up
+ * the MRNet tree, so the frontend receives one node per unique call path
+ * rather than one stack per task.
+ *
+ * Frames are addresses relative to the linked object containing them, so the
+ * same frame compares equal across tasks loaded at different addresses. They
+ * are only turned into function names by the frontend.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <boost/dynamic_bitset.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** Call-prefix tree of the stacks of many tasks. */
+class StackTree
+{
+
+public:
+
+    /** Set of tasks, indexed as the task names. */
+    typedef boost::dynamic_bitset<uint64_t> TaskSet;
+
+    /** Linked object containing frames of the tree. */
+    struct Module
+    {
+        std::string path;  /**< Path of the linked object */
+        uint64_t begin;    /**< Address at which it was found loaded */
+        uint64_t end;      /**< End of its mapping at that address */
+    };
+
+    /** Node of the tree. */
+    struct Node
+    {
+        uint64_t frame;    /**< Frame, encoded by makeFrame() */
+        uint32_t parent;   /**< Index of the node of the calling frame */
+        TaskSet tasks;     /**< Tasks whose stacks pass through this node */
+    };
+
+    /** Index of the root node, which has no frame and every task. */
+    static const uint32_t Root = 0;
+
+    /** Module of frames that are not within any linked object. */
+    static const uint64_t UnknownModule = 0xFFFF;
+
+    /** Encode the given module and offset within it as a frame. */
+    static uint64_t makeFrame(uint64_t module, uint64_t offset)
+    {
+        return (module << 48) | (offset & ((uint64_t(1) << 48) - 1));
+    }
+
+    /** Get the module of an encoded frame. */
+    static uint64_t getModule(uint64_t frame)
+    {
+        return frame >> 48;
+    }
+
+    /** Get the offset, or the address for UnknownModule, of a frame. */
+    static uint64_t getOffset(uint64_t frame)
+    {
+        return frame & ((uint64_t(1) << 48) - 1);
+    }
+
+    /** Construct an empty tree. */
+    StackTree() :
+        dm_tasks(),
+        dm_modules(),
+        dm_nodes(1),
+        dm_module_index(),
+        dm_children()
+    {
+        dm_nodes[Root].frame = 0;
+        dm_nodes[Root].parent = Root;
+    }
+
+    /** Get the names of the tasks. */
+    const std::vector<std::string>& getTasks() const
+    {
+        return dm_tasks;
+    }
+
+    /** Get the modules. */
+    const std::vector<Module>& getModules() const
+    {
+        return dm_modules;
+    }
+
+    /**
+     * Get the nodes. The root is first and every node follows its parent.
+     * The task set of a node may be shorter than the number of tasks, in
+     * which case the missing tasks are not in the set.
+     */
+    const std::vector<Node>& getNodes() const
+    {
+        return dm_nodes;
+    }
+
+    /** Add a task with the given name, returning its index. */
+    uint32_t addTask(const std::string& name)
+    {
+        dm_tasks.push_back(name);
+        return dm_tasks.size() - 1;
+    }
+
+    /**
+     * Add a module, returning its index. A module with the same path as an
+     * existing one is the same module, whose extent is widened if needed.
+     */
+    uint64_t addModule(const std::string& path, uint64_t begin, uint64_t end)
+    {
+        boost::unordered_map<std::string, uint64_t>::const_iterator
+            i = dm_module_index.find(path);
+        if (i != dm_module_index.end()) {
+            Module& module = dm_modules[i->second];
+            if ((end - begin) > (module.end - module.begin)) {
+                module.end = module.begin + (end - begin);
+            }
+            return i->second;
+        }
+
+        Module module;
+        module.path = path;
+        module.begin = begin;
+        module.end = end;
+        dm_modules.push_back(module);
+        dm_module_index.insert(std::make_pair(path, dm_modules.size() - 1));
+        return dm_modules.size() - 1;
+    }
+
+    /**
+     * Add a stack of a task.
+     *
+     * @param task      Index of the task.
+     * @param frames    Frames of the stack, outermost first.
+     */
+    void addStack(uint32_t task, const std::vector<uint64_t>& frames)
+    {
+        uint32_t node = Root;
+        addTaskTo(node, task);
+        for (std::vector<uint64_t>::const_iterator
+                 i = frames.begin(); i != frames.end(); ++i) {
+            node = getChild(node, *i);
+            addTaskTo(node, task);
+        }
+    }
+
+    /**
+     * Merge another tree into this one. The tasks of the other tree follow
+     * those of this tree.
+     */
+    void merge(const StackTree& other)
+    {
+        uint32_t first = dm_tasks.size();
+        dm_tasks.insert(dm_tasks.end(),
+                        other.dm_tasks.begin(), other.dm_tasks.end());
+
+        std::vector<uint64_t> modules;
+        for (std::vector<Module>::const_iterator
+                 i = other.dm_modules.begin(); i != other.dm_modules.end(); ++i) {
+            modules.push_back(addModule(i->path, i->begin, i->end));
+        }
+
+        // Parents precede their children, so each node's parent is already
+        // mapped to its node in this tree when the node itself is reached
+        std::vector<uint32_t> nodes(other.dm_nodes.size(), uint32_t(Root));
+        for (uint32_t i = 0; i < other.dm_nodes.size(); ++i) {
+            const Node& node = other.dm_nodes[i];
+            if (i != Root) {
+                uint64_t module = getModule(node.frame);
+                if (module < modules.size()) {
+                    module = modules[module];
+                }
+                nodes[i] = getChild(nodes[node.parent],
+                                    makeFrame(module, getOffset(node.frame)));
+            }
+            for (TaskSet::size_type
+                     t = node.tasks.find_first();
+                 t != TaskSet::npos; t = node.tasks.find_next(t)) {
+                addTaskTo(nodes[i], first + t);
+            }
+        }
+    }
+
+    /**
+     * Pack this tree into a vector of strings and a vector of integers.
+     *
+     * The strings are the task names followed by the module paths. The
+     * integers are the number of tasks, modules, nodes and task set blocks
+     * per node; then the beginning and end of each module; then the frame,
+     * parent and task set blocks of each node.
+     */
+    void pack(std::vector<std::string>& strings,
+              std::vector<uint64_t>& integers) const
+    {
+        strings = dm_tasks;
+        for (std::vector<Module>::const_iterator
+                 i = dm_modules.begin(); i != dm_modules.end(); ++i) {
+            strings.push_back(i->path);
+        }
+
+        TaskSet::size_type blocks =
+            (dm_tasks.size() + TaskSet::bits_per_block - 1) /
+            TaskSet::bits_per_block;
+
+        integers.clear();
+        integers.reserve(4 + (2 * dm_modules.size()) +
+                         ((2 + blocks) * dm_nodes.size()));
+        integers.push_back(dm_tasks.size());
+        integers.push_back(dm_modules.size());
+        integers.push_back(dm_nodes.size());
+        integers.push_back(blocks);
+        for (std::vector<Module>::const_iterator
+                 i = dm_modules.begin(); i != dm_modules.end(); ++i) {
+            integers.push_back(i->begin);
+            integers.push_back(i->end);
+        }
+        for (std::vector<Node>::const_iterator
+                 i = dm_nodes.begin(); i != dm_nodes.end(); ++i) {
+            integers.push_back(i->frame);
+            integers.push_back(i->parent);
+            TaskSet tasks(i->tasks);
+            tasks.resize(dm_tasks.size());
+            boost::to_block_range(tasks, std::back_inserter(integers));
+        }
+    }
+
+    /**
+     * Unpack a tree packed by pack() into this one.
+     *
+     * @return    Boolean flag indicating if the tree could be unpacked.
+     */
+    bool unpack(const std::vector<std::string>& strings,
+                const std::vector<uint64_t>& integers)
+    {
+        *this = StackTree();
+
+        if (integers.size() < 4) {
+            return false;
+        }
+        uint64_t tasks = integers[0], modules = integers[1];
+        uint64_t nodes = integers[2], blocks = integers[3];
+        if ((strings.size() != (tasks + modules)) || (nodes == 0) ||
+            (blocks != ((tasks + TaskSet::bits_per_block - 1) /
+                        TaskSet::bits_per_block)) ||
+            (integers.size() != (4 + (2 * modules) + ((2 + blocks) * nodes)))) {
+            return false;
+        }
+
+        dm_tasks.assign(strings.begin(), strings.begin() + tasks);
+        std::vector<uint64_t>::const_iterator i = integers.begin() + 4;
+        for (uint64_t m = 0; m < modules; ++m, i += 2) {
+            addModule(strings[tasks + m], i[0], i[1]);
+        }
+
+        dm_nodes.resize(nodes);
+        for (uint64_t n = 0; n < nodes; ++n, i += 2 + blocks) {
+            Node& node = dm_nodes[n];
+            node.frame = i[0];
+            node.parent = i[1];
+            if ((n != Root) && (node.parent >= n)) {
+                *this = StackTree();
+                return false;
+            }
+            node.tasks.append(i + 2, i + 2 + blocks);
+            node.tasks.resize(tasks);
+            if (n != Root) {
+                dm_children.insert(
+                    std::make_pair(std::make_pair(node.parent, node.frame), n)
+                    );
+            }
+        }
+        return true;
+    }
+
+private:
+
+    /** Get the child of a node for the given frame, adding it if needed. */
+    uint32_t getChild(uint32_t parent, uint64_t frame)
+    {
+        std::pair<ChildIndex::iterator, bool> i = dm_children.insert(
+            std::make_pair(std::make_pair(parent, frame), dm_nodes.size())
+            );
+        if (i.second) {
+            Node node;
+            node.frame = frame;
+            node.parent = parent;
+            dm_nodes.push_back(node);
+        }
+        return i.first->second;
+    }
+
+    /** Add a task to the task set of a node. */
+    void addTaskTo(uint32_t node, uint32_t task)
+    {
+        TaskSet& tasks = dm_nodes[node].tasks;
+        if (tasks.size() <= task) {
+            tasks.resize(dm_tasks.size() > task ? dm_tasks.size() : task + 1);
+        }
+        tasks.set(task);
+    }
+
+    /** Index of the children of each node by their parent and frame. */
+    typedef boost::unordered_map<
+        std::pair<uint32_t, uint64_t>, uint32_t
+        > ChildIndex;
+
+    /** Names of the tasks. */
+    std::vector<std::string> dm_tasks;
+
+    /** Modules containing the frames. */
+    std::vector<Module> dm_modules;
+
+    /** Nodes, starting with the root. */
+    std::vector<Node> dm_nodes;
+
+    /** Index of the modules by their path. */
+    boost::unordered_map<std::string, uint64_t> dm_module_index;
+
+    /** Index of the nodes by their parent and frame. */
+    ChildIndex dm_children;
+
+}; // class StackTree
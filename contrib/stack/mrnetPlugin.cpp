@@ -3,12 +3,16 @@
 #include <boost/bind.hpp>
 #include <mrnet/MRNet.h>
 #include <typeinfo>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include <KrellInstitute/CBTF/Component.hpp>
 #include <KrellInstitute/CBTF/Type.hpp>
 #include <KrellInstitute/CBTF/Version.hpp>
 
+#include "StackTree.hpp"
+
 using namespace KrellInstitute::CBTF;
 
 /**
@@ -190,6 +194,124 @@ private:
 KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(ConvertPacketToStringList)
 
 
+/**
+ * Component that converts a StackTree value into a MRNet packet.
+ */
+class __attribute__ ((visibility ("hidden"))) ConvertStackTreeToPacket :
+    public Component
+{
+
+public:
+
+    /** Factory function for this component type. */
+    static Component::Instance factoryFunction()
+    {
+        return Component::Instance(
+            reinterpret_cast<Component*>(new ConvertStackTreeToPacket())
+            );
+    }
+
+private:
+
+    /** Default constructor. */
+    ConvertStackTreeToPacket() :
+        Component(Type(typeid(ConvertStackTreeToPacket)), Version(1, 0, 0))
+    {
+        declareInput<StackTree>(
+            "in", boost::bind(&ConvertStackTreeToPacket::inHandler, this, _1)
+            );
+        declareOutput<MRN::PacketPtr>("out");
+    }
+
+    /** Handler for the "in" input.*/
+    void inHandler(const StackTree& in)
+    {
+        std::vector<std::string> strings;
+        std::vector<uint64_t> integers;
+        in.pack(strings, integers);
+
+	char** arr = (char**) malloc( (strings.size() + 1) * sizeof(char*) );
+	for( unsigned u = 0; u < strings.size(); u++ ) {
+	    arr[u] = strdup(strings[u].c_str());
+	}
+	uint64_t* ints = (uint64_t*) malloc( integers.size() * sizeof(uint64_t) );
+	std::copy(integers.begin(), integers.end(), ints);
+
+        emitOutput<MRN::PacketPtr>(
+            "out", MRN::PacketPtr(new MRN::Packet(0, 0, "%as %auld",
+                                                  arr, strings.size(),
+                                                  ints, integers.size()))
+            );
+
+	for( unsigned u = 0; u < strings.size(); u++ ) {
+	    free(arr[u]);
+	}
+	free(arr);
+	free(ints);
+    }
+    
+}; // class ConvertStackTreeToPacket
+
+KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(ConvertStackTreeToPacket)
+
+/**
+ * Component that converts a MRNet packet into a StackTree value.
+ */
+class __attribute__ ((visibility ("hidden"))) ConvertPacketToStackTree :
+    public Component
+{
+
+public:
+
+    /** Factory function for this component type. */
+    static Component::Instance factoryFunction()
+    {
+        return Component::Instance(
+            reinterpret_cast<Component*>(new ConvertPacketToStackTree())
+            );
+    }
+
+private:
+
+    /** Default constructor. */
+    ConvertPacketToStackTree() :
+        Component(Type(typeid(ConvertPacketToStackTree)), Version(1, 0, 0))
+    {
+        declareInput<MRN::PacketPtr>(
+            "in", boost::bind(&ConvertPacketToStackTree::inHandler, this, _1)
+            );
+        declareOutput<StackTree>("out");
+    }
+
+    /** Handler for the "in" input.*/
+    void inHandler(const MRN::PacketPtr& in)
+    {
+	char** arr = NULL;
+	unsigned arrlen = 0;
+	uint64_t* ints = NULL;
+	unsigned intslen = 0;
+        in->unpack("%as %auld", &arr, &arrlen, &ints, &intslen);
+
+        std::vector<std::string> strings;
+	for( unsigned u = 0; u < arrlen; u++ ) {
+	    strings.push_back(std::string(arr[u]));
+	    free(arr[u]);
+	}
+	free(arr);
+        std::vector<uint64_t> integers(ints, ints + intslen);
+	free(ints);
+
+        // A malformed tree is passed on empty, as no stacks were found
+        StackTree out;
+        out.unpack(strings, integers);
+        emitOutput<StackTree>("out", out);
+    }
+    
+}; // class ConvertPacketToStackTree
+
+KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(ConvertPacketToStackTree)
+
+
 /**
  * Component that converts a MRNet packet into an string value.
  */
@@ -222,6 +344,11 @@ private:
             "in2", boost::bind(&PassThrough::inHandler2, this, _1)
             );
         declareOutput<std::vector<std::string> >("out2");
+
+        declareInput<StackTree>(
+            "in3", boost::bind(&PassThrough::inHandler3, this, _1)
+            );
+        declareOutput<StackTree>("out3");
     }
 
     /** Handler for the "in" input.*/
@@ -235,6 +362,10 @@ private:
         std::vector<std::string> out = in;
         emitOutput<std::vector<std::string> >("out2", out);
     }
+    void inHandler3(const StackTree& in)
+    {
+        emitOutput<StackTree>("out3", in);
+    }
     
 }; // class PassThrough
 
@@ -22,238 +22,325 @@
 // Again as in any C++ file we start by including the libraries we will 
 // need.  We load our boost, Krell and normal helper libraries.
 #include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
 #include <typeinfo>
-#include <iostream>
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sys/param.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <KrellInstitute/CBTF/Component.hpp>
 #include <KrellInstitute/CBTF/Type.hpp>
 #include <KrellInstitute/CBTF/Version.hpp>
 
+// The ProcScan component scans /proc for the processes running a command.
+// It is defined in a header shared by the tools, so we register it in this 
+// plugin below.
+#include "../components/backends/procscan/procScanPlugin.hpp"
+
+// The frames of each stack are found with libunwind, reading the registers 
+// and memory of each thread through ptrace, rather than by running gstack.
+// libunwind-ptrace is a remote unwinder so we must not define UNW_LOCAL_ONLY.
+#include <libunwind-ptrace.h>
+
+#include <KrellInstitute/CBTF/Impl/MRNet.hpp>
+
+// The stacks of all the tasks are merged into a call-prefix tree.
+#include "StackTree.hpp"
+
 // We are still working in the KrellInstitute::CBTF namespace.
 using namespace KrellInstitute::CBTF;
 
-// This is the C++ class definition for the component called getPID.
-// This component will take the name of an MPI application as a string 
-// and output a list, as a vector of strings, of all PIDs on the node 
-// that have that name.  The stack tool then feeds this to the input of 
-// a component that takes a list of PIDs and outputs a stack trace for 
-// each of those PIDs.
-class __attribute__ ((visibility ("hidden"))) getPID :
+KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(ProcScan)
+
+// Filters emit their output once every child has sent its input.
+#define TOTAL_CHILDREN Impl::TheTopologyInfo.NumChildren
+
+// Deepest stack that is unwound.
+#define MAX_STACK_DEPTH 256
+
+// A mapping of a linked object into the address space of a process, and 
+// the index of that linked object in the tree of stacks.
+struct stackMapping {
+  uint64_t begin;
+  uint64_t end;
+  uint64_t base;
+  uint64_t module;
+};
+
+// Read the linked objects mapped into a process from /proc/<pid>/maps, adding
+// them to the tree.  The frames of a linked object are relative to the lowest
+// address at which it is mapped, which is where it was loaded.
+static void getMappings(pid_t pid, StackTree& tree,
+                        std::vector<stackMapping>& mappings)
+{
+  mappings.clear();
+
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+  FILE *maps = fopen(path, "r");
+  if(maps == NULL)
+    return;
+
+  std::vector<std::pair<stackMapping, std::string> > found;
+  boost::unordered_map<std::string, std::pair<uint64_t, uint64_t> > extents;
+  char line[PATH_MAX + 128];
+  while(fgets(line, sizeof(line), maps) != NULL)
+  {
+    unsigned long begin, end;
+    int name = 0;
+    if(sscanf(line, "%lx-%lx %*s %*x %*s %*u %n", &begin, &end, &name) < 2 ||
+       name == 0 || line[name] != '/')
+      continue;
+
+    std::string object(line + name);
+    object.erase(object.find_last_not_of("\n") + 1);
+
+    stackMapping mapping = { begin, end, 0, 0 };
+    found.push_back(std::make_pair(mapping, object));
+
+    std::pair<boost::unordered_map<std::string,
+                                   std::pair<uint64_t, uint64_t> >::iterator,
+              bool> extent = extents.insert(
+                std::make_pair(object, std::make_pair(begin, end)));
+    if(!extent.second)
+    {
+      extent.first->second.first = std::min<uint64_t>(extent.first->second.first, begin);
+      extent.first->second.second = std::max<uint64_t>(extent.first->second.second, end);
+    }
+  }
+  fclose(maps);
+
+  // The maps are in address order, so the mappings are too.
+  for(std::vector<std::pair<stackMapping, std::string> >::iterator
+        i = found.begin(); i != found.end(); ++i)
+  {
+    const std::pair<uint64_t, uint64_t>& extent = extents[i->second];
+    i->first.base = extent.first;
+    i->first.module = tree.addModule(i->second, extent.first, extent.second);
+    mappings.push_back(i->first);
+  }
+}
+
+// Encode the address of a frame relative to the linked object containing it.
+static uint64_t getFrame(const std::vector<stackMapping>& mappings,
+                         uint64_t address)
+{
+  size_t low = 0, high = mappings.size();
+  while(low < high)
+  {
+    size_t middle = (low + high) / 2;
+    if(mappings[middle].begin <= address)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  if(low > 0 && address < mappings[low - 1].end)
+    return StackTree::makeFrame(mappings[low - 1].module,
+                                address - mappings[low - 1].base);
+  return StackTree::makeFrame(StackTree::UnknownModule, address);
+}
+
+// Wait for a thread that was interrupted to stop.  The signal it stopped for, 
+// if any, is delivered when it is detached.
+static bool waitForStop(pid_t tid, int& signal)
+{
+  int status;
+  while(waitpid(tid, &status, __WALL) == -1)
+  {
+    if(errno != EINTR)
+      return false;
+  }
+  if(!WIFSTOPPED(status))
+    return false;
+  signal = ((status >> 16) == PTRACE_EVENT_STOP) ? 0 : WSTOPSIG(status);
+  return true;
+}
+
+// Unwind the stack of a stopped thread, outermost frame first.
+static void unwindThread(unw_addr_space_t space, pid_t tid,
+                         const std::vector<stackMapping>& mappings,
+                         std::vector<uint64_t>& frames)
+{
+  frames.clear();
+
+  void *context = _UPT_create(tid);
+  if(context == NULL)
+    return;
+
+  unw_cursor_t cursor;
+  if(unw_init_remote(&cursor, space, context) == 0)
+  {
+    // The addresses of the callers are return addresses, which may be the 
+    // start of the next statement, so they are moved back into the call.  
+    // The interrupted address of a signal frame is not a return address.
+    bool is_return = false;
+    do
+    {
+      unw_word_t ip = 0;
+      if(unw_get_reg(&cursor, UNW_REG_IP, &ip) != 0 || ip == 0)
+        break;
+      frames.push_back(getFrame(mappings, is_return ? ip - 1 : ip));
+      is_return = (unw_is_signal_frame(&cursor) <= 0);
+    } while(frames.size() < MAX_STACK_DEPTH && unw_step(&cursor) > 0);
+  }
+
+  _UPT_destroy(context);
+  std::reverse(frames.begin(), frames.end());
+}
+
+// Add the stacks of every thread of a process to the tree.
+static void sampleProcess(pid_t pid, uint32_t task, StackTree& tree)
+{
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/task", pid);
+  DIR *threads = opendir(path);
+  if(threads == NULL)
+    return;
+
+  // Stop every thread before unwinding any of them, so the stacks of the 
+  // process are a consistent snapshot.  Seizing and interrupting the threads,
+  // rather than attaching to them, doesn't send them a SIGSTOP.
+  std::vector<std::pair<pid_t, int> > stopped;
+  for(struct dirent *entry = readdir(threads); entry != NULL;
+      entry = readdir(threads))
+  {
+    pid_t tid = atoi(entry->d_name);
+    if(tid <= 0 || ptrace(PTRACE_SEIZE, tid, 0, 0) != 0)
+      continue;
+    int signal = 0;
+    if(ptrace(PTRACE_INTERRUPT, tid, 0, 0) == 0 && waitForStop(tid, signal))
+      stopped.push_back(std::make_pair(tid, signal));
+    else
+      ptrace(PTRACE_DETACH, tid, 0, 0);
+  }
+  closedir(threads);
+
+  if(!stopped.empty())
+  {
+    std::vector<stackMapping> mappings;
+    getMappings(pid, tree, mappings);
+
+    // The threads share one address space, so what libunwind caches while 
+    // unwinding one of them is valid for the others.
+    unw_addr_space_t space = unw_create_addr_space(&_UPT_accessors, 0);
+    if(space != NULL)
+    {
+      unw_set_caching_policy(space, UNW_CACHE_GLOBAL);
+      std::vector<uint64_t> frames;
+      for(std::vector<std::pair<pid_t, int> >::const_iterator
+            i = stopped.begin(); i != stopped.end(); ++i)
+      {
+        unwindThread(space, i->first, mappings, frames);
+        if(!frames.empty())
+          tree.addStack(task, frames);
+      }
+      unw_destroy_addr_space(space);
+    }
+  }
+
+  for(std::vector<std::pair<pid_t, int> >::const_iterator
+        i = stopped.begin(); i != stopped.end(); ++i)
+  {
+    ptrace(PTRACE_DETACH, i->first, 0, i->second);
+  }
+}
+
+// This is the C++ class definition for the component called sampleStacks.
+// This component will take the processes running an MPI application, as 
+// scanned by the ProcScan component from the name of that application, 
+// and output the stacks of every thread of those that belong to the user, 
+// as a StackTree.  Each process is a task of the tree named hostname(pid).
+class __attribute__ ((visibility ("hidden"))) sampleStacks :
     public Component
 {
 
 // Remember most of this code is the same for each component so the 
 // only thing you need to change for a new component so far is the name 
-// getPID above and below.
+// sampleStacks above and below.
 public:
     /** Factory function for this component type. */
     static Component::Instance factoryFunction()
     {
         return Component::Instance(
-          reinterpret_cast<Component*>(new getPID())
+          reinterpret_cast<Component*>(new sampleStacks())
         );
     }
 
 // This part is important, here is where you define the inputs and 
 // outputs to this component.  You use the functions declareInput 
-// or declareOutput to define a new input/output.  You include they 
+// or declareOutput to define a new input/output.  You include the 
 // C++ type for that input/output in the <>.  Then you name that 
-// input/output in "", that name will be used in the XML file.  
-// They should be unique with in a component but you can have multiple
-//  component with an input called "in".  Although it may be helpful 
-//  to be a little more descriptive when dealing with more complicated 
-//  components.  At the moment there is no naming convention in CBTF. 
-//  For the input you then need to bind the input to a function (a 
-//  method of this class).
+// input/output in "", that name will be used in the XML file.
 private:
     /** Default constructor. */
-    getPID() :
-        Component(Type(typeid(getPID)), Version(1, 0, 0))
+    sampleStacks() :
+        Component(Type(typeid(sampleStacks)), Version(1, 0, 0))
     {
-        declareInput<std::string>(
-            "in", boost::bind(&getPID::inHandler, this, _1)
+        declareInput<ProcRecordVec>(
+            "in", boost::bind(&sampleStacks::inHandler, this, _1)
             );
-        declareOutput<std::vector<std::string> >("out");
+        declareOutput<StackTree>("out");
     }
 
 // This is the function we have bound to the input for this component.  
 // Notice that it takes one argument with the type defined in declareInput 
-// above.  These input handler functions are where you add your code, 
-// this is the part the tells the component what to do with the input.
+// above.
     /** Handler for the "in" input.*/
-    void inHandler(const std::string& in)
+    void inHandler(const ProcRecordVec& in)
     { 
 // Remember that instances of this component that will be run on all of 
 // the backend nodes but any single component will only be running on 
 // one node.  So you just need to write your code as if you are dealing 
 // with one node and CBTF will handle dealing with the many nodes your 
-// tool will run on.  Below we setup some variables used for this component.
-      char buffer[100];
-      memset(&buffer,0,sizeof(buffer));
-      FILE *p = NULL;
-      std::string outline = "";
-
-// Here we setup the output variable with the same type as we stated in 
-// the declareOutput function above.  This is the variable we send as output 
-// at the end of this function.  We also prepare a command line that will get 
-// a list of PIDs with the name that was sent down the tree.  Remember this 
-// component only needs to get the PID list from the node it is running on.
-      std::vector<std::string> output;
-      std::string cmd = "ps -u $USER -o pid= -o comm= | grep ";
-      cmd += in; 
-      cmd += " | awk -F \" \" '{print $1}'";
-
-// Here we use the normal C popen function to run the command on the node 
-// and store the output PIDs in the output variable.
-      // get cmd
-      p = popen(cmd.c_str(), "r");
-      if(p != NULL) {
-	while(fgets(buffer, sizeof(buffer), p) != NULL)
-        {
-          outline.assign(buffer);
-          outline = outline.substr(0,outline.rfind("\n"));
-          output.push_back(outline);
-        }
-        pclose(p);
-      } //end if p
-
-// Once we have the PID list in the output variable we use the CBTF 
-// function emitOutput to send the output to where ever "out" is connected to.
-      emitOutput<std::vector <std::string> >("out", output ); 
-    }
-}; // end class getPID
-
-// This macro is needed to end the definition of the component.
-KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(getPID)
-
-
-/**
- *  * Component type used by the unit test for the Component class.
- *   */
-class __attribute__ ((visibility ("hidden"))) getStack :
-    public Component
-{
-
-public:
-    /** Factory function for this component type. */
-    static Component::Instance factoryFunction()
-    {
-        return Component::Instance(
-          reinterpret_cast<Component*>(new getStack())
-        );
-    }
-
-private:
-    /** Default constructor. */
-    getStack() :
-        Component(Type(typeid(getStack)), Version(1, 0, 0))
-    {
-        declareInput<std::vector<std::string> >(
-            "in", boost::bind(&getStack::inHandler, this, _1)
-            );
-        declareOutput<std::vector<std::string> >("out");
-    }
-
-    /** Handler for the "in" input.*/
-    void inHandler(const std::vector<std::string>& in)
-    { 
-      char buffer[100];
-      memset(&buffer,0,sizeof(buffer));
-      FILE *p = NULL;
-      std::string outline = "";
-      std::vector<std::string> output;
-      std::string hostname = "";
-
-      // get hostname
-      std::string cmd = "hostname";
-
-      // get cmd
-      p = popen(cmd.c_str(), "r");
-      if(p != NULL) {
-	while(fgets(buffer, sizeof(buffer), p) != NULL)
-        {
-          hostname.assign(buffer);
-        }
-        pclose(p);
-      } //end if p
-
-      //loop over each pid and get stack trace
-      for(std::vector<std::string>::const_iterator pid = in.begin(); 
-        pid != in.end(); ++pid)
+// tool will run on.
+      StackTree output;
+      uid_t uid = geteuid();
+      pid_t self = getpid();
+
+      char hostname[HOST_NAME_MAX + 1];
+      if(gethostname(hostname, sizeof(hostname)) != 0)
+        hostname[0] = '\0';
+      hostname[HOST_NAME_MAX] = '\0';
+
+// The processes we were given already run the application that was sent 
+// down the tree, so we only keep the ones belonging to this user, as 
+// "ps -u $USER" would.
+      char name[HOST_NAME_MAX + 32];
+      for(ProcRecordVec::const_iterator
+            record = in.begin(); record != in.end(); ++record)
       {
-        // add hostname(pid) to the output
-        outline = hostname.substr(0,hostname.rfind("\n"));
-        outline += "(";
-        //outline += pid->substr(0,pid->rfind("\n"));
-        outline += *pid;
-        outline += ")\n";
-        output.push_back(outline);
-
-        // set cmd to gstack pid
-        std::string cmd = "gstack ";
-        cmd += *pid;
-        cmd += " | sed -e s/'0x[A-Za-z0-9]*'/###/g -e s/'LWP [0-9]*'/'LWP ###'/g -e s/'[0-9].[0-9].[0-9].[0-9].[0-9].[0-9]*'/###/g";
-
-        // get gstack
-        p = NULL;
-        p = popen(cmd.c_str(), "r");
-        if(p != NULL) {
-          while(fgets(buffer, sizeof(buffer), p) != NULL)
-          {
-            outline.assign(buffer);
-            output.push_back(outline);
-          }
-          pclose(p);
-        } //end if p
-
-        // add a delimiter to the end of each stack
-        output.push_back("STOP");
-      }//end for
-
-      emitOutput<std::vector <std::string> >("out", output ); 
-    }
-}; // end class getStack
+        if(record->uid != uid || record->pid == (uint32_t)self)
+          continue;
 
-KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(getStack)
+        snprintf(name, sizeof(name), "%s(%u)", hostname, record->pid);
+        sampleProcess(record->pid, output.addTask(name), output);
+      }
 
-struct stackGroup {
-  std::string name;
-  std::vector<std::string> stack;
-};
+// Once we have the stacks in the output variable we use the CBTF 
+// function emitOutput to send the output to where ever "out" is connected to.
+      emitOutput<StackTree>("out", output);
+    }
+}; // end class sampleStacks
 
-// check to see if two stacks (vector<string>) are the same
-int equalStack(std::vector<std::string> vec1, std::vector<std::string> vec2)
-{
-  int ret = 0;
-  // are they the smae lenght?
-  if(vec1.size() == vec2.size())
-  {
-    ret = 1;
-//    for(std::vector<std::string>::const_iterator str1 = vec1.begin(), std::vector<std::string>::const_iterator str2 = vec2.begin(); str1 != vec1.end(); ++str1, ++str2)
-    for(int i = 0; i < vec1.size(); i++)
-    {
-      // make sure each line is the same
-      // if not stop looking and return 0
-//      if(*str1 != *str2)
-      if(vec1[i] != vec2[i])
-      {
-        ret = 0;
-        break;
-      }
-    }//end for
-  }//end if size == size
+// This macro is needed to end the definition of the component.
+KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(sampleStacks)
 
-  return ret;
-}
 
 /**
- *  * Filter used to group the same stack traces together
- *   */
-class __attribute__ ((visibility ("hidden"))) groupStack :
+ * Filter used to merge the stack trees of every child into one, so that each
+ * unique call path is sent up the tree once along with the tasks that share it.
+ */
+class __attribute__ ((visibility ("hidden"))) mergeStacks :
     public Component
 {
 
@@ -262,133 +349,41 @@ public:
     static Component::Instance factoryFunction()
     {
         return Component::Instance(
-          reinterpret_cast<Component*>(new groupStack())
+          reinterpret_cast<Component*>(new mergeStacks())
         );
     }
 
 private:
     // variables
-    int runNum;
-    int nodes;
-    std::vector<std::string> output;
-    std::vector<stackGroup> tempIn;
-    std::vector<stackGroup> tempOut;
+    int children;
+    StackTree merged;
 
     /** Default constructor. */
-    groupStack() :
-        Component(Type(typeid(groupStack)), Version(1, 0, 0))
+    mergeStacks() :
+        Component(Type(typeid(mergeStacks)), Version(1, 0, 0))
     {
-        declareInput<std::vector<std::string> >(
-            "in", boost::bind(&groupStack::inHandler, this, _1)
+        declareInput<StackTree>(
+            "in", boost::bind(&mergeStacks::inHandler, this, _1)
             );
-        declareOutput<std::vector<std::string> >("out");
+        declareOutput<StackTree>("out");
 
         // variables
-        runNum = 0;
-        nodes = 1;
-        output.clear();
-        tempIn.clear();
-        tempOut.clear();
+        children = 0;
     }
 
     /** Handler for the "in" input.*/
-    void inHandler(const std::vector<std::string>& in)
+    void inHandler(const StackTree& in)
     { 
-      std::string name;
-      std::string tmpstr;
-      stackGroup *stk;
-      int stack = 0;
-      int match = 0;
-
-      //reset the output on the first run
-      //can't reset it after you emitoutput because because it is bound to it
-      if(runNum == 0) {
-        output.clear();
-        tempIn.clear();
-        tempOut.clear();
-      }
-      // only emit output when all nodes have replied.
-      runNum++;
+      merged.merge(in);
 
-      // save the in for each node in inVec then search it when all nodes 
-      // have responded
-      for(std::vector<std::string>::const_iterator str = in.begin(); str != in.end(); ++str)
+      // only emit output when all children have replied.
+      if(++children >= TOTAL_CHILDREN)
       {
-        // are we reading the stack or the hostname or STOP
-        // if stack = 0 this is the hostname
-        // make a new stackGroup and save the hostname then set the stack
-        //   var so you continue reading in the stack until you hit STOP 
-        if(stack == 0) 
-        {
-          // make a new stackGroup for this stack trace
-          stk = new stackGroup;
-          // save the hostname(PID)
-          stk->name = *str;
-          // set it up to now read in the stack
-          stack = 1;
-        }
-        else 
-        { // stack == 1 so read in the stack
-          // the stack for this hostname(PID) stops at STOP
-          if(*str != "STOP")
-          {  // this is the stack save it in stk.stack      
-            stk->stack.push_back(*str);
-          }
-          else 
-          { // we hit STOP then end of this stack
-            // save the stackGroup stk
-            tempIn.push_back(*stk);
-            // reset stack var to get hostname of next stack
-            stack = 0;
-          }//end else *str == STOP
-        }//end else stack
-      }//end for in
-
-      // once all nodes have responded search through the inVec to group
-      // together the same stack traces
-      if(runNum >= nodes) {
-        for(std::vector<stackGroup>::const_iterator stkIn = tempIn.begin(); stkIn != tempIn.end(); ++stkIn)
-        {  // loop through tempIn group similar stacks together in tempOut 
-          // reset match
-          match = 0;
-          for(std::vector<stackGroup>::iterator stkOut = tempOut.begin(); stkOut != tempOut.end(); ++stkOut)
-          {
-            //are these the same stacks?
-            if( equalStack(stkIn->stack,stkOut->stack) )
-            {
-              tmpstr = "";
-              tmpstr += stkOut->name.substr(0,stkOut->name.rfind("\n"));
-              tmpstr += " ";
-              tmpstr += stkIn->name.substr(0,stkIn->name.rfind("\n"));
-              tmpstr += "\n";
-              stkOut->name = tmpstr;
-              match = 1;
-              break;
-            }
-          }//end for tempOut
-
-          // if match == 0 the this is a unique stack and need to save it
-          if(match == 0)
-          {
-            tempOut.push_back(*stkIn);
-          }
-        }//end for stkIn
-      }//end if runNum >= nodes
-
-      // convert the tempOut vector of stackGroups to a flat vector of strings
-      for(std::vector<stackGroup>::const_iterator stkOut = tempOut.begin(); stkOut != tempOut.end(); ++stkOut)
-      {
-        output.push_back(stkOut->name);
-        for(std::vector<std::string>::const_iterator str = stkOut->stack.begin(); str != stkOut->stack.end(); ++str)
-        {
-          output.push_back(*str);
-        }//end for str
-        
-        output.push_back("----------\n");
-      }//end for stkOut
-
-      emitOutput<std::vector <std::string> >("out", output ); 
+        emitOutput<StackTree>("out", merged);
+        merged = StackTree();
+        children = 0;
+      }
     }
-}; // end class groupStack
+}; // end class mergeStacks
 
-KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(groupStack)
+KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(mergeStacks)
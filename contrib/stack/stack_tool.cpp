@@ -42,18 +42,135 @@
 #include <KrellInstitute/CBTF/Version.hpp>
 #include <KrellInstitute/CBTF/XML.hpp>
 
+// The stacks are symbolized here, in the frontend, with the SymtabAPI 
+// symbols code from the cbtf-krell core library.
+#include <KrellInstitute/Core/Address.hpp>
+#include <KrellInstitute/Core/AddressBuffer.hpp>
+#include <KrellInstitute/Core/AddressRange.hpp>
+#include <KrellInstitute/Core/LinkedObjectEntry.hpp>
+#include <KrellInstitute/Core/SymbolTable.hpp>
+#include <KrellInstitute/Core/SymtabAPISymbols.hpp>
+
+#include <cxxabi.h>
 #include <iostream>
+#include <limits.h>
 #include <map>
 #include <set>
 #include <stdexcept>
+#include <stdlib.h>
 #include <string>
 #include <stdio.h>
 #include <sstream>
 #include <unistd.h>
 #include <vector>
 
+#include "StackTree.hpp"
+
 // we work in the KrellInstitute::CBTF name space
 using namespace KrellInstitute::CBTF;
+using namespace KrellInstitute::Core;
+
+// Find the name of the function containing each frame of the tree of stacks.
+// The frames are offsets within the linked objects containing them, so each 
+// linked object is looked up at the address where one of the backends found 
+// it loaded, with all of its frames at once.  Frames that are not within a 
+// function are named by their linked object and offset, or their address.
+static void getFrameNames(const StackTree& tree, std::vector<std::string>& names)
+{
+  const std::vector<StackTree::Module>& modules = tree.getModules();
+  const std::vector<StackTree::Node>& nodes = tree.getNodes();
+
+  std::vector<AddressBuffer> buffers(modules.size());
+  for(size_t i = 1; i < nodes.size(); ++i)
+  {
+    uint64_t module = StackTree::getModule(nodes[i].frame);
+    if(module < modules.size())
+      buffers[module].updateAddressCounts(
+        modules[module].begin + StackTree::getOffset(nodes[i].frame), 1);
+  }
+
+  SymtabAPISymbols symbols;
+  std::vector<std::map<AddressRange, std::string> > functions(modules.size());
+  for(size_t m = 0; m < modules.size(); ++m)
+  {
+    if(buffers[m].addresscounts.empty())
+      continue;
+
+    LinkedObjectEntry linkedobject;
+    linkedobject.path = modules[m].path;
+    linkedobject.addr_begin = Address(modules[m].begin);
+    linkedobject.addr_end = Address(modules[m].end);
+
+    SymbolTable st(linkedobject.getAddressRange());
+    symbols.getSymbols(buffers[m], linkedobject, st);
+    functions[m] = st.getFunctions();
+  }
+
+  names.assign(nodes.size(), std::string());
+  char buffer[PATH_MAX + 32];
+  for(size_t i = 1; i < nodes.size(); ++i)
+  {
+    uint64_t module = StackTree::getModule(nodes[i].frame);
+    unsigned long long offset = StackTree::getOffset(nodes[i].frame);
+    if(module >= modules.size())
+    {
+      snprintf(buffer, sizeof(buffer), "0x%llx", offset);
+      names[i] = buffer;
+      continue;
+    }
+
+    // The function map finds the function overlapping the given range.
+    Address address(modules[module].begin + offset);
+    std::map<AddressRange, std::string>::const_iterator f =
+      functions[module].find(AddressRange(address, Address(address.getValue() + 1)));
+    if(f == functions[module].end())
+    {
+      const std::string& path = modules[module].path;
+      snprintf(buffer, sizeof(buffer), "%s+0x%llx",
+               path.substr(path.rfind('/') + 1).c_str(), offset);
+      names[i] = buffer;
+      continue;
+    }
+
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(f->second.c_str(), NULL, NULL, &status);
+    names[i] = (status == 0 && demangled != NULL) ? demangled : f->second;
+    free(demangled);
+  }
+}
+
+// Print a node of the tree of stacks, and the nodes below it, indented by 
+// their depth.  Each node shows how many tasks have a stack through it, and 
+// which ones where they differ from those of its caller.
+static void printTree(const StackTree& tree,
+                      const std::vector<std::vector<uint32_t> >& children,
+                      const std::vector<std::string>& names,
+                      uint32_t node, unsigned depth)
+{
+  const StackTree::Node& n = tree.getNodes()[node];
+  size_t count = n.tasks.count();
+
+  std::cout << std::string(2 * depth, ' ')
+            << (node == StackTree::Root ? "all" : names[node])
+            << " [" << count << "]";
+  if(node == StackTree::Root || children[node].empty() ||
+     count != tree.getNodes()[n.parent].tasks.count())
+  {
+    for(StackTree::TaskSet::size_type
+          t = n.tasks.find_first(); t != StackTree::TaskSet::npos;
+          t = n.tasks.find_next(t))
+    {
+      std::cout << " " << tree.getTasks()[t];
+    }
+  }
+  std::cout << "\n";
+
+  for(std::vector<uint32_t>::const_iterator
+        i = children[node].begin(); i != children[node].end(); ++i)
+  {
+    printTree(tree, children, names, *i, depth + 1);
+  }
+}
 
 // This is the main function for the Tool, it will take the name of the 
 // MPI application as a command line argument.
@@ -104,11 +221,11 @@ int main(int argc,  char *argv[ ])
   Component::connect(input_value_component, "value", network, "in");
 
   // Create the final output from the CBTF network, which will be the 
-  // group of stack traces from the MPI application.  Again we start by 
+  // merged tree of stack traces from the MPI application.  Again we start by 
   // making a boost shared pointer, turn it into a CBTF component then 
   // create a connection.  We will see in the XML file where the output 
   // value "out" is defined in the network.
-  boost::shared_ptr<ValueSink<std::vector<std::string> > > output_value = ValueSink<std::vector<std::string> >::instantiate();
+  boost::shared_ptr<ValueSink<StackTree> > output_value = ValueSink<StackTree>::instantiate();
   Component::Instance output_value_component = boost::reinterpret_pointer_cast<Component>(output_value);
   Component::connect(network, "out", output_value_component, "value");
 
@@ -127,16 +244,31 @@ int main(int argc,  char *argv[ ])
 
   // Because output_value is a Boost variable this call is blocking 
   // until a value is sent up the MRNet tree to the output "out" from 
-  // the network.  The stack traces are returned as a vector of strings.
-  std::vector<std::string> output = *output_value;
+  // the network.  The stack traces are returned as a tree with a node 
+  // for each unique call path, and the set of tasks on that path.
+  StackTree output = *output_value;
 
+  // Now the frames of the tree are turned into function names, and the 
+  // tree is shown to the user with each call path indented below its caller.
+  std::vector<std::string> names;
+  getFrameNames(output, names);
+
+  const std::vector<StackTree::Node>& nodes = output.getNodes();
+  std::vector<std::vector<uint32_t> > children(nodes.size());
+  for(uint32_t i = 1; i < nodes.size(); ++i)
+  {
+    children[nodes[i].parent].push_back(i);
+  }
+  printTree(output, children, names, StackTree::Root, 0);
 
-  // Now the vector of strings output which contains all the stack 
-  // trace information is simply shown to the user.
-  for(std::vector<std::string>::const_iterator i = output.begin(); 
-        i != output.end(); ++i)
+  // Any process that exited, or could not be attached to, has no stack.
+  for(uint32_t t = 0; t < output.getTasks().size(); ++t)
   {
-    std::cout << *i;
+    if(t >= nodes[StackTree::Root].tasks.size() ||
+       !nodes[StackTree::Root].tasks.test(t))
+    {
+      std::cout << "no stack " << output.getTasks()[t] << "\n";
+    }
   }
 
   return 0;
@@ -263,8 +263,10 @@ static void initialize_data(TLS* tls)
     tls->data.count.count_len = 0;
 
     /* Re-initialize the sampling buffer */
-    memset(tls->buffer.stacktraces, 0, sizeof(tls->buffer.stacktraces));
-    memset(tls->buffer.count, 0, sizeof(tls->buffer.count));
+    tls->buffer.addr_begin = ~0;
+    tls->buffer.addr_end = 0;
+    tls->buffer.length = 0;
+    memset(tls->buffer.hash_table, 0, sizeof(tls->buffer.hash_table));
 }
 
 
@@ -331,6 +333,11 @@ static void send_samples(TLS *tls)
     tls->header.rank = monitor_mpi_comm_rank();
 #endif
 
+    tls->header.addr_begin = tls->buffer.addr_begin;
+    tls->header.addr_end = tls->buffer.addr_end;
+    tls->data.stacktraces.stacktraces_len = tls->buffer.length;
+    tls->data.count.count_len = tls->buffer.length;
+
 #ifndef NDEBUG
 	if (IsCollectorDebugEnabled) {
 	    fprintf(stderr, "[%ld,%d] hwctime send_samples: time_range(%lu,%lu) addr range[%lx, %lx] stacktraces_len(%d) count_len(%d)\n",
@@ -382,7 +389,6 @@ hwctimePAPIHandler(int EventSet, void *address, long_long overflow_vector, void*
     }
  
     unsigned int framecount = 0;
-    int stackindex = 0;
     uint64_t framebuf[CBTF_USERTIME_MAXFRAMES];
 
     memset(framebuf,0, sizeof(framebuf));
@@ -467,75 +473,11 @@ hwctimePAPIHandler(int EventSet, void *address, long_long overflow_vector, void*
     }
 #endif // if defined (HAVE_OMPT)
 
-    bool_t stack_already_exists = FALSE;
-
-    unsigned int i, j;
-    /* search individual stacks via count/indexing array */
-    for (i = 0; i < tls->data.count.count_len ; i++ )
-    {
-	/* a count > 0 indexes the top of stack in the data buffer. */
-	/* a count == 255 indicates this stack is at the count limit. */
-
-	if (tls->buffer.count[i] == 0) {
-	    continue;
-	}
-	if (tls->buffer.count[i] == 255) {
-	    continue;
-	}
-
-	/* see if the stack addresses match */
-	for (j = 0; j < framecount ; j++ )
-	{
-	    if ( tls->buffer.stacktraces[i+j] != framebuf[j] ) {
-		   break;
-	    }
-	}
-
-	if ( j == framecount) {
-	    stack_already_exists = TRUE;
-	    stackindex = i;
-	}
-    }
-
-    /* if the stack already exisits in the buffer, update its count
-     * and return. If the stack is already at the count limit.
-    */
-    if (stack_already_exists && tls->buffer.count[stackindex] < 255 ) {
-	/* update count for this stack */
-	tls->buffer.count[stackindex] = tls->buffer.count[stackindex] + 1;
-	return;
-    }
-
-    /* sample buffer has no room for these stack frames.*/
-    int buflen = tls->data.stacktraces.stacktraces_len + framecount;
-    if ( buflen > CBTF_USERTIME_BUFFERSIZE) {
-	/* send the current sample buffer. (will init a new buffer) */
+    /* Add the stack, sending the sample buffer first if it has no room */
+    if(CBTF_UpdateStackTraceBuffer(framebuf, framecount, &tls->buffer)) {
         tls->header.time_end = CBTF_GetTime();
 	send_samples(tls);
-    }
-
-    /* add frames to sample buffer, compute addresss range */
-    for (i = 0; i < framecount ; i++)
-    {
-	/* always add address to buffer bt */
-	tls->buffer.stacktraces[tls->data.stacktraces.stacktraces_len] = framebuf[i];
-
-	/* top of stack indicated by a positive count. */
-	/* all other elements are 0 */
-	if (i > 0 ) {
-	    tls->buffer.count[tls->data.count.count_len] = 0;
-	} else {
-	    tls->buffer.count[tls->data.count.count_len] = 1;
-	}
-
-	if (framebuf[i] < tls->header.addr_begin ) {
-	    tls->header.addr_begin = framebuf[i];
-	}
-	if (framebuf[i] > tls->header.addr_end ) {
-	    tls->header.addr_end = framebuf[i];
-	}
-	tls->data.stacktraces.stacktraces_len++;
-	tls->data.count.count_len++;
+	CBTF_UpdateStackTraceBuffer(framebuf, framecount, &tls->buffer);
     }
 }
 
@@ -761,7 +703,7 @@ void cbtf_collector_stop()
     tls->header.time_end = CBTF_GetTime();
 
     /* Are there any unsent samples? */
-    if(tls->data.stacktraces.stacktraces_len > 0) {
+    if(tls->buffer.length > 0) {
 	/* Send these samples */
 	send_samples(tls);
     }
@@ -58,4 +58,22 @@
 
 #endif
 
+/**
+ * Every function wrapped by the IO collector. Expands into the identifiers
+ * that the wrappers pass to io_do_trace(), which index the bitmask of traced
+ * functions built from the traced function list when collection starts.
+ */
+#define CBTF_IO_TRACEABLE_FUNCTIONS(F) \
+    F(close) F(creat) F(creat64) F(dup) F(dup2) F(lseek) F(lseek64) F(open) \
+    F(open64) F(pipe) F(pread) F(pread64) F(pwrite) F(pwrite64) F(read) \
+    F(readv) F(write) F(writev)
+
+/** Identifiers of the functions wrapped by the IO collector. */
+typedef enum {
+#define CBTF_IO_TRACEABLE_ID(name) CBTF_IOTraceable_##name,
+    CBTF_IO_TRACEABLE_FUNCTIONS(CBTF_IO_TRACEABLE_ID)
+#undef CBTF_IO_TRACEABLE_ID
+    CBTF_IOTraceableFunctionCount
+} CBTF_IOTraceableFunction;
+
 #endif
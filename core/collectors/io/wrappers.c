@@ -31,6 +31,7 @@
 #include "KrellInstitute/Services/Assert.h"
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Services/Time.h"
+#include "IOTraceableFunctions.h"
 
 
 #if !defined(CBTF_SERVICE_USE_OFFLINE)
@@ -57,7 +58,7 @@ extern void io_start_event(CBTF_io_event*);
 #endif
 #endif
 
-extern bool_t io_do_trace(const char*);
+extern bool_t io_do_trace(CBTF_IOTraceableFunction);
 
 
 /* Start part 2 of 2 for Hack to get around inconsistent syscall definitions */
@@ -153,14 +154,14 @@ ssize_t ioread(int fd, void *buf, size_t count)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("read");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_read);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -175,9 +176,9 @@ ssize_t ioread(int fd, void *buf, size_t count)
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_read;
@@ -255,14 +256,14 @@ ssize_t iowrite(int fd, void *buf, size_t count)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("write");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_write);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -278,11 +279,11 @@ ssize_t iowrite(int fd, void *buf, size_t count)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_write;
@@ -354,14 +355,14 @@ off_t iolseek(int fd, off_t offset, int whence)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("lseek");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_lseek);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -377,10 +378,10 @@ off_t iolseek(int fd, off_t offset, int whence)
     if (dotrace) {
 #if defined(PROFILE)
 
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_lseek;
@@ -450,14 +451,14 @@ off_t iolseek64(int fd, off_t offset, int whence)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("lseek64");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_lseek64);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -473,9 +474,9 @@ off_t iolseek64(int fd, off_t offset, int whence)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_lseek;
@@ -541,14 +542,14 @@ int ioopen(const char *pathname, int flags, mode_t mode)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("open");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_open);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -564,9 +565,9 @@ int ioopen(const char *pathname, int flags, mode_t mode)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.retval = retval;
@@ -619,14 +620,14 @@ int ioopen64(const char *pathname, int flags, mode_t mode)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("open64");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_open64);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -642,9 +643,9 @@ int ioopen64(const char *pathname, int flags, mode_t mode)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_open;
@@ -701,14 +702,14 @@ int ioclose(int fd)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("close");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_close);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
 	/* use that to get the path into /proc. */
@@ -740,10 +741,10 @@ int ioclose(int fd)
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_close;
@@ -797,14 +798,14 @@ int iodup(int oldfd)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("dup");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_dup);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -819,10 +820,10 @@ int iodup(int oldfd)
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_dup;
@@ -891,14 +892,14 @@ int iodup2(int oldfd, int newfd)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("dup2");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_dup2);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -913,10 +914,10 @@ int iodup2(int oldfd, int newfd)
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_dup2;
@@ -980,14 +981,14 @@ int iocreat(char *pathname, mode_t mode)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("creat");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_creat);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1003,9 +1004,9 @@ int iocreat(char *pathname, mode_t mode)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.retval = retval;
@@ -1056,14 +1057,14 @@ int iocreat64(char *pathname, mode_t mode)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("creat64");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_creat64);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1079,9 +1080,9 @@ int iocreat64(char *pathname, mode_t mode)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_creat;
@@ -1132,14 +1133,14 @@ int iopipe(int filedes[2])
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("pipe");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_pipe);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1155,9 +1156,9 @@ int iopipe(int filedes[2])
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_pipe;
@@ -1205,14 +1206,14 @@ ssize_t iopread(int fd, void *buf, size_t count, off_t offset)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("pread");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_pread);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1228,9 +1229,9 @@ ssize_t iopread(int fd, void *buf, size_t count, off_t offset)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
 #if   defined(__linux) && defined(SYS_pread)
@@ -1294,14 +1295,14 @@ ssize_t iopread64(int fd, void *buf, size_t count, off_t offset)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("pread64");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_pread64);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1316,10 +1317,10 @@ ssize_t iopread64(int fd, void *buf, size_t count, off_t offset)
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
 #if   defined(__linux) && defined(SYS_pread)
@@ -1398,14 +1399,14 @@ ssize_t iopwrite(int fd, void *buf, size_t count, off_t offset)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("pwrite");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_pwrite);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1421,9 +1422,9 @@ ssize_t iopwrite(int fd, void *buf, size_t count, off_t offset)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
 #if   defined(__linux) && defined(SYS_pwrite)
@@ -1502,14 +1503,14 @@ ssize_t iopwrite64(int fd, void *buf, size_t count, off_t offset)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("pwrite64");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_pwrite64);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1525,9 +1526,9 @@ ssize_t iopwrite64(int fd, void *buf, size_t count, off_t offset)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
 #if   defined(__linux) && defined(SYS_pwrite)
@@ -1607,14 +1608,14 @@ ssize_t ioreadv(int fd, const struct iovec *vector, int count)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("readv");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_readv);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1630,9 +1631,9 @@ ssize_t ioreadv(int fd, const struct iovec *vector, int count)
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_readv;
@@ -1702,14 +1703,14 @@ ssize_t iowritev(int fd, const struct iovec *vector, int count)
 #endif
 #endif
 
-    bool_t dotrace = io_do_trace("writev");
+    bool_t dotrace = io_do_trace(CBTF_IOTraceable_writev);
 
     if (dotrace) {
 	io_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-	event.start_time = CBTF_GetTime();
+	event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -1724,10 +1725,10 @@ ssize_t iowritev(int fd, const struct iovec *vector, int count)
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 
 #if defined(EXTENDEDTRACE)
     event.syscallno = SYS_writev;
@@ -43,4 +43,20 @@
 
 #endif
 
+/**
+ * Every function wrapped by the memory collector. Expands into the identifiers
+ * that the wrappers pass to mem_do_trace(), which index the bitmask of traced
+ * functions built from the traced function list when collection starts.
+ */
+#define CBTF_MEM_TRACEABLE_FUNCTIONS(F) \
+    F(malloc) F(free) F(memalign) F(posix_memalign) F(calloc) F(realloc)
+
+/** Identifiers of the functions wrapped by the memory collector. */
+typedef enum {
+#define CBTF_MEM_TRACEABLE_ID(name) CBTF_MemTraceable_##name,
+    CBTF_MEM_TRACEABLE_FUNCTIONS(CBTF_MEM_TRACEABLE_ID)
+#undef CBTF_MEM_TRACEABLE_ID
+    CBTF_MemTraceableFunctionCount
+} CBTF_MemTraceableFunction;
+
 #endif
@@ -90,6 +90,10 @@ const unsigned OverheadFrameCount = 2;
 /** allows for 6 unique stacktraces (384*8/512) */
 #define StackTraceBufferSize (CBTF_BlobSizeFactor * 384)
 
+/** Number of entries in the stack trace hash table. */
+#define StackTraceHashTableSize \
+	CBTF_StackTraceHashTableSize(StackTraceBufferSize)
+
 
 /** Number of event entries in the tracing buffer. */
 /** CBTF_mem_event is 32 bytes */
@@ -108,11 +112,13 @@ typedef struct {
     /** Tracing buffer. NOTE: using exended data memt for buffer*/
     struct {
 	uint64_t stacktraces[StackTraceBufferSize];  /**< Stack traces. */
+	unsigned hash_table[StackTraceHashTableSize]; /**< Stack trace hash table. */
 	CBTF_memt_event events[EventBufferSize];     /**< Mem call events. */
     } buffer;
 
 #if defined (CBTF_SERVICE_USE_OFFLINE)
-    char CBTF_mem_traced[PATH_MAX];
+    /** Bitmask of traced functions indexed by CBTF_MemTraceableFunction. */
+    uint64_t traced[(CBTF_MemTraceableFunctionCount + 63) / 64];
 #endif
     
     /** Nesting depth within the mem wrappers. */
@@ -154,6 +160,16 @@ void defer_trace(int defer_tracing) {
 }
 
 
+#if defined (CBTF_SERVICE_USE_OFFLINE)
+/** Names of the traceable functions indexed by CBTF_MemTraceableFunction. */
+static const char* TraceableFunctionNames[] = {
+#define CBTF_MEM_TRACEABLE_NAME(name) #name,
+    CBTF_MEM_TRACEABLE_FUNCTIONS(CBTF_MEM_TRACEABLE_NAME)
+#undef CBTF_MEM_TRACEABLE_NAME
+};
+#endif
+
+
 /**
  * Initialize the performance data header and blob contained within the given
  * thread-local storage. This function <em>must</em> be called before any of
@@ -180,6 +196,7 @@ static void initialize_data(TLS* tls)
 
     /* Re-initialize the sampling buffer */
     memset(tls->buffer.stacktraces, 0, sizeof(tls->buffer.stacktraces));
+    memset(tls->buffer.hash_table, 0, sizeof(tls->buffer.hash_table));
     memset(tls->buffer.events, 0, sizeof(tls->buffer.events));
 }
 
@@ -334,7 +351,7 @@ void mem_record_event(const CBTF_memt_event* event, uint64_t function)
 
     uint64_t stacktrace[MaxFramesPerStackTrace];
     unsigned stacktrace_size = 0;
-    unsigned entry = 0, start, i;
+    unsigned entry = 0, i;
 
     /* Decrement the Mem function wrapper nesting depth */
     --tls->nesting_depth;
@@ -371,41 +388,21 @@ void mem_record_event(const CBTF_memt_event* event, uint64_t function)
      * wrapper. On IA64, because OverheadFrameCount is one higher, it will be
      * the mini-tramp for the wrapper that is calling mem_record_event().
      */
-    if(stacktrace_size > 0)
-	stacktrace[0] = function;
+    /* A stack that could not be unwound is recorded as the function alone */
+    if(stacktrace_size == 0)
+	stacktrace_size = 1;
+    stacktrace[0] = function;
     
     /*
      * Search the tracing buffer for an existing stack trace matching the stack
-     * trace from the current thread context. For now do a simple linear search.
+     * trace from the current thread context. The stack trace hash table keeps
+     * the cost of this search independent of how full the buffer is.
      */
-    for(start = 0, i = 0;
-	(i < stacktrace_size) &&
-	    ((start + i) < tls->data.stacktraces.stacktraces_len);
-	++i)
-	
-	/* Do the i'th frames differ? */
-	if(stacktrace[i] != tls->buffer.stacktraces[start + i]) {
-	    
-	    /* Advance in the tracing buffer to the end of this stack trace */
-	    for(start += i;
-		(tls->buffer.stacktraces[start] != 0) &&
-		    (start < tls->data.stacktraces.stacktraces_len);
-		++start);
-	    
-	    /* Advance in the tracing buffer past the terminating zero */
-	    ++start;
-	    
-	    /* Begin comparing at the zero'th frame again */
-	    i = 0;
-	    
-	}
-    
-    /* Did we find a match in the tracing buffer? */
-    if(i == stacktrace_size)
-	entry = start;
-    
-    /* Otherwise add this stack trace to the tracing buffer */
-    else {
+    if(!CBTF_FindStackTrace(stacktrace, stacktrace_size,
+			    tls->buffer.stacktraces,
+			    tls->data.stacktraces.stacktraces_len, NULL,
+			    tls->buffer.hash_table, StackTraceHashTableSize,
+			    &entry)) {
 	
 	/* Send events if there is insufficient room for this stack trace */
 	if((tls->data.stacktraces.stacktraces_len + stacktrace_size + 1) >=
@@ -435,6 +432,10 @@ void mem_record_event(const CBTF_memt_event* event, uint64_t function)
 	
 	/* Set the new size of the tracing buffer */
 	tls->data.stacktraces.stacktraces_len += (stacktrace_size + 1);
+
+	/* Index the new stack trace in the stack trace hash table */
+	CBTF_AddStackTrace(stacktrace, stacktrace_size, entry,
+			   tls->buffer.hash_table, StackTraceHashTableSize);
 	
     }
     
@@ -508,9 +509,11 @@ void cbtf_collector_start(const CBTF_DataHeader* const header)
     const char* mem_traced = getenv("CBTF_MEM_TRACED");
 
     if (mem_traced != NULL && strcmp(mem_traced,"") != 0) {
-	strcpy(tls->CBTF_mem_traced,mem_traced);
+	CBTF_SetTracedFunctions(mem_traced, TraceableFunctionNames,
+				CBTF_MemTraceableFunctionCount, tls->traced);
     } else {
-	strcpy(tls->CBTF_mem_traced,traceable);
+	CBTF_SetTracedFunctions(traceable, TraceableFunctionNames,
+				CBTF_MemTraceableFunctionCount, tls->traced);
     }
 #endif
 
@@ -672,7 +675,7 @@ void cbtf_collector_stop()
 #endif
 }
 
-bool_t mem_do_trace(const char* traced_func)
+bool_t mem_do_trace(CBTF_MemTraceableFunction traced_func)
 {
     /* Access our thread-local storage */
 #ifdef USE_EXPLICIT_TLS
@@ -689,7 +692,6 @@ bool_t mem_do_trace(const char* traced_func)
 
 #if defined (CBTF_SERVICE_USE_OFFLINE)
 
-    int saved_do_trace = tls->do_trace;
     if (tls->do_trace == 0) {
 	if (tls->nesting_depth > 1)
 	    --tls->nesting_depth;
@@ -697,23 +699,8 @@ bool_t mem_do_trace(const char* traced_func)
     }
 
     /* See if this function has been selected for tracing */
-    char *tfptr, *saveptr, *tf_token;
-
-    tls->do_trace = 0;
-    tfptr = strdup(tls->CBTF_mem_traced);
-
-    int i;
-    for (i = 1;  ; i++, tfptr = NULL) {
-	tf_token = strtok_r(tfptr, ":,", &saveptr);
-	if (tf_token == NULL)
-	    break;
-	if ( strcmp(tf_token,traced_func) == 0) {
-	
-    	    if (tfptr)
-		free(tfptr);
-	    tls->do_trace = saved_do_trace;
-	    return TRUE;
-	}
+    if (tls->traced[traced_func / 64] & ((uint64_t)1 << (traced_func % 64))) {
+	return TRUE;
     }
 
     /* Remove any nesting due to skipping mem_start_event/mem_record_event for
@@ -723,7 +710,6 @@ bool_t mem_do_trace(const char* traced_func)
     if (tls->nesting_depth > 1)
 	--tls->nesting_depth;
 
-    tls->do_trace = saved_do_trace;
     return FALSE;
 #else
     /* Always return true for dynamic instrumentors since these collectors
@@ -29,6 +29,7 @@
 #include "KrellInstitute/Services/Assert.h"
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Services/Time.h"
+#include "MemTraceableFunctions.h"
 
 
 #if !defined(CBTF_SERVICE_USE_OFFLINE)
@@ -42,7 +43,7 @@
 #include <sys/uio.h>
 #include <stdlib.h>
 
-extern bool_t mem_do_trace(const char* traced_func);
+extern bool_t mem_do_trace(CBTF_MemTraceableFunction traced_func);
 extern void mem_start_event(CBTF_memt_event* event);
 extern void mem_record_event(const CBTF_memt_event* event, uint64_t function);
 
@@ -93,7 +94,7 @@ void* memmalloc(size_t size)
     void* retval;
     CBTF_memt_event event;
 
-    bool_t dotrace = mem_do_trace("malloc");
+    bool_t dotrace = mem_do_trace(CBTF_MemTraceable_malloc);
 
     if (dotrace) {
         mem_start_event(&event);
@@ -151,7 +152,7 @@ void* memcalloc(size_t count, size_t size)
     void* retval;
     CBTF_memt_event event;
 
-    bool_t dotrace = mem_do_trace("calloc");
+    bool_t dotrace = mem_do_trace(CBTF_MemTraceable_calloc);
 
     if (dotrace) {
         mem_start_event(&event);
@@ -211,7 +212,7 @@ void* memrealloc(void* oldPtr, size_t size)
     void* retval;
     CBTF_memt_event event;
 
-    bool_t dotrace = mem_do_trace("realloc");
+    bool_t dotrace = mem_do_trace(CBTF_MemTraceable_realloc);
 
     if (dotrace) {
         mem_start_event(&event);
@@ -267,7 +268,7 @@ int memposix_memalign(void ** memptr, size_t alignment, size_t size)
 
     CBTF_memt_event event;
 
-    bool_t dotrace = mem_do_trace("posix_memalign");
+    bool_t dotrace = mem_do_trace(CBTF_MemTraceable_posix_memalign);
 
     if (dotrace) {
         mem_start_event(&event);
@@ -325,7 +326,7 @@ int memmemalign(size_t blocksize, size_t bytes)
 #endif
     CBTF_memt_event event;
 
-    bool_t dotrace = mem_do_trace("memalign");
+    bool_t dotrace = mem_do_trace(CBTF_MemTraceable_memalign);
 
     if (dotrace) {
         mem_start_event(&event);
@@ -384,7 +385,7 @@ void memfree(void * ptr)
 #endif
     CBTF_memt_event event;
 
-    bool_t dotrace = mem_do_trace("free");
+    bool_t dotrace = mem_do_trace(CBTF_MemTraceable_free);
 
     /* when ptr is NULL free is a no-op. We could record these if desired
      * but the cost is high.  Only reason to record is to pinpoint the
@@ -358,18 +358,18 @@ MPI_Alltoallv:MPI_Barrier:MPI_Bcast:MPI_Bsend:MPI_Bsend_init:\
 MPI_Cancel:MPI_Cart_create:MPI_Cart_sub:MPI_Comm_create:\
 MPI_Comm_dup:MPI_Comm_free:MPI_Comm_idup:MPI_Comm_split:MPI_File_close:\
 MPI_File_delete:MPI_File_get_amode:MPI_File_get_group:MPI_File_get_info:\
-MPI_File_get_position:MPI_File_get_position_shared: \
+MPI_File_get_position:MPI_File_get_position_shared:\
 MPI_File_get_size:MPI_File_get_view:MPI_File_iread:MPI_File_iread_at:\
 MPI_File_iread_shared:MPI_File_iwrite:MPI_File_iwrite_at:\
 MPI_File_iwrite_shared:MPI_File_open:MPI_File_read:MPI_File_read_all:\
-MPI_File_read_at:MPI_File_read_at_all:MPI_File_read_ordered:MPI_File_seek:\
-MPI_File_seek_shared:MPI_File_set_info:MPI_File_set_size:MPI_File_set_view:\
-MPI_File_write:MPI_File_write_all:MPI_File_write_at:MPI_File_write_at_all:\
-MPI_File_write_ordered:MPI_File_write_shared:MPI_Finalize:\
+MPI_File_read_at:MPI_File_read_at_all:MPI_File_read_ordered:MPI_File_read_shared:\
+MPI_File_seek:MPI_File_seek_shared:MPI_File_set_info:MPI_File_set_size:\
+MPI_File_set_view:MPI_File_write:MPI_File_write_all:MPI_File_write_at:\
+MPI_File_write_at_all:MPI_File_write_ordered:MPI_File_write_shared:MPI_Finalize:\
 MPI_Gather:MPI_Gatherv:MPI_Get_count:MPI_Graph_create:\
 MPI_Iallgather:MPI_Iallgatherv:MPI_Iallreduce:MPI_Ialltoall:\
 MPI_Ialltoallv:MPI_Ialltoallw:MPI_Ibarrier:MPI_Ibcast:\
-MPI_Ibsend:MPI_Iexscan:MPI_Igather:MPI_Ibsend:MPI_Improbe:\
+MPI_Ibsend:MPI_Iexscan:MPI_Igather:MPI_Igatherv:MPI_Improbe:\
 MPI_Imrecv:MPI_Ineighbor_allgather:MPI_Ineighbor_allgatherv:\
 MPI_Ineighbor_alltoall:MPI_Ineighbor_alltoallv:MPI_Ineighbor_alltoallw:\
 MPI_Init:MPI_Intercomm_create:MPI_Intercomm_merge:\
@@ -378,7 +378,48 @@ MPI_Irsend:MPI_Iscan:MPI_Iscatter:MPI_Iscatterv:MPI_Isend:MPI_Issend:\
 MPI_Pack:MPI_Probe:MPI_Recv:MPI_Recv_init:MPI_Reduce:\
 MPI_Reduce_scatter:MPI_Request_free:MPI_Rsend:MPI_Rsend_init:\
 MPI_Scan:MPI_Scatter:MPI_Scatterv:MPI_Send:MPI_Sendrecv:\
-MPI_Sendrecv_replace:MPI_Ssend:MPI_Ssend_init:MPI_Start:\
+MPI_Send_init:MPI_Sendrecv_replace:MPI_Ssend:MPI_Ssend_init:MPI_Start:\
 MPI_Startall:MPI_Test:MPI_Testall:MPI_Testany:MPI_Testsome:\
 MPI_Unpack:MPI_Wait:MPI_Waitall:MPI_Waitany:MPI_Waitsome";
 
+/**
+ * Every function wrapped by the MPI collector, without the "MPI_" prefix.
+ * Expands into the identifiers that the wrappers pass to mpi_do_trace(), which
+ * index the bitmask of traced functions built from the traced function list
+ * when collection starts.
+ */
+#define CBTF_MPI_TRACEABLE_FUNCTIONS(F) \
+    F(Allgather) F(Allgatherv) F(Allreduce) F(Alltoall) F(Alltoallv) \
+    F(Barrier) F(Bcast) F(Bsend) F(Bsend_init) F(Cancel) F(Cart_create) \
+    F(Cart_sub) F(Comm_create) F(Comm_dup) F(Comm_free) F(Comm_split) \
+    F(File_close) F(File_delete) F(File_get_amode) F(File_get_group) \
+    F(File_get_info) F(File_get_position) F(File_get_position_shared) \
+    F(File_get_size) F(File_get_view) F(File_iread) F(File_iread_at) \
+    F(File_iread_shared) F(File_iwrite) F(File_iwrite_at) \
+    F(File_iwrite_shared) F(File_open) F(File_read) F(File_read_all) \
+    F(File_read_at) F(File_read_at_all) F(File_read_ordered) \
+    F(File_read_shared) F(File_seek) F(File_seek_shared) F(File_set_info) \
+    F(File_set_size) F(File_set_view) F(File_write) F(File_write_all) \
+    F(File_write_at) F(File_write_at_all) F(File_write_ordered) \
+    F(File_write_shared) F(Finalize) F(Gather) F(Gatherv) F(Get_count) \
+    F(Graph_create) F(Ibsend) F(Init) F(Intercomm_create) F(Intercomm_merge) \
+    F(Iprobe) F(Irecv) F(Irsend) F(Isend) F(Issend) F(Pack) F(Probe) F(Recv) \
+    F(Recv_init) F(Reduce) F(Reduce_scatter) F(Request_free) F(Rsend) \
+    F(Rsend_init) F(Scan) F(Scatter) F(Scatterv) F(Send) F(Sendrecv) \
+    F(Sendrecv_replace) F(Ssend) F(Ssend_init) F(Start) F(Startall) F(Test) \
+    F(Testall) F(Testany) F(Testsome) F(Unpack) F(Wait) F(Waitall) \
+    F(Waitany) F(Waitsome) F(Iallgather) F(Iallgatherv) F(Iallreduce) \
+    F(Ialltoall) F(Ialltoallv) F(Ialltoallw) F(Ibarrier) F(Ibcast) \
+    F(Iexscan) F(Igather) F(Igatherv) F(Improbe) F(Imrecv) \
+    F(Ineighbor_allgather) F(Ineighbor_allgatherv) F(Ineighbor_alltoall) \
+    F(Ineighbor_alltoallv) F(Ineighbor_alltoallw) F(Ireduce) \
+    F(Ireduce_scatter) F(Ireduce_scatter_block) F(Comm_idup) F(Iscan) \
+    F(Iscatter) F(Iscatterv) F(Send_init)
+
+/** Identifiers of the functions wrapped by the MPI collector. */
+typedef enum {
+#define CBTF_MPI_TRACEABLE_ID(name) CBTF_MPITraceable_##name,
+    CBTF_MPI_TRACEABLE_FUNCTIONS(CBTF_MPI_TRACEABLE_ID)
+#undef CBTF_MPI_TRACEABLE_ID
+    CBTF_MPITraceableFunctionCount
+} CBTF_MPITraceableFunction;
@@ -46,12 +46,16 @@
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Services/Context.h"
 #include "KrellInstitute/Services/Data.h"
+#if defined(CBTF_SERVICE_USE_FILEIO)
+#include "KrellInstitute/Services/Fileio.h"
+#endif
 #include "KrellInstitute/Services/Time.h"
 #include "KrellInstitute/Services/Timer.h"
 #include "KrellInstitute/Services/Unwind.h"
 #include "KrellInstitute/Services/TLS.h"
 #include "MPITraceableFunctions.h"
 #include "monitor.h"
+#include <pthread.h>
 
 
 /** String uniquely identifying this collector. */
@@ -106,6 +110,10 @@ const unsigned OverheadFrameCount = 2;
 #define StackTraceBufferSize (CBTF_BlobSizeFactor * 384)
 #endif
 
+/** Number of entries in the stack trace hash table. */
+#define StackTraceHashTableSize \
+	CBTF_StackTraceHashTableSize(StackTraceBufferSize)
+
 
 /** Number of event entries in the tracing buffer. */
 /** CBTF_mpi_event is 32 bytes */
@@ -115,6 +123,21 @@ const unsigned OverheadFrameCount = 2;
 #define EventBufferSize (CBTF_BlobSizeFactor * 415)
 #endif
 
+#if defined(CBTF_SERVICE_USE_FILEIO) && !defined(PROFILE) && !defined(EXTENDEDTRACE)
+/**
+ * Events are handed off to the raw event encoder thread rather than recorded
+ * by the MPI function wrappers when CBTF_RAW_EVENTS is set in the environment.
+ */
+#define RAW_EVENTS 1
+
+#if MaxFramesPerStackTrace > CBTF_RawEventMaxFrames
+#error "MaxFramesPerStackTrace exceeds CBTF_RawEventMaxFrames"
+#endif
+
+static pthread_once_t raw_encoder_once = PTHREAD_ONCE_INIT;
+static bool raw_encoder_started = false;
+#endif
+
 /** Type defining the items stored in thread-local storage. */
 typedef struct {
 
@@ -133,12 +156,14 @@ typedef struct {
 #if defined(PROFILE)
     struct {
         uint64_t stacktraces[StackTraceBufferSize];  /**< Stack traces. */
+        unsigned hash_table[StackTraceHashTableSize]; /**< Stack trace hash table. */
         uint64_t time[StackTraceBufferSize];  /**< Stack traces. */
         uint8_t count[StackTraceBufferSize];  /**< Stack traces. */
     } buffer;
 #else
     struct {
         uint64_t stacktraces[StackTraceBufferSize]; /**< Stack traces. */
+        unsigned hash_table[StackTraceHashTableSize]; /**< Stack trace hash table. */
 #if defined(EXTENDEDTRACE)
         CBTF_mpit_event events[EventBufferSize];    /**< MPI call events with details. */
 #else
@@ -148,13 +173,19 @@ typedef struct {
 #endif
     
 #if defined (CBTF_SERVICE_USE_OFFLINE)
-    char CBTF_mpi_traced[PATH_MAX];
+    /** Bitmask of traced functions indexed by CBTF_MPITraceableFunction. */
+    uint64_t traced[(CBTF_MPITraceableFunctionCount + 63) / 64];
 #endif
     
     /** Nesting depth within the MPI function wrappers. */
     unsigned nesting_depth;
     bool_t do_trace;
     bool_t defer_sampling;
+
+#if defined(RAW_EVENTS)
+    /** Tracing buffer of the raw event encoder (or NULL if not in use). */
+    CBTF_RawTrace* raw;
+#endif
 } TLS;
 
 /* debug flags */
@@ -200,6 +231,16 @@ void defer_trace(int defer_tracing) {
 }
 
 
+#if defined (CBTF_SERVICE_USE_OFFLINE)
+/** Names of the traceable functions indexed by CBTF_MPITraceableFunction. */
+static const char* TraceableFunctionNames[] = {
+#define CBTF_MPI_TRACEABLE_NAME(name) "MPI_" #name,
+    CBTF_MPI_TRACEABLE_FUNCTIONS(CBTF_MPI_TRACEABLE_NAME)
+#undef CBTF_MPI_TRACEABLE_NAME
+};
+#endif
+
+
 /**
  * Initialize the performance data header and blob contained within the given
  * thread-local storage. This function <em>must</em> be called before any of
@@ -233,6 +274,7 @@ static void initialize_data(TLS* tls)
 
     /* Re-initialize the sampling buffer */
     memset(tls->buffer.stacktraces, 0, sizeof(tls->buffer.stacktraces));
+    memset(tls->buffer.hash_table, 0, sizeof(tls->buffer.hash_table));
 #if defined(PROFILE)
     memset(tls->buffer.count, 0, sizeof(tls->buffer.count));
     memset(tls->buffer.time, 0, sizeof(tls->buffer.time));
@@ -289,6 +331,41 @@ inline void update_header_with_address(TLS* tls, uint64_t addr)
 }
 
 
+/**
+ * Convert the ticks recorded in the tracing buffer to times (or durations).
+ * Done only when the events are sent, never as they are recorded, and against
+ * the same calibration for every event so that none ends before it starts.
+ *
+ * @param tls    Thread-local storage whose tracing buffer is to be converted.
+ */
+static void convert_ticks(TLS* tls)
+{
+    CBTF_TickCalibration calibration;
+    unsigned i;
+
+    CBTF_GetTickCalibration(&calibration);
+
+#if defined(PROFILE)
+    for (i = 0; i < tls->data.time.time_len; ++i) {
+	tls->buffer.time[i] =
+	    CBTF_TicksToDuration(&calibration, tls->buffer.time[i]);
+    }
+#else
+    for (i = 0; i < tls->data.events.events_len; ++i) {
+	tls->buffer.events[i].start_time =
+	    CBTF_TicksToTime(&calibration, tls->buffer.events[i].start_time);
+	tls->buffer.events[i].stop_time =
+	    CBTF_TicksToTime(&calibration, tls->buffer.events[i].stop_time);
+
+	/* The event may predate the (re-)initialization of the tracing buffer */
+	if (tls->buffer.events[i].start_time < tls->header.time_begin) {
+	    tls->header.time_begin = tls->buffer.events[i].start_time;
+	}
+    }
+#endif
+}
+
+
 /**
  * Send events.
  *
@@ -300,6 +377,8 @@ static void send_samples(TLS *tls)
 {
     Assert(tls != NULL);
 
+    convert_ticks(tls);
+
     tls->header.id = strdup(cbtf_collector_unique_id);
     tls->header.time_end = CBTF_GetTime();
     tls->header.rank = monitor_mpi_comm_rank();
@@ -335,6 +414,26 @@ static void send_samples(TLS *tls)
     initialize_data(tls);
 }
 
+#if defined(RAW_EVENTS)
+/**
+ * Start the raw event encoder thread if CBTF_RAW_EVENTS is set in the
+ * environment. Called once per process.
+ */
+static void start_raw_encoder()
+{
+    if (getenv("CBTF_RAW_EVENTS") == NULL) {
+	return;
+    }
+
+    /* The encoder thread must not itself be traced */
+    monitor_disable_new_threads();
+    raw_encoder_started = CBTF_StartRawEventEncoder();
+    monitor_enable_new_threads();
+}
+#endif
+
+
+
 /**
  * Start an event.
  *
@@ -388,7 +487,8 @@ void mpi_start_event(CBTF_mpi_event* event)
  * buffer is full, it is sent to the framework for storage in the experiment's
  * database.
  *
- * @param event       Event to be recorded.
+ * @param event       Event to be recorded. Its times are in ticks, as returned
+ *                    by CBTF_GetTicks(), and are converted here.
  * @param function    Address of the MPI function for which the event is being
  *                    recorded.
  */
@@ -416,7 +516,7 @@ void mpi_record_event(const CBTF_mpi_event* event, uint64_t function)
 
     uint64_t stacktrace[MaxFramesPerStackTrace];
     unsigned stacktrace_size = 0;
-    unsigned entry = 0, start, i;
+    unsigned entry = 0, i;
     unsigned pathindex = 0;
 
 #ifndef NDEBUG
@@ -448,6 +548,15 @@ fprintf(stderr,"[%ld,%d] ENTERED mpi_record_event, sizeof event=%ld, sizeof stac
 	return;
     }
     
+#if defined(RAW_EVENTS)
+    if ((tls->raw != NULL) &&
+	CBTF_RecordRawTraceEvent(function, event->start_time, event->stop_time,
+				 OverheadFrameCount, MaxFramesPerStackTrace)) {
+	tls->do_trace = TRUE;
+	return;
+    }
+#endif
+
     /* Newer versions of libunwind now make io calls (open a file in /proc/<self>/maps)
      * that cause a thread lock in the libunwind dwarf parser. We are not interested in
      * any io done by libunwind while we get the stacktrace for the current context.
@@ -468,39 +577,23 @@ fprintf(stderr,"[%ld,%d] ENTERED mpi_record_event, sizeof event=%ld, sizeof stac
 
 #if defined(PROFILE)
 
-    bool_t stack_already_exists = FALSE;
-
-    if(stacktrace_size > 0)
-	stacktrace[0] = function;
-
-    int j;
-    int stackindex = 0;
-    /* search individual stacks via count/indexing array */
-    for (i = 0; i < tls->data.count.count_len ; i++ )
-    {
-	/* a count > 0 indexes the top of stack in the data buffer. */
-	/* a count == 255 indicates this stack is at the count limit. */
-
-	if (tls->buffer.count[i] == 0) {
-	    continue;
-	}
-	if (tls->buffer.count[i] == 255) {
-	    continue;
-	}
-
-	/* see if the stack addresses match */
-	for (j = 0; j < stacktrace_size ; j++ )
-	{
-	    if ( tls->buffer.stacktraces[i+j] != stacktrace[j] ) {
-		   break;
-	    }
-	}
+    /* A stack that could not be unwound is recorded as the function alone */
+    if(stacktrace_size == 0)
+	stacktrace_size = 1;
+    stacktrace[0] = function;
 
-	if ( j == stacktrace_size) {
-	    stack_already_exists = TRUE;
-	    stackindex = i;
-	}
-    }
+    /*
+     * Search the sample buffer for an existing stack via the stack trace
+     * hash table. Stacks at the count limit are skipped by the search.
+     */
+    unsigned stackindex = 0;
+    bool_t stack_already_exists =
+	CBTF_FindStackTrace(stacktrace, stacktrace_size,
+			    tls->buffer.stacktraces,
+			    tls->data.stacktraces.stacktraces_len,
+			    tls->buffer.count,
+			    tls->buffer.hash_table, StackTraceHashTableSize,
+			    &stackindex);
 
     /* if the stack already exisits in the buffer, update its count
      * and return. If the stack is already at the count limit.
@@ -527,6 +620,7 @@ fprintf(stderr,"[%ld,%d] ENTERED mpi_record_event, sizeof event=%ld, sizeof stac
     }
 
     /* add frames to sample buffer, compute addresss range */
+    entry = tls->data.stacktraces.stacktraces_len;
     for (i = 0; i < stacktrace_size ; i++)
     {
 	/* always add address to buffer bt */
@@ -552,6 +646,10 @@ fprintf(stderr,"[%ld,%d] ENTERED mpi_record_event, sizeof event=%ld, sizeof stac
 	tls->data.time.time_len++;
     }
 
+    /* Index the new stack in the stack trace hash table */
+    CBTF_AddStackTrace(stacktrace, stacktrace_size, entry,
+		       tls->buffer.hash_table, StackTraceHashTableSize);
+
 #else
     /*
      * Replace the first entry in the call stack with the address of the MPI
@@ -560,41 +658,21 @@ fprintf(stderr,"[%ld,%d] ENTERED mpi_record_event, sizeof event=%ld, sizeof stac
      * wrapper. On IA64, because OverheadFrameCount is one higher, it will be
      * the mini-tramp for the wrapper that is calling mpi_record_event().
      */
-    if(stacktrace_size > 0)
-	stacktrace[0] = function;
+    /* A stack that could not be unwound is recorded as the function alone */
+    if(stacktrace_size == 0)
+	stacktrace_size = 1;
+    stacktrace[0] = function;
     
     /*
      * Search the tracing buffer for an existing stack trace matching the stack
-     * trace from the current thread context. For now do a simple linear search.
+     * trace from the current thread context. The stack trace hash table keeps
+     * the cost of this search independent of how full the buffer is.
      */
-    for(start = 0, i = 0;
-	(i < stacktrace_size) &&
-	    ((start + i) < tls->data.stacktraces.stacktraces_len);
-	++i)
-	
-	/* Do the i'th frames differ? */
-	if(stacktrace[i] != tls->buffer.stacktraces[start + i]) {
-	    
-	    /* Advance in the tracing buffer to the end of this stack trace */
-	    for(start += i;
-		(tls->buffer.stacktraces[start] != 0) &&
-		    (start < tls->data.stacktraces.stacktraces_len);
-		++start);
-	    
-	    /* Advance in the tracing buffer past the terminating zero */
-	    ++start;
-	    
-	    /* Begin comparing at the zero'th frame again */
-	    i = 0;
-	    
-	}
-    
-    /* Did we find a match in the tracing buffer? */
-    if(i == stacktrace_size)
-	entry = start;
-    
-    /* Otherwise add this stack trace to the tracing buffer */
-    else {
+    if(!CBTF_FindStackTrace(stacktrace, stacktrace_size,
+			    tls->buffer.stacktraces,
+			    tls->data.stacktraces.stacktraces_len, NULL,
+			    tls->buffer.hash_table, StackTraceHashTableSize,
+			    &entry)) {
 	
 	/* Send events if there is insufficient room for this stack trace */
 	if((tls->data.stacktraces.stacktraces_len + stacktrace_size + 1) >=
@@ -627,6 +705,10 @@ fprintf(stderr,"[%ld,%d] ENTERED mpi_record_event, sizeof event=%ld, sizeof stac
 	
 	/* Set the new size of the tracing buffer */
 	tls->data.stacktraces.stacktraces_len += (stacktrace_size + 1);
+
+	/* Index the new stack trace in the stack trace hash table */
+	CBTF_AddStackTrace(stacktrace, stacktrace_size, entry,
+			   tls->buffer.hash_table, StackTraceHashTableSize);
 	
     }
     
@@ -706,9 +788,11 @@ void cbtf_collector_start(const CBTF_DataHeader* const header)
     const char* mpi_traced = getenv("CBTF_MPI_TRACED");
 
     if (mpi_traced != NULL && strcmp(mpi_traced,"") != 0) {
-	strcpy(tls->CBTF_mpi_traced,mpi_traced);
+	CBTF_SetTracedFunctions(mpi_traced, TraceableFunctionNames,
+				CBTF_MPITraceableFunctionCount, tls->traced);
     } else {
-	strcpy(tls->CBTF_mpi_traced,all);
+	CBTF_SetTracedFunctions(all, TraceableFunctionNames,
+				CBTF_MPITraceableFunctionCount, tls->traced);
     }
 #endif
 
@@ -735,6 +819,19 @@ void cbtf_collector_start(const CBTF_DataHeader* const header)
 
     /* Initialize the MPI function wrapper nesting depth */
     tls->nesting_depth = 0;
+
+#if defined(RAW_EVENTS)
+    /* Hand off events to the raw event encoder if requested */
+    tls->raw = NULL;
+    pthread_once(&raw_encoder_once, start_raw_encoder);
+    if (raw_encoder_started) {
+	CBTF_DataHeader raw_header;
+	memcpy(&raw_header, &tls->header, sizeof(CBTF_DataHeader));
+	raw_header.id = (char*)cbtf_collector_unique_id;
+	tls->raw = CBTF_StartRawTrace(&raw_header,
+				      (xdrproc_t)xdr_CBTF_mpi_trace_data);
+    }
+#endif
  
     /* Begin sampling */
     tls->header.time_begin = CBTF_GetTime();
@@ -833,6 +930,16 @@ void cbtf_collector_stop()
     /* Stop sampling */
     defer_trace(0);
 
+#if defined(RAW_EVENTS)
+    /* Wait for the raw event encoder and send what it has not yet sent */
+    if (tls->raw != NULL) {
+	if (CBTF_StopRawTrace(tls->raw)) {
+	    cbtf_collector_data_sent();
+	}
+	tls->raw = NULL;
+    }
+#endif
+
     /* Are there any unsent samples? */
 #if defined(PROFILE)
 #ifndef NDEBUG
@@ -861,7 +968,7 @@ void cbtf_collector_stop()
 #endif
 }
 
-bool_t mpi_do_trace(const char* traced_func)
+bool_t mpi_do_trace(CBTF_MPITraceableFunction traced_func)
 {
     /* Access our thread-local storage */
 #ifdef USE_EXPLICIT_TLS
@@ -886,19 +993,8 @@ bool_t mpi_do_trace(const char* traced_func)
     }
 
     /* See if this function has been selected for tracing */
-    char *tfptr, *saveptr, *tf_token;
-    tfptr = strdup(tls->CBTF_mpi_traced);
-    int i;
-    for (i = 1;  ; i++, tfptr = NULL) {
-	tf_token = strtok_r(tfptr, ":,", &saveptr);
-	if (tf_token == NULL)
-	    break;
-	if ( strcmp(tf_token,traced_func) == 0) {
-	
-    	    if (tfptr)
-		free(tfptr);
-	    return TRUE;
-	}
+    if (tls->traced[traced_func / 64] & ((uint64_t)1 << (traced_func % 64))) {
+	return TRUE;
     }
 
     /* Remove any nesting due to skipping mpi_start_event/mpi_record_event for
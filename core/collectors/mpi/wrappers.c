@@ -34,8 +34,14 @@
 #include "KrellInstitute/Services/Assert.h"
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Services/Time.h"
+#include "MPITraceableFunctions.h"
 
 #include <mpi.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #if defined (CBTF_SERVICE_USE_OFFLINE)
 int CBTF_mpi_rank;
@@ -54,11 +60,736 @@ extern void mpi_start_event(CBTF_mpi_event*);
 #endif
 #endif
 
-extern bool_t mpi_do_trace(const char*);
+extern bool_t mpi_do_trace(CBTF_MPITraceableFunction);
 
 
 static int debug_trace = 0;
 
+/** Rank of this process in MPI_COMM_WORLD, or -1 until it is known. */
+static int world_rank = -1;
+
+/** Number of entries in the datatype size cache (a power of two). */
+#define DatatypeSizeCacheSize 64
+
+/**
+ * Entry of the datatype size cache. The entry is being written while its
+ * sequence number is odd, and has changed when its sequence number has.
+ */
+typedef struct {
+    unsigned sequence;
+    MPI_Datatype datatype;
+    int size;
+} DatatypeSizeCacheEntry;
+
+/** Sizes of the datatypes most recently passed to the wrappers. */
+static DatatypeSizeCacheEntry datatype_sizes[DatatypeSizeCacheSize];
+
+/** Attribute key marking the derived datatypes whose size has been cached. */
+static int datatype_size_keyval = MPI_KEYVAL_INVALID;
+
+/** Creation of the above attribute key. */
+static pthread_once_t datatype_size_keyval_once = PTHREAD_ONCE_INIT;
+
+
+
+/**
+ * Get the rank of this process in MPI_COMM_WORLD.
+ *
+ * The rank is asked to MPI only once, by the first wrapper that needs it,
+ * rather than on every call.
+ */
+static inline int get_world_rank()
+{
+    int rank = __atomic_load_n(&world_rank, __ATOMIC_RELAXED);
+
+    if (rank < 0) {
+	PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	__atomic_store_n(&world_rank, rank, __ATOMIC_RELAXED);
+    }
+    return rank;
+}
+
+
+
+/** Find the entry of the datatype size cache for the given datatype. */
+static inline DatatypeSizeCacheEntry* datatype_size_entry(MPI_Datatype datatype)
+{
+    uint64_t hash = (uint64_t)(uintptr_t)datatype * 0x9E3779B97F4A7C15ULL;
+
+    return &datatype_sizes[hash >> 58];
+}
+
+
+
+/**
+ * Update an entry of the datatype size cache. The update is skipped when
+ * another thread is updating the same entry.
+ */
+static void set_datatype_size(DatatypeSizeCacheEntry* entry,
+			      MPI_Datatype datatype, int size)
+{
+    unsigned sequence = __atomic_load_n(&entry->sequence, __ATOMIC_RELAXED);
+
+    if ((sequence & 1) || !__atomic_compare_exchange_n(&entry->sequence,
+						       &sequence, sequence + 1,
+						       false, __ATOMIC_ACQUIRE,
+						       __ATOMIC_RELAXED))
+	return;
+
+    __atomic_store_n(&entry->datatype, datatype, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->size, size, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+
+
+/**
+ * Invalidate the entry of the datatype size cache for a datatype that is being
+ * freed, since its handle may be reused by a datatype of a different size.
+ */
+static void invalidate_datatype_size(MPI_Datatype datatype)
+{
+    DatatypeSizeCacheEntry* entry = datatype_size_entry(datatype);
+    unsigned sequence;
+
+    do {
+	sequence = __atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) & ~1U;
+    } while (!__atomic_compare_exchange_n(&entry->sequence,
+					  &sequence, sequence + 1,
+					  false, __ATOMIC_ACQUIRE,
+					  __ATOMIC_RELAXED));
+
+    if (__atomic_load_n(&entry->datatype, __ATOMIC_RELAXED) == datatype)
+	__atomic_store_n(&entry->datatype, MPI_DATATYPE_NULL, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+
+
+/**
+ * Delete callback of the datatype size attribute. MPI calls it when a marked
+ * datatype is freed, whether through C, Fortran, or a wrapper that isn't bound.
+ */
+static int datatype_size_deleted(MPI_Datatype datatype, int keyval,
+				 void* attribute, void* extra_state)
+{
+    (void)keyval;
+    (void)attribute;
+    (void)extra_state;
+
+    invalidate_datatype_size(datatype);
+    return MPI_SUCCESS;
+}
+
+
+
+/** Create the datatype size attribute key. */
+static void create_datatype_size_keyval()
+{
+    PMPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, datatype_size_deleted,
+			    &datatype_size_keyval, NULL);
+}
+
+
+
+/**
+ * Check that the size of a datatype may be cached.
+ *
+ * Predefined datatypes are never freed. Derived datatypes are marked with the
+ * datatype size attribute, so that their entry is invalidated before their
+ * handle can be reused by a datatype of a different size.
+ */
+static bool_t can_cache_datatype_size(MPI_Datatype datatype)
+{
+    int integers, addresses, datatypes, combiner, flag;
+    void* attribute;
+
+    if ((PMPI_Type_get_envelope(datatype, &integers, &addresses, &datatypes,
+				&combiner) != MPI_SUCCESS) ||
+	(combiner == MPI_COMBINER_NAMED))
+	return combiner == MPI_COMBINER_NAMED;
+
+    pthread_once(&datatype_size_keyval_once, create_datatype_size_keyval);
+    if (datatype_size_keyval == MPI_KEYVAL_INVALID)
+	return FALSE;
+
+    if (PMPI_Type_get_attr(datatype, datatype_size_keyval,
+			   &attribute, &flag) != MPI_SUCCESS)
+	return FALSE;
+
+    return flag || (PMPI_Type_set_attr(datatype, datatype_size_keyval,
+				       NULL) == MPI_SUCCESS);
+}
+
+
+
+/**
+ * Get the size of a datatype.
+ *
+ * Looks the datatype up in the datatype size cache before asking MPI, so that
+ * the wrappers of the calls made repeatedly with the same datatypes only read
+ * memory. Entries are invalidated when their datatype is freed, by the delete
+ * callback of the datatype size attribute.
+ */
+static inline int get_datatype_size(MPI_Datatype datatype)
+{
+    DatatypeSizeCacheEntry* entry = datatype_size_entry(datatype);
+    unsigned sequence = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+    MPI_Datatype cached = __atomic_load_n(&entry->datatype, __ATOMIC_RELAXED);
+    int size = __atomic_load_n(&entry->size, __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (!(sequence & 1) && (cached == datatype) &&
+	(__atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) == sequence))
+	return size;
+
+    PMPI_Type_size(datatype, &size);
+    if (can_cache_datatype_size(datatype))
+	set_datatype_size(entry, datatype, size);
+    return size;
+}
+
+
+
+/** Number of entries in the communicator table (a power of two). */
+#define CommunicatorTableSize 256
+
+/** Maximum number of communicators held by the communicator table. */
+#define MaxCommunicators (3 * CommunicatorTableSize / 4)
+
+/** State of an entry of the communicator table. */
+typedef enum {
+    CommunicatorEmpty = 0, CommunicatorValid, CommunicatorFreed
+} CommunicatorState;
+
+/**
+ * Entry of the communicator table. As in the datatype size cache, the entry is
+ * being written while its sequence number is odd.
+ */
+typedef struct {
+    unsigned sequence;
+    CommunicatorState state;
+    MPI_Comm communicator;
+    int id;            /**< Identifier of the communicator. */
+    int size;          /**< Number of peers (remote ranks for intercomms). */
+    int* world_ranks;  /**< World ranks of the peers, NULL if identical. */
+    bool referenced;   /**< Was it looked up since the last compaction? */
+} CommunicatorEntry;
+
+/**
+ * Translation of the ranks of the communicators used by this process to their
+ * ranks in MPI_COMM_WORLD. The table is an open addressing hash table keyed by
+ * communicator handle, read without locking and written under a spin lock.
+ * When it fills up, the communicators still in use are rehashed into the spare
+ * table and the others are evicted.
+ */
+static CommunicatorEntry communicator_tables[2][CommunicatorTableSize];
+static CommunicatorEntry* communicators = communicator_tables[0];
+static unsigned communicators_used = 0;
+static bool communicators_lock = false;
+
+/**
+ * Readers of the communicator table, counted separately for the two most recent
+ * epochs. World ranks removed from the table are only freed once every reader
+ * that might still be translating a rank with them has left.
+ */
+static unsigned communicators_epoch = 0;
+static unsigned communicators_readers[2] = { 0, 0 };
+
+/** Attribute key marking the communicators added to the communicator table. */
+static int communicator_keyval = MPI_KEYVAL_INVALID;
+
+/** Creation of the above attribute key. */
+static pthread_once_t communicator_keyval_once = PTHREAD_ONCE_INIT;
+
+
+
+/** Find the first entry of the communicator table to probe for a handle. */
+static inline unsigned communicator_slot(MPI_Comm communicator)
+{
+    uint64_t hash = (uint64_t)(uintptr_t)communicator * 0x9E3779B97F4A7C15ULL;
+
+    return (unsigned)(hash >> 56) & (CommunicatorTableSize - 1);
+}
+
+
+
+/**
+ * Translate all the ranks of a group to MPI_COMM_WORLD ranks.
+ *
+ * @param group    Group to be translated.
+ * @param world    Group of MPI_COMM_WORLD.
+ * @retval size    Size of the group.
+ * @retval hash    Hash of the group's world ranks, in order.
+ * @return         World ranks of the group, allocated with malloc().
+ */
+static int* translate_group(MPI_Group group, MPI_Group world,
+			    int* size, uint64_t* hash)
+{
+    int* ranks;
+    int* world_ranks;
+    int i;
+
+    PMPI_Group_size(group, size);
+    ranks = malloc((*size + 1) * sizeof(int));
+    world_ranks = malloc((*size + 1) * sizeof(int));
+    Assert((ranks != NULL) && (world_ranks != NULL));
+
+    for (i = 0; i < *size; ++i)
+	ranks[i] = i;
+    PMPI_Group_translate_ranks(group, *size, ranks, world, world_ranks);
+    free(ranks);
+
+    /* FNV-1a */
+    *hash = 14695981039346656037ULL;
+    for (i = 0; i < *size; ++i) {
+	*hash ^= (uint64_t)(unsigned)world_ranks[i];
+	*hash *= 1099511628211ULL;
+    }
+
+    return world_ranks;
+}
+
+
+
+/**
+ * Compute the translation of a communicator's ranks to MPI_COMM_WORLD ranks.
+ *
+ * The identifier of the communicator is derived from the world ranks of its
+ * group (and remote group for an intercommunicator), so that every member of
+ * the communicator gets the same identifier for it. MPI_COMM_WORLD, and any
+ * duplicate of it, gets the identifier 0.
+ *
+ * @param communicator    Communicator to be translated.
+ * @retval entry          Identifier, size and world ranks of the translation.
+ */
+static void translate_communicator(MPI_Comm communicator,
+				   CommunicatorEntry* entry)
+{
+    MPI_Group world, group;
+    int inter = 0, world_size = 0, i;
+    uint64_t hash, remote_hash;
+    bool identity;
+
+    PMPI_Comm_group(MPI_COMM_WORLD, &world);
+    PMPI_Group_size(world, &world_size);
+    PMPI_Comm_test_inter(communicator, &inter);
+
+    PMPI_Comm_group(communicator, &group);
+    entry->world_ranks = translate_group(group, world, &entry->size, &hash);
+    PMPI_Group_free(&group);
+
+    identity = !inter && (entry->size == world_size);
+    for (i = 0; identity && (i < entry->size); ++i)
+	identity = (entry->world_ranks[i] == i);
+
+    /* The peers of an intercommunicator are the ranks of its remote group */
+    if (inter) {
+	free(entry->world_ranks);
+	PMPI_Comm_remote_group(communicator, &group);
+	entry->world_ranks =
+	    translate_group(group, world, &entry->size, &remote_hash);
+	PMPI_Group_free(&group);
+	hash ^= remote_hash;
+    }
+    PMPI_Group_free(&world);
+
+    if (identity) {
+	free(entry->world_ranks);
+	entry->world_ranks = NULL;
+	entry->id = 0;
+    } else {
+	entry->id = (int)(hash & 0x7FFFFFFF);
+	if (entry->id == 0)
+	    entry->id = 1;
+    }
+}
+
+
+
+/** Enter the communicator table as a reader, returning the epoch to leave. */
+static inline unsigned enter_communicators()
+{
+    unsigned epoch = __atomic_load_n(&communicators_epoch, __ATOMIC_RELAXED) & 1;
+
+    __atomic_add_fetch(&communicators_readers[epoch], 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return epoch;
+}
+
+
+
+/** Leave the communicator table as a reader. */
+static inline void leave_communicators(unsigned epoch)
+{
+    __atomic_sub_fetch(&communicators_readers[epoch], 1, __ATOMIC_RELEASE);
+}
+
+
+
+/**
+ * Wait for every reader that might still see what was removed from the
+ * communicator table. The epoch is advanced twice, waiting each time for the
+ * readers of the epoch being left, so that a reader which entered with a stale
+ * epoch is waited for too. Readers entering meanwhile count towards the new
+ * epoch and already see the table without it. Called with the lock held.
+ */
+static void synchronize_communicators()
+{
+    unsigned i;
+
+    for (i = 0; i < 2; ++i) {
+	unsigned epoch = communicators_epoch;
+
+	__atomic_store_n(&communicators_epoch, epoch + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&communicators_readers[epoch & 1],
+			       __ATOMIC_ACQUIRE) != 0)
+	    sched_yield();
+    }
+}
+
+
+
+/** Translate a rank using the given translation of its communicator. */
+static inline int translate_rank(int rank, int size, const int* world_ranks)
+{
+    /* MPI_ANY_SOURCE, MPI_PROC_NULL, MPI_ROOT, etc. are left as they are */
+    if ((rank < 0) || (rank >= size) || (world_ranks == NULL))
+	return rank;
+    return world_ranks[rank];
+}
+
+
+
+/**
+ * Look a communicator up in the communicator table without locking.
+ *
+ * @param communicator    Communicator to be looked up.
+ * @param rank            Rank in the communicator to be translated.
+ * @retval id             Identifier of the communicator.
+ * @retval world_rank     Rank in MPI_COMM_WORLD.
+ * @return                Boolean "true" if the communicator was found, or
+ *                        "false" if it was not or was being written.
+ */
+static inline bool find_communicator(MPI_Comm communicator, int rank,
+				     int* id, int* world_rank)
+{
+    unsigned epoch = enter_communicators();
+    CommunicatorEntry* table = __atomic_load_n(&communicators, __ATOMIC_ACQUIRE);
+    unsigned slot = communicator_slot(communicator), n;
+    bool found = false;
+
+    for (n = 0; n < CommunicatorTableSize;
+	 ++n, slot = (slot + 1) & (CommunicatorTableSize - 1)) {
+	CommunicatorEntry* entry = &table[slot];
+	unsigned sequence =
+	    __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+	CommunicatorState state =
+	    __atomic_load_n(&entry->state, __ATOMIC_RELAXED);
+
+	if ((sequence & 1) || (state == CommunicatorEmpty))
+	    break;
+
+	if ((state == CommunicatorValid) &&
+	    (__atomic_load_n(&entry->communicator, __ATOMIC_RELAXED) ==
+	     communicator)) {
+	    int found_id = __atomic_load_n(&entry->id, __ATOMIC_RELAXED);
+	    int size = __atomic_load_n(&entry->size, __ATOMIC_RELAXED);
+	    const int* world_ranks =
+		__atomic_load_n(&entry->world_ranks, __ATOMIC_RELAXED);
+
+	    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+	    if (__atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) != sequence)
+		break;
+
+	    /* The world ranks aren't freed before this reader leaves */
+	    *id = found_id;
+	    *world_rank = translate_rank(rank, size, world_ranks);
+
+	    if (!__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED))
+		__atomic_store_n(&entry->referenced, true, __ATOMIC_RELAXED);
+	    found = true;
+	    break;
+	}
+    }
+
+    leave_communicators(epoch);
+    return found;
+}
+
+
+
+/** Write an entry of the communicator table. Called with the lock held. */
+static void set_communicator(CommunicatorEntry* entry, CommunicatorState state,
+			     MPI_Comm communicator, int id, int size,
+			     int* world_ranks)
+{
+    unsigned sequence = entry->sequence;
+
+    __atomic_store_n(&entry->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&entry->state, state, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->communicator, communicator, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->id, id, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->size, size, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->world_ranks, world_ranks, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->referenced, true, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+
+
+/**
+ * Find the entry of the communicator table into which a communicator can be
+ * added: the first freed entry on its probe sequence, or else the empty one
+ * ending it if the table isn't full. Called with the lock held.
+ */
+static CommunicatorEntry* find_free_communicator(MPI_Comm communicator)
+{
+    unsigned slot = communicator_slot(communicator), n;
+
+    for (n = 0; n < CommunicatorTableSize;
+	 ++n, slot = (slot + 1) & (CommunicatorTableSize - 1)) {
+	if (communicators[slot].state == CommunicatorFreed)
+	    return &communicators[slot];
+	if (communicators[slot].state == CommunicatorEmpty) {
+	    if (communicators_used == MaxCommunicators)
+		return NULL;
+	    ++communicators_used;
+	    return &communicators[slot];
+	}
+    }
+
+    return NULL;
+}
+
+
+
+/**
+ * Compact the full communicator table. The communicators looked up since the
+ * last compaction, up to half of the table, are rehashed into the spare table,
+ * which then replaces the table. The other communicators are evicted and are
+ * translated again if they are used again. Called with the lock held.
+ */
+static void compact_communicators()
+{
+    CommunicatorEntry* from = communicators;
+    CommunicatorEntry* to = (from == communicator_tables[0]) ?
+	communicator_tables[1] : communicator_tables[0];
+    bool kept[CommunicatorTableSize];
+    unsigned used = 0, i, slot;
+
+    /* No reader has been left in the spare table since it was replaced */
+    memset(to, 0, sizeof(communicator_tables[0]));
+
+    for (i = 0; i < CommunicatorTableSize; ++i) {
+	kept[i] = (from[i].state == CommunicatorValid) &&
+	    __atomic_load_n(&from[i].referenced, __ATOMIC_RELAXED) &&
+	    (used < (MaxCommunicators / 2));
+	if (!kept[i])
+	    continue;
+
+	slot = communicator_slot(from[i].communicator);
+	while (to[slot].state != CommunicatorEmpty)
+	    slot = (slot + 1) & (CommunicatorTableSize - 1);
+	to[slot].state = CommunicatorValid;
+	to[slot].communicator = from[i].communicator;
+	to[slot].id = from[i].id;
+	to[slot].size = from[i].size;
+	to[slot].world_ranks = from[i].world_ranks;
+	++used;
+    }
+
+    __atomic_store_n(&communicators, to, __ATOMIC_RELEASE);
+    communicators_used = used;
+    synchronize_communicators();
+
+    for (i = 0; i < CommunicatorTableSize; ++i)
+	if ((from[i].state == CommunicatorValid) && !kept[i])
+	    free(from[i].world_ranks);
+}
+
+
+
+/**
+ * Remove a communicator that is being freed from the communicator table, since
+ * its handle may be reused by a communicator with other ranks.
+ */
+static void forget_communicator(MPI_Comm communicator)
+{
+    unsigned slot = communicator_slot(communicator), n;
+    int* world_ranks = NULL;
+
+    while (__atomic_test_and_set(&communicators_lock, __ATOMIC_ACQUIRE));
+
+    for (n = 0; n < CommunicatorTableSize;
+	 ++n, slot = (slot + 1) & (CommunicatorTableSize - 1)) {
+	CommunicatorEntry* entry = &communicators[slot];
+
+	if (entry->state == CommunicatorEmpty)
+	    break;
+	if ((entry->state == CommunicatorValid) &&
+	    (entry->communicator == communicator)) {
+	    world_ranks = entry->world_ranks;
+	    set_communicator(entry, CommunicatorFreed, MPI_COMM_NULL,
+			     -1, 0, NULL);
+	    synchronize_communicators();
+	    break;
+	}
+    }
+
+    __atomic_clear(&communicators_lock, __ATOMIC_RELEASE);
+
+    free(world_ranks);
+}
+
+
+
+/**
+ * Delete callback of the communicator attribute. MPI calls it when a marked
+ * communicator is freed or disconnected, whether or not the wrappers of these
+ * calls are bound.
+ */
+static int communicator_deleted(MPI_Comm communicator, int keyval,
+				void* attribute, void* extra_state)
+{
+    (void)keyval;
+    (void)attribute;
+    (void)extra_state;
+
+    forget_communicator(communicator);
+    return MPI_SUCCESS;
+}
+
+
+
+/** Create the communicator attribute key. */
+static void create_communicator_keyval()
+{
+    PMPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, communicator_deleted,
+			    &communicator_keyval, NULL);
+}
+
+
+
+/**
+ * Mark a communicator with the communicator attribute, so that it is removed
+ * from the communicator table before its handle can be reused.
+ *
+ * @param communicator    Communicator to be marked.
+ * @return                Boolean "true" if the communicator is marked, or
+ *                        "false" if it can't be added to the table.
+ */
+static bool mark_communicator(MPI_Comm communicator)
+{
+    void* attribute;
+    int flag;
+
+    pthread_once(&communicator_keyval_once, create_communicator_keyval);
+    if (communicator_keyval == MPI_KEYVAL_INVALID)
+	return false;
+
+    if (PMPI_Comm_get_attr(communicator, communicator_keyval,
+			   &attribute, &flag) != MPI_SUCCESS)
+	return false;
+
+    return flag || (PMPI_Comm_set_attr(communicator, communicator_keyval,
+				       NULL) == MPI_SUCCESS);
+}
+
+
+
+/**
+ * Look a communicator up in the communicator table, adding it if necessary.
+ *
+ * The translation of a communicator that is not in the table is computed once,
+ * with PMPI_Group_translate_ranks(), and is then shared by all the calls using
+ * that communicator. When the table is full, it is first compacted.
+ *
+ * @param communicator    Communicator to be looked up.
+ * @param rank            Rank in the communicator to be translated.
+ * @retval id             Identifier of the communicator, or -1 if none.
+ * @retval world_rank     Rank in MPI_COMM_WORLD.
+ */
+static void lookup_communicator(MPI_Comm communicator, int rank,
+				int* id, int* world_rank)
+{
+    CommunicatorEntry translation;
+    CommunicatorEntry* target;
+
+    if (communicator == MPI_COMM_NULL) {
+	*id = -1;
+	*world_rank = rank;
+	return;
+    }
+
+    if (find_communicator(communicator, rank, id, world_rank))
+	return;
+
+    translate_communicator(communicator, &translation);
+
+    /* A communicator that can't be forgotten when freed isn't kept */
+    if (!mark_communicator(communicator)) {
+	*id = translation.id;
+	*world_rank = translate_rank(rank, translation.size,
+				     translation.world_ranks);
+	free(translation.world_ranks);
+	return;
+    }
+
+    while (__atomic_test_and_set(&communicators_lock, __ATOMIC_ACQUIRE));
+
+    if (!find_communicator(communicator, rank, id, world_rank)) {
+
+	target = find_free_communicator(communicator);
+	if (target == NULL) {
+	    compact_communicators();
+	    target = find_free_communicator(communicator);
+	}
+	Assert(target != NULL);
+
+	*id = translation.id;
+	*world_rank = translate_rank(rank, translation.size,
+				     translation.world_ranks);
+
+	set_communicator(target, CommunicatorValid, communicator,
+			 translation.id, translation.size,
+			 translation.world_ranks);
+	translation.world_ranks = NULL;
+
+    }
+
+    __atomic_clear(&communicators_lock, __ATOMIC_RELEASE);
+
+    free(translation.world_ranks);
+}
+
+
+
+/**
+ * Get the identifier of a communicator. The identifier is the same for all the
+ * members of the communicator and is 0 for MPI_COMM_WORLD.
+ */
+static inline int get_communicator_id(MPI_Comm communicator)
+{
+    int id, world_rank;
+
+    lookup_communicator(communicator, -1, &id, &world_rank);
+    return id;
+}
+
+
+
+/** Translate a peer's rank in a communicator to its rank in MPI_COMM_WORLD. */
+static inline int get_peer_world_rank(MPI_Comm communicator, int rank)
+{
+    int id, world_rank;
+
+    lookup_communicator(communicator, rank, &id, &world_rank);
+    return world_rank;
+}
+
 //start new mpi functions
 
 /*
@@ -92,15 +823,15 @@ int mpi_PMPI_Iallgather
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iallgather");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iallgather);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -110,19 +841,19 @@ int mpi_PMPI_Iallgather
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size = recvcount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
 
     /* Initialize unused arguments */
@@ -175,15 +906,15 @@ int mpi_PMPI_Iallgatherv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iallgatherv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iallgatherv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -193,20 +924,20 @@ int mpi_PMPI_Iallgatherv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
 
     /* Initialize unused arguments */
@@ -255,15 +986,15 @@ int mpi_PMPI_Iallreduce
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iallreduce");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iallreduce);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -273,19 +1004,19 @@ int mpi_PMPI_Iallreduce
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
 
     /* Initialize unused arguments */
@@ -335,15 +1066,15 @@ int mpi_PMPI_Ialltoall
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ialltoall");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ialltoall);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -354,20 +1085,20 @@ int mpi_PMPI_Ialltoall
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size = recvcount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
 
     /* Initialize unused arguments */
@@ -415,15 +1146,15 @@ int mpi_PMPI_Ialltoallv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ialltoallv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ialltoallv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -434,19 +1165,19 @@ int mpi_PMPI_Ialltoallv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
 
     /* Initialize unused arguments */
@@ -496,15 +1227,15 @@ int mpi_PMPI_Ialltoallw
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ialltoallw");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ialltoallw);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -515,19 +1246,19 @@ int mpi_PMPI_Ialltoallw
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(*recvtypes, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(*recvtypes);
 
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t)( *recvtypes);
 
     /* Initialize unused arguments */
@@ -573,15 +1304,15 @@ int mpi_PMPI_Ibarrier
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ibarrier");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ibarrier);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -590,18 +1321,18 @@ int mpi_PMPI_Ibarrier
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
 
     event.size = 0;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = 0;
 
     /* Initialize unused arguments */
@@ -651,15 +1382,15 @@ int mpi_PMPI_Ibcast
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ibcast");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ibcast);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -669,19 +1400,19 @@ int mpi_PMPI_Ibcast
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
 
     /* Initialize unused arguments */
@@ -731,15 +1462,15 @@ int mpi_PMPI_Iexscan
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iexscan");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iexscan);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -749,19 +1480,19 @@ int mpi_PMPI_Iexscan
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
 
     /* Initialize unused arguments */
@@ -811,15 +1542,15 @@ int mpi_PMPI_Igather
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Igather");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Igather);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -829,19 +1560,19 @@ int mpi_PMPI_Igather
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size = recvcount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
 
     /* Initialize unused arguments */
@@ -891,15 +1622,15 @@ int mpi_PMPI_Igatherv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Igatherv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Igatherv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -909,19 +1640,19 @@ int mpi_PMPI_Igatherv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size = * recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
 
     /* Initialize unused arguments */
@@ -979,15 +1710,15 @@ int mpi_PMPI_Improbe
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Improbe");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Improbe);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1000,21 +1731,21 @@ int mpi_PMPI_Improbe
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.source = source;
+    event.source = get_peer_world_rank(comm, source);
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     //PMPI_Type_size(datatype, &datatype_size);
 
     event.size =  0;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = 0;
     event.tag = tag;
 
@@ -1062,15 +1793,15 @@ int mpi_PMPI_Imrecv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Imrecv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Imrecv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1080,16 +1811,16 @@ int mpi_PMPI_Imrecv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size =  count * datatype_size;
     event.datatype = (int64_t) datatype;
@@ -1142,15 +1873,15 @@ int mpi_PMPI_Ineighbor_allgather
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ineighbor_allgather");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ineighbor_allgather);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1161,21 +1892,21 @@ int mpi_PMPI_Ineighbor_allgather
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size =  recvcount * datatype_size;
     event.datatype = (int64_t) recvtype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1224,15 +1955,15 @@ int mpi_PMPI_Ineighbor_allgatherv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ineighbor_allgatherv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ineighbor_allgatherv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1243,21 +1974,21 @@ int mpi_PMPI_Ineighbor_allgatherv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size =  *recvcounts * datatype_size;
     event.datatype = (int64_t) recvtype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1306,15 +2037,15 @@ int mpi_PMPI_Ineighbor_alltoall
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ineighbor_alltoall");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ineighbor_alltoall);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1325,21 +2056,21 @@ int mpi_PMPI_Ineighbor_alltoall
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size =  recvcount * datatype_size;
     event.datatype = (int64_t) recvtype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.source = -1;
@@ -1389,15 +2120,15 @@ int mpi_PMPI_Ineighbor_alltoallv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ineighbor_alltoallv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ineighbor_alltoallv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1408,20 +2139,20 @@ int mpi_PMPI_Ineighbor_alltoallv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size =  *recvcounts * datatype_size;
     event.datatype = (int64_t) recvtype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1471,15 +2202,15 @@ int mpi_PMPI_Ineighbor_alltoallw
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ineighbor_alltoallw");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ineighbor_alltoallw);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1490,20 +2221,20 @@ int mpi_PMPI_Ineighbor_alltoallw
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(*recvtypes, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(*recvtypes);
 
     event.size =  *recvcounts * datatype_size;
     event.datatype = (int64_t) (*recvtypes);
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1552,15 +2283,15 @@ int mpi_PMPI_Ireduce
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ireduce");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ireduce);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1571,20 +2302,20 @@ int mpi_PMPI_Ireduce
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size =  count * datatype_size;
     event.datatype = (int64_t) datatype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1636,15 +2367,15 @@ int mpi_PMPI_Ireduce_scatter
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ireduce_scatter");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ireduce_scatter);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1655,21 +2386,21 @@ int mpi_PMPI_Ireduce_scatter
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size =  (*recvcounts) * datatype_size;
     event.datatype = (int64_t) datatype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1719,15 +2450,15 @@ int mpi_PMPI_Ireduce_scatter_block
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ireduce_scatter_block");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ireduce_scatter_block);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1738,21 +2469,21 @@ int mpi_PMPI_Ireduce_scatter_block
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size =  recvcount * datatype_size;
     event.datatype = (int64_t) datatype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1801,15 +2532,15 @@ int mpi_PMPI_Comm_idup
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Comm_idup");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Comm_idup);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1819,21 +2550,21 @@ int mpi_PMPI_Comm_idup
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     //PMPI_Type_size(datatype, &datatype_size);
 
     event.size =  0;
     event.datatype = 0;
-    event.communicator = (int64_t) newcomm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1882,15 +2613,15 @@ int mpi_PMPI_Iscan
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iscan");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iscan);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1900,21 +2631,21 @@ int mpi_PMPI_Iscan
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size =  count * datatype_size;
     event.datatype = (int64_t) datatype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -1966,15 +2697,15 @@ int mpi_PMPI_Iscatter
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iscatter");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iscatter);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -1985,21 +2716,21 @@ int mpi_PMPI_Iscatter
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size =  recvcount * datatype_size;
     event.datatype = (int64_t) recvtype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -2049,15 +2780,15 @@ int mpi_PMPI_Iscatterv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iscatterv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iscatterv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2068,21 +2799,21 @@ int mpi_PMPI_Iscatterv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
 
     event.size =  recvcount * datatype_size;
     event.datatype = (int64_t) recvtype;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
 
     /* Initialize unused arguments */
     event.destination = -1;
@@ -2130,15 +2861,15 @@ int mpi_PMPI_Irecv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Irecv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Irecv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-    start_time = CBTF_GetTime();
+    start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2147,22 +2878,22 @@ int mpi_PMPI_Irecv
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.source = source;
+    event.source = get_peer_world_rank(comm, source);
 
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
 
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
 
     /* Initialize unused arguments */
@@ -2208,15 +2939,15 @@ int mpi_PMPI_Recv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Recv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Recv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2226,20 +2957,20 @@ int mpi_PMPI_Recv
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.source = source;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.source = get_peer_world_rank(comm, source);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -2286,15 +3017,15 @@ int mpi_PMPI_Recv_init
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Recv_init");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Recv_init);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2304,20 +3035,20 @@ int mpi_PMPI_Recv_init
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.source = source;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.source = get_peer_world_rank(comm, source);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -2360,15 +3091,15 @@ int mpi_PMPI_Iprobe
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Iprobe");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Iprobe);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2378,18 +3109,18 @@ int mpi_PMPI_Iprobe
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.source = source;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.source = get_peer_world_rank(comm, source);
+    event.destination = get_world_rank();
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -2432,15 +3163,15 @@ int mpi_PMPI_Probe
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Probe");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Probe);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2450,18 +3181,18 @@ int mpi_PMPI_Probe
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.source = source;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.source = get_peer_world_rank(comm, source);
+    event.destination = get_world_rank();
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -2519,15 +3250,15 @@ int mpi_PMPI_Isend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Isend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Isend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2537,20 +3268,20 @@ int mpi_PMPI_Isend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    event.destination = dest;
-    PMPI_Type_size(datatype, &datatype_size);
+    event.source = get_world_rank();
+    event.destination = get_peer_world_rank(comm, dest);
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -2599,15 +3330,15 @@ int mpi_PMPI_Bsend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Bsend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Bsend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2617,20 +3348,20 @@ int mpi_PMPI_Bsend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -2681,15 +3412,15 @@ int mpi_PMPI_Bsend_init
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("Bsend_init");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Bsend_init);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2699,20 +3430,20 @@ int mpi_PMPI_Bsend_init
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -2762,15 +3493,15 @@ int mpi_PMPI_Ibsend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ibsend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ibsend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2780,20 +3511,20 @@ int mpi_PMPI_Ibsend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -2843,15 +3574,15 @@ int mpi_PMPI_Irsend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Irsend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Irsend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2861,20 +3592,20 @@ int mpi_PMPI_Irsend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -2924,15 +3655,15 @@ int mpi_PMPI_Issend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Issend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Issend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -2942,20 +3673,20 @@ int mpi_PMPI_Issend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3004,15 +3735,15 @@ int mpi_PMPI_Rsend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Rsend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Rsend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3022,20 +3753,20 @@ int mpi_PMPI_Rsend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3086,15 +3817,15 @@ int mpi_PMPI_Rsend_init
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Rsend_init");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Rsend_init);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3104,20 +3835,20 @@ int mpi_PMPI_Rsend_init
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3166,15 +3897,15 @@ int mpi_PMPI_Send
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Send");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Send);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3184,20 +3915,20 @@ int mpi_PMPI_Send
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3248,15 +3979,15 @@ int mpi_PMPI_Send_init
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Send_init");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Send_init);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3266,20 +3997,20 @@ int mpi_PMPI_Send_init
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3328,15 +4059,15 @@ int mpi_PMPI_Ssend
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ssend");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ssend);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3346,20 +4077,20 @@ int mpi_PMPI_Ssend
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3410,15 +4141,15 @@ int mpi_PMPI_Ssend_init
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Ssend_init");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Ssend_init);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3428,20 +4159,20 @@ int mpi_PMPI_Ssend_init
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_peer_world_rank(comm, dest);
+    event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
     event.tag = tag;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 #endif
@@ -3479,15 +4210,15 @@ int mpi_PMPI_Waitall
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Waitall");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Waitall);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3497,15 +4228,15 @@ int mpi_PMPI_Waitall
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -3547,20 +4278,20 @@ int mpi_PMPI_Finalize()
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Finalize");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Finalize);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
 
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
 #endif
 
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3570,10 +4301,10 @@ int mpi_PMPI_Finalize()
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -3627,15 +4358,15 @@ int mpi_PMPI_Waitsome
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Waitsome");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Waitsome);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3647,15 +4378,15 @@ int mpi_PMPI_Waitsome
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -3705,15 +4436,15 @@ int mpi_PMPI_Testsome
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Testsome");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Testsome);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3725,15 +4456,15 @@ int mpi_PMPI_Testsome
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -3779,15 +4510,15 @@ int mpi_PMPI_Waitany
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Waitany");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Waitany);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3797,15 +4528,15 @@ int mpi_PMPI_Waitany
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -3865,15 +4596,15 @@ int mpi_PMPI_Unpack
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Unpack");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Unpack);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3884,16 +4615,16 @@ int mpi_PMPI_Unpack
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = outcount * datatype_size;
     event.datatype = (int64_t) datatype;
     event.retval = retval;
@@ -3937,15 +4668,15 @@ int mpi_PMPI_Wait
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Wait");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Wait);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -3955,15 +4686,15 @@ int mpi_PMPI_Wait
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -4010,15 +4741,15 @@ int mpi_PMPI_Testany
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Testany");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Testany);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4028,15 +4759,15 @@ int mpi_PMPI_Testany
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -4082,15 +4813,15 @@ int mpi_PMPI_Testall
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Testall");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Testall);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4100,15 +4831,15 @@ int mpi_PMPI_Testall
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -4153,15 +4884,15 @@ int mpi_PMPI_Test
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Test");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Test);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4171,15 +4902,15 @@ int mpi_PMPI_Test
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -4235,15 +4966,15 @@ int mpi_PMPI_Scan
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Scan");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Scan);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4253,18 +4984,18 @@ int mpi_PMPI_Scan
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -4305,15 +5036,15 @@ int mpi_PMPI_Request_free
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Request_free");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Request_free);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4323,15 +5054,15 @@ int mpi_PMPI_Request_free
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -4394,15 +5125,15 @@ int mpi_PMPI_Reduce_scatter
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Reduce_scatter");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Reduce_scatter);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4412,18 +5143,18 @@ int mpi_PMPI_Reduce_scatter
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -4478,15 +5209,15 @@ int mpi_PMPI_Reduce
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Reduce");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Reduce);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4496,18 +5227,18 @@ int mpi_PMPI_Reduce
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -4562,15 +5293,15 @@ int mpi_PMPI_Pack
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Pack");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Pack);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4581,18 +5312,18 @@ int mpi_PMPI_Pack
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = incount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -4634,15 +5365,15 @@ int mpi_PMPI_Init
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Init");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Init);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4650,23 +5381,21 @@ int mpi_PMPI_Init
     retval = PMPI_Init(argc, argv);
 
 #if defined (CBTF_SERVICE_USE_OFFLINE)
-    int oss_rank = -1;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &oss_rank);
-    CBTF_mpi_rank = oss_rank;
+    CBTF_mpi_rank = get_world_rank();
 #endif
 
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -4717,15 +5446,15 @@ int mpi_PMPI_Get_count
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Get_count");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Get_count);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4735,16 +5464,16 @@ int mpi_PMPI_Get_count
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = *count * datatype_size;
     event.datatype = (int64_t) datatype;
     event.retval = retval;
@@ -4813,15 +5542,15 @@ int mpi_PMPI_Gatherv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Gatherv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Gatherv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4832,18 +5561,18 @@ int mpi_PMPI_Gatherv
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
     event.retval = retval;
 
@@ -4900,15 +5629,15 @@ int mpi_PMPI_Gather
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Gather");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Gather);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4920,18 +5649,18 @@ int mpi_PMPI_Gather
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     event.size = recvcount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
     event.retval = retval;
 
@@ -4972,15 +5701,15 @@ int mpi_PMPI_Cancel
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Cancel");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Cancel);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -4990,15 +5719,15 @@ int mpi_PMPI_Cancel
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
+    event.destination = get_world_rank();
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -5046,15 +5775,15 @@ int mpi_PMPI_Bcast
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Bcast");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Bcast);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5064,18 +5793,18 @@ int mpi_PMPI_Bcast
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -5116,15 +5845,15 @@ int mpi_PMPI_Barrier
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Barrier");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Barrier);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5134,16 +5863,16 @@ int mpi_PMPI_Barrier
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    event.communicator = (int64_t) comm;
+    event.destination = get_world_rank();
+    event.communicator = get_communicator_id(comm);
     event.retval = retval;
 
     /* Initialize unused arguments */
@@ -5213,15 +5942,15 @@ int mpi_PMPI_Alltoallv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Alltoallv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Alltoallv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5233,18 +5962,18 @@ int mpi_PMPI_Alltoallv
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
     event.retval = retval;
 #endif
@@ -5295,15 +6024,15 @@ int mpi_PMPI_Alltoall
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Alltoall");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Alltoall);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5314,18 +6043,18 @@ int mpi_PMPI_Alltoall
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     event.size = recvcount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
     event.retval = retval;
 
@@ -5379,15 +6108,15 @@ int mpi_PMPI_Allreduce
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Allreduce");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Allreduce);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5397,18 +6126,18 @@ int mpi_PMPI_Allreduce
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     event.size = count * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) datatype;
     event.retval = retval;
 
@@ -5474,15 +6203,15 @@ int mpi_PMPI_Allgatherv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Allgatherv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Allgatherv);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5494,18 +6223,18 @@ int mpi_PMPI_Allgatherv
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     event.size = *recvcounts * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
     event.retval = retval;
 
@@ -5560,15 +6289,15 @@ int mpi_PMPI_Allgather
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Allgather");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Allgather);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -5579,18 +6308,18 @@ int mpi_PMPI_Allgather
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     event.size = recvcount * datatype_size;
-    event.communicator = (int64_t) comm;
+    event.communicator = get_communicator_id(comm);
     event.datatype = (int64_t) recvtype;
     event.retval = retval;
 
@@ -5648,7 +6377,7 @@ int mpi_PMPI_Scatter
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Scatter");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Scatter);
 
     if (dotrace) {
 
@@ -5658,22 +6387,22 @@ int mpi_PMPI_Scatter
     /* Set up the send record */
     mpi_start_event(&send_event);
     mpi_start_event(&recv_event);
-    send_event.source = root;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(send_event.source));
-    PMPI_Type_size(sendtype, &datatype_size);
+    send_event.source = get_peer_world_rank(comm, root);
+    send_event.source = get_world_rank();
+    datatype_size = get_datatype_size(sendtype);
     send_event.size = sendcount * datatype_size;
     send_event.datatype = (int64_t) sendtype;
     
 
     /* Initialize unused arguments */
     send_event.tag = 0;
-    send_event.start_time = CBTF_GetTime();
+    send_event.start_time = CBTF_GetTicks();
 #else
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 #endif
 
@@ -5688,19 +6417,19 @@ int mpi_PMPI_Scatter
     
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    send_event.stop_time = CBTF_GetTime();
-    send_event.communicator = (int64_t) comm;
+    send_event.stop_time = CBTF_GetTicks();
+    send_event.communicator = get_communicator_id(comm);
     send_event.retval = retval;
     recv_event.start_time = send_event.start_time;
     recv_event.stop_time = send_event.stop_time;
     mpi_record_event(&send_event, CBTF_GetAddressOfFunction(PMPI_Scatter));
 
     /* Set up the recv record */
-    PMPI_Type_size(recvtype, &datatype_size);
+    datatype_size = get_datatype_size(recvtype);
     recv_event.size = recvcount * datatype_size;
     recv_event.datatype = (int64_t) recvtype;
 
-    recv_event.communicator = (int64_t) comm;
+    recv_event.communicator = get_communicator_id(comm);
     recv_event.retval = retval;
 
     /* Initialize unused arguments */
@@ -5708,9 +6437,9 @@ int mpi_PMPI_Scatter
     mpi_record_event(&recv_event, CBTF_GetAddressOfFunction(PMPI_Scatter));
 #else
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
     mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_Scatter));
 #endif
@@ -5768,7 +6497,7 @@ int mpi_PMPI_Scatterv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Scatterv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Scatterv);
 
     if (dotrace) {
 
@@ -5778,19 +6507,19 @@ int mpi_PMPI_Scatterv
     /* Set up the send record */
     mpi_start_event(&send_event);
     mpi_start_event(&recv_event);
-    send_event.source = root;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(send_event.source));
-    PMPI_Type_size(sendtype, &datatype_size);
+    send_event.source = get_peer_world_rank(comm, root);
+    send_event.source = get_world_rank();
+    datatype_size = get_datatype_size(sendtype);
     /* This is surly wrong */
     send_event.size = sendcounts[0] * datatype_size;
     send_event.datatype = (int64_t) sendtype;
-    send_event.start_time = CBTF_GetTime();
+    send_event.start_time = CBTF_GetTicks();
 #else
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 #endif
     
@@ -5806,8 +6535,8 @@ int mpi_PMPI_Scatterv
     
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    send_event.stop_time = CBTF_GetTime();
-    send_event.communicator = (int64_t) comm;
+    send_event.stop_time = CBTF_GetTicks();
+    send_event.communicator = get_communicator_id(comm);
     send_event.retval = retval;
     recv_event.start_time = send_event.start_time;
     recv_event.stop_time = send_event.stop_time;
@@ -5815,13 +6544,13 @@ int mpi_PMPI_Scatterv
     /* Initialize unused arguments */
     send_event.tag = 0;
 
-    send_event.stop_time = CBTF_GetTime();
+    send_event.stop_time = CBTF_GetTicks();
     mpi_record_event(&send_event, CBTF_GetAddressOfFunction(PMPI_Scatterv));
 #else
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
     mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_Scatterv));
 #endif
@@ -5829,16 +6558,16 @@ int mpi_PMPI_Scatterv
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
     /* Set up the recv record */
-    PMPI_Type_size(recvtype, &datatype_size);
+    datatype_size = get_datatype_size(recvtype);
     recv_event.size = recvcount * datatype_size;
     recv_event.datatype = (int64_t) recvtype;
 
-    recv_event.communicator = (int64_t) comm;
+    recv_event.communicator = get_communicator_id(comm);
     recv_event.retval = retval;
 
     /* Initialize unused arguments */
     recv_event.tag = 0;
-    recv_event.stop_time = CBTF_GetTime();
+    recv_event.stop_time = CBTF_GetTicks();
     mpi_record_event(&recv_event, CBTF_GetAddressOfFunction(PMPI_Scatterv));
 #endif
 
@@ -5894,7 +6623,7 @@ int mpi_PMPI_Sendrecv
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Sendrecv");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Sendrecv);
 
     if (dotrace) {
 
@@ -5904,19 +6633,19 @@ int mpi_PMPI_Sendrecv
     /* Set up the send record */
     mpi_start_event(&send_event);
     mpi_start_event(&recv_event);
-    send_event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(send_event.source));
-    PMPI_Type_size(sendtype, &datatype_size);
+    send_event.destination = get_peer_world_rank(comm, dest);
+    send_event.source = get_world_rank();
+    datatype_size = get_datatype_size(sendtype);
     send_event.size = sendcount * datatype_size;
     send_event.tag = sendtag;
     send_event.datatype = (int64_t) sendtype;
-    send_event.start_time = CBTF_GetTime();
+    send_event.start_time = CBTF_GetTicks();
 #else
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 #endif
 
@@ -5931,31 +6660,31 @@ int mpi_PMPI_Sendrecv
     
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    send_event.stop_time = CBTF_GetTime();
-    send_event.communicator = (int64_t) comm;
+    send_event.stop_time = CBTF_GetTicks();
+    send_event.communicator = get_communicator_id(comm);
     send_event.retval = retval;
     recv_event.start_time = send_event.start_time;
     recv_event.stop_time = send_event.stop_time;
     mpi_record_event(&send_event, CBTF_GetAddressOfFunction(PMPI_Sendrecv));
 
     /* Set up the recv record */
-    recv_event.source = source;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(recv_event.destination));
-    PMPI_Type_size(recvtype, &datatype_size);
+    recv_event.source = get_peer_world_rank(comm, source);
+    recv_event.destination = get_world_rank();
+    datatype_size = get_datatype_size(recvtype);
     recv_event.size = recvcount * datatype_size;
     recv_event.tag = recvtag;
     recv_event.datatype = (int64_t) recvtype;
 
-    recv_event.communicator = (int64_t) comm;
+    recv_event.communicator = get_communicator_id(comm);
     recv_event.retval = retval;
 
-    send_event.stop_time = CBTF_GetTime();
+    send_event.stop_time = CBTF_GetTicks();
     mpi_record_event(&recv_event, CBTF_GetAddressOfFunction(PMPI_Sendrecv));
 #else
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
     mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_Sendrecv));
 #endif
@@ -6001,7 +6730,7 @@ int mpi_PMPI_Sendrecv_replace
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_Sendrecv_replace");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Sendrecv_replace);
 
     if (dotrace) {
 
@@ -6011,19 +6740,19 @@ int mpi_PMPI_Sendrecv_replace
     /* Set up the send record */
     mpi_start_event(&send_event);
     mpi_start_event(&recv_event);
-    send_event.destination = dest;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(send_event.source));
-    PMPI_Type_size(datatype, &datatype_size);
+    send_event.destination = get_peer_world_rank(comm, dest);
+    send_event.source = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     send_event.size = count * datatype_size;
     send_event.tag = sendtag;
     send_event.datatype = (int64_t) datatype;
-    send_event.start_time = CBTF_GetTime();
+    send_event.start_time = CBTF_GetTicks();
 #else
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 #endif
     
@@ -6039,29 +6768,29 @@ int mpi_PMPI_Sendrecv_replace
     
     /*TRACE DETAILS*/
 #if defined(EXTENDEDTRACE)
-    send_event.stop_time = CBTF_GetTime();
-    send_event.communicator = (int64_t) comm;
+    send_event.stop_time = CBTF_GetTicks();
+    send_event.communicator = get_communicator_id(comm);
     send_event.retval = retval;
     recv_event.start_time = send_event.start_time;
     recv_event.stop_time = send_event.stop_time;
     mpi_record_event(&send_event, CBTF_GetAddressOfFunction(PMPI_Sendrecv_replace));
 
     /* Set up the recv record */
-    recv_event.source = source;
-    PMPI_Comm_rank(MPI_COMM_WORLD, &(recv_event.destination));
-    PMPI_Type_size(datatype, &datatype_size);
+    recv_event.source = get_peer_world_rank(comm, source);
+    recv_event.destination = get_world_rank();
+    datatype_size = get_datatype_size(datatype);
     recv_event.size = count * datatype_size;
     recv_event.tag = recvtag;
     recv_event.datatype = (int64_t) datatype;
 
-    recv_event.communicator = (int64_t) comm;
+    recv_event.communicator = get_communicator_id(comm);
     recv_event.retval = retval;
     mpi_record_event(&recv_event, CBTF_GetAddressOfFunction(PMPI_Sendrecv_replace));
 #else
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
     mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_Sendrecv_replace));
 #endif
@@ -6119,15 +6848,15 @@ int mpi_PMPI_Cart_create
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Cart_create");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Cart_create);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6137,10 +6866,10 @@ int mpi_PMPI_Cart_create
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6197,15 +6926,15 @@ int mpi_PMPI_Cart_sub
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Cart_sub");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Cart_sub);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6215,10 +6944,10 @@ int mpi_PMPI_Cart_sub
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6274,15 +7003,15 @@ int mpi_PMPI_Graph_create
 #endif
 #endif
 
-    bool_t dotrace = mpi_do_trace("MPI_Graph_create");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Graph_create);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     if (debug_trace) {
@@ -6297,10 +7026,10 @@ int mpi_PMPI_Graph_create
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6355,15 +7084,15 @@ int mpi_PMPI_Intercomm_create
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Intercomm_create");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Intercomm_create);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
 
@@ -6375,10 +7104,10 @@ int mpi_PMPI_Intercomm_create
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6429,15 +7158,15 @@ int mpi_PMPI_Intercomm_merge
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Intercomm_merge");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Intercomm_merge);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6447,10 +7176,10 @@ int mpi_PMPI_Intercomm_merge
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6502,15 +7231,15 @@ int mpi_PMPI_Comm_free
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Comm_free");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Comm_free);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6520,10 +7249,10 @@ int mpi_PMPI_Comm_free
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6583,15 +7312,15 @@ int mpi_PMPI_Comm_dup
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Comm_dup");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Comm_dup);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6601,10 +7330,10 @@ int mpi_PMPI_Comm_dup
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6650,15 +7379,15 @@ int mpi_PMPI_Comm_create
 #endif
 #endif
 
-    bool_t dotrace = mpi_do_trace("MPI_Comm_create");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Comm_create);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     if (debug_trace) {
@@ -6673,10 +7402,10 @@ int mpi_PMPI_Comm_create
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6728,15 +7457,15 @@ int mpi_PMPI_Comm_split
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Comm_split");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Comm_split);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6746,10 +7475,10 @@ int mpi_PMPI_Comm_split
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6801,15 +7530,15 @@ int mpi_PMPI_Start
       fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Start");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Start);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6819,10 +7548,10 @@ int mpi_PMPI_Start
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6874,15 +7603,15 @@ int mpi_PMPI_Startall
         fflush(stderr);
     }
 
-    bool_t dotrace = mpi_do_trace("MPI_Startall");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_Startall);
 
     if (dotrace) {
 
     mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-    event.start_time = CBTF_GetTime();
+    event.start_time = CBTF_GetTicks();
 #endif
 
     }
@@ -6892,10 +7621,10 @@ int mpi_PMPI_Startall
     if (dotrace) {
 
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-    event.stop_time = CBTF_GetTime();
+    event.stop_time = CBTF_GetTicks();
 #endif
 
     /*TRACE DETAILS*/
@@ -6953,7 +7682,7 @@ int mpi_PMPI_File_open
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_open");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_open);
 
     if (debug_trace) {
       fprintf(stderr, "WRAPPER, mpi_PMPI_File_open called, comm=%d, dotrace=%d \n", comm, dotrace);
@@ -6963,9 +7692,9 @@ int mpi_PMPI_File_open
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -6973,10 +7702,10 @@ int mpi_PMPI_File_open
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_open));
     }
@@ -7018,7 +7747,7 @@ int mpi_PMPI_File_write
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_write");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_write);
 
     if (debug_trace) {
       fprintf(stderr, "WRAPPER, mpi_PMPI_File_write called, count=%d, dotrace=%d \n", count, dotrace);
@@ -7028,9 +7757,9 @@ int mpi_PMPI_File_write
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7038,10 +7767,10 @@ int mpi_PMPI_File_write
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_write));
     }
@@ -7083,7 +7812,7 @@ int mpi_PMPI_File_write_ordered
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_write_ordered");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_write_ordered);
 
     if (debug_trace) {
       fprintf(stderr, "WRAPPER, mpi_PMPI_File_write_ordered called, count=%d, dotrace=%d \n", count, dotrace);
@@ -7093,9 +7822,9 @@ int mpi_PMPI_File_write_ordered
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7103,10 +7832,10 @@ int mpi_PMPI_File_write_ordered
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_write_ordered));
     }
@@ -7148,14 +7877,14 @@ int mpi_PMPI_File_write_shared
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_write_shared");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_write_shared);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7163,10 +7892,10 @@ int mpi_PMPI_File_write_shared
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_write_shared));
     }
@@ -7208,14 +7937,14 @@ int mpi_PMPI_File_write_all
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_write_all");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_write_all);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7223,10 +7952,10 @@ int mpi_PMPI_File_write_all
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_write_all));
     }
@@ -7262,14 +7991,14 @@ int mpi_PMPI_File_seek
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_seek");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_seek);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7277,10 +8006,10 @@ int mpi_PMPI_File_seek
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-       event.stop_time = CBTF_GetTime();
+       event.stop_time = CBTF_GetTicks();
 #endif
        mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_seek));
     }
@@ -7316,14 +8045,14 @@ int mpi_PMPI_File_seek_shared
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_seek_shared");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_seek_shared);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7331,10 +8060,10 @@ int mpi_PMPI_File_seek_shared
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-       event.stop_time = CBTF_GetTime();
+       event.stop_time = CBTF_GetTicks();
 #endif
        mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_seek_shared));
     }
@@ -7379,14 +8108,14 @@ int mpi_PMPI_File_set_view
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_set_view");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_set_view);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7394,10 +8123,10 @@ int mpi_PMPI_File_set_view
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_set_view));
     }
@@ -7431,7 +8160,7 @@ int mpi_PMPI_File_close
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_close");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_close);
 
     if (debug_trace) {
       fprintf(stderr, "WRAPPER, mpi_PMPI_File_close called, dotrace=%d \n", dotrace);
@@ -7441,9 +8170,9 @@ int mpi_PMPI_File_close
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7451,10 +8180,10 @@ int mpi_PMPI_File_close
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_close));
     }
@@ -7494,14 +8223,14 @@ int mpi_PMPI_File_delete
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_delete");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_delete);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7509,10 +8238,10 @@ int mpi_PMPI_File_delete
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_delete));
     }
@@ -7549,14 +8278,14 @@ int mpi_PMPI_File_set_size
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_set_size");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_set_size);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7564,10 +8293,10 @@ int mpi_PMPI_File_set_size
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_set_size));
     }
@@ -7603,14 +8332,14 @@ int mpi_PMPI_File_get_size
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_size");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_size);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7618,10 +8347,10 @@ int mpi_PMPI_File_get_size
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_size));
     }
@@ -7657,14 +8386,14 @@ int mpi_PMPI_File_get_position
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_position");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_position);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7672,10 +8401,10 @@ int mpi_PMPI_File_get_position
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_position));
     }
@@ -7710,14 +8439,14 @@ int mpi_PMPI_File_get_position_shared
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_position_shared");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_position_shared);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7725,10 +8454,10 @@ int mpi_PMPI_File_get_position_shared
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_position_shared));
     }
@@ -7762,14 +8491,14 @@ int mpi_PMPI_File_get_group
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_group");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_group);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7777,10 +8506,10 @@ int mpi_PMPI_File_get_group
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_group));
     }
@@ -7814,14 +8543,14 @@ int mpi_PMPI_File_get_amode
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_amode");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_amode);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7829,10 +8558,10 @@ int mpi_PMPI_File_get_amode
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_amode));
     }
@@ -7866,14 +8595,14 @@ int mpi_PMPI_File_set_info
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_set_info");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_set_info);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7881,10 +8610,10 @@ int mpi_PMPI_File_set_info
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_set_info));
     }
@@ -7919,14 +8648,14 @@ int mpi_PMPI_File_get_info
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_info");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_info);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7934,10 +8663,10 @@ int mpi_PMPI_File_get_info
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_info));
     }
@@ -7974,14 +8703,14 @@ int mpi_PMPI_File_get_view
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_get_view");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_get_view);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -7989,10 +8718,10 @@ int mpi_PMPI_File_get_view
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_get_view));
     }
@@ -8030,14 +8759,14 @@ int mpi_PMPI_File_read
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_read");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_read);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8045,10 +8774,10 @@ int mpi_PMPI_File_read
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_read));
     }
@@ -8086,14 +8815,14 @@ int mpi_PMPI_File_read_shared
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_read_shared");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_read_shared);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8101,10 +8830,10 @@ int mpi_PMPI_File_read_shared
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_read_shared));
     }
@@ -8142,14 +8871,14 @@ int mpi_PMPI_File_read_ordered
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_read_ordered");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_read_ordered);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8157,10 +8886,10 @@ int mpi_PMPI_File_read_ordered
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_read_ordered));
     }
@@ -8198,14 +8927,14 @@ int mpi_PMPI_File_read_all
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_read_all");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_read_all);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8213,10 +8942,10 @@ int mpi_PMPI_File_read_all
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_read_all));
     }
@@ -8254,14 +8983,14 @@ int mpi_PMPI_File_read_at
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_read_at");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_read_at);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8269,10 +8998,10 @@ int mpi_PMPI_File_read_at
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_read_at));
     }
@@ -8311,14 +9040,14 @@ int mpi_PMPI_File_read_at_all
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_read_at_all");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_read_at_all);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8326,10 +9055,10 @@ int mpi_PMPI_File_read_at_all
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_read_at_all));
     }
@@ -8372,14 +9101,14 @@ int mpi_PMPI_File_write_at
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_write_at");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_write_at);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8387,10 +9116,10 @@ int mpi_PMPI_File_write_at
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_write_at));
     }
@@ -8433,14 +9162,14 @@ int mpi_PMPI_File_write_at_all
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_write_at_all");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_write_at_all);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8448,10 +9177,10 @@ int mpi_PMPI_File_write_at_all
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_write_at_all));
     }
@@ -8490,14 +9219,14 @@ int mpi_PMPI_File_iread_at
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_iread_at");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_iread_at);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8505,10 +9234,10 @@ int mpi_PMPI_File_iread_at
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_iread_at));
     }
@@ -8547,14 +9276,14 @@ int mpi_PMPI_File_iread
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_iread");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_iread);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8562,10 +9291,10 @@ int mpi_PMPI_File_iread
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_iread));
     }
@@ -8602,14 +9331,14 @@ int mpi_PMPI_File_iread_shared
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_iread_shared");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_iread_shared);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8617,10 +9346,10 @@ int mpi_PMPI_File_iread_shared
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_iread_shared));
     }
@@ -8663,14 +9392,14 @@ int mpi_PMPI_File_iwrite_at
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_iwrite_at");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_iwrite_at);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8678,10 +9407,10 @@ int mpi_PMPI_File_iwrite_at
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_iwrite_at));
     }
@@ -8722,14 +9451,14 @@ int mpi_PMPI_File_iwrite
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_iwrite");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_iwrite);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8737,10 +9466,10 @@ int mpi_PMPI_File_iwrite
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_iwrite));
     }
@@ -8782,14 +9511,14 @@ int mpi_PMPI_File_iwrite_shared
 #endif
 #endif
     
-    bool_t dotrace = mpi_do_trace("MPI_File_iwrite_shared");
+    bool_t dotrace = mpi_do_trace(CBTF_MPITraceable_File_iwrite_shared);
 
     if (dotrace) {
       mpi_start_event(&event);
 #if defined(PROFILE)
-	start_time = CBTF_GetTime();
+	start_time = CBTF_GetTicks();
 #else
-      event.start_time = CBTF_GetTime();
+      event.start_time = CBTF_GetTicks();
 #endif
     }
 
@@ -8797,10 +9526,10 @@ int mpi_PMPI_File_iwrite_shared
 
     if (dotrace) {
 #if defined(PROFILE)
-    event.time = CBTF_GetTime() - start_time;
+    event.time = CBTF_GetTicks() - start_time;
 #else
 
-      event.stop_time = CBTF_GetTime();
+      event.stop_time = CBTF_GetTicks();
 #endif
       mpi_record_event(&event, CBTF_GetAddressOfFunction(PMPI_File_iwrite_shared));
     }
@@ -66,8 +66,18 @@ const char* const data_suffix = "cbtf-data";
 typedef struct {
 
     CBTF_DataHeader header;  /**< Header for following data blob. */
-    CBTF_pcsamp_data data;   /**< Actual data blob. */
-    CBTF_PCData buffer;      /**< PC sampling data buffer. */
+    CBTF_pcsamp_data* data;  /**< Actual data blob. */
+    CBTF_PCData* buffer;     /**< PC sampling data buffer. */
+
+    /**
+     * Double buffered data blobs and sampling buffers. Samples are taken into
+     * the current one while the other may still be owned by the background
+     * flusher (see cbtf_collector_send_async).
+     */
+    CBTF_pcsamp_data blobs[2];
+    CBTF_PCData buffers[2];
+    volatile bool in_flight[2];
+    unsigned current;
 
 #if defined (HAVE_OMPT)
     /* these are ompt specific. */
@@ -162,18 +172,20 @@ static void initialize_data(TLS* tls)
     tls->header.addr_end = 0;
     
     /* Initialize the actual data blob */
-    tls->data.pc.pc_val = tls->buffer.pc;
-    tls->data.count.count_val = tls->buffer.count;
+    tls->data = &tls->blobs[tls->current];
+    tls->buffer = &tls->buffers[tls->current];
+    tls->data->pc.pc_val = tls->buffer->pc;
+    tls->data->count.count_val = tls->buffer->count;
 
     /* Re-initialize the actual data blob */
-    tls->data.pc.pc_len = 0;
-    tls->data.count.count_len = 0;
+    tls->data->pc.pc_len = 0;
+    tls->data->count.count_len = 0;
 
     /* Re-initialize the sampling buffer */
-    tls->buffer.addr_begin = ~0UL;
-    tls->buffer.addr_end = 0;
-    tls->buffer.length = 0;
-    memset(tls->buffer.hash_table, 0, sizeof(tls->buffer.hash_table));
+    tls->buffer->addr_begin = ~0UL;
+    tls->buffer->addr_end = 0;
+    tls->buffer->length = 0;
+    memset(tls->buffer->hash_table, 0, sizeof(tls->buffer->hash_table));
 }
 
 
@@ -231,14 +243,14 @@ static void send_samples (TLS* tls)
     Assert(tls != NULL);
 
     tls->header.time_end = CBTF_GetTime();
-    tls->header.addr_begin = tls->buffer.addr_begin;
-    tls->header.addr_end = tls->buffer.addr_end;
+    tls->header.addr_begin = tls->buffer->addr_begin;
+    tls->header.addr_end = tls->buffer->addr_end;
 
     /* rank is not filled until mpi_init finished. safe to set here*/
     tls->header.rank = monitor_mpi_comm_rank();
 
-    tls->data.pc.pc_len = tls->buffer.length;
-    tls->data.count.count_len = tls->buffer.length;
+    tls->data->pc.pc_len = tls->buffer->length;
+    tls->data->count.count_len = tls->buffer->length;
 
 #ifndef NDEBUG
     if (IsCollectorDebugEnabled) {
@@ -246,11 +258,22 @@ static void send_samples (TLS* tls)
 	    tls->header.pid, tls->header.omp_tid,
             (uint64_t)tls->header.time_begin, (uint64_t)tls->header.time_end,
             tls->header.addr_begin, tls->header.addr_end,
-            tls->data.pc.pc_len);
+            tls->data->pc.pc_len);
     }
 #endif
 
-    cbtf_collector_send(&tls->header, (xdrproc_t)xdr_CBTF_pcsamp_data, &tls->data);
+    /* Hand the blob off to the background flusher if one is running and
+     * continue sampling into the other buffer. Otherwise, and when the other
+     * buffer is still owned by the flusher, send it here rather than wait.
+     */
+    if (!tls->in_flight[tls->current ^ 1] &&
+	cbtf_collector_send_async(&tls->header,
+				  (xdrproc_t)xdr_CBTF_pcsamp_data, tls->data,
+				  &tls->in_flight[tls->current])) {
+	tls->current ^= 1;
+    } else {
+	cbtf_collector_send(&tls->header, (xdrproc_t)xdr_CBTF_pcsamp_data, tls->data);
+    }
 
     /* Re-initialize the data blob's header */
     initialize_data(tls);
@@ -319,7 +342,7 @@ static void serviceTimerHandler(const ucontext_t* context)
 
 
     /* Update the sampling buffer and check if it has been filled */
-    if(CBTF_UpdatePCData(pc, &tls->buffer)) {
+    if(CBTF_UpdatePCData(pc, tls->buffer)) {
 	/* Send these samples */
 	send_samples(tls);
     }
@@ -382,12 +405,12 @@ void cbtf_collector_start(const CBTF_DataHeader* header)
 
     /* Initialize the actual data blob */
     memcpy(&tls->header, header, sizeof(CBTF_DataHeader));
+    tls->current = 0;
+    tls->in_flight[0] = tls->in_flight[1] = false;
     initialize_data(tls);
 
-    tls->data.interval = 
+    tls->blobs[0].interval = tls->blobs[1].interval =
 	(uint64_t)(1000000000) / (uint64_t)(args.sampling_rate);
-    tls->data.pc.pc_val = tls->buffer.pc;
-    tls->data.count.count_val = tls->buffer.count;
 
     /* We can not assign mpi rank in the header at this point as it may not
      * be set yet. assign an integer tid value.  omp_tid is used regardless of
@@ -417,7 +440,7 @@ void cbtf_collector_start(const CBTF_DataHeader* header)
 #endif
 
     /* Begin sampling */
-    CBTF_Timer(tls->data.interval, serviceTimerHandler);
+    CBTF_Timer(tls->data->interval, serviceTimerHandler);
 }
 
 
@@ -506,10 +529,10 @@ void cbtf_collector_stop()
     if (IsCollectorDebugEnabled) {
 #if defined(CBTF_SERVICE_USE_FILEIO)
 	fprintf(stderr,"[%ld,%d] collector_stop  buffer.length:%d\n",
-	    tls->header.pid, tls->header.omp_tid,tls->buffer.length);
+	    tls->header.pid, tls->header.omp_tid,tls->buffer->length);
 #else
 	fprintf(stderr,"[%ld,%d] collector_stop  buffer.length:%d connected_to_mrnet:%d\n",
-	    tls->header.pid, tls->header.omp_tid,tls->buffer.length,cbtf_connected_to_mrnet());
+	    tls->header.pid, tls->header.omp_tid,tls->buffer->length,cbtf_connected_to_mrnet());
 #endif
     }
 #endif
@@ -520,11 +543,14 @@ void cbtf_collector_stop()
     tls->header.time_end = CBTF_GetTime();
 
     /* Are there any unsent samples? */
-    if(tls->buffer.length > 0) {
+    if(tls->buffer->length > 0) {
 	/* Send these samples */
 	send_samples(tls);
     }
 
+    /* Wait for any blobs still owned by the background flusher */
+    cbtf_collector_wait_async();
+
     /* Destroy our thread-local storage */
 #ifdef CBTF_SERVICE_USE_EXPLICIT_TLS
     destroy_explicit_tls();
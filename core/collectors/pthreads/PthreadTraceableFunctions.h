@@ -50,4 +50,23 @@
 
 #endif
 
+/**
+ * Every function wrapped by the pthreads collector. Expands into the identifiers
+ * that the wrappers pass to pthreads_do_trace(), which index the bitmask of traced
+ * functions built from the traced function list when collection starts.
+ */
+#define CBTF_PTHREAD_TRACEABLE_FUNCTIONS(F) \
+    F(pthread_create) F(pthread_mutex_init) F(pthread_mutex_destroy) \
+    F(pthread_mutex_lock) F(pthread_mutex_trylock) F(pthread_mutex_unlock) \
+    F(pthread_cond_init) F(pthread_cond_destroy) F(pthread_cond_signal) \
+    F(pthread_cond_broadcast) F(pthread_cond_wait) F(pthread_cond_timedwait)
+
+/** Identifiers of the functions wrapped by the pthreads collector. */
+typedef enum {
+#define CBTF_PTHREAD_TRACEABLE_ID(name) CBTF_PthreadTraceable_##name,
+    CBTF_PTHREAD_TRACEABLE_FUNCTIONS(CBTF_PTHREAD_TRACEABLE_ID)
+#undef CBTF_PTHREAD_TRACEABLE_ID
+    CBTF_PthreadTraceableFunctionCount
+} CBTF_PthreadTraceableFunction;
+
 #endif
@@ -29,6 +29,7 @@
 #include "KrellInstitute/Services/Assert.h"
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Services/Time.h"
+#include "PthreadTraceableFunctions.h"
 
 
 #if !defined(CBTF_SERVICE_USE_OFFLINE)
@@ -42,6 +43,8 @@
 #include <sys/types.h>
 #include <pthread.h>
 
+extern bool_t pthreads_do_trace(CBTF_PthreadTraceableFunction);
+
 #if defined (CBTF_SERVICE_USE_OFFLINE) && !defined(CBTF_SERVICE_BUILD_STATIC)
 int pthread_create(pthread_t *thread, const pthread_attr_t *attr,
                           void *(*start_routine) (void *), void *arg)
@@ -56,7 +59,7 @@ int pthreads_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_create");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_create);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -110,7 +113,7 @@ int pthreads_pthread_mutex_init( pthread_mutex_t* mtx,
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_mutex_init");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_mutex_init);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -161,7 +164,7 @@ int pthreads_pthread_mutex_init( pthread_mutex_t* mtx)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_mutex_destroy");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_mutex_destroy);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -212,7 +215,7 @@ int pthreads_pthread_mutex_lock( pthread_mutex_t* mtx)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_mutex_lock");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_mutex_lock);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -263,7 +266,7 @@ int pthreads_pthread_mutex_unlock( pthread_mutex_t* mtx)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_mutex_unlock");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_mutex_unlock);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -314,7 +317,7 @@ int pthreads_pthread_mutex_trylock( pthread_mutex_t* mtx)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_mutex_trylock");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_mutex_trylock);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -369,7 +372,7 @@ int pthreads_pthread_cond_init(pthread_cond_t* cnd, const pthread_condattr_t* at
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_cond_init");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_cond_init);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -420,7 +423,7 @@ int pthreads_pthread_cond_destroy(pthread_cond_t* cnd)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_cond_destroy");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_cond_destroy);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -471,7 +474,7 @@ int pthreads_pthread_cond_signal(pthread_cond_t* cnd)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_cond_signal");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_cond_signal);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -522,7 +525,7 @@ int pthreads_pthread_cond_broadcast(pthread_cond_t* cnd)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_cond_broadcast");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_cond_broadcast);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -573,7 +576,7 @@ int pthreads_pthread_cond_wait(pthread_cond_t* cnd, pthread_mutex_t* mtx)
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_cond_wait");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_cond_wait);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
@@ -628,7 +631,7 @@ int pthreads_pthread_cond_timedwait(pthread_cond_t* cnd, pthread_mutex_t* mtx,
     int retval,eval;
     CBTF_pthreadt_event event;
 
-    bool_t dotrace = pthreads_do_trace("pthread_cond_timedwait");
+    bool_t dotrace = pthreads_do_trace(CBTF_PthreadTraceable_pthread_cond_timedwait);
 
     if (dotrace) {
         eval = pthreads_start_event(&event);
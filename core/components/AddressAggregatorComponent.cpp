@@ -21,6 +21,7 @@
 #include <boost/bind.hpp>
 #include <boost/operators.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 #include <typeinfo>
 #include <string>
 #include <sstream>
@@ -28,6 +29,8 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <deque>
+#include <map>
 
 #include <KrellInstitute/CBTF/Component.hpp>
 #include <KrellInstitute/CBTF/Type.hpp>
@@ -38,6 +41,7 @@
 #include "KrellInstitute/Core/AddressBuffer.hpp"
 #include "KrellInstitute/Core/AddressRange.hpp"
 #include "KrellInstitute/Core/Blob.hpp"
+#include "KrellInstitute/Core/BlobView.hpp"
 #if 0
 #include "KrellInstitute/Core/Graph.hpp"
 #include "KrellInstitute/Core/PCData.hpp"
@@ -102,9 +106,27 @@ bool is_time_aggregator_events_enabled =
 
     bool is_defer_emit = (getenv("CBTF_DEFER_AGGR_EMIT") != NULL);
 
+    // Number of worker threads aggregating data blobs on a leaf CP. Defaults
+    // to the number of cores on the CP node and can be set with the
+    // CBTF_AGGR_THREADS environment variable. One means no worker threads.
+    unsigned getNumAggregatorThreads()
+    {
+	const char* threads = getenv("CBTF_AGGR_THREADS");
+	if (threads != NULL && atoi(threads) > 0) {
+	    return atoi(threads);
+	}
+	unsigned cores = boost::thread::hardware_concurrency();
+	return (cores > 0) ? cores : 1;
+    }
+
     bool is_finished = false;
     int data_blobs = 0;
     int handled_buffers = 0;
+
+    // address buffers received from children and not yet merged. A deque
+    // so that the pointers to earlier buffers stay valid as more arrive.
+    std::deque<AddressBuffer> child_buffers;
+    std::vector<const AddressBuffer*> child_pointers;
     long numTerminated = 0;
 
     // vector of incoming threadnames. For each thread we expect
@@ -152,6 +174,7 @@ bool is_time_aggregator_events_enabled =
 	    flushOutput(output);
 	}
 #endif
+	return true;
     }
 
     void printAddrThreadCountMap(AddrThreadCountMap& addrTM)
@@ -283,6 +306,12 @@ private:
 	init_TopologyInfo();
     }
 
+    /** Destructor. */
+    ~AddressAggregator()
+    {
+	stopWorkers();
+    }
+
     // While this informs us of how may BE's will be connecting it is
     // used to initialize the local component knowledge of the TopologyInfo
     // members we are interested once and only once as early as possible.
@@ -376,6 +405,7 @@ private:
 #endif
 
 	if (isLeafCP() && numTerminated == threadnames.size()) {
+	    drainWorkers();
 #ifndef NDEBUG
 	    if (is_trace_aggregator_events_enabled) {
 		output << debug_prefix.str()
@@ -412,6 +442,7 @@ private:
     void finishedHandler(const bool& in)
     {
 	if (isLeafCP()) {
+	    drainWorkers();
 	    return;
 	}
 
@@ -531,7 +562,41 @@ private:
 	// From this point on only leafCP nodes decode and handle
 	// the passed in performance data blobs.
 
-	Blob perfdatablob(in.get()->data.data_len, in.get()->data.data_val);
+	// Hand the blob to the worker threads when there are any.
+	startWorkers();
+	if (!workers.empty()) {
+	    queueBlob(in);
+	    return;
+	}
+
+	ThreadName threadname;
+	AddressBuffer buf;
+	total_data_size += aggregateBlob(perfdata, in, threadname, buf);
+
+#ifndef NDEBUG
+        if (is_debug_aggregator_events_enabled) {
+	    output << debug_prefix.str()
+	    << "AddressAggregator::cbtf_protocol_blob_Handler Aggregating blob"
+	    << " addresses for data from thread:" << threadname
+	    << " total data bytes: " << total_data_size
+	    << std::endl;
+	    flushOutput(output);
+	}
+#endif
+	abuffer.updateAddressCounts(buf);
+
+	// load balance on address counts or raw time.
+	updateAddrThreadCountMap(buf, addrThreadCount, threadname);
+    }
+
+    // Decode one performance data blob and aggregate its addresses into
+    // the passed buffer. Safe to call concurrently with distinct PerfData
+    // objects and buffers. Returns the data size for total_data_size.
+    int aggregateBlob(PerfData& perfdata,
+		      const boost::shared_ptr<CBTF_Protocol_Blob>& in,
+		      ThreadName& threadname, AddressBuffer& buf)
+    {
+	BlobView perfdatablob(in.get()->data.data_len, in.get()->data.data_val);
 
 	// decode this blobs data header and create a threadname object
 	// and collector id object.
@@ -540,37 +605,178 @@ private:
         unsigned header_size = perfdatablob.getXDRDecoding(
             reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader), &header
             );
-        ThreadName threadname(header.host,header.pid,header.posix_tid,header.rank,header.omp_tid);
+        threadname = ThreadName(header.host,header.pid,header.posix_tid,header.rank,header.omp_tid);
 
 	// find the actual data blob after the header and create a Blob.
 	// TODO: Map the incoming data size to it's thread and increment as new
 	// data for same thread arrives.  Could be use to identify threads
 	// that are generating more data than others. REDUCTION.
 	unsigned data_size = perfdatablob.getSize() - header_size;
-	total_data_size += data_size;
 
-	AddressBuffer buf;
 	// update aggregate addresses and counts.
-	total_data_size += perfdata.aggregate(perfdatablob,buf);
+	data_size += perfdata.aggregate(perfdatablob,buf);
 
-#ifndef NDEBUG
-        if (is_debug_aggregator_events_enabled) {
-	    output << debug_prefix.str()
-	    << "AddressAggregator::cbtf_protocol_blob_Handler Aggregating blob"
-	    << " addresses for data from thread:" << threadname
-	    << " total data bytes: " << total_data_size
-	    << std::endl;
-	    flushOutput(output);
+        xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader), reinterpret_cast<char*>(&header));
+
+	return data_size;
+    }
+
+    // Leaf CP worker threads. Data blobs are queued, in arrival order, for
+    // the workers to decode concurrently. Each worker accumulates addresses
+    // into its own AddressBuffer, and these are merged into abuffer when the
+    // workers are drained before emitting. The per-blob buffers are kept,
+    // by arrival order, until the per thread maps can be updated with them
+    // in that same order so the results match serial aggregation.
+
+    /** Data blob waiting for a worker, with its arrival order. */
+    typedef std::pair<uint64_t, boost::shared_ptr<CBTF_Protocol_Blob> >
+	PendingBlob;
+
+    /** Aggregated data blob waiting to update the per thread maps. */
+    struct AggregatedBlob
+    {
+	ThreadName threadname;
+	AddressBuffer buf;
+	int data_size;
+    };
+
+    void startWorkers()
+    {
+	if (workers_started) {
+	    return;
 	}
-#endif
-	abuffer.updateAddressCounts(buf);
+	workers_started = true;
 
-	// load balance on address counts or raw time.
-	updateAddrThreadCountMap(buf, addrThreadCount, threadname);
+	unsigned count = getNumAggregatorThreads();
+	if (count < 2) {
+	    return;
+	}
 
-        xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader), reinterpret_cast<char*>(&header));
+	worker_buffers.resize(count);
+	for (unsigned i = 0; i < count; ++i) {
+	    workers.push_back(boost::shared_ptr<boost::thread>(new boost::thread(
+		boost::bind(&AddressAggregator::workerLoop, this, i)
+		)));
+	}
+    }
 
+    void stopWorkers()
+    {
+	{
+	    boost::lock_guard<boost::mutex> lock(worker_mutex);
+	    stopping_workers = true;
+	}
+	work_available.notify_all();
+	for (unsigned i = 0; i < workers.size(); ++i) {
+	    workers[i]->join();
+	}
+	workers.clear();
+    }
 
+    void workerLoop(unsigned index)
+    {
+	// Each worker needs its own PerfData for its collector lookup cache.
+	PerfData worker_perfdata;
+
+	boost::unique_lock<boost::mutex> lock(worker_mutex);
+	while (true) {
+	    while (pending_blobs.empty() && !stopping_workers) {
+		work_available.wait(lock);
+	    }
+	    if (pending_blobs.empty()) {
+		return;
+	    }
+
+	    PendingBlob pending = pending_blobs.front();
+	    pending_blobs.pop_front();
+	    ++busy_workers;
+	    work_done.notify_all();
+	    lock.unlock();
+
+	    AggregatedBlob result;
+	    result.data_size = aggregateBlob(worker_perfdata, pending.second,
+					     result.threadname, result.buf);
+	    worker_buffers[index].updateAddressCounts(result.buf);
+	    pending.second.reset();
+
+	    lock.lock();
+	    aggregated_blobs[pending.first].threadname = result.threadname;
+	    aggregated_blobs[pending.first].buf.addresscounts.swap(
+		result.buf.addresscounts
+		);
+	    aggregated_blobs[pending.first].data_size = result.data_size;
+	    --busy_workers;
+	    work_done.notify_all();
+	}
+    }
+
+    void queueBlob(const boost::shared_ptr<CBTF_Protocol_Blob>& in)
+    {
+	{
+	    boost::unique_lock<boost::mutex> lock(worker_mutex);
+
+	    // Bound the number of queued blobs held in memory.
+	    while (pending_blobs.size() >= (4 * workers.size())) {
+		work_done.wait(lock);
+	    }
+	    pending_blobs.push_back(std::make_pair(next_blob, in));
+	    ++next_blob;
+	}
+	work_available.notify_one();
+
+	applyAggregatedBlobs();
+    }
+
+    // Update the per thread maps with aggregated blobs, in arrival order.
+    void applyAggregatedBlobs()
+    {
+	while (true) {
+	    AggregatedBlob result;
+	    {
+		boost::lock_guard<boost::mutex> lock(worker_mutex);
+		std::map<uint64_t, AggregatedBlob>::iterator i =
+		    aggregated_blobs.begin();
+		if (i == aggregated_blobs.end() || i->first != next_applied_blob) {
+		    return;
+		}
+		result.threadname = i->second.threadname;
+		result.buf.addresscounts.swap(i->second.buf.addresscounts);
+		result.data_size = i->second.data_size;
+		aggregated_blobs.erase(i);
+		++next_applied_blob;
+	    }
+
+	    total_data_size += result.data_size;
+	    updateAddrThreadCountMap(result.buf, addrThreadCount,
+				     result.threadname);
+	}
+    }
+
+    // Wait for the workers to aggregate every queued blob, then merge
+    // their results.
+    void drainWorkers()
+    {
+	if (workers.empty()) {
+	    return;
+	}
+
+	{
+	    boost::unique_lock<boost::mutex> lock(worker_mutex);
+	    while (!pending_blobs.empty() || busy_workers > 0) {
+		work_done.wait(lock);
+	    }
+	}
+
+	applyAggregatedBlobs();
+
+	std::vector<const AddressBuffer*> merged;
+	for (unsigned i = 0; i < worker_buffers.size(); ++i) {
+	    merged.push_back(&worker_buffers[i]);
+	}
+	abuffer.updateAddressCounts(merged);
+	for (unsigned i = 0; i < worker_buffers.size(); ++i) {
+	    worker_buffers[i].addresscounts.clear();
+	}
     }
 
 
@@ -651,11 +857,17 @@ private:
 	    flushOutput(output);
 	}
 #endif
-	AddressCounts::const_iterator aci;
-	for (aci = in.addresscounts.begin(); aci != in.addresscounts.end(); ++aci) {
-
-	    AddressCounts::iterator lb = abuffer.addresscounts.lower_bound(aci->first);
-	    abuffer.updateAddressCounts(aci->first.getValue(), aci->second);
+	// Hold on to the children's buffers until all have arrived so that
+	// they are merged with a single linear k-way pass over the sorted
+	// counts. The last child's buffer is merged in place without a copy.
+	if (handled_buffers < getNumChildren()) {
+	    child_buffers.push_back(in);
+	    child_pointers.push_back(&child_buffers.back());
+	} else {
+	    child_pointers.push_back(&in);
+	    abuffer.updateAddressCounts(child_pointers);
+	    child_pointers.clear();
+	    child_buffers.clear();
 	}
 
 
@@ -773,6 +985,20 @@ private:
     AddrThreadCountMap addrThreadCount;
     PerfData perfdata;
 
+    // leaf CP worker threads and the state they share.
+    bool workers_started = false;
+    bool stopping_workers = false;
+    std::vector<boost::shared_ptr<boost::thread> > workers;
+    std::vector<AddressBuffer> worker_buffers;
+    boost::mutex worker_mutex;
+    boost::condition_variable work_available;
+    boost::condition_variable work_done;
+    std::deque<PendingBlob> pending_blobs;
+    std::map<uint64_t, AggregatedBlob> aggregated_blobs;
+    unsigned busy_workers = 0;
+    uint64_t next_blob = 0;
+    uint64_t next_applied_blob = 0;
+
 }; // class AddressAggregator
 
 KRELL_INSTITUTE_CBTF_REGISTER_FACTORY_FUNCTION(AddressAggregator)
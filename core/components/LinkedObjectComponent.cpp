@@ -19,8 +19,11 @@
 /** @file LinkedObjectComponent. */
 
 #include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/operators.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <mrnet/MRNet.h>
 #include <typeinfo>
 #include <algorithm>
@@ -107,6 +110,58 @@ namespace {
 	 return _MaxLeafDistance;
     }
 
+    /**
+     * Linked object set of a thread. Threads with identical linked object sets
+     * (typically all the threads of a rank, and all the ranks of a node) share
+     * a single immutable copy of the set.
+     */
+    typedef boost::shared_ptr<const LinkedObjectVec> LinkedObjectVecPtr;
+
+    /** Hash of the contents of a linked object set. */
+    struct LinkedObjectVecHash
+    {
+	std::size_t operator()(const LinkedObjectVecPtr& objects) const
+	{
+	    std::size_t seed = 0;
+	    for (LinkedObjectVec::const_iterator
+		     i = objects->begin(); i != objects->end(); ++i) {
+		boost::hash_combine(seed, static_cast<const std::string&>(i->path));
+		boost::hash_combine(seed, i->range.getBegin().getValue());
+		boost::hash_combine(seed, i->range.getEnd().getValue());
+		boost::hash_combine(seed, i->time.getBegin().getValue());
+		boost::hash_combine(seed, i->time.getEnd().getValue());
+		boost::hash_combine(seed, i->is_executable);
+	    }
+	    return seed;
+	}
+    };
+
+    /** Equality of the contents of two linked object sets. */
+    struct LinkedObjectVecEqual
+    {
+	bool operator()(const LinkedObjectVecPtr& lhs,
+			const LinkedObjectVecPtr& rhs) const
+	{
+	    if (lhs->size() != rhs->size()) {
+		return false;
+	    }
+	    for (LinkedObjectVec::const_iterator i = lhs->begin(), j = rhs->begin();
+		 i != lhs->end(); ++i, ++j) {
+		if (!(*i == *j) || (i->is_executable != j->is_executable)) {
+		    return false;
+		}
+	    }
+	    return true;
+	}
+    };
+
+    /** Unique linked object sets. */
+    typedef boost::unordered_set<LinkedObjectVecPtr, LinkedObjectVecHash,
+				 LinkedObjectVecEqual> LinkedObjectVecSet;
+
+    /** Map of threadname to its shared linked object set. */
+    typedef std::map<ThreadName, LinkedObjectVecPtr> SharedAddressSpace;
+
     bool initialized_topology_info = false;
 
     void init_TopologyInfo() {
@@ -286,37 +341,45 @@ private:
         if (numTerminated == numThreads && addressspace.size() == numThreads) {
 
 
-	    AddressCounts ac = abuffer.addresscounts;
+	    const AddressCounts& ac = abuffer.addresscounts;
 	    // ICP and FE levels do not have counts. Possibly due to no buffer yet?
 	    bool havecounts = (ac.size() > 0) ? true : false ;
 	    AddressSpace found;
 
-	    AddressSpace::iterator i;
-	    for (AddressSpace::iterator i = addressspace.begin(); i != addressspace.end(); ++i) {
+	    // Reduce each unique linked object set only once, no matter how
+	    // many threads share it.
+	    boost::unordered_map<LinkedObjectVecPtr, LinkedObjectVec> reduced;
 
-		LinkedObjectVec tmp;
-		for (LinkedObjectVec::iterator k = (*i).second.begin();
-			     k != (*i).second.end(); ++k) {
+	    for (SharedAddressSpace::const_iterator i = addressspace.begin(); i != addressspace.end(); ++i) {
 
-		    bool has_sample = false;
-		    AddressRange addr_range((*k).getAddressRange());
-		    AddressCounts::const_iterator aci;
-		    for (aci=ac.equal_range(addr_range.getBegin()).first;
-			 aci!=ac.equal_range(addr_range.getEnd()).second;aci++) {
-			has_sample = true;
-			break;
-		    }
+		boost::unordered_map<LinkedObjectVecPtr, LinkedObjectVec>::iterator
+		    r = reduced.find((*i).second);
+		if (r == reduced.end()) {
+		    r = reduced.insert(
+			std::make_pair((*i).second, LinkedObjectVec())
+			).first;
 
-		    if(has_sample || !havecounts) {
+		    for (LinkedObjectVec::const_iterator k = (*i).second->begin();
+			 k != (*i).second->end(); ++k) {
+
+			// Is there a sampled address within [begin, end]?
+			AddressRange addr_range((*k).getAddressRange());
+			AddressCounts::const_iterator aci =
+			    ac.lower_bound(addr_range.getBegin());
+			bool has_sample = (aci != ac.end()) &&
+			    !(addr_range.getEnd() < aci->first);
+
+			if(has_sample || !havecounts) {
 #ifndef NDEBUG
-			if (is_trace_linkedobject_events_enabled) {
-    			    output << debug_prefix.str()
-				<< "\t HAS SAMPLE name:" << (*k).getPath()
-				<< " range:" << (*k).getAddressRange()
-				<< std::endl;
-			}
+			    if (is_trace_linkedobject_events_enabled) {
+				output << debug_prefix.str()
+				    << "\t HAS SAMPLE name:" << (*k).getPath()
+				    << " range:" << (*k).getAddressRange()
+				    << std::endl;
+			    }
 #endif
-			tmp.push_back(*k);
+			    r->second.push_back(*k);
+			}
 		    }
 		}
 
@@ -328,8 +391,8 @@ private:
 		}
 #endif
 
-		if(tmp.size() > 0) {
-		    found.insert( std::make_pair((*i).first,tmp) );
+		if(r->second.size() > 0) {
+		    found.insert( std::make_pair((*i).first,r->second) );
 		}
 	    }
 
@@ -471,7 +534,9 @@ private:
 #endif
 
 
-        LinkedObjectVec linkedobjectvec;
+        boost::shared_ptr<LinkedObjectVec> linkedobjectvec =
+	    boost::make_shared<LinkedObjectVec>();
+	linkedobjectvec->reserve(message->linkedobjects.linkedobjects_len);
 	
 	for(int i = 0; i < message->linkedobjects.linkedobjects_len; ++i) {
 	        const CBTF_Protocol_LinkedObject& msg_lo =
@@ -481,9 +546,13 @@ private:
 		e.is_executable = msg_lo.is_executable;
 		e.time = TimeInterval(msg_lo.time_begin,msg_lo.time_end);
 		e.range = AddressRange(msg_lo.range.begin,msg_lo.range.end);
-	        linkedobjectvec.push_back(e);
+	        linkedobjectvec->push_back(e);
 	}
-	addressspace.insert(std::make_pair(tname,linkedobjectvec));
+
+	// Share the linked object set of any thread seen with the same set
+	LinkedObjectVecPtr shared =
+	    *linkedobjectsets.insert(linkedobjectvec).first;
+	addressspace.insert(std::make_pair(tname,shared));
 
 #ifndef NDEBUG
 	if (is_trace_linkedobject_events_enabled) {
@@ -500,7 +569,7 @@ private:
 	if ( !isLeafCP() &&
 	     (addressspace.size() == threadnames.size()) &&
 	     (numTerminated == threadnames.size()) ) {
-	    for (AddressSpace::iterator i = addressspace.begin(); i != addressspace.end(); ++i) {
+	    for (SharedAddressSpace::const_iterator i = addressspace.begin(); i != addressspace.end(); ++i) {
 
 		boost::shared_ptr<CBTF_Protocol_LinkedObjectGroup> logroup(
 		    new CBTF_Protocol_LinkedObjectGroup()
@@ -509,15 +578,15 @@ private:
 		CBTF_Protocol_ThreadName* ptr = &logroup->thread;
 		convert((*i).first, *ptr);
 
-		logroup->linkedobjects.linkedobjects_len = (*i).second.size();
+		logroup->linkedobjects.linkedobjects_len = (*i).second->size();
 		logroup->linkedobjects.linkedobjects_val =
 		    reinterpret_cast<CBTF_Protocol_LinkedObject*>(
-		    malloc((*i).second.size() * sizeof(CBTF_Protocol_LinkedObject))
+		    malloc((*i).second->size() * sizeof(CBTF_Protocol_LinkedObject))
 		    );
 
 		int j = 0;
-		for (LinkedObjectVec::iterator k = (*i).second.begin();
-			     k != (*i).second.end(); ++k) {
+		for (LinkedObjectVec::const_iterator k = (*i).second->begin();
+			     k != (*i).second->end(); ++k) {
 		    CBTF_Protocol_LinkedObject* destination =
 			&logroup->linkedobjects.linkedobjects_val[j];
 			convert((*k), *destination);
@@ -638,8 +707,10 @@ private:
     LinkedObjectEntryVec linkedobjectentryvec;
     // vector of linkedobject info.
     LinkedObjectVec linkedobjectvec;
-    // map of threadname to linkedobjectvec.
-    AddressSpace addressspace;
+    // map of threadname to its shared linkedobjectvec.
+    SharedAddressSpace addressspace;
+    // unique linkedobjectvecs shared by the threads in addressspace.
+    LinkedObjectVecSet linkedobjectsets;
 
     // vector of incoming threadnames.
     ThreadNameVec threadnames;
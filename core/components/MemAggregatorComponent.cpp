@@ -39,6 +39,7 @@
 #include "KrellInstitute/Core/AddressBuffer.hpp"
 #include "KrellInstitute/Core/AddressRange.hpp"
 #include "KrellInstitute/Core/Blob.hpp"
+#include "KrellInstitute/Core/BlobView.hpp"
 #include "KrellInstitute/Core/PerfData.hpp"
 #include "KrellInstitute/Core/Time.hpp"
 #include "KrellInstitute/Core/TimeInterval.hpp"
@@ -757,7 +758,7 @@ private:
 	// From this point on only leafCP nodes should decode and handle
 	// the passed in performance data blobs from lightweight backends.
 
-	Blob perfdatablob(in.get()->data.data_len, in.get()->data.data_val);
+	BlobView perfdatablob(in.get()->data.data_len, in.get()->data.data_val);
 
 	// decode this blobs data header and create a threadname object
 	// and collector id object.
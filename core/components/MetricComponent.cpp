@@ -32,6 +32,7 @@
 #include "KrellInstitute/Core/AddressBuffer.hpp"
 #include "KrellInstitute/Core/AddressRange.hpp"
 #include "KrellInstitute/Core/Blob.hpp"
+#include "KrellInstitute/Core/CollectorRegistry.hpp"
 #include "KrellInstitute/Core/PCData.hpp"
 #include "KrellInstitute/Core/Path.hpp"
 #include "KrellInstitute/Core/StacktraceData.hpp"
@@ -68,104 +69,139 @@ bool is_debug_aggregator_events_enabled =
 
     bool sent_buffer = false;
 
+    // collector index of the previously handled blob.
+    int last_collector = -1;
+
     // vector of incoming threadnames. For each thread we expect
     ThreadNameVec threadnames;
 
-    void SampleMetric(const std::string id, const Blob &blob)
+    void metric_pcsamp(const Blob &blob)
     {
-	if (id == "pcsamp") {
-            CBTF_pcsamp_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_pcsamp_data), &data);
-
-	    std::vector<uint64_t> values;
-	    for(unsigned i = 0; i < data.pc.pc_len; ++i) {
-		uint64_t t_sample =
-			static_cast<uint64_t>(data.count.count_val[i]) *
-			static_cast<uint64_t>(data.interval) / 1000000000.0;
+	CBTF_pcsamp_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_pcsamp_data), &data);
+
+	std::vector<uint64_t> values;
+	for(unsigned i = 0; i < data.pc.pc_len; ++i) {
+	    uint64_t t_sample =
+		    static_cast<uint64_t>(data.count.count_val[i]) *
+		    static_cast<uint64_t>(data.interval) / 1000000000.0;
 std::cerr << "PCSAMP: Address:" << Address(data.pc.pc_val[i]) << " Time:" << Time(t_sample) << std::endl;
 
-	    }
-	    xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_pcsamp_data),
-		     reinterpret_cast<char*>(&data));
-
-	} else if (id == "hwc") {
-            CBTF_hwc_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwc_data), &data);
-
-	    std::vector<uint64_t> values;
-	    for(unsigned i = 0; i < data.pc.pc_len; ++i) {
-		uint64_t t_sample = static_cast<uint64_t>(data.count.count_val[i]) *
-                            static_cast<uint64_t>(data.interval);
-	    }
-	    xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwc_data),
-		     reinterpret_cast<char*>(&data));
-
-	} else if (id == "hwcsamp") {
-            CBTF_hwcsamp_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwcsamp_data), &data);
-
-	    for(unsigned i = 0; i < data.pc.pc_len; ++i) {
-		double t_sample =
-			static_cast<double>(data.count.count_val[i]) *
-			static_cast<double>(data.interval) / 1000000000.0;
-	    }
-	    xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwcsamp_data),
-		     reinterpret_cast<char*>(&data));
-
-	} else {
-	    return;
 	}
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_pcsamp_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
+    void metric_hwc(const Blob &blob)
+    {
+	CBTF_hwc_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwc_data), &data);
+
+	std::vector<uint64_t> values;
+	for(unsigned i = 0; i < data.pc.pc_len; ++i) {
+	    uint64_t t_sample = static_cast<uint64_t>(data.count.count_val[i]) *
+			static_cast<uint64_t>(data.interval);
+	}
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwc_data),
+		 reinterpret_cast<char*>(&data));
     }
 
-    void STSampleMetric(const std::string id, const Blob &blob)
+    void metric_hwcsamp(const Blob &blob)
     {
-	if (id == "usertime") {
-            CBTF_usertime_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_usertime_data), &data);
-	} else if (id == "hwctime") {
-            CBTF_hwctime_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwctime_data), &data);
-	} else {
-	    return;
+	CBTF_hwcsamp_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwcsamp_data), &data);
+
+	for(unsigned i = 0; i < data.pc.pc_len; ++i) {
+	    double t_sample =
+		    static_cast<double>(data.count.count_val[i]) *
+		    static_cast<double>(data.interval) / 1000000000.0;
 	}
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwcsamp_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
+    void metric_usertime(const Blob &blob)
+    {
+	CBTF_usertime_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_usertime_data), &data);
     }
 
-    void STTraceMetric(const std::string id, const Blob &blob)
+    void metric_hwctime(const Blob &blob)
     {
+	CBTF_hwctime_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwctime_data), &data);
+    }
 
-	if (id == "io") {
-            CBTF_io_trace_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_trace_data), &data);
-	} else if (id == "iot") {
-            CBTF_io_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_exttrace_data), &data);
-	} else if (id == "mem") {
-            CBTF_mem_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mem_exttrace_data), &data);
-	} else if (id == "mpi") {
-            CBTF_mpi_trace_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_trace_data), &data);
-	} else if (id == "mpit") {
-            CBTF_mpi_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_exttrace_data), &data);
-	} else {
-	    return;
-	}
+    void metric_io(const Blob &blob)
+    {
+	CBTF_io_trace_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_trace_data), &data);
+    }
 
+    void metric_iot(const Blob &blob)
+    {
+	CBTF_io_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_exttrace_data), &data);
     }
 
+    void metric_mem(const Blob &blob)
+    {
+	CBTF_mem_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mem_exttrace_data), &data);
+    }
+
+    void metric_mpi(const Blob &blob)
+    {
+	CBTF_mpi_trace_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_trace_data), &data);
+    }
+
+    void metric_mpit(const Blob &blob)
+    {
+	CBTF_mpi_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_exttrace_data), &data);
+    }
+
+    /** Collectors whose data is known but not yet used for metrics. */
+    void metric_ignored(const Blob &blob)
+    {
+    }
+
+    /** Type of the functions computing metrics from one collector's blob. */
+    typedef void (*MetricFunction)(const Blob&);
+
+    /** Build the table of metric functions for every known collector. */
+    CollectorRegistry<MetricFunction> makeMetrics()
+    {
+	CollectorRegistry<MetricFunction> registry;
+	registry.add("pcsamp", metric_pcsamp);
+	registry.add("hwc", metric_hwc);
+	registry.add("hwcsamp", metric_hwcsamp);
+	registry.add("usertime", metric_usertime);
+	registry.add("hwctime", metric_hwctime);
+	registry.add("io", metric_io);
+	registry.add("iot", metric_iot);
+	registry.add("mem", metric_mem);
+	registry.add("mpi", metric_mpi);
+	registry.add("mpit", metric_mpit);
+	registry.add("mpip", metric_ignored);
+	registry.add("pthreads", metric_ignored);
+	return registry;
+    }
+
+    /** Metric functions of the known collectors. */
+    const CollectorRegistry<MetricFunction> Metrics = makeMetrics();
+
 }
 
 /**
@@ -284,12 +320,10 @@ private:
             reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader), &header
             );
 
-	std::string collectorID(header.id);
-
 #ifndef NDEBUG
         if (is_debug_aggregator_events_enabled) {
 	    std::cerr << "Aggregating CBTF_Protocol_Blob addresses for "
-	    << collectorID << " data from "
+	    << header.id << " data from "
 	    << header.host << ":" << header.pid
 	    << " from cbtf pid " << getpid()
 	    << std::endl;
@@ -301,14 +335,9 @@ private:
 	const void* data_ptr = &(reinterpret_cast<const char *>(myblob.getContents())[header_size]);
 	Blob dblob(data_size,data_ptr);
 
-	if (collectorID == "pcsamp" || collectorID == "hwc" || collectorID == "hwcsamp") {
-            SampleMetric(collectorID, dblob);
-	} else if (collectorID == "usertime" || collectorID == "hwctime") {
-            STSampleMetric(collectorID, dblob);
-        } else if (collectorID == "io" || collectorID == "iot" || collectorID == "mem" ||
-		   collectorID == "mpi" || collectorID == "mpit" || 
-                   collectorID == "mpip" || collectorID == "pthreads") {
-            STTraceMetric(collectorID, dblob);
+	int collector = Metrics.find(header.id, last_collector);
+	if (Metrics.isValid(collector)) {
+	    Metrics[collector](dblob);
 	} else {
 	    std::cerr << "Unknown collector data handled!" << std::endl;
 	}
@@ -340,12 +369,10 @@ private:
         unsigned header_size = in.getXDRDecoding(
             reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader), &header
             );
-
-	std::string collectorID(header.id);
 #ifndef NDEBUG
         if (is_debug_aggregator_events_enabled) {
 	    std::cerr << "Aggregating Blob addresses for "
-	    << collectorID << " data from "
+	    << header.id << " data from "
 	    << header.host << ":" << header.pid
 	    << " from cbtf pid " << getpid()
 	    << std::endl;
@@ -357,14 +384,9 @@ private:
 	const void* data_ptr = &(reinterpret_cast<const char *>(in.getContents())[header_size]);
 	Blob dblob(data_size,data_ptr);
 
-	if (collectorID == "pcsamp" || collectorID == "hwc" || collectorID == "hwcsamp") {
-            SampleMetric(collectorID, dblob);
-	} else if (collectorID == "usertime" || collectorID == "hwctime") {
-            STSampleMetric(collectorID, dblob);
-        } else if (collectorID == "io" || collectorID == "iot" || collectorID == "mem" ||
-		   collectorID == "mpi" || collectorID == "mpit" || 
-                   collectorID == "mpip" || collectorID == "pthreads") {
-            STTraceMetric(collectorID, dblob);
+	int collector = Metrics.find(header.id, last_collector);
+	if (Metrics.isValid(collector)) {
+	    Metrics[collector](dblob);
 	} else {
 	    std::cerr << "Unknown collector data handled!" << std::endl;
 	}
@@ -187,7 +187,7 @@ namespace KrellInstitute { namespace Core {
         int dm_destination;        /**< Destination rank (in MPI_COMM_WORLD). */
         uint64_t dm_size;          /**< Number of bytes sent. */
         int dm_tag;                /**< Tag of the message (if any). */
-        int dm_communicator;       /**< Communicator used. */
+        int dm_communicator;       /**< Identifier of the communicator used. */
         int dm_datatype;           /**< Data type of the message. */
         int dm_retval;             /**< Enumerated return value. */
 
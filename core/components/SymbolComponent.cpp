@@ -21,6 +21,8 @@
 #include <boost/bind.hpp>
 #include <boost/operators.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
 #include <mrnet/MRNet.h>
 #include <typeinfo>
 #include <algorithm>
@@ -41,6 +43,7 @@
 #include "KrellInstitute/Core/Blob.hpp"
 #include "KrellInstitute/Core/LinkedObjectEntry.hpp"
 #include "KrellInstitute/Core/LinkedObject.hpp"
+#include "KrellInstitute/Core/LinkedObjectIndex.hpp"
 #include "KrellInstitute/Core/Path.hpp"
 #include "KrellInstitute/Core/SymbolTable.hpp"
 #include "KrellInstitute/Core/SymtabAPISymbols.hpp"
@@ -122,6 +125,23 @@ struct FuncThreadStats {
 // vector to hold the mappings of function to threads with counts.
 typedef std::vector<FuncThreadStats> FuncStatsVec;
 
+// mapping of interned function and thread ids to an entry of a FuncStatsVec.
+typedef boost::unordered_map<std::pair<unsigned,unsigned>,std::size_t> FuncStatsIndex;
+
+// Summary of the values of a function over all threads.
+// The max and min are indices into a FuncStatsVec.
+struct FuncStatsSummary {
+    static const std::size_t None = ~static_cast<std::size_t>(0);
+    uint64_t total;
+    uint64_t threads;
+    std::size_t max;
+    std::size_t min;
+    FuncStatsSummary()
+	: total(0), threads(0), max(None), min(None)
+    {
+    };
+};
+
 // mapping of addressbuffers to thread from AddressAggregatorComponent.
 typedef std::map<ThreadName,AddressBuffer>  ThreadAddrBufMap;
 
@@ -200,6 +220,22 @@ bool is_show_metric_events_enabled =
 	 return _MaxLeafDistance;
     }
 
+    // Number of worker threads resolving the symbols of linked objects on a
+    // leaf CP. Defaults to the number of cores on the CP node and can be set
+    // with the CBTF_SYMBOL_THREADS environment variable. One means no worker
+    // threads. The workers parse different linked objects with SymtabAPI, read
+    // their symbol cache entries and match them against the sampled addresses
+    // concurrently; only opening a linked object is serialized.
+    unsigned getNumSymbolThreads()
+    {
+	const char* threads = getenv("CBTF_SYMBOL_THREADS");
+	if (threads != NULL && atoi(threads) > 0) {
+	    return atoi(threads);
+	}
+	unsigned cores = boost::thread::hardware_concurrency();
+	return (cores > 0) ? cores : 1;
+    }
+
     bool initialized_topology_info = false;
 
     void init_TopologyInfo() {
@@ -891,6 +927,7 @@ private:
                 linkedobjectvec.push_back(e);
 	    }
 	}
+	linkedobjectindex = LinkedObjectIndex(linkedobjectvec);
 
 #ifndef NDEBUG
         if (is_trace_symbol_events_enabled) {
@@ -940,25 +977,21 @@ private:
 	    flushOutput(output);
 	}
 #endif
-	AddressCounts ac = abuffer.addresscounts;
-	AddressCounts::const_iterator aci;
-	LinkedObjectEntryVec::iterator li;
-	for (aci = ac.begin(); aci != ac.end(); ++aci) {
-	    bool foundit = false;
-	    for (li = linkedobjectvec.begin(); li != linkedobjectvec.end(); ++li) {
-		AddressRange addr_range(li->addr_begin,li->addr_end);
-		if (addr_range.doesContain(aci->first) ) {
-		    symtabmap.insert(std::make_pair(addr_range,
-				 std::make_pair(addr_range, *li )
-				));
-		    foundit = true;
-		    break;
-		}
+	LinkedObjectPartitionVec partitions;
+	linkedobjectindex.partition(abuffer.addresscounts, partitions);
+	for (LinkedObjectPartitionVec::const_iterator pi = partitions.begin();
+	     pi != partitions.end(); ++pi) {
+	    if (pi->object != NULL) {
+		AddressRange addr_range(pi->object->addr_begin,pi->object->addr_end);
+		symtabmap.insert(std::make_pair(addr_range,
+			     std::make_pair(addr_range, *pi->object )
+			    ));
+		continue;
 	    }
 
 #ifndef NDEBUG
       	    if (is_debug_symbol_events_enabled) {
-		if(!foundit) {
+		for (AddressCounts::const_iterator aci = pi->begin; aci != pi->end; ++aci) {
 		    output << "ResolveSymbols::symtabAPISymbolHandler: CANNOT RESOLVE symbols for address "
 			<< aci->first  << std::endl;
 		}
@@ -967,11 +1000,13 @@ private:
 	}
 
 	// Now cycle through these symboltables and find functions and statements.
-	SymtabAPISymbols stapi_symbols;
+	std::vector<SymbolTable> symboltables;
+	resolveSymbolTables(symboltables);
+	std::vector<SymbolTable>::iterator sti = symboltables.begin();
 
-	for(SymbolTableMap::iterator i = symtabmap.begin(); i != symtabmap.end(); ++i) {
+	for(SymbolTableMap::iterator i = symtabmap.begin(); i != symtabmap.end(); ++i, ++sti) {
 		LinkedObjectEntry le = i->second.second;
-		SymbolTable st = i->first;
+		SymbolTable& st = *sti;
 #ifndef NDEBUG
         	if (is_debug_symbol_events_enabled) {
 		    output << debug_prefix.str()
@@ -979,7 +1014,6 @@ private:
 			<< le.path  << std::endl;
 		}
 #endif
-		stapi_symbols.getSymbols(abuffer,le,st);
 		CBTF_Protocol_SymbolTable pst;
 		pst = st;
 		pst.linked_object.path = strdup(le.path.c_str());
@@ -1017,22 +1051,19 @@ private:
     // unless we get symtabapi support sooner.
     void BFDSymbolHandler(const BFDSymbols& in)
     {
-	AddressCounts::const_iterator aci;
-	LinkedObjectEntryVec::iterator li;
-	for (aci = ac.begin(); aci != ac.end(); ++aci) {
-	    bool foundit = false;
-	    for (li = linkedobjectvec.begin(); li != linkedobjectvec.end(); ++li) {
-		AddressRange addr_range(li->addr_begin,li->addr_end);
-		if (addr_range.doesContain(aci->first) ) {
-		    symtabmap.insert(std::make_pair(addr_range,
-				 std::make_pair(addr_range, *li )
-				));
-		    foundit = true;
-		    break;
-		}
+	LinkedObjectPartitionVec partitions;
+	linkedobjectindex.partition(abuffer.addresscounts, partitions);
+	for (LinkedObjectPartitionVec::const_iterator pi = partitions.begin();
+	     pi != partitions.end(); ++pi) {
+	    if (pi->object != NULL) {
+		AddressRange addr_range(pi->object->addr_begin,pi->object->addr_end);
+		symtabmap.insert(std::make_pair(addr_range,
+			     std::make_pair(addr_range, *pi->object )
+			    ));
+		continue;
 	    }
 
-	    if(!foundit) {
+	    for (AddressCounts::const_iterator aci = pi->begin; aci != pi->end; ++aci) {
 		std::cerr << "CANNOT RESOLVE symbols for address "
 			<< aci->first  << std::endl;
 	    }
@@ -1050,6 +1081,59 @@ private:
 #endif
 
 
+    // Resolve the functions and statements of each linked object in
+    // symtabmap into its own SymbolTable, returned in symtabmap order.
+    // Linked objects are independent of each other so they are resolved
+    // on a bounded pool of worker threads (see getNumSymbolThreads).
+    void resolveSymbolTables(std::vector<SymbolTable>& symboltables)
+    {
+	std::vector<SymbolTableMap::const_iterator> entries;
+	for(SymbolTableMap::const_iterator i = symtabmap.begin(); i != symtabmap.end(); ++i) {
+	    entries.push_back(i);
+	    symboltables.push_back(SymbolTable(i->first));
+	}
+
+	unsigned count = std::min<std::size_t>(getNumSymbolThreads(), entries.size());
+	unsigned next = 0;
+	boost::mutex next_mutex;
+
+	if (count < 2) {
+	    resolveWorker(entries, symboltables, next, next_mutex);
+	    return;
+	}
+
+	boost::thread_group workers;
+	for (unsigned i = 0; i < count; ++i) {
+	    workers.create_thread(boost::bind(&ResolveSymbols::resolveWorker, this,
+					      boost::cref(entries),
+					      boost::ref(symboltables),
+					      boost::ref(next),
+					      boost::ref(next_mutex)));
+	}
+	workers.join_all();
+    }
+
+    // Worker for resolveSymbolTables. Claims the next unresolved linked
+    // object until there are none left.
+    void resolveWorker(const std::vector<SymbolTableMap::const_iterator>& entries,
+		       std::vector<SymbolTable>& symboltables,
+		       unsigned& next, boost::mutex& next_mutex)
+    {
+	SymtabAPISymbols stapi_symbols;
+	while (true) {
+	    unsigned n;
+	    {
+		boost::mutex::scoped_lock lock(next_mutex);
+		if (next >= entries.size()) {
+		    return;
+		}
+		n = next++;
+	    }
+	    stapi_symbols.getSymbols(abuffer, entries[n]->second.second,
+				     symboltables[n]);
+	}
+    }
+
     // This is intended to run only at the leaf CP levels.
     // Creates initial symboltables.
     // Creates the min,max,avg values.
@@ -1084,7 +1168,7 @@ private:
 	    return;
 	}
 
-	AddressCounts ac = abuffer.addresscounts;
+	const AddressCounts& ac = abuffer.addresscounts;
 #ifndef NDEBUG
 	if (is_debug_symbol_events_enabled) {
             output << debug_prefix.str()
@@ -1096,37 +1180,49 @@ private:
 	    flushOutput(output);
 	}
 #endif
-	for (AddressCounts::const_iterator aci = ac.begin(); aci != ac.end(); ++aci) {
-	    bool foundit = false;
-	    for (LinkedObjectEntryVec::iterator li = linkedobjectvec.begin(); li != linkedobjectvec.end(); ++li) {
-		AddressRange addr_range(li->addr_begin,li->addr_end);
-		if (addr_range.doesContain(aci->first) ) {
-		    symtabmap.insert(std::make_pair(addr_range,
-				 std::make_pair(addr_range, *li )
-				));
-		    foundit = true;
-		    break;
-		}
+	LinkedObjectPartitionVec partitions;
+	linkedobjectindex.partition(ac, partitions);
+	for (LinkedObjectPartitionVec::const_iterator pi = partitions.begin();
+	     pi != partitions.end(); ++pi) {
+	    if (pi->object != NULL) {
+		AddressRange addr_range(pi->object->addr_begin,pi->object->addr_end);
+		symtabmap.insert(std::make_pair(addr_range,
+			     std::make_pair(addr_range, *pi->object )
+			    ));
+		continue;
 	    }
 
-	    if(!foundit) {
 #ifndef NDEBUG
-        	if (is_debug_symbol_events_enabled) {
+	    if (is_debug_symbol_events_enabled) {
+		for (AddressCounts::const_iterator aci = pi->begin; aci != pi->end; ++aci) {
 		    output << debug_prefix.str()
 		        << "ResolveSymbols::finishedHandler: CANNOT RESOLVE symbols for address "
 			<< aci->first  << std::endl;
 		}
-#endif
 	    }
+#endif
 	}
 
+	// Per-thread function statistics. Function names are interned and the
+	// entries of fstatvec indexed by (function, thread) id, so that adding
+	// the count of an address does not have to search fstatvec.
+	FuncStatsVec fstatvec;
+	std::vector<unsigned> fstatfunctions;
+	FuncStatsIndex fstatindex;
+	boost::unordered_map<std::string,unsigned> function_ids;
+	std::vector<std::string> function_names;
+
 	// Now cycle through these symboltables and find functions and statements.
-	SymtabAPISymbols stapi_symbols;
+	// The symbols are resolved up front, in parallel, while the symbol
+	// tables are emitted and the statistics gathered in symtabmap order.
+	std::vector<SymbolTable> symboltables;
+	resolveSymbolTables(symboltables);
+	std::vector<SymbolTable>::iterator sti = symboltables.begin();
 
-	for(SymbolTableMap::iterator ii = symtabmap.begin(); ii != symtabmap.end(); ++ii)
+	for(SymbolTableMap::iterator ii = symtabmap.begin(); ii != symtabmap.end(); ++ii, ++sti)
 	{
 	    LinkedObjectEntry le = ii->second.second;
-	    SymbolTable st = ii->first;
+	    SymbolTable& st = *sti;
 #ifndef NDEBUG
             if (is_debug_symbol_events_enabled) {
 	        output << debug_prefix.str()
@@ -1135,8 +1231,6 @@ private:
 	    }
 #endif
 
-	    stapi_symbols.getSymbols(abuffer,le,st);
-
 	    CBTF_Protocol_SymbolTable pst;
 	    pst = st;
 	    pst.linked_object.path = strdup(le.path.c_str());
@@ -1162,7 +1256,20 @@ private:
 	    }
 #endif
 
-	    for (ThreadAddrBufMap::const_iterator avi = threadAddrBufMap.begin(); avi != threadAddrBufMap.end(); ++avi) {
+	    std::vector<unsigned> stFuncIds;
+	    stFuncIds.reserve(stFuncs.size());
+	    for(FunctionMap::const_iterator fi = stFuncs.begin(); fi != stFuncs.end(); ++fi) {
+		std::pair<boost::unordered_map<std::string,unsigned>::iterator,bool> id =
+		    function_ids.insert(std::make_pair(fi->second, function_names.size()));
+		if (id.second) {
+		    function_names.push_back(fi->second);
+		}
+		stFuncIds.push_back(id.first->second);
+	    }
+
+	    // Threads are identified by their position in threadAddrBufMap.
+	    unsigned tid = 0;
+	    for (ThreadAddrBufMap::const_iterator avi = threadAddrBufMap.begin(); avi != threadAddrBufMap.end(); ++avi, ++tid) {
 #ifndef NDEBUG
 		if (is_debug_symbol_events_enabled) {
 		    output << debug_prefix.str()
@@ -1172,61 +1279,72 @@ private:
 		}
 #endif
 
-		AddressCounts ac = (*avi).second.addresscounts;
-		for(FunctionMap::const_iterator fi = stFuncs.begin(); fi != stFuncs.end(); ++fi) {
-		    AddressRange frange(fi->first.getBegin(),fi->first.getEnd());
-	 	    for (AddressCounts::const_iterator aci=ac.equal_range(frange.getBegin()).first;
-			 aci!=ac.equal_range(frange.getEnd()).second;++aci) {
-			if (frange.doesContain((*aci).first)) {
-			    FuncThreadStats fts(fi->second,(*avi).first,(*aci).second);
-			    FuncStatsVec::iterator it = std::find(fstatvec.begin(),fstatvec.end(),fts);
-			    if (it == fstatvec.end()) {
-		  		fstatvec.push_back(fts);
-			    } else {
-		     		(*it).value += (*aci).second;
-			    }
+		const AddressCounts& ac = (*avi).second.addresscounts;
+		std::vector<unsigned>::const_iterator fid = stFuncIds.begin();
+		for(FunctionMap::const_iterator fi = stFuncs.begin(); fi != stFuncs.end(); ++fi, ++fid) {
+		    for (AddressCounts::const_iterator aci = ac.lower_bound(fi->first.getBegin());
+			 aci != ac.end() && aci->first < fi->first.getEnd(); ++aci) {
+			std::pair<FuncStatsIndex::iterator,bool> it = fstatindex.insert(
+			    std::make_pair(std::make_pair(*fid,tid), fstatvec.size()));
+			if (it.second) {
+			    fstatvec.push_back(FuncThreadStats(fi->second,(*avi).first,(*aci).second));
+			    fstatfunctions.push_back(*fid);
+			} else {
+			    fstatvec[it.first->second].value += (*aci).second;
 			}
 		    }
 		}
 	    }
 	}
 
-	std::set<std::string> functions;
-	FunctionAvgMap functionscounts;
-	for(FuncStatsVec::iterator fit = fstatvec.begin(); fit != fstatvec.end(); ++fit) {
+	// Summarize each function over all threads in a single pass. The
+	// entries are visited in the order they were added, so ties for the
+	// max and min still go to the first thread found.
+	std::vector<FuncStatsSummary> summaries(function_names.size());
+	for(std::size_t n = 0; n < fstatvec.size(); ++n) {
+	    const FuncThreadStats& fts = fstatvec[n];
+	    FuncStatsSummary& summary = summaries[fstatfunctions[n]];
 #ifndef NDEBUG
 	    if (is_debug_symbol_events_enabled) {
-		output << debug_prefix.str() << "FuncStatsVec: function:" << (*fit).funcname
-		<< " thread:" << (*fit).tname
-		<< " count:" << (*fit).value
+		output << debug_prefix.str() << "FuncStatsVec: function:" << fts.funcname
+		<< " thread:" << fts.tname
+		<< " count:" << fts.value
 		<< std::endl;
 	    }
 #endif
-	    functions.insert((*fit).funcname);
-	    FunctionAvgMap::iterator it = functionscounts.find(std::string((*fit).funcname));
-	    if (it == functionscounts.end() ) {
-		functionscounts.insert(std::make_pair(std::string((*fit).funcname),
-				       std::make_pair((*fit).value,1)));
-#ifndef NDEBUG
-		if (is_debug_symbol_events_enabled) {
-		output << debug_prefix.str() << "FuncStatsVec: function:" << (*fit).funcname
-		<< " total counts:" << (*fit).value << " num threads:" << 1
-		<< " avg:" << (*fit).value << std::endl;
-		}
-#endif
-	    } else {
-		(*it).second.first += (*fit).value;
-		++(*it).second.second;
-#ifndef NDEBUG
-		if (is_debug_symbol_events_enabled) {
-		    output << debug_prefix.str()
-		    << "FuncStatsVec: function:" << (*fit).funcname
-		    << " UPDATE total counts:" << (*it).second.first
-		    << " num threads:" << (*it).second.second
-		    << " avg:" << (*it).second.first/(*it).second.second
-		    << std::endl;
-		}
-#endif
+	    summary.total += fts.value;
+	    ++summary.threads;
+	    if (fts.value == 0) {
+		// only intersted in function sample/trace points.
+		continue;
+	    }
+	    if (summary.max == FuncStatsSummary::None ||
+		fts.value > fstatvec[summary.max].value) {
+		summary.max = n;
+	    }
+	    if (summary.min == FuncStatsSummary::None ||
+		fts.value < fstatvec[summary.min].value) {
+		summary.min = n;
+	    }
+	}
+
+	FunctionAvgMap functionscounts;
+	FunctionThreadCount maxfuncs;
+	FunctionThreadCount minfuncs;
+	for(unsigned id = 0; id < function_names.size(); ++id) {
+	    const FuncStatsSummary& summary = summaries[id];
+	    if (summary.threads == 0) {
+		continue;
+	    }
+	    functionscounts.insert(std::make_pair(function_names[id],
+				   std::make_pair(summary.total,summary.threads)));
+	    if (summary.max != FuncStatsSummary::None) {
+		maxfuncs.insert(std::make_pair(function_names[id],
+				std::make_pair(fstatvec[summary.max].tname,
+					       fstatvec[summary.max].value)));
+		minfuncs.insert(std::make_pair(function_names[id],
+				std::make_pair(fstatvec[summary.min].tname,
+					       fstatvec[summary.min].value)));
 	    }
 	}
 
@@ -1261,38 +1379,6 @@ private:
 	boost::shared_ptr<CBTF_Protocol_FunctionAvgValues> avgvals_xdr =
                boost::make_shared<CBTF_Protocol_FunctionAvgValues>(avgVals);
 
-	FunctionThreadCount maxfuncs;
-	FunctionThreadCount minfuncs;
-	std::set<std::string>::const_iterator f;
-	for (std::set<std::string>::const_iterator f = functions.begin(); f != functions.end(); ++f) {
-	    for(FuncStatsVec::iterator fit = fstatvec.begin(); fit != fstatvec.end(); ++fit) {
-		if ( (*fit).value == 0) {
-		    // only intersted in function sample/trace points.
-		    continue;
-		}
-		if (*f == (*fit).funcname) {
-		    std::pair<ThreadName,uint64_t> fts = std::make_pair((*fit).tname,(*fit).value);
-		    // handle MAX.
-		    FunctionThreadCount::iterator it = maxfuncs.find(*f);
-		    if ( it == maxfuncs.end() ) {
-			maxfuncs.insert(std::make_pair(*f,fts));
-		    } else if ( (*fit).funcname == (*it).first && (*fit).value > (*it).second.second ) {
-			(*it).second.first = (*fit).tname;
-			(*it).second.second = (*fit).value;
-		    }
-		    // handle MIN.
-		    it = minfuncs.find(*f);
-		    if ( it == minfuncs.end() ) {
-			minfuncs.insert(std::make_pair(*f,fts));
-		    } else if ( (*fit).funcname == (*it).first && (*fit).value < (*it).second.second ) {
-			(*it).second.first = (*fit).tname;
-			(*it).second.second = (*fit).value;
-		    }
-		    
-		}
-	    }
-	}
-
 	CBTF_Protocol_FunctionThreadValues maxVals;
 	maxVals.values.values_len = maxfuncs.size();
 	maxVals.values.values_val =
@@ -1479,9 +1565,9 @@ private:
     
     SymbolTableMap symtabmap;
     LinkedObjectEntryVec linkedobjectvec;
+    LinkedObjectIndex linkedobjectindex;
     AddressSpace addressspace;
     AddressBuffer abuffer;
-    FuncStatsVec fstatvec;
     ThreadAddrBufMap threadAddrBufMap;
     FunctionThreadCount maxvals;
     FunctionThreadCount minvals;
@@ -28,7 +28,9 @@
 #include "config.h"
 #endif
 #include "KrellInstitute/Core/Address.hpp"
+#include "KrellInstitute/Core/XDRArrayView.hpp"
 #include <map>
+#include <vector>
 
 
 namespace KrellInstitute { namespace Core {
@@ -43,8 +45,15 @@ namespace KrellInstitute { namespace Core {
 	AddressCounts addresscounts;
 
 	bool updateAddressCounts(uint64_t, uint64_t);
-	bool updateAddressCounts(AddressBuffer&);
+	bool updateAddressCounts(const unsigned&, const uint64_t*,
+				 const uint8_t*);
+	bool updateAddressCounts(const unsigned&, const uint64_t*,
+				 const uint64_t&);
+	bool updateAddressCounts(const XDRArrayView<uint64_t>&,
+				 const XDRArrayView<uint8_t>&);
+	bool updateAddressCounts(const AddressBuffer&);
 	bool updateAddressCounts(AddressCounts&);
+	bool updateAddressCounts(const std::vector<const AddressBuffer*>&);
 	void printResults() const;
 
 	AddressCounts  getAddressCounts() {
@@ -53,6 +62,9 @@ namespace KrellInstitute { namespace Core {
 
 	private:
 
+	template <typename Iterator>
+	void mergeSortedCounts(Iterator, Iterator);
+
     };
 
 } }
@@ -85,10 +85,18 @@ struct BFDStatement
 typedef std::vector<BFDFunction>  FunctionsVec;
 typedef std::vector<BFDStatement> StatementsVec;
 
+/**
+ * BFD symbols.
+ *
+ * All of the state of a symbol lookup is held by the instance, so distinct
+ * instances may resolve different linked objects concurrently.
+ */
 class BFDSymbols {
 
     public:
 
+    BFDSymbols();
+
 #if 0
     int		getBFDFunctionStatements(AddressBuffer*, const LinkedObject&,
 					 SymbolTableMap&);
@@ -110,6 +118,23 @@ class BFDSymbols {
 
     int init_done;
 
+    /** BFD of the linked object being processed. */
+    bfd *theBFD;
+
+    /** BFD symbols for the linked object being processed. */
+    asymbol **syms;
+    long numsyms;
+
+    /** Sorted BFD symbols, used to find function begin and end addresses. */
+    asymbol **sortedsyms;
+    long numsortedsyms;
+
+    /** Offset at which the linked object was loaded. */
+    bfd_vma obj_base;
+
+    StatementsVec statementvec;
+    FunctionsVec functionvec;
+
 #ifndef NDEBUG
     static bool is_debug_bfd_symbols_enabled;
     static bool is_debug_bfd_symbols_details_enabled;
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Declaration of the BlobView class.
+ *
+ */
+
+#ifndef _KrellInstitute_Core_BlobView_
+#define _KrellInstitute_Core_BlobView_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "KrellInstitute/Core/XDRArrayView.hpp"
+
+#include <rpc/rpc.h>
+
+
+
+namespace KrellInstitute { namespace Core {
+
+    class Blob;
+
+    /**
+     * Binary large object view.
+     *
+     * Non-owning, read-only view of a buffer of raw, untyped, binary data such
+     * as the contents of a Blob or of a CBTF_Protocol_Blob message. Unlike a
+     * Blob, constructing a view never copies the data, so the data must
+     * outlive the view. In addition to the XDR decoding provided by Blob, the
+     * fields of an XDR encoding can be walked in place, without allocating or
+     * copying anything.
+     *
+     * @ingroup Utility
+     */
+    class BlobView
+    {
+
+    public:
+
+	BlobView(const unsigned&, const void*);
+	BlobView(const Blob&);
+
+	/** Read-only data member accessor function. */
+	const unsigned& getSize() const
+	{
+	    return dm_size;
+	}
+
+	/** Read-only data member accessor function. */
+	const void* getContents() const
+	{
+	    return dm_contents;
+	}
+
+	BlobView getSuffix(const unsigned&) const;
+
+	unsigned getXDRDecoding(const xdrproc_t, void*) const;
+
+	bool getXDRUnsigned(unsigned&, uint32_t&) const;
+	bool getXDRUnsigned(unsigned&, uint64_t&) const;
+
+	/**
+	 * Get XDR encoded array in place.
+	 *
+	 * Gets a view of the variable length array of unsigned integers XDR
+	 * encoded at the given offset, and advances the offset past it.
+	 *
+	 * @param offset    Offset (in bytes) of the array's encoding.
+	 * @retval array    View of the array's elements.
+	 * @return          Boolean "true" if the encoded array lies within the
+	 *                  view, "false" otherwise.
+	 */
+	template <typename T>
+	bool getXDRArray(unsigned& offset, XDRArrayView<T>& array) const
+	{
+	    uint32_t size = 0;
+	    unsigned next = offset;
+	    if (!getXDRUnsigned(next, size) ||
+		((dm_size - next) / XDRArrayView<T>::Stride) < size) {
+		return false;
+	    }
+	    array = XDRArrayView<T>(size, dm_contents + next);
+	    offset = next + (size * XDRArrayView<T>::Stride);
+	    return true;
+	}
+
+	bool isEmpty() const;
+
+    private:
+
+	/** Size of the view (in bytes). */
+	unsigned dm_size;
+
+	/** Pointer to the view's contents. */
+	const unsigned char* dm_contents;
+
+    };
+
+} }
+
+
+
+#endif
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institue. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Declaration and definition of the CollectorRegistry class.
+ *
+ */
+
+#ifndef _KrellInstitute_Core_CollectorRegistry_
+#define _KrellInstitute_Core_CollectorRegistry_
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+
+namespace KrellInstitute { namespace Core {
+
+    /**
+     * Collector registry.
+     *
+     * Table of per-collector handlers indexed by a small integer assigned to
+     * each collector id at registration. Data blobs carry their collector id
+     * as a string in the data header, so callers look the id up with find(),
+     * passing the index found for the previous blob of the same stream. Since
+     * a stream almost always carries data of a single collector this makes
+     * the per-blob cost one string compare and a table index rather than a
+     * chain of comparisons against every known collector id.
+     *
+     * Adding support for a new collector is then a single add() call where
+     * the registry is built.
+     */
+    template <typename Handler>
+    class CollectorRegistry
+    {
+
+    public:
+
+	/** Index returned by find() for an unknown collector. */
+	static const int Unknown = -1;
+
+	/** Register a handler for the given collector id. */
+	CollectorRegistry& add(const std::string& id, const Handler& handler)
+	{
+	    dm_ids.push_back(id);
+	    dm_handlers.push_back(handler);
+	    return *this;
+	}
+
+	/**
+	 * Find a collector.
+	 *
+	 * Returns the index of the given collector id, trying the index found
+	 * by the previous call first.
+	 *
+	 * @param id      Collector id to be found.
+	 * @param last    Index found by the previous call, updated on return.
+	 * @return        Index of the collector or Unknown if not registered.
+	 */
+	int find(const char* id, int& last) const
+	{
+	    if ((id == NULL) || !isValid(last) ||
+		(std::strcmp(dm_ids[last].c_str(), id) != 0)) {
+		last = Unknown;
+		if (id != NULL)
+		    for (int i = 0; i < static_cast<int>(dm_ids.size()); ++i)
+			if (std::strcmp(dm_ids[i].c_str(), id) == 0) {
+			    last = i;
+			    break;
+			}
+	    }
+	    return last;
+	}
+
+	/** Test whether an index refers to a registered collector. */
+	bool isValid(const int& index) const
+	{
+	    return (index >= 0) && (index < static_cast<int>(dm_handlers.size()));
+	}
+
+	/** Get the handler of the collector at the given index. */
+	const Handler& operator[](const int& index) const
+	{
+	    return dm_handlers[index];
+	}
+
+    private:
+
+	/** Registered collector ids. */
+	std::vector<std::string> dm_ids;
+
+	/** Handlers of the registered collectors. */
+	std::vector<Handler> dm_handlers;
+
+    };
+
+} }
+
+
+
+#endif
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Declaration of the LinkedObjectIndex class.
+ *
+ */
+
+#ifndef _KrellInstitute_Core_LinkedObjectIndex_
+#define _KrellInstitute_Core_LinkedObjectIndex_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "KrellInstitute/Core/Address.hpp"
+#include "KrellInstitute/Core/AddressBuffer.hpp"
+#include "KrellInstitute/Core/LinkedObjectEntry.hpp"
+
+#include <vector>
+
+
+
+namespace KrellInstitute { namespace Core {
+
+    /**
+     * Run of sorted addresses falling within a single linked object.
+     *
+     * The object is NULL for a run of addresses not contained within any of
+     * the indexed linked objects.
+     */
+    struct LinkedObjectPartition
+    {
+	const LinkedObjectEntry* object;
+	AddressCounts::const_iterator begin;
+	AddressCounts::const_iterator end;
+    };
+
+    typedef std::vector<LinkedObjectPartition> LinkedObjectPartitionVec;
+
+    /**
+     * Linked object index.
+     *
+     * Sorted interval index over the address ranges of a vector of linked
+     * objects. The ranges of the linked objects of different threads usually
+     * overlap, so the index flattens them into disjoint segments, each of them
+     * owned by the earliest linked object in the vector containing it. An
+     * address is thus resolved to the same linked object as by a linear search
+     * of the vector, in logarithmic rather than linear time.
+     *
+     * @ingroup Utility
+     */
+    class LinkedObjectIndex
+    {
+
+    public:
+
+	LinkedObjectIndex();
+	LinkedObjectIndex(const LinkedObjectEntryVec&);
+
+	/** Test if the index is empty. */
+	bool isEmpty() const
+	{
+	    return dm_segments.empty();
+	}
+
+	const LinkedObjectEntry* find(const Address&) const;
+
+	void partition(const AddressCounts&, LinkedObjectPartitionVec&) const;
+
+    private:
+
+	/** Disjoint address range owned by one linked object. */
+	struct Segment
+	{
+	    Address begin;
+	    Address end;
+	    unsigned object;
+	};
+
+	/** Linked objects owning at least one segment. */
+	LinkedObjectEntryVec dm_objects;
+
+	/** Segments sorted by address. */
+	std::vector<Segment> dm_segments;
+
+    };
+
+} }
+
+
+
+#endif
@@ -45,6 +45,7 @@
 
 #include "KrellInstitute/Core/AddressBuffer.hpp"
 #include "KrellInstitute/Core/Blob.hpp"
+#include "KrellInstitute/Core/BlobView.hpp"
 #include "KrellInstitute/Core/Address.hpp"
 #include "KrellInstitute/Core/AddressEntry.hpp"
 #include "KrellInstitute/Core/PCData.hpp"
@@ -60,12 +61,17 @@ namespace KrellInstitute { namespace Core {
     class PerfData {
 
 	public:
-	   int aggregate(const Blob&, AddressBuffer& buf);
-	   int memMetrics(const Blob&, MemMetrics&);
+	   PerfData() : dm_last_collector(-1) { }
+
+	   int aggregate(const BlobView&, AddressBuffer& buf);
+	   int memMetrics(const BlobView&, MemMetrics&);
 
 
 	private:
 
+	   /** Collector index of the previously aggregated blob. */
+	   int dm_last_collector;
+
     };
 
 } }
@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Declaration of the SymbolCache class.
+ *
+ */
+
+#ifndef _KrellInstitute_Core_SymbolCache_
+#define _KrellInstitute_Core_SymbolCache_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "KrellInstitute/Core/AddressBuffer.hpp"
+#include "KrellInstitute/Core/LinkedObjectEntry.hpp"
+#include "KrellInstitute/Core/NonCopyable.hpp"
+#include "KrellInstitute/Core/SymbolTable.hpp"
+
+#include <cstddef>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+
+namespace KrellInstitute { namespace Core {
+
+    /**
+     * Symbol cache.
+     *
+     * Persistent on-disk cache of all the functions and statements of a linked
+     * object, so that libraries that do not change between experiments (libc,
+     * the MPI libraries, the application's own libraries) are only parsed once.
+     * The cache is enabled by setting CBTF_SYMBOL_CACHE_DIR to a directory.
+     *
+     * Entries are keyed by the ELF build-id of the linked object, or by its
+     * path, size and modification time when it has no build-id. Each entry is
+     * a single file holding sorted, fixed size function and statement records
+     * followed by a string pool. It is mapped into memory as is and searched in
+     * place, without being parsed.
+     *
+     * A missing entry is built by the caller from the parsed linked object with
+     * setImage(), addFunction() and addStatement(), then laid out by store(),
+     * which also writes it when the cache is enabled and the linked object was
+     * parsed completely. Either way the sampled
+     * addresses are resolved by getSymbols() from the entry, so warm and cold
+     * runs, with or without the cache, produce the same symbol table.
+     *
+     * @ingroup Utility
+     */
+    class SymbolCache :
+	private NonCopyable
+    {
+
+    public:
+
+	SymbolCache(const std::string&);
+	~SymbolCache();
+
+	/** Test if an entry can be cached for the linked object. */
+	bool isEnabled() const
+	{
+	    return !dm_file.empty();
+	}
+
+	/** Test if the entry for the linked object is available. */
+	bool isCached() const
+	{
+	    return dm_header != NULL;
+	}
+
+	void setImage(const uint64_t&, const uint64_t&);
+	void addFunction(const uint64_t&, const uint64_t&, const std::string&);
+	void addStatement(const uint64_t&, const uint64_t&,
+			  const std::string&, const int&, const int&);
+	bool store(const bool& = true);
+
+	void getSymbols(const AddressBuffer&, const LinkedObjectEntry&,
+			SymbolTable&) const;
+
+    private:
+
+	/** Header of a cache entry. */
+	struct Header
+	{
+	    char magic[8];
+	    uint32_t version;
+	    uint32_t reserved;
+	    uint64_t image_offset;
+	    uint64_t image_length;
+	    uint64_t num_functions;
+	    uint64_t num_statements;
+	    uint64_t max_statement_length;
+	    uint64_t strings_size;
+	};
+
+	/** Function record, sorted by beginning address. */
+	struct FunctionRecord
+	{
+	    uint64_t begin;
+	    uint64_t end;
+	    uint64_t name;
+	    uint64_t order;  /**< Position in the linked object's own order. */
+
+	    static bool byBegin(const FunctionRecord&, const FunctionRecord&);
+	    static bool inOrder(const FunctionRecord*, const FunctionRecord*);
+	};
+
+	/** Statement record, sorted by beginning address. */
+	struct StatementRecord
+	{
+	    uint64_t begin;
+	    uint64_t end;
+	    uint64_t file;
+	    int32_t line;
+	    int32_t column;
+
+	    static bool byBegin(const StatementRecord&, const StatementRecord&);
+	    bool operator<(const StatementRecord&) const;
+	    bool operator==(const StatementRecord&) const;
+	};
+
+	void getStatements(const std::vector<uint64_t>&, const uint64_t&,
+			   SymbolTable&) const;
+	uint64_t intern(const std::string&);
+	bool map(int);
+
+	/** Name of the cache file holding the entry. */
+	std::string dm_file;
+
+	/** Memory mapped cache file. */
+	void* dm_map;
+
+	/** Size of the memory mapped cache file. */
+	std::size_t dm_map_size;
+
+	/** Entry being built, when it is not mapped. */
+	std::vector<char> dm_entry;
+
+	/** Sections of the current entry, either mapped or built. */
+	const Header* dm_header;
+	const FunctionRecord* dm_functions;
+	const StatementRecord* dm_statements;
+	const char* dm_strings;
+
+	/** Records and interned strings of the entry being built. */
+	Header dm_image;
+	std::vector<FunctionRecord> dm_function_records;
+	std::vector<StatementRecord> dm_statement_records;
+	std::map<std::string, uint64_t> dm_string_offsets;
+	std::string dm_string_pool;
+
+    };
+
+} }
+
+
+
+#endif
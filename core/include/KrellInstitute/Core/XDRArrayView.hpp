@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Declaration and definition of the XDRArrayView class.
+ *
+ */
+
+#ifndef _KrellInstitute_Core_XDRArrayView_
+#define _KrellInstitute_Core_XDRArrayView_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstddef>
+#include <stdint.h>
+
+
+
+namespace KrellInstitute { namespace Core {
+
+    /**
+     * XDR encoded array view.
+     *
+     * Non-owning, read-only view of the elements of an XDR encoded variable
+     * length array of unsigned integers (such as "uint64_t pc<>") still in its
+     * encoded form. Elements are converted from XDR's big-endian encoding as
+     * they are accessed, so that performance data can be walked without first
+     * decoding it into newly allocated arrays. As in XDR, 64-bit values take
+     * eight bytes and all smaller values take four bytes.
+     *
+     * @sa    BlobView::getXDRArray()
+     *
+     * @ingroup Utility
+     */
+    template <typename T>
+    class XDRArrayView
+    {
+
+    public:
+
+	/** Number of bytes taken by each encoded element. */
+	static const unsigned Stride = (sizeof(T) > 4) ? 8 : 4;
+
+	/** Default constructor. */
+	XDRArrayView() :
+	    dm_size(0),
+	    dm_contents(NULL)
+	{
+	}
+
+	/** Construct from the number of elements and their encoding. */
+	XDRArrayView(const unsigned& size, const unsigned char* contents) :
+	    dm_size(size),
+	    dm_contents(contents)
+	{
+	}
+
+	/** Read-only data member accessor function. */
+	const unsigned& getSize() const
+	{
+	    return dm_size;
+	}
+
+	/** Get the element at the given index. */
+	T operator[](const unsigned& index) const
+	{
+	    const unsigned char* p = dm_contents + (index * Stride);
+	    uint64_t value = 0;
+	    for (unsigned i = 0; i < Stride; ++i)
+		value = (value << 8) | p[i];
+	    return static_cast<T>(value);
+	}
+
+    private:
+
+	/** Number of elements in the array. */
+	unsigned dm_size;
+
+	/** Pointer to the encoding of the first element. */
+	const unsigned char* dm_contents;
+
+    };
+
+} }
+
+
+
+#endif
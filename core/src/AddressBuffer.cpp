@@ -26,9 +26,101 @@
 #include "KrellInstitute/Core/AddressEntry.hpp"
 #include "KrellInstitute/Core/AddressBuffer.hpp"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 using namespace KrellInstitute::Core;
 
 
+
+namespace {
+
+    /** Address and count pair as accumulated by AddressCountsHash. */
+    typedef std::pair<uint64_t, uint64_t> AddressCount;
+
+    /**
+     * Open-addressing hash of address counts.
+     *
+     * Accumulates the counts of one batch of addresses (such as the pc array
+     * of a single data blob) without any per-address allocation. Address zero
+     * is never counted and marks an empty slot. The distinct addresses are then
+     * extracted once, sorted, so that they can be merged into an AddressCounts
+     * map in a single ordered pass.
+     */
+    class AddressCountsHash
+    {
+
+    public:
+
+	/** Construct a hash large enough for the given number of addresses. */
+	explicit AddressCountsHash(const unsigned& len) :
+	    dm_mask(0),
+	    dm_slots()
+	{
+	    std::size_t size = 16;
+	    while (size < (2 * static_cast<std::size_t>(len)))
+		size <<= 1;
+	    dm_mask = size - 1;
+	    dm_slots.resize(size, AddressCount(0, 0));
+	}
+
+	/** Add the given count to the given address. */
+	void add(const uint64_t& addr, const uint64_t& count)
+	{
+	    std::size_t i = hash(addr) & dm_mask;
+	    while ((dm_slots[i].first != 0) && (dm_slots[i].first != addr))
+		i = (i + 1) & dm_mask;
+	    dm_slots[i].first = addr;
+	    dm_slots[i].second += count;
+	}
+
+	/** Extract the distinct addresses and their counts sorted by address. */
+	void getSorted(std::vector<AddressCount>& sorted) const
+	{
+	    sorted.clear();
+	    for (std::vector<AddressCount>::const_iterator
+		     i = dm_slots.begin(); i != dm_slots.end(); ++i)
+		if (i->first != 0)
+		    sorted.push_back(*i);
+	    std::sort(sorted.begin(), sorted.end());
+	}
+
+    private:
+
+	/** Mix the address bits so that aligned addresses spread out. */
+	static std::size_t hash(uint64_t addr)
+	{
+	    addr ^= addr >> 33;
+	    addr *= 0xff51afd7ed558ccdULL;
+	    addr ^= addr >> 33;
+	    return static_cast<std::size_t>(addr);
+	}
+
+	/** Mask applied to hashes (the number of slots minus one). */
+	std::size_t dm_mask;
+
+	/** Slots of the hash. */
+	std::vector<AddressCount> dm_slots;
+
+    };
+
+    /** Current and end positions within the address counts being merged. */
+    typedef std::pair<AddressCounts::const_iterator,
+		      AddressCounts::const_iterator> Cursor;
+
+    /** Heap ordering placing the cursor at the lowest address on top. */
+    struct LaterCursor
+    {
+	bool operator()(const Cursor& lhs, const Cursor& rhs) const
+	{
+	    return rhs.first->first < lhs.first->first;
+	}
+    };
+
+}
+
+
 void AddressBuffer::printResults() const {
 
 	    //std::cout << "DisplayAddressBuffer, printResults interval is " << interval << std::endl;
@@ -100,34 +192,182 @@ bool AddressBuffer::updateAddressCounts(uint64_t pc, uint64_t count)
     return true;
 }
 
-bool AddressBuffer::updateAddressCounts(AddressBuffer& buf)
+/**
+ * Merge sorted address counts.
+ *
+ * Adds the counts from a range of address/count pairs, sorted by address,
+ * into the address counts. Each new address is inserted using the position of
+ * the previous one as a hint, so that merging sorted data costs amortized
+ * constant time per address instead of a full tree search.
+ *
+ * @param begin    Beginning of the range of address/count pairs.
+ * @param end      End of the range of address/count pairs.
+ */
+template <typename Iterator>
+void AddressBuffer::mergeSortedCounts(Iterator begin, Iterator end)
 {
-  AddressCounts::const_iterator aci;
-  for (aci = buf.addresscounts.begin(); aci != buf.addresscounts.end(); ++aci) {
+    // Maximum number of entries skipped linearly before searching the tree.
+    const unsigned MaxLinearSkip = 2;
 
-    AddressCounts::iterator lb = addresscounts.lower_bound(aci->first);
+    AddressCounts::iterator lb = addresscounts.begin();
 
-    if(lb != addresscounts.end() && !(addresscounts.key_comp()(aci->first, lb->first))) {
-	lb->second += aci->second;
-    } else {
-	addresscounts.insert(lb, AddressCounts::value_type(aci->first, aci->second));
+    for (Iterator i = begin; i != end; ++i) {
+
+	Address addr(i->first);
+
+	// Advance to the first entry not less than this address.
+	unsigned skipped = 0;
+	while ((lb != addresscounts.end()) && (lb->first < addr)) {
+	    if (++skipped > MaxLinearSkip) {
+		lb = addresscounts.lower_bound(addr);
+		break;
+	    }
+	    ++lb;
+	}
+
+	if ((lb != addresscounts.end()) && !(addr < lb->first)) {
+	    lb->second += i->second;
+	} else {
+	    lb = addresscounts.insert(lb, AddressCounts::value_type(addr, i->second));
+	}
     }
-  }
-  return true;
+}
+
+/**
+ * Update address counts from a pc (or stack frame) array and a matching
+ * counts array, such as those found in a single data blob. Repeated addresses
+ * are combined in a hash before being merged into the address counts.
+ */
+bool AddressBuffer::updateAddressCounts(const unsigned& len,
+					const uint64_t* pcs,
+					const uint8_t* counts)
+{
+    AddressCountsHash hash(len);
+    for (unsigned i = 0; i < len; ++i) {
+	if (pcs[i] != 0) {
+	    hash.add(pcs[i], counts[i]);
+	}
+    }
+
+    std::vector<AddressCount> sorted;
+    hash.getSorted(sorted);
+    mergeSortedCounts(sorted.begin(), sorted.end());
+    return true;
+}
+
+/**
+ * Update address counts from a pc (or stack frame) array where each address
+ * has the same count, such as the stack traces of tracing data.
+ */
+bool AddressBuffer::updateAddressCounts(const unsigned& len,
+					const uint64_t* pcs,
+					const uint64_t& count)
+{
+    AddressCountsHash hash(len);
+    for (unsigned i = 0; i < len; ++i) {
+	if (pcs[i] != 0) {
+	    hash.add(pcs[i], count);
+	}
+    }
+
+    std::vector<AddressCount> sorted;
+    hash.getSorted(sorted);
+    mergeSortedCounts(sorted.begin(), sorted.end());
+    return true;
+}
+
+/**
+ * Update address counts from a pc (or stack frame) array and a matching
+ * counts array still in their XDR encoding, such as those found in place
+ * within a data blob by BlobView::getXDRArray().
+ */
+bool AddressBuffer::updateAddressCounts(const XDRArrayView<uint64_t>& pcs,
+					const XDRArrayView<uint8_t>& counts)
+{
+    unsigned len = std::min(pcs.getSize(), counts.getSize());
+
+    AddressCountsHash hash(len);
+    for (unsigned i = 0; i < len; ++i) {
+	uint64_t pc = pcs[i];
+	if (pc != 0) {
+	    hash.add(pc, counts[i]);
+	}
+    }
+
+    std::vector<AddressCount> sorted;
+    hash.getSorted(sorted);
+    mergeSortedCounts(sorted.begin(), sorted.end());
+    return true;
+}
+
+bool AddressBuffer::updateAddressCounts(const AddressBuffer& buf)
+{
+    mergeSortedCounts(buf.addresscounts.begin(), buf.addresscounts.end());
+    return true;
 }
 
 bool AddressBuffer::updateAddressCounts(AddressCounts& addrcounts)
 {
-  AddressCounts::const_iterator aci;
-  for (aci = addrcounts.begin(); aci != addrcounts.end(); ++aci) {
+    mergeSortedCounts(addrcounts.begin(), addrcounts.end());
+    return true;
+}
 
-    AddressCounts::iterator lb = addresscounts.lower_bound(aci->first);
+/**
+ * Update address counts from many address buffers.
+ *
+ * Merges the address counts of all the given buffers, along with the existing
+ * address counts, in a single k-way pass. Since every input is already sorted
+ * the merged counts are produced in address order and appended to a new map,
+ * costing O(n log k) for n total addresses from k buffers rather than a tree
+ * search into an ever growing map for every address of every buffer. The
+ * buffers are only read, so callers holding them need not copy them.
+ *
+ * @param buffers    Address buffers to be merged.
+ */
+bool AddressBuffer::updateAddressCounts(
+    const std::vector<const AddressBuffer*>& buffers
+    )
+{
+    if (buffers.empty()) {
+	return true;
+    }
 
-    if(lb != addresscounts.end() && !(addresscounts.key_comp()(aci->first, lb->first))) {
-	lb->second += aci->second;
-    } else {
-	addresscounts.insert(lb, AddressCounts::value_type(aci->first, aci->second));
+    // Cursors into the merged inputs, kept as a heap ordered on next address.
+    std::vector<Cursor> heap;
+    heap.reserve(buffers.size() + 1);
+
+    if (!addresscounts.empty()) {
+	heap.push_back(Cursor(addresscounts.begin(), addresscounts.end()));
+    }
+    for (std::vector<const AddressBuffer*>::const_iterator
+	     i = buffers.begin(); i != buffers.end(); ++i) {
+	if (!(*i)->addresscounts.empty()) {
+	    heap.push_back(Cursor((*i)->addresscounts.begin(),
+				  (*i)->addresscounts.end()));
+	}
     }
-  }
-  return true;
+
+    std::make_heap(heap.begin(), heap.end(), LaterCursor());
+
+    AddressCounts merged;
+    while (!heap.empty()) {
+
+	std::pop_heap(heap.begin(), heap.end(), LaterCursor());
+	Cursor& cursor = heap.back();
+
+	if (!merged.empty() && !(merged.rbegin()->first < cursor.first->first)) {
+	    merged.rbegin()->second += cursor.first->second;
+	} else {
+	    merged.insert(merged.end(), *cursor.first);
+	}
+
+	if (++cursor.first == cursor.second) {
+	    heap.pop_back();
+	} else {
+	    std::push_heap(heap.begin(), heap.end(), LaterCursor());
+	}
+    }
+
+    addresscounts.swap(merged);
+    return true;
 }
@@ -49,30 +49,28 @@
 #include <algorithm>
 #include "KrellInstitute/Core/BFDSymbols.hpp"
 #include "KrellInstitute/Core/Path.hpp"
+#include "KrellInstitute/Core/SymbolCache.hpp"
 
 
-// bfd symbols for current linkedobject
-static asymbol **syms;
-static long numsyms;
-
-// Sorted bfd symbols for current linkedobject
-// Used to find function begin and end addresses.
-static asymbol **sortedsyms;
-static long numsortedsyms;
-
-static int init_done = 0;
+using namespace KrellInstitute::Core;
 
-// statics used by find_address_in_section and bfd_find_nearest_line.
-static bfd  *theBFD;
-static bfd_vma pc;
-static bfd_vma obj_base;
-static bfd_boolean found;
-static bool debug_symbols = false;
+namespace {
 
-using namespace KrellInstitute::Core;
+    /**
+     * Line lookup of a single address, passed through bfd_map_over_sections
+     * to find_address_in_section.
+     */
+    struct LineQuery
+    {
+	asymbol **syms;
+	bfd_vma pc;
+	bfd_vma obj_base;
+	bfd_boolean found;
+	bool debug_symbols;
+	StatementsVec *statements;
+    };
 
-static StatementsVec statementvec;
-static FunctionsVec functionvec;
+}
 
 #ifndef NDEBUG
 /** Flag indicating if debuging for offline symbols is enabled. */
@@ -83,6 +81,19 @@ bool BFDSymbols::is_debug_bfd_symbols_details_enabled =
 #endif
 
 
+BFDSymbols::BFDSymbols() :
+    init_done(0),
+    theBFD(NULL),
+    syms(NULL),
+    numsyms(0),
+    sortedsyms(NULL),
+    numsortedsyms(0),
+    obj_base(0),
+    statementvec(),
+    functionvec()
+{
+}
+
 #if 0
 /* binutils 2.23/2.24 use this definition */
 /* 2.28 replaces ... with va_list, but there is no */
@@ -722,7 +733,10 @@ BFDSymbols::getFunctionSyms (const AddressBuffer& addrbuf,
 
 int BFDSymbols::initBFD (std::string filename)
 {
-    bfd_init();
+    // bfd_init only needs to run once per process. Function-local
+    // statics are initialized exactly once even with concurrent callers.
+    static const bool bfd_initialized = (bfd_init(), true);
+    (void)bfd_initialized;
 
 #if 0
 /* binutils 2.23/2.24 use this definition */
@@ -755,14 +769,15 @@ int BFDSymbols::initBFD (std::string filename)
 }
 
 // Callback for bfd_map_over_sections to find nearest line.
-void
-find_address_in_section (bfd *theBFD, asection *section,
-                         void *data ATTRIBUTE_UNUSED)
+// The address to look up and the results are passed in a LineQuery.
+static void
+find_address_in_section (bfd *theBFD, asection *section, void *data)
 {
+    LineQuery& query = *static_cast<LineQuery*>(data);
     bfd_vma vma;
     bfd_size_type size;
 
-    if (found) {
+    if (query.found) {
 	return;
     }
 
@@ -770,10 +785,10 @@ find_address_in_section (bfd *theBFD, asection *section,
 	return;
     }
 
-    bfd_vma real_pc = pc;
+    bfd_vma real_pc = query.pc;
 
-    if (obj_base > 0) {
-	real_pc = pc - obj_base;
+    if (query.obj_base > 0) {
+	real_pc = query.pc - query.obj_base;
     }
 
     vma = bfd_get_section_vma (theBFD, section);
@@ -789,7 +804,7 @@ find_address_in_section (bfd *theBFD, asection *section,
 // DEBUG
 #if 0
 	std::cerr << "find_address_in_section: RETURNS EARLY "
-	   << " pc " << Address(pc)
+	   << " pc " << Address(query.pc)
 	   << " >= vma + size " << Address(vma + size)
 	   << " for vma " << Address(vma)
 	   << " + size " << Address(size) << std::endl;
@@ -802,14 +817,15 @@ find_address_in_section (bfd *theBFD, asection *section,
     const char *filename;
     const char *functionname;
     unsigned int line;
-    found = bfd_find_nearest_line (theBFD, section, syms, real_pc - vma,
-                                   &filename, &functionname, &line);
-    if (!found) {
+    query.found = bfd_find_nearest_line (theBFD, section, query.syms,
+					 real_pc - vma,
+					 &filename, &functionname, &line);
+    if (!query.found) {
 // DEBUG
 #ifndef NDEBUG
-	if(debug_symbols) {
+	if(query.debug_symbols) {
 	    std::cerr << "find_address_in_section: "
-	    << " bfd_find_nearest_line FAILS FOR " << Address(pc) << std::endl;
+	    << " bfd_find_nearest_line FAILS FOR " << Address(query.pc) << std::endl;
 	}
 #endif
 	return;
@@ -820,8 +836,8 @@ find_address_in_section (bfd *theBFD, asection *section,
 
 // DEBUG
 #ifndef NDEBUG
-    if(debug_symbols) {
-      std::cerr << "find_address_in_section: addr[" << Address(pc) << "]"
+    if(query.debug_symbols) {
+      std::cerr << "find_address_in_section: addr[" << Address(query.pc) << "]"
 	<< " func[" << tfunc << "]"
 	<< " file[" << tfile << "]"
 	<< " line[" << line << "]"
@@ -836,8 +852,8 @@ find_address_in_section (bfd *theBFD, asection *section,
     // DPM: do not add statement info if there is no source file
     // found. Typically tfile is empty and line is 0 in this case.
     if (!tfile.empty()) {
-	BFDStatement datastatement(pc, tfile, line);
-	statementvec.push_back(datastatement);
+	BFDStatement datastatement(query.pc, tfile, line);
+	query.statements->push_back(datastatement);
     }
 
     fflush(stdout);
@@ -896,9 +912,12 @@ BFDSymbols::getBFDFunctionStatements(const AddressBuffer& addrbuf,
 {
     int rval = -1;
     init_done = 0;
+
+    LineQuery query;
+    query.debug_symbols = false;
 #ifndef NDEBUG
     if(is_debug_bfd_symbols_details_enabled) {
-	debug_symbols = true;
+	query.debug_symbols = true;
     }
 #endif
 
@@ -970,6 +989,10 @@ BFDSymbols::getBFDFunctionStatements(const AddressBuffer& addrbuf,
 					      lorange.getBegin().getValue(),
 					      lorange.getEnd().getValue());
 
+	query.syms = syms;
+	query.obj_base = obj_base;
+	query.statements = &statementvec;
+
 #ifndef NDEBUG
 	if(is_debug_bfd_symbols_details_enabled) {
 	    std::cerr << "After Calling getFunctionSyms for "
@@ -983,9 +1006,9 @@ BFDSymbols::getBFDFunctionStatements(const AddressBuffer& addrbuf,
 	// in the sampled address space.
 	for (unsigned ii = 0; ii < addrvec.size(); ++ii) {
             int foundpc = 0;
-            pc = addrvec[ii];
+            query.pc = addrvec[ii];
             Address cur_pc(addrvec[ii]);
-            found = false;
+            query.found = false;
 
 	    for(FunctionsVec::iterator f = functionvec.begin();
 				       f !=  functionvec.end(); ++f) {
@@ -1059,7 +1082,7 @@ BFDSymbols::getBFDFunctionStatements(const AddressBuffer& addrbuf,
 #endif
 
 	    rval = addresses_found;
-	    bfd_map_over_sections (theBFD, find_address_in_section, NULL);
+	    bfd_map_over_sections (theBFD, find_address_in_section, &query);
 	}
     }
 
@@ -1068,9 +1091,9 @@ BFDSymbols::getBFDFunctionStatements(const AddressBuffer& addrbuf,
     for(std::set<Address>::const_iterator fi = function_begin_addresses.begin();
 					  fi != function_begin_addresses.end();
 					  ++fi) {
-	found = false;
-	pc = (*fi).getValue();
-        bfd_map_over_sections (theBFD, find_address_in_section, NULL);
+	query.found = false;
+	query.pc = (*fi).getValue();
+        bfd_map_over_sections (theBFD, find_address_in_section, &query);
     }
 
     if (syms) {
@@ -1083,6 +1106,7 @@ BFDSymbols::getBFDFunctionStatements(const AddressBuffer& addrbuf,
     }
 
     bfd_close(theBFD);
+    theBFD = NULL;
 
 // VERBOSE
 #ifndef NDEBUG
@@ -1100,6 +1124,15 @@ void
 BFDSymbols::getSymbols(const AddressBuffer& addrbuf,
 		       const LinkedObjectEntry& lo, SymbolTable& stmap)
 {
+    // Resolve from the symbol cache if this linked object was already parsed.
+    // BFD has no cheap way to enumerate all the statements of a linked object
+    // so entries are only ever added by SymtabAPISymbols.
+    SymbolCache cache(lo.getPath());
+    if (cache.isCached()) {
+	cache.getSymbols(addrbuf, lo, stmap);
+	return;
+    }
+
     // LinkedObject::getAddressRange actually returns the
     // set of AddressSpaces found in the database where the
     // LinkedObject actually was loaded into memory.
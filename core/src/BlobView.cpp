@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Definition of the BlobView class.
+ *
+ */
+
+#include "KrellInstitute/Core/Assert.hpp"
+#include "KrellInstitute/Core/Blob.hpp"
+#include "KrellInstitute/Core/BlobView.hpp"
+
+using namespace KrellInstitute::Core;
+
+
+
+/**
+ * Constructor from size and contents.
+ *
+ * Constructs a new BlobView of the specified size and contents. The contents
+ * are not copied and must remain valid for the lifetime of the view.
+ *
+ * @param size        Size of the view.
+ * @param contents    Pointer to the view's contents.
+ */
+BlobView::BlobView(const unsigned& size, const void* contents) :
+    dm_size(size),
+    dm_contents(reinterpret_cast<const unsigned char*>(contents))
+{
+}
+
+
+
+/**
+ * Constructor from a blob.
+ *
+ * Constructs a new BlobView of the specified blob's contents. The blob must
+ * remain valid, and unmodified, for the lifetime of the view.
+ *
+ * @param blob    Blob to be viewed.
+ */
+BlobView::BlobView(const Blob& blob) :
+    dm_size(blob.getSize()),
+    dm_contents(reinterpret_cast<const unsigned char*>(blob.getContents()))
+{
+}
+
+
+
+/**
+ * Get suffix.
+ *
+ * Returns a view of the contents following the specified offset, such as the
+ * performance data following an already decoded data header.
+ *
+ * @param offset    Offset (in bytes) of the suffix.
+ * @return          View of the suffix.
+ */
+BlobView BlobView::getSuffix(const unsigned& offset) const
+{
+    Assert(offset <= dm_size);
+    return BlobView(dm_size - offset, dm_contents + offset);
+}
+
+
+
+/**
+ * Get XDR decoding of contents.
+ *
+ * Gets an XDR decoding of the view's contents, placed into a caller-provided
+ * data structure, exactly as Blob::getXDRDecoding() does. The same notes on
+ * zero initializing and freeing the data structure apply.
+ *
+ * @param xdrproc    XDR procedure for the returned data type.
+ * @retval data      Pointer to the decoded data structure.
+ * @return           Decoding size (in bytes).
+ */
+unsigned BlobView::getXDRDecoding(const xdrproc_t xdrproc, void* data) const
+{
+    // Check assertions
+    Assert(xdrproc != NULL);
+    Assert(data != NULL);
+
+    // Open an XDR stream using our contents (which decoding never modifies)
+    XDR xdrs;
+    xdrmem_create(&xdrs,
+		  const_cast<char*>(reinterpret_cast<const char*>(dm_contents)),
+		  dm_size, XDR_DECODE);
+
+    // Decode the data structure from this stream
+    Assert((*xdrproc)(&xdrs, data) == TRUE);
+
+    // Get the decoding size
+    unsigned size = xdr_getpos(&xdrs);
+
+    // Close the XDR stream
+    xdr_destroy(&xdrs);
+
+    // Return the decoding size to the caller
+    return size;
+}
+
+
+
+/**
+ * Get XDR encoded 32-bit unsigned integer in place.
+ *
+ * @param offset    Offset (in bytes) of the encoding, advanced past it.
+ * @retval value    Decoded value.
+ * @return          Boolean "true" if the encoding lies within the view,
+ *                  "false" otherwise.
+ */
+bool BlobView::getXDRUnsigned(unsigned& offset, uint32_t& value) const
+{
+    if ((offset > dm_size) || ((dm_size - offset) < 4)) {
+	return false;
+    }
+    value = XDRArrayView<uint32_t>(1, dm_contents + offset)[0];
+    offset += 4;
+    return true;
+}
+
+
+
+/**
+ * Get XDR encoded 64-bit unsigned integer in place.
+ *
+ * @param offset    Offset (in bytes) of the encoding, advanced past it.
+ * @retval value    Decoded value.
+ * @return          Boolean "true" if the encoding lies within the view,
+ *                  "false" otherwise.
+ */
+bool BlobView::getXDRUnsigned(unsigned& offset, uint64_t& value) const
+{
+    if ((offset > dm_size) || ((dm_size - offset) < 8)) {
+	return false;
+    }
+    value = XDRArrayView<uint64_t>(1, dm_contents + offset)[0];
+    offset += 8;
+    return true;
+}
+
+
+
+/**
+ * Test if empty.
+ *
+ * Returns a boolean value indicating if the view is empty (has a zero size or
+ * null contents).
+ *
+ * @return    Boolean "true" if the view is empty, "false" otherwise.
+ */
+bool BlobView::isEmpty() const
+{
+    return (dm_size == 0) || (dm_contents == NULL);
+}
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Definition of the LinkedObjectIndex class.
+ *
+ */
+
+#include "KrellInstitute/Core/Assert.hpp"
+#include "KrellInstitute/Core/LinkedObjectIndex.hpp"
+
+#include <algorithm>
+#include <set>
+
+using namespace KrellInstitute::Core;
+
+
+
+namespace {
+
+    /** Start or end of a linked object's address range. */
+    struct Boundary
+    {
+	Address address;
+	bool is_begin;
+	unsigned object;
+
+	bool operator<(const Boundary& other) const
+	{
+	    return address < other.address;
+	}
+    };
+
+}
+
+
+
+/**
+ * Default constructor.
+ *
+ * Constructs an empty linked object index.
+ */
+LinkedObjectIndex::LinkedObjectIndex() :
+    dm_objects(),
+    dm_segments()
+{
+}
+
+
+
+/**
+ * Constructor from a vector of linked objects.
+ *
+ * Constructs the index of the passed linked objects. Sweeps over the sorted
+ * boundaries of their address ranges, keeping the set of linked objects
+ * containing the current address, and assigns each elementary range between
+ * two boundaries to the earliest linked object in that set. Linked objects
+ * with an empty address range are ignored.
+ *
+ * @param objects    Linked objects to be indexed.
+ */
+LinkedObjectIndex::LinkedObjectIndex(const LinkedObjectEntryVec& objects) :
+    dm_objects(),
+    dm_segments()
+{
+    std::vector<Boundary> boundaries;
+    boundaries.reserve(2 * objects.size());
+    for (unsigned i = 0; i < objects.size(); ++i) {
+	if (objects[i].addr_begin < objects[i].addr_end) {
+	    Boundary b = { objects[i].addr_begin, true, i };
+	    Boundary e = { objects[i].addr_end, false, i };
+	    boundaries.push_back(b);
+	    boundaries.push_back(e);
+	}
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+
+    // Index in dm_objects of each linked object owning a segment
+    std::vector<unsigned> owners(objects.size(), ~0U);
+
+    std::set<unsigned> active;
+    std::vector<Boundary>::const_iterator i = boundaries.begin();
+    while (i != boundaries.end()) {
+	Address address = i->address;
+	for (; (i != boundaries.end()) && (i->address == address); ++i) {
+	    if (i->is_begin) {
+		active.insert(i->object);
+	    } else {
+		active.erase(i->object);
+	    }
+	}
+
+	if (active.empty()) {
+	    continue;
+	}
+	Assert(i != boundaries.end());
+
+	unsigned object = *active.begin();
+	if (owners[object] == ~0U) {
+	    owners[object] = dm_objects.size();
+	    dm_objects.push_back(objects[object]);
+	}
+
+	// Extend the previous segment if it is adjacent and has the same owner
+	if (!dm_segments.empty() &&
+	    (dm_segments.back().end == address) &&
+	    (dm_segments.back().object == owners[object])) {
+	    dm_segments.back().end = i->address;
+	} else {
+	    Segment segment = { address, i->address, owners[object] };
+	    dm_segments.push_back(segment);
+	}
+    }
+}
+
+
+
+/**
+ * Find linked object.
+ *
+ * Finds the linked object containing the passed address.
+ *
+ * @param address    Address to be found.
+ * @return           Linked object containing the address, or NULL if none of
+ *                   the indexed linked objects contains it.
+ */
+const LinkedObjectEntry* LinkedObjectIndex::find(const Address& address) const
+{
+    // Find the first segment ending after the address
+    std::vector<Segment>::const_iterator i = dm_segments.begin();
+    std::vector<Segment>::const_iterator n = dm_segments.end();
+    while (i != n) {
+	std::vector<Segment>::const_iterator mid = i + ((n - i) / 2);
+	if (mid->end <= address) {
+	    i = mid + 1;
+	} else {
+	    n = mid;
+	}
+    }
+
+    if ((i == dm_segments.end()) || (address < i->begin)) {
+	return NULL;
+    }
+    return &dm_objects[i->object];
+}
+
+
+
+/**
+ * Partition addresses by linked object.
+ *
+ * Splits the passed address counts into runs of addresses falling within
+ * the same linked object. Both the addresses and the segments of the index
+ * are sorted, so they are walked together once rather than searching the
+ * index for every address.
+ *
+ * @param counts         Address counts to be partitioned.
+ * @retval partitions    Runs of addresses, in address order. Addresses not
+ *                       contained within any linked object are returned in
+ *                       runs with a NULL linked object.
+ */
+void LinkedObjectIndex::partition(const AddressCounts& counts,
+				  LinkedObjectPartitionVec& partitions) const
+{
+    std::vector<Segment>::const_iterator s = dm_segments.begin();
+    AddressCounts::const_iterator i = counts.begin();
+
+    while (i != counts.end()) {
+	while ((s != dm_segments.end()) && (s->end <= i->first)) {
+	    ++s;
+	}
+
+	LinkedObjectPartition run;
+	run.begin = i;
+	if ((s == dm_segments.end()) || (i->first < s->begin)) {
+	    run.object = NULL;
+	    while ((i != counts.end()) &&
+		   ((s == dm_segments.end()) || (i->first < s->begin))) {
+		++i;
+	    }
+	} else {
+	    run.object = &dm_objects[s->object];
+	    while ((i != counts.end()) && (i->first < s->end)) {
+		++i;
+	    }
+	}
+	run.end = i;
+	partitions.push_back(run);
+    }
+}
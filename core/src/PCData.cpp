@@ -59,12 +59,6 @@ void PCData::aggregateAddressCounts(
 	const uint8_t* counts,
 	AddressBuffer& buffer) const
 {
-    // Iterate over each of the stacktrace address entries.
-    for(unsigned i = 0; i < len; ++i) {
-#if 0
-	std::cerr << "Address " << Address((uint64_t)pc[i]) << " has count "
-	 << (int)counts[i] <<  std::endl;
-#endif
-	buffer.updateAddressCounts(pc[i], counts[i]);
-    }
+    // Repeated addresses are combined before updating the buffer.
+    buffer.updateAddressCounts(len, pc, counts);
 }
@@ -24,6 +24,9 @@
 
 #include <algorithm>
 
+#include "KrellInstitute/Core/Assert.hpp"
+#include "KrellInstitute/Core/BlobView.hpp"
+#include "KrellInstitute/Core/CollectorRegistry.hpp"
 #include "KrellInstitute/Core/PerfData.hpp"
 
 // uncomment this to get details of mem trace/
@@ -42,180 +45,129 @@ bool is_debug_aggregator_events_enabled =
     Graph dGraph;
 #endif
 
-    void aggregatePCData(const std::string id, const Blob &blob,
-			 AddressBuffer &buf, uint64_t &interval)
+    /**
+     * Aggregate sampling data in place. The pcsamp, hwc, hwcsamp, usertime and
+     * hwctime data blobs all begin with the sampling interval followed by the
+     * pc (or stack trace) and count arrays. These are walked directly within
+     * the blob's XDR encoding instead of being decoded into allocated arrays.
+     */
+    void aggregateEncodedSamples(const BlobView &blob, AddressBuffer &buf,
+				 uint64_t &interval)
     {
-	if (id == "pcsamp") {
-            CBTF_pcsamp_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_pcsamp_data), &data);
-	    interval = data.interval;
-	    PCData pcdata;
-            pcdata.aggregateAddressCounts(data.pc.pc_len, data.pc.pc_val, data.count.count_val, buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_pcsamp_data),
-                     reinterpret_cast<char*>(&data));
-
-	} else if (id == "hwc") {
-            CBTF_hwc_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwc_data), &data);
-	    interval = data.interval;
-	    PCData pcdata;
-            pcdata.aggregateAddressCounts(data.pc.pc_len, data.pc.pc_val, data.count.count_val, buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwc_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "hwcsamp") {
-            CBTF_hwcsamp_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwcsamp_data), &data);
-	    interval = data.interval;
-	    PCData pcdata;
-            pcdata.aggregateAddressCounts(data.pc.pc_len, data.pc.pc_val, data.count.count_val, buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwcsamp_data),
-                     reinterpret_cast<char*>(&data));
-	} else {
-	    return;
-	}
+	unsigned offset = 0;
+	XDRArrayView<uint64_t> pcs;
+	XDRArrayView<uint8_t> counts;
+	Assert(blob.getXDRUnsigned(offset, interval) &&
+	       blob.getXDRArray(offset, pcs) &&
+	       blob.getXDRArray(offset, counts));
+	buf.updateAddressCounts(pcs, counts);
     }
 
-    void aggregateSTSampleData(const std::string id, const Blob &blob,
-			 AddressBuffer &buf, uint64_t &interval)
+#if defined(CREATE_GRAPH)
+    void aggregate_usertime(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
     {
 	StacktraceData stdata;
-	if (id == "usertime") {
-            CBTF_usertime_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_usertime_data), &data);
-	    interval = data.interval;
-	    stdata.aggregateAddressCounts(data.stacktraces.stacktraces_len,
-				data.stacktraces.stacktraces_val,
-				data.count.count_val, buf);
+	CBTF_usertime_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_usertime_data), &data);
+	interval = data.interval;
+	stdata.aggregateAddressCounts(data.stacktraces.stacktraces_len,
+			    data.stacktraces.stacktraces_val,
+			    data.count.count_val, buf);
 #if defined(CREATE_GRAPH)
-	    // This is a per blob graph.
-	    Graph dGraph;
-	    stdata.graphAddressCounts(data.stacktraces.stacktraces_len,
-				data.stacktraces.stacktraces_val,
-				data.count.count_val, dGraph);
+	// This is a per blob graph.
+	Graph dGraph;
+	stdata.graphAddressCounts(data.stacktraces.stacktraces_len,
+			    data.stacktraces.stacktraces_val,
+			    data.count.count_val, dGraph);
 
-	    dGraph.printGraph();
+	dGraph.printGraph();
 #endif
 
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_usertime_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "hwctime") {
-            CBTF_hwctime_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwctime_data), &data);
-	    interval = data.interval;
-	    stdata.aggregateAddressCounts(data.stacktraces.stacktraces_len,
-				data.stacktraces.stacktraces_val,
-				data.count.count_val, buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_hwctime_data),
-                     reinterpret_cast<char*>(&data));
-	} else {
-	    return;
-	}
-
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_usertime_data),
+		 reinterpret_cast<char*>(&data));
     }
+#endif
 
-    void aggregateSTTraceData(const std::string id, const Blob &blob,
-			 AddressBuffer &buf)
+    void aggregate_io(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
     {
 	StacktraceData stdata;
-	if (id == "io") {
-            CBTF_io_trace_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_trace_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.events.events_len; ++i) {
-		++eventcount;
-		uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
-
-		for (unsigned j = data.events.events_val[i].stacktrace;
-		     j < data.stacktraces.stacktraces_len; ++j) {
-
-		    if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
-	        	Address a;
-			a = Address(data.stacktraces.stacktraces_val[j]);
-
-			AddressCounts::iterator it = addressTime.find(a);
-			if (it == addressTime.end() ) {
-			    addressTime.insert(std::make_pair(a,event_time));
-			} else {
-			    (*it).second += event_time;
-		    }
-		}
-	    }
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_trace_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "iop") {
-            CBTF_io_profile_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_profile_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.time.time_len; ++i) {
-		++eventcount;
-	        Address a;
-		a = Address(data.stacktraces.stacktraces_val[i]);
+	CBTF_io_trace_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_trace_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.events.events_len; ++i) {
+	    ++eventcount;
+	    uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
+
+	    for (unsigned j = data.events.events_val[i].stacktrace;
+		 j < data.stacktraces.stacktraces_len; ++j) {
+
+		if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+		    Address a;
+		    a = Address(data.stacktraces.stacktraces_val[j]);
 
-		AddressCounts::iterator it = addressTime.find(a);
-		if (it == addressTime.end() ) {
-		    addressTime.insert(std::make_pair(a,data.time.time_val[i]));
-		} else {
-		    (*it).second += data.time.time_val[i];
+		    AddressCounts::iterator it = addressTime.find(a);
+		    if (it == addressTime.end() ) {
+			addressTime.insert(std::make_pair(a,event_time));
+		    } else {
+			(*it).second += event_time;
 		}
 	    }
+	}
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_trace_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_profile_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "iot") {
-            CBTF_io_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_exttrace_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.events.events_len; ++i) {
-		++eventcount;
-		uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
-
-		for (unsigned j = data.events.events_val[i].stacktrace;
-		     j < data.stacktraces.stacktraces_len; ++j) {
-
-		    if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
-	        	Address a;
-			a = Address(data.stacktraces.stacktraces_val[j]);
-
-			AddressCounts::iterator it = addressTime.find(a);
-			if (it == addressTime.end() ) {
-			    addressTime.insert(std::make_pair(a,event_time));
-			} else {
-			    (*it).second += event_time;
-		    }
-		}
+    void aggregate_iop(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_io_profile_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_profile_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.time.time_len; ++i) {
+	    ++eventcount;
+	    Address a;
+	    a = Address(data.stacktraces.stacktraces_val[i]);
+
+	    AddressCounts::iterator it = addressTime.find(a);
+	    if (it == addressTime.end() ) {
+		addressTime.insert(std::make_pair(a,data.time.time_val[i]));
+	    } else {
+		(*it).second += data.time.time_val[i];
 	    }
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_exttrace_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "mem") {
-            CBTF_mem_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mem_exttrace_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.events.events_len; ++i) {
-		++eventcount;
-		uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
-
-		for (unsigned j = data.events.events_val[i].stacktrace;
-		     j < data.stacktraces.stacktraces_len; ++j) {
+	}
 
-		    if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_profile_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-	            Address a;
+    void aggregate_iot(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_io_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_exttrace_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.events.events_len; ++i) {
+	    ++eventcount;
+	    uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
+
+	    for (unsigned j = data.events.events_val[i].stacktrace;
+		 j < data.stacktraces.stacktraces_len; ++j) {
+
+		if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+		    Address a;
 		    a = Address(data.stacktraces.stacktraces_val[j]);
 
 		    AddressCounts::iterator it = addressTime.find(a);
@@ -223,190 +175,268 @@ bool is_debug_aggregator_events_enabled =
 			addressTime.insert(std::make_pair(a,event_time));
 		    } else {
 			(*it).second += event_time;
-		    }
 		}
 	    }
+	}
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_io_exttrace_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mem_exttrace_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "omptp") {
-            CBTF_ompt_profile_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_ompt_profile_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.time.time_len; ++i) {
-		++eventcount;
-	        Address a;
-		a = Address(data.stacktraces.stacktraces_val[i]);
+    void aggregate_mem(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_mem_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mem_exttrace_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.events.events_len; ++i) {
+	    ++eventcount;
+	    uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
+
+	    for (unsigned j = data.events.events_val[i].stacktrace;
+		 j < data.stacktraces.stacktraces_len; ++j) {
+
+		if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+
+		Address a;
+		a = Address(data.stacktraces.stacktraces_val[j]);
 
 		AddressCounts::iterator it = addressTime.find(a);
 		if (it == addressTime.end() ) {
-		    addressTime.insert(std::make_pair(a,data.time.time_val[i]));
+		    addressTime.insert(std::make_pair(a,event_time));
 		} else {
-		    (*it).second += data.time.time_val[i];
+		    (*it).second += event_time;
 		}
 	    }
+	}
 
-	    StacktraceData stdata;
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_ompt_profile_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "pthreads") {
-            CBTF_pthreads_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_pthreads_exttrace_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.events.events_len; ++i) {
-		++eventcount;
-		uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
-
-		for (unsigned j = data.events.events_val[i].stacktrace;
-		     j < data.stacktraces.stacktraces_len; ++j) {
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mem_exttrace_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-		    if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
-	        	Address a;
-			a = Address(data.stacktraces.stacktraces_val[j]);
+    void aggregate_omptp(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_ompt_profile_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_ompt_profile_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.time.time_len; ++i) {
+	    ++eventcount;
+	    Address a;
+	    a = Address(data.stacktraces.stacktraces_val[i]);
+
+	    AddressCounts::iterator it = addressTime.find(a);
+	    if (it == addressTime.end() ) {
+		addressTime.insert(std::make_pair(a,data.time.time_val[i]));
+	    } else {
+		(*it).second += data.time.time_val[i];
+	    }
+	}
 
-			AddressCounts::iterator it = addressTime.find(a);
-			if (it == addressTime.end() ) {
-			    addressTime.insert(std::make_pair(a,event_time));
-			} else {
-			    (*it).second += event_time;
-		    }
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_ompt_profile_data),
+		 reinterpret_cast<char*>(&data));
+    }
+
+    void aggregate_pthreads(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_pthreads_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_pthreads_exttrace_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.events.events_len; ++i) {
+	    ++eventcount;
+	    uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
+
+	    for (unsigned j = data.events.events_val[i].stacktrace;
+		 j < data.stacktraces.stacktraces_len; ++j) {
+
+		if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+		    Address a;
+		    a = Address(data.stacktraces.stacktraces_val[j]);
+
+		    AddressCounts::iterator it = addressTime.find(a);
+		    if (it == addressTime.end() ) {
+			addressTime.insert(std::make_pair(a,event_time));
+		    } else {
+			(*it).second += event_time;
 		}
 	    }
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_pthreads_exttrace_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "mpi") {
-            CBTF_mpi_trace_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_trace_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.events.events_len; ++i) {
-		++eventcount;
-		uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
-
-		for (unsigned j = data.events.events_val[i].stacktrace;
-		     j < data.stacktraces.stacktraces_len; ++j) {
+	}
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_pthreads_exttrace_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-		    if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
-	        	Address a;
-			a = Address(data.stacktraces.stacktraces_val[j]);
+    void aggregate_mpi(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_mpi_trace_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_trace_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.events.events_len; ++i) {
+	    ++eventcount;
+	    uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
+
+	    for (unsigned j = data.events.events_val[i].stacktrace;
+		 j < data.stacktraces.stacktraces_len; ++j) {
+
+		if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+		    Address a;
+		    a = Address(data.stacktraces.stacktraces_val[j]);
 
-			AddressCounts::iterator it = addressTime.find(a);
-			if (it == addressTime.end() ) {
-			    addressTime.insert(std::make_pair(a,event_time));
-			} else {
-			    (*it).second += event_time;
-		    }
+		    AddressCounts::iterator it = addressTime.find(a);
+		    if (it == addressTime.end() ) {
+			addressTime.insert(std::make_pair(a,event_time));
+		    } else {
+			(*it).second += event_time;
 		}
 	    }
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_trace_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "mpip") {
-            CBTF_mpi_profile_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_profile_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.time.time_len; ++i) {
-		++eventcount;
-	        Address a;
-		a = Address(data.stacktraces.stacktraces_val[i]);
+	}
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_trace_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-		AddressCounts::iterator it = addressTime.find(a);
-		if (it == addressTime.end() ) {
-		    addressTime.insert(std::make_pair(a,data.time.time_val[i]));
-		} else {
-		    (*it).second += data.time.time_val[i];
-		}
+    void aggregate_mpip(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_mpi_profile_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_profile_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.time.time_len; ++i) {
+	    ++eventcount;
+	    Address a;
+	    a = Address(data.stacktraces.stacktraces_val[i]);
+
+	    AddressCounts::iterator it = addressTime.find(a);
+	    if (it == addressTime.end() ) {
+		addressTime.insert(std::make_pair(a,data.time.time_val[i]));
+	    } else {
+		(*it).second += data.time.time_val[i];
 	    }
+	}
 
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_profile_data),
-                     reinterpret_cast<char*>(&data));
-	} else if (id == "mpit") {
-            CBTF_mpi_exttrace_data data;
-            memset(&data, 0, sizeof(data));
-            unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_exttrace_data), &data);
-	    int eventcount = 0;
-	    AddressCounts addressTime;
-	    for(unsigned i = 0; i < data.events.events_len; ++i) {
-		++eventcount;
-		uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
-
-		for (unsigned j = data.events.events_val[i].stacktrace;
-		     j < data.stacktraces.stacktraces_len; ++j) {
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_profile_data),
+		 reinterpret_cast<char*>(&data));
+    }
 
-		    if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
-			Address a;
-			a = Address(data.stacktraces.stacktraces_val[j]);
+    void aggregate_mpit(const BlobView &blob, AddressBuffer &buf,
+			 uint64_t &interval)
+    {
+	StacktraceData stdata;
+	CBTF_mpi_exttrace_data data;
+	memset(&data, 0, sizeof(data));
+	unsigned bsize = blob.getXDRDecoding(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_exttrace_data), &data);
+	int eventcount = 0;
+	AddressCounts addressTime;
+	for(unsigned i = 0; i < data.events.events_len; ++i) {
+	    ++eventcount;
+	    uint64_t event_time = data.events.events_val[i].stop_time - data.events.events_val[i].start_time;
+
+	    for (unsigned j = data.events.events_val[i].stacktrace;
+		 j < data.stacktraces.stacktraces_len; ++j) {
+
+		if (data.stacktraces.stacktraces_val[j] == 0) break; // end of stack
+		    Address a;
+		    a = Address(data.stacktraces.stacktraces_val[j]);
 
-			AddressCounts::iterator it = addressTime.find(a);
-			if (it == addressTime.end() ) {
-			    addressTime.insert(std::make_pair(a,event_time));
-			} else {
-			    (*it).second += event_time;
-		    }
+		    AddressCounts::iterator it = addressTime.find(a);
+		    if (it == addressTime.end() ) {
+			addressTime.insert(std::make_pair(a,event_time));
+		    } else {
+			(*it).second += event_time;
 		}
 	    }
-	    stdata.aggregateAddressCounts(addressTime,buf);
-            xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_exttrace_data),
-                     reinterpret_cast<char*>(&data));
-	} else {
-	    return;
 	}
+	stdata.aggregateAddressCounts(addressTime,buf);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_mpi_exttrace_data),
+		 reinterpret_cast<char*>(&data));
+    }
+
+    /** Type of the functions aggregating one collector's data blob. */
+    typedef void (*AggregateFunction)(const BlobView&, AddressBuffer&, uint64_t&);
 
+    /** Build the table of aggregation functions for every known collector. */
+    CollectorRegistry<AggregateFunction> makeAggregators()
+    {
+	CollectorRegistry<AggregateFunction> registry;
+	registry.add("pcsamp", aggregateEncodedSamples);
+	registry.add("hwc", aggregateEncodedSamples);
+	registry.add("hwcsamp", aggregateEncodedSamples);
+#if defined(CREATE_GRAPH)
+	registry.add("usertime", aggregate_usertime);
+#else
+	registry.add("usertime", aggregateEncodedSamples);
+#endif
+	registry.add("hwctime", aggregateEncodedSamples);
+	registry.add("io", aggregate_io);
+	registry.add("iop", aggregate_iop);
+	registry.add("iot", aggregate_iot);
+	registry.add("mem", aggregate_mem);
+	registry.add("omptp", aggregate_omptp);
+	registry.add("pthreads", aggregate_pthreads);
+	registry.add("mpi", aggregate_mpi);
+	registry.add("mpip", aggregate_mpip);
+	registry.add("mpit", aggregate_mpit);
+	return registry;
     }
+
+    /** Aggregation functions of the known collectors. */
+    const CollectorRegistry<AggregateFunction> Aggregators = makeAggregators();
 };
 
-int PerfData::aggregate(const Blob &blob, AddressBuffer &buf) {
+int PerfData::aggregate(const BlobView &blob, AddressBuffer &buf) {
 	// decode this blobs data header
         CBTF_DataHeader header;
         memset(&header, 0, sizeof(header));
         unsigned header_size = blob.getXDRDecoding(
             reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader), &header
             );
-	std::string collectorID(header.id);
 
-	// find the actual data blob after the header and create a Blob.
+	// find the actual data blob after the header and view it in place.
 	// TODO at callsite: Map the incoming data size to it's thread and increment as new
 	// data for same thread arrives.  Could be use to identify threads
 	// that are generating more data than others. REDUCTION.
-	unsigned data_size = blob.getSize() - header_size;
-	const void* data_ptr = &(reinterpret_cast<const char *>(blob.getContents())[header_size]);
-	Blob dblob(data_size,data_ptr);
+	BlobView dblob = blob.getSuffix(header_size);
+	unsigned data_size = dblob.getSize();
 
 #ifndef NDEBUG
         if (is_debug_aggregator_events_enabled) {
 	    std::cerr << "Aggregating Data Blob addresses for "
-	    << collectorID << " data bytes: " << data_size
+	    << header.id << " data bytes: " << data_size
 	    << std::endl;
 	}
 #endif
 
 	// The following does a global aggregation of the data. Not per thread of execution.
-	if (collectorID == "pcsamp" || collectorID == "hwc" || collectorID == "hwcsamp") {
-	    uint64_t interval;
-            aggregatePCData(collectorID, dblob, buf, interval);
-	} else if (collectorID == "usertime" || collectorID == "hwctime") {
+	int collector = Aggregators.find(header.id, dm_last_collector);
+	if (Aggregators.isValid(collector)) {
 	    uint64_t interval;
-            aggregateSTSampleData(collectorID, dblob, buf, interval);
-        } else if (collectorID == "io" || collectorID == "iot" ||
-		   collectorID == "iop" || collectorID == "mem" ||
-		   collectorID == "mpi" || collectorID == "mpit" ||
-		   collectorID == "mpip" || collectorID == "pthreads" ||
-		   collectorID == "omptp" ) {
-            aggregateSTTraceData(collectorID, dblob, buf);
+	    Aggregators[collector](dblob, buf, interval);
 	} else {
 	    std::cerr << "Unknown collector data handled!" << std::endl;
 	}
+
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader),
+		 reinterpret_cast<char*>(&header));
 	return data_size;
 }
 
@@ -444,7 +474,7 @@ int PerfData::aggregate(const Blob &blob, AddressBuffer &buf) {
 // Implemented but not active at this time.
 // CBTF_MEM_REASON_DURATION_OF_ALLOCATION.
 //
-int PerfData::memMetrics(const Blob &blob, MemMetrics& metrics) {
+int PerfData::memMetrics(const BlobView &blob, MemMetrics& metrics) {
     // decode this blobs data header
     CBTF_DataHeader header;
     memset(&header, 0, sizeof(header));
@@ -453,10 +483,8 @@ int PerfData::memMetrics(const Blob &blob, MemMetrics& metrics) {
             );
     std::string collectorID(header.id);
 
-    // find the actual data blob after the header and create a Blob.
-    const void* data_ptr =
-	&(reinterpret_cast<const char *>(blob.getContents())[header_size]);
-    Blob dblob(blob.getSize() - header_size,data_ptr);
+    // find the actual data blob after the header and view it in place.
+    BlobView dblob = blob.getSuffix(header_size);
 
     CBTF_mem_exttrace_data data;
     memset(&data, 0, sizeof(data));
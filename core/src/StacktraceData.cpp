@@ -47,10 +47,8 @@ void StacktraceData::aggregateAddressCounts(
 	const uint8_t* counts,
 	AddressBuffer& buffer) const
 {
-    // Iterate over each of the stacktrace address entries.
-    for(unsigned i = 0; i < len; ++i) {
-	buffer.updateAddressCounts(st[i], counts[i]);
-    }
+    // Frames repeat across stacktraces so these are combined in bulk.
+    buffer.updateAddressCounts(len, st, counts);
 }
 
 // Handle data from tracing.
@@ -59,10 +57,8 @@ void StacktraceData::aggregateAddressCounts(
 	const uint64_t* st,
 	AddressBuffer& buffer) const
 {
-    // Iterate over each of the stacktrace address entries.
-    for(unsigned i = 0; i < len; ++i) {
-	buffer.updateAddressCounts(st[i], 1);
-    }
+    // Frames repeat across stacktraces so these are combined in bulk.
+    buffer.updateAddressCounts(len, st, static_cast<uint64_t>(1));
 }
 
 // Handle data from tracing using exclusive time in function as count.
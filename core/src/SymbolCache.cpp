@@ -0,0 +1,713 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Definition of the SymbolCache class.
+ *
+ */
+
+#include "KrellInstitute/Core/Assert.hpp"
+#include "KrellInstitute/Core/Path.hpp"
+#include "KrellInstitute/Core/SymbolCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+using namespace KrellInstitute::Core;
+
+
+
+namespace {
+
+    /** Magic string at the start of each cache entry. */
+    const char Magic[8] = "CBTFSYM";
+
+    /** Version of the cache entry format. */
+    const uint32_t Version = 2;
+
+    /** Largest build-id note that is accepted. */
+    const std::size_t MaxNoteSize = 64 * 1024;
+
+    /** Read exactly the requested bytes at the given file offset. */
+    bool readAt(int fd, void* buffer, std::size_t size, off_t offset)
+    {
+	char* ptr = reinterpret_cast<char*>(buffer);
+	while (size > 0) {
+	    ssize_t n = pread(fd, ptr, size, offset);
+	    if (n < 0 && errno == EINTR) {
+		continue;
+	    }
+	    if (n <= 0) {
+		return false;
+	    }
+	    ptr += n;
+	    size -= n;
+	    offset += n;
+	}
+	return true;
+    }
+
+    /** Write all of the passed bytes. */
+    bool writeAll(int fd, const void* buffer, std::size_t size)
+    {
+	const char* ptr = reinterpret_cast<const char*>(buffer);
+	while (size > 0) {
+	    ssize_t n = write(fd, ptr, size);
+	    if (n < 0 && errno == EINTR) {
+		continue;
+	    }
+	    if (n <= 0) {
+		return false;
+	    }
+	    ptr += n;
+	    size -= n;
+	}
+	return true;
+    }
+
+    /** Find the GNU build-id in the notes of an ELF program header table. */
+    template <typename Ehdr, typename Phdr, typename Nhdr>
+    std::string findBuildId(int fd)
+    {
+	Ehdr ehdr;
+	if (!readAt(fd, &ehdr, sizeof(ehdr), 0) ||
+	    (ehdr.e_phentsize != sizeof(Phdr))) {
+	    return std::string();
+	}
+
+	for (unsigned i = 0; i < ehdr.e_phnum; ++i) {
+	    Phdr phdr;
+	    if (!readAt(fd, &phdr, sizeof(phdr),
+			ehdr.e_phoff + (i * sizeof(Phdr))) ||
+		(phdr.p_type != PT_NOTE) ||
+		(phdr.p_filesz > MaxNoteSize)) {
+		continue;
+	    }
+
+	    std::vector<char> notes(phdr.p_filesz);
+	    if (notes.empty() ||
+		!readAt(fd, &notes[0], notes.size(), phdr.p_offset)) {
+		continue;
+	    }
+
+	    std::size_t offset = 0;
+	    while ((offset + sizeof(Nhdr)) <= notes.size()) {
+		Nhdr nhdr;
+		memcpy(&nhdr, &notes[offset], sizeof(nhdr));
+		std::size_t name = offset + sizeof(Nhdr);
+		std::size_t desc = name + ((nhdr.n_namesz + 3) & ~3);
+		std::size_t next = desc + ((nhdr.n_descsz + 3) & ~3);
+		if (next > notes.size()) {
+		    break;
+		}
+
+		if ((nhdr.n_type == NT_GNU_BUILD_ID) &&
+		    (nhdr.n_namesz == 4) &&
+		    (memcmp(&notes[name], "GNU", 4) == 0) &&
+		    (nhdr.n_descsz > 0)) {
+		    std::ostringstream id;
+		    for (unsigned j = 0; j < nhdr.n_descsz; ++j) {
+			char hex[3];
+			snprintf(hex, sizeof(hex), "%02x",
+				 static_cast<unsigned char>(notes[desc + j]));
+			id << hex;
+		    }
+		    return id.str();
+		}
+		offset = next;
+	    }
+	}
+
+	return std::string();
+    }
+
+    /**
+     * Get the key of a linked object.
+     *
+     * Returns the ELF build-id of the linked object when it has one. Otherwise
+     * returns a key made of a hash of its path, its size and its modification
+     * time. An empty key is returned if the linked object can't be read.
+     */
+    std::string getKey(const std::string& path)
+    {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+	    return std::string();
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+	    close(fd);
+	    return std::string();
+	}
+
+	std::string key;
+	unsigned char ident[EI_NIDENT];
+	if (readAt(fd, ident, sizeof(ident), 0) &&
+	    (memcmp(ident, ELFMAG, SELFMAG) == 0)) {
+	    if (ident[EI_CLASS] == ELFCLASS64) {
+		key = findBuildId<Elf64_Ehdr, Elf64_Phdr, Elf64_Nhdr>(fd);
+	    } else if (ident[EI_CLASS] == ELFCLASS32) {
+		key = findBuildId<Elf32_Ehdr, Elf32_Phdr, Elf32_Nhdr>(fd);
+	    }
+	}
+	close(fd);
+
+	if (key.empty()) {
+	    // 64-bit FNV-1a hash of the path
+	    uint64_t hash = 14695981039346656037ULL;
+	    for (std::string::const_iterator i = path.begin();
+		 i != path.end(); ++i) {
+		hash = (hash ^ static_cast<unsigned char>(*i)) *
+		    1099511628211ULL;
+	    }
+
+	    std::ostringstream name;
+	    name << std::hex << hash << "-" << st.st_size << "-" << st.st_mtime;
+	    key = name.str();
+	}
+
+	return key;
+    }
+
+}
+
+
+
+/**
+ * Constructor from a linked object path.
+ *
+ * Constructs the symbol cache of the specified linked object. The entry of the
+ * linked object is mapped into memory if it is found in the cache directory
+ * given by CBTF_SYMBOL_CACHE_DIR. The cache is disabled if that variable isn't
+ * set or the linked object can't be read.
+ *
+ * @param path    Path of the linked object.
+ */
+SymbolCache::SymbolCache(const std::string& path) :
+    dm_file(),
+    dm_map(NULL),
+    dm_map_size(0),
+    dm_entry(),
+    dm_header(NULL),
+    dm_functions(NULL),
+    dm_statements(NULL),
+    dm_strings(NULL),
+    dm_image(),
+    dm_function_records(),
+    dm_statement_records(),
+    dm_string_offsets(),
+    dm_string_pool()
+{
+    const char* directory = getenv("CBTF_SYMBOL_CACHE_DIR");
+    if ((directory == NULL) || (*directory == '\0')) {
+	return;
+    }
+
+    std::string key = getKey(path);
+    if (key.empty()) {
+	return;
+    }
+    dm_file = std::string(directory) + "/" + key + ".symbols";
+
+    int fd = open(dm_file.c_str(), O_RDONLY);
+    if (fd >= 0) {
+	map(fd);
+	close(fd);
+    }
+}
+
+
+
+/**
+ * Destructor.
+ *
+ * Unmaps the entry of the linked object.
+ */
+SymbolCache::~SymbolCache()
+{
+    if (dm_map != NULL) {
+	munmap(dm_map, dm_map_size);
+    }
+}
+
+
+
+/**
+ * Set the image.
+ *
+ * Sets the image offset and length of the linked object of the entry being
+ * built.
+ *
+ * @param offset    Image offset of the linked object.
+ * @param length    Image length of the linked object.
+ */
+void SymbolCache::setImage(const uint64_t& offset, const uint64_t& length)
+{
+    dm_image.image_offset = offset;
+    dm_image.image_length = length;
+}
+
+
+
+/**
+ * Add a function.
+ *
+ * Adds the specified function to the entry being built. Functions must be added
+ * in the order they are found in the linked object, since the first of several
+ * overlapping functions is the one kept by the symbol table.
+ *
+ * @param begin    Beginning offset of the function.
+ * @param end      Ending offset of the function.
+ * @param name     Mangled name of the function.
+ */
+void SymbolCache::addFunction(const uint64_t& begin, const uint64_t& end,
+			      const std::string& name)
+{
+    if (begin >= end) {
+	return;
+    }
+    FunctionRecord record = {
+	begin, end, intern(name), dm_function_records.size()
+    };
+    dm_function_records.push_back(record);
+}
+
+
+
+/**
+ * Add a statement.
+ *
+ * Adds the specified statement to the entry being built.
+ *
+ * @param begin     Beginning offset of the statement.
+ * @param end       Ending offset of the statement.
+ * @param path      Full path name of this statement's source file.
+ * @param line      Line number of this statement.
+ * @param column    Column number of this statement.
+ */
+void SymbolCache::addStatement(const uint64_t& begin, const uint64_t& end,
+			       const std::string& path,
+			       const int& line, const int& column)
+{
+    if (begin >= end) {
+	return;
+    }
+    StatementRecord record = { begin, end, intern(path), line, column };
+    dm_statement_records.push_back(record);
+}
+
+
+
+/**
+ * Store the entry.
+ *
+ * Lays out the entry being built and writes it to the cache directory. The
+ * entry is written to a temporary file that is then renamed, so concurrent
+ * readers and writers of the same entry never see a partial file. Whether
+ * or not it could be written, the entry becomes the current entry. An entry
+ * built from an incompletely parsed linked object is never written, so that
+ * it isn't used in place of parsing the linked object again.
+ *
+ * @param complete    Boolean "true" if the linked object was parsed completely.
+ * @return            Boolean "true" if the entry was written, "false" otherwise.
+ */
+bool SymbolCache::store(const bool& complete)
+{
+    Assert(dm_header == NULL);
+
+    std::stable_sort(dm_function_records.begin(), dm_function_records.end(),
+		     FunctionRecord::byBegin);
+    std::sort(dm_statement_records.begin(), dm_statement_records.end());
+    dm_statement_records.erase(std::unique(dm_statement_records.begin(),
+					   dm_statement_records.end()),
+			       dm_statement_records.end());
+
+    memcpy(dm_image.magic, Magic, sizeof(Magic));
+    dm_image.version = Version;
+    dm_image.reserved = 0;
+    dm_image.num_functions = dm_function_records.size();
+    dm_image.num_statements = dm_statement_records.size();
+    dm_image.max_statement_length = 0;
+    for (std::vector<StatementRecord>::const_iterator
+	     i = dm_statement_records.begin();
+	 i != dm_statement_records.end(); ++i) {
+	dm_image.max_statement_length =
+	    std::max(dm_image.max_statement_length, i->end - i->begin);
+    }
+    dm_image.strings_size = dm_string_pool.size();
+
+    std::size_t functions_size =
+	dm_function_records.size() * sizeof(FunctionRecord);
+    std::size_t statements_size =
+	dm_statement_records.size() * sizeof(StatementRecord);
+
+    dm_entry.resize(sizeof(Header) + functions_size + statements_size +
+		    dm_string_pool.size());
+    char* ptr = &dm_entry[0];
+    memcpy(ptr, &dm_image, sizeof(Header));
+    ptr += sizeof(Header);
+    if (functions_size > 0) {
+	memcpy(ptr, &dm_function_records[0], functions_size);
+	ptr += functions_size;
+    }
+    if (statements_size > 0) {
+	memcpy(ptr, &dm_statement_records[0], statements_size);
+	ptr += statements_size;
+    }
+    if (!dm_string_pool.empty()) {
+	memcpy(ptr, dm_string_pool.data(), dm_string_pool.size());
+    }
+
+    dm_header = reinterpret_cast<const Header*>(&dm_entry[0]);
+    dm_functions = reinterpret_cast<const FunctionRecord*>(dm_header + 1);
+    dm_statements =
+	reinterpret_cast<const StatementRecord*>(dm_functions +
+						 dm_header->num_functions);
+    dm_strings =
+	reinterpret_cast<const char*>(dm_statements +
+				      dm_header->num_statements);
+
+    dm_function_records.clear();
+    dm_statement_records.clear();
+    dm_string_offsets.clear();
+    dm_string_pool.clear();
+
+    if (!isEnabled() || !complete) {
+	return false;
+    }
+
+    // Create the cache directory if necessary
+    Path directory = Path(dm_file).getDirName();
+    if (!directory.doesExist()) {
+	std::string partial;
+	std::istringstream components(directory);
+	std::string component;
+	while (std::getline(components, component, '/')) {
+	    partial += component + "/";
+	    mkdir(partial.c_str(), 0755);
+	}
+    }
+
+    std::string temporary = dm_file + ".XXXXXX";
+    std::vector<char> name(temporary.begin(), temporary.end());
+    name.push_back('\0');
+    int fd = mkstemp(&name[0]);
+    if (fd < 0) {
+	return false;
+    }
+    fchmod(fd, 0644);
+
+    bool written = writeAll(fd, &dm_entry[0], dm_entry.size());
+    if (close(fd) != 0) {
+	written = false;
+    }
+    if (!written || (rename(&name[0], dm_file.c_str()) != 0)) {
+	unlink(&name[0]);
+	return false;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Get symbols.
+ *
+ * Adds to the symbol table the functions containing a sampled address of the
+ * linked object, the statements containing a sampled address, and the
+ * statements at the beginning of the functions that were found.
+ *
+ * @pre    The entry must be available. An assertion failure occurs if it is
+ *         neither mapped nor built.
+ *
+ * @param abuffer         Sampled addresses.
+ * @param linkedobject    Linked object being resolved.
+ * @retval st             Symbol table to be updated.
+ */
+void SymbolCache::getSymbols(const AddressBuffer& abuffer,
+			     const LinkedObjectEntry& linkedobject,
+			     SymbolTable& st) const
+{
+    Assert(dm_header != NULL);
+
+    AddressRange lorange = linkedobject.getAddressRange();
+    AddressCounts::const_iterator ai_begin =
+	abuffer.addresscounts.lower_bound(lorange.getBegin());
+    AddressCounts::const_iterator ai_end =
+	abuffer.addresscounts.upper_bound(lorange.getEnd());
+    AddressCounts::const_iterator ai;
+
+    Address image_offset(dm_header->image_offset);
+    Address base(0);
+    if ((image_offset - lorange.getBegin()) < 0) {
+	base = lorange.getBegin();
+    }
+
+    // Offsets of the sampled addresses within the linked object, ascending
+    std::vector<uint64_t> offsets;
+    for (ai = ai_begin; ai != ai_end; ++ai) {
+	// normalize address for testing range from symtabapi.
+	Address theAddr(ai->first - base.getValue());
+	offsets.push_back(theAddr.getValue());
+    }
+
+    // Find the functions containing a sampled offset. The functions are sorted
+    // by beginning offset, so the first sampled offset not below the beginning
+    // of each function is found with a single walk over both. A function is
+    // sampled if that offset is also below its end.
+    std::vector<const FunctionRecord*> sampled;
+    std::vector<uint64_t>::const_iterator o = offsets.begin();
+    for (const FunctionRecord* f = dm_functions;
+	 (f != dm_functions + dm_header->num_functions) &&
+	     (o != offsets.end());
+	 ++f) {
+	while ((o != offsets.end()) && (*o < f->begin)) {
+	    ++o;
+	}
+	if ((o != offsets.end()) && (*o < f->end)) {
+	    sampled.push_back(f);
+	}
+    }
+
+    // Add them in the linked object's own order, since the first of several
+    // identical ranges is the one kept by the symbol table
+    std::sort(sampled.begin(), sampled.end(), FunctionRecord::inOrder);
+
+    std::set<uint64_t> function_begin_offsets;
+    for (std::vector<const FunctionRecord*>::const_iterator
+	     f = sampled.begin(); f != sampled.end(); ++f) {
+	Address begin((*f)->begin);
+	st.addFunction(begin, Address((*f)->end), base,
+		       dm_strings + (*f)->name);
+
+	// Record the function begin addresses, This allows the cli and gui
+	// to focus on or display the first statement of a function.
+	Address theAddr(begin - base.getValue());
+	function_begin_offsets.insert(theAddr.getValue());
+    }
+
+    std::vector<uint64_t> statement_offsets;
+    std::set_union(offsets.begin(), offsets.end(),
+		   function_begin_offsets.begin(), function_begin_offsets.end(),
+		   std::back_inserter(statement_offsets));
+    getStatements(statement_offsets, base.getValue(), st);
+}
+
+
+
+/** Compare two FunctionRecord objects by beginning offset. */
+bool SymbolCache::FunctionRecord::byBegin(const FunctionRecord& lhs,
+					  const FunctionRecord& rhs)
+{
+    return lhs.begin < rhs.begin;
+}
+
+
+
+/** Compare two FunctionRecord objects by their order in the linked object. */
+bool SymbolCache::FunctionRecord::inOrder(const FunctionRecord* lhs,
+					  const FunctionRecord* rhs)
+{
+    return lhs->order < rhs->order;
+}
+
+
+
+/** Compare two StatementRecord objects by beginning offset. */
+bool SymbolCache::StatementRecord::byBegin(const StatementRecord& lhs,
+					   const StatementRecord& rhs)
+{
+    return lhs.begin < rhs.begin;
+}
+
+
+
+/** Operator "<" defined for two StatementRecord objects. */
+bool SymbolCache::StatementRecord::operator<(const StatementRecord& other) const
+{
+    if (begin != other.begin)
+	return begin < other.begin;
+    if (end != other.end)
+	return end < other.end;
+    if (file != other.file)
+	return file < other.file;
+    if (line != other.line)
+	return line < other.line;
+    return column < other.column;
+}
+
+
+
+/** Operator "==" defined for two StatementRecord objects. */
+bool SymbolCache::StatementRecord::operator==(const StatementRecord& other) const
+{
+    return (begin == other.begin) && (end == other.end) &&
+	(file == other.file) && (line == other.line) &&
+	(column == other.column);
+}
+
+
+
+/**
+ * Get statements at offsets.
+ *
+ * Adds to the symbol table, relocated by the base address, every statement
+ * whose address range contains one of the passed offsets. Statements are
+ * sorted by beginning offset, so each of them is examined at most once, at
+ * the first offset not below its beginning. Statements ending before that
+ * offset can't contain any later offset either. Statements beginning more
+ * than the longest statement before the offset are skipped with a binary
+ * search.
+ *
+ * @param offsets    Offsets within the linked object, sorted and unique.
+ * @param base       Base address of the linked object.
+ * @retval st        Symbol table to be updated.
+ */
+void SymbolCache::getStatements(const std::vector<uint64_t>& offsets,
+				const uint64_t& base, SymbolTable& st) const
+{
+    const StatementRecord* i = dm_statements;
+    const StatementRecord* n = dm_statements + dm_header->num_statements;
+
+    for (std::vector<uint64_t>::const_iterator
+	     o = offsets.begin(); (o != offsets.end()) && (i != n); ++o) {
+	if (*o >= dm_header->max_statement_length) {
+	    StatementRecord lowest = { *o - dm_header->max_statement_length + 1 };
+	    if (i->begin < lowest.begin) {
+		i = std::lower_bound(i, n, lowest, StatementRecord::byBegin);
+	    }
+	}
+
+	for (; (i != n) && (i->begin <= *o); ++i) {
+	    if (*o < i->end) {
+		st.addStatement(Address(i->begin) + Address(base),
+				Address(i->end) + Address(base),
+				Path(dm_strings + i->file), i->line, i->column);
+	    }
+	}
+    }
+}
+
+
+
+/**
+ * Intern a string.
+ *
+ * Adds the passed string to the string pool of the entry being built, unless
+ * it is already there.
+ *
+ * @param value    String to be interned.
+ * @return         Offset of the string within the string pool.
+ */
+uint64_t SymbolCache::intern(const std::string& value)
+{
+    std::map<std::string, uint64_t>::const_iterator
+	i = dm_string_offsets.find(value);
+    if (i != dm_string_offsets.end()) {
+	return i->second;
+    }
+
+    uint64_t offset = dm_string_pool.size();
+    dm_string_pool.append(value.c_str(), value.size() + 1);
+    dm_string_offsets.insert(std::make_pair(value, offset));
+    return offset;
+}
+
+
+
+/**
+ * Map an entry.
+ *
+ * Maps the passed cache file into memory and makes it the current entry if
+ * it is a complete entry of the current version.
+ *
+ * @param fd    File descriptor of the cache file.
+ * @return      Boolean "true" if the entry was mapped, "false" otherwise.
+ */
+bool SymbolCache::map(int fd)
+{
+    struct stat st;
+    if ((fstat(fd, &st) != 0) ||
+	(static_cast<uint64_t>(st.st_size) < sizeof(Header))) {
+	return false;
+    }
+
+    void* ptr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+	return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(ptr);
+    bool valid = (memcmp(header->magic, Magic, sizeof(Magic)) == 0) &&
+	(header->version == Version) &&
+	(header->num_functions <= (st.st_size / sizeof(FunctionRecord))) &&
+	(header->num_statements <= (st.st_size / sizeof(StatementRecord))) &&
+	(header->strings_size <= static_cast<uint64_t>(st.st_size)) &&
+	((sizeof(Header) +
+	  (header->num_functions * sizeof(FunctionRecord)) +
+	  (header->num_statements * sizeof(StatementRecord)) +
+	  header->strings_size) == static_cast<uint64_t>(st.st_size)) &&
+	((header->strings_size == 0) ||
+	 (reinterpret_cast<const char*>(ptr)[st.st_size - 1] == '\0'));
+
+    // Every string offset must be within the string pool. Since the pool ends
+    // with a NUL, each string is then terminated within the pool.
+    const FunctionRecord* functions =
+	reinterpret_cast<const FunctionRecord*>(header + 1);
+    const StatementRecord* statements =
+	reinterpret_cast<const StatementRecord*>(functions +
+						 (valid ? header->num_functions : 0));
+    for (uint64_t i = 0; valid && (i < header->num_functions); ++i) {
+	valid = (functions[i].name < header->strings_size);
+    }
+    for (uint64_t i = 0; valid && (i < header->num_statements); ++i) {
+	valid = (statements[i].file < header->strings_size);
+    }
+
+    if (!valid) {
+	munmap(ptr, st.st_size);
+	return false;
+    }
+
+    dm_map = ptr;
+    dm_map_size = st.st_size;
+    dm_header = header;
+    dm_functions = reinterpret_cast<const FunctionRecord*>(dm_header + 1);
+    dm_statements =
+	reinterpret_cast<const StatementRecord*>(dm_functions +
+						 dm_header->num_functions);
+    dm_strings =
+	reinterpret_cast<const char*>(dm_statements +
+				      dm_header->num_statements);
+    return true;
+}
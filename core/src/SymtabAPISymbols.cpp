@@ -25,15 +25,63 @@
 #include "KrellInstitute/Core/SymtabAPISymbols.hpp"
 #include "KrellInstitute/Core/Address.hpp"
 #include "KrellInstitute/Core/AddressRange.hpp"
+#include "KrellInstitute/Core/SymbolCache.hpp"
 #include "Symtab.h"
 #include "LineInformation.h"
 #include "Function.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <map>
 #include <sstream>
 
 using namespace KrellInstitute::Core;
 using namespace Dyninst;
 using namespace Dyninst::SymtabAPI;
 
+namespace {
+
+    /**
+     * Symtab::openFile is not reentrant: every thread shares the list of the
+     * opened Symtabs that it searches and appends to. Opening a linked object
+     * is serialized by this mutex, which also guards symtab_mutexes.
+     */
+    boost::mutex symtabapi_mutex;
+
+    /**
+     * Opening the same linked object again returns the same Symtab, which
+     * must not be parsed by two threads at once. Each Symtab is parsed while
+     * holding its own mutex, so different linked objects are parsed
+     * concurrently.
+     */
+    std::map<Symtab*, boost::shared_ptr<boost::mutex> > symtab_mutexes;
+
+    /**
+     * Open a linked object with SymtabAPI.
+     *
+     * @param objname    Path of the linked object to open.
+     * @retval symtab    Symtab of the linked object.
+     * @return           Mutex to hold while parsing the Symtab, or a null
+     *                   pointer if the linked object could not be opened.
+     */
+    boost::shared_ptr<boost::mutex> openSymtab(const std::string& objname,
+					       Symtab*& symtab)
+    {
+	boost::mutex::scoped_lock lock(symtabapi_mutex);
+
+	symtab = NULL;
+	if (!Symtab::openFile(symtab, objname) || (symtab == NULL)) {
+	    return boost::shared_ptr<boost::mutex>();
+	}
+
+	boost::shared_ptr<boost::mutex>& symtab_mutex = symtab_mutexes[symtab];
+	if (!symtab_mutex) {
+	    symtab_mutex.reset(new boost::mutex);
+	}
+	return symtab_mutex;
+    }
+
+}
+
 #ifndef NDEBUG
 /** Flag indicating if debuging is enabled. */
 bool SymtabAPISymbols::is_debug_symtabapi_symbols_enabled =
@@ -50,36 +98,39 @@ SymtabAPISymbols::getSymbols(const AddressBuffer& abuffer,
 			     const LinkedObjectEntry& linkedobject,
 			     SymbolTable& st)
 {
-    std::set<Address> addresses;
-    AddressCounts ac = abuffer.addresscounts;
-    AddressCounts::const_iterator aci;
-
-    std::set<Address>::iterator ai;
-    for (aci = ac.begin(); aci != ac.end(); ++aci) {
-	addresses.insert(aci->first);
-    }
-
     std::string objname = linkedobject.getPath();
-    AddressRange lorange = linkedobject.getAddressRange();
-    std::set<AddressRange>::iterator si;
-
 
 // DEBUG
 #ifndef NDEBUG
     if(is_debug_symtabapi_symbols_enabled) {
 	std::cerr << "SymtabAPISymbols::getSymbols: Processing linked object "
-	    << objname << " with address range " << lorange
-	    << " addresses is " << addresses.size()
+	    << objname << " with address range " << linkedobject.getAddressRange()
+	    << " addresses is " << abuffer.addresscounts.size()
 	    << std::endl;
     }
 #endif
 
-    Symtab *symtab;
-    bool symtab_opened = Symtab::openFile(symtab, objname);
+    // The functions and statements of this linked object are resolved from
+    // its symbol cache entry. Parse the linked object only if it isn't cached.
+    SymbolCache cache(objname);
+    if (cache.isCached()) {
+// DEBUG
+#ifndef NDEBUG
+	if(is_debug_symtabapi_symbols_enabled) {
+	    std::cerr << "SymtabAPISymbols::getSymbols: Using cached symbols for "
+		<< objname << std::endl;
+	}
+#endif
+	cache.getSymbols(abuffer, linkedobject, st);
+	return;
+    }
 
-    //std::cerr << "SymtabAPISymbols::getSymbols: symtab_opened=" << symtab_opened << " symtab=" << symtab << std::endl;
+    // Gather the functions and statements of this linked object into its
+    // symbol cache entry. Only this part calls into SymtabAPI.
+    Symtab *symtab;
+    boost::shared_ptr<boost::mutex> symtab_mutex = openSymtab(objname, symtab);
 
-    if (!symtab_opened || symtab == NULL) { 
+    if (!symtab_mutex) { 
 // DEBUG
 #ifndef NDEBUG
         if(is_debug_symtabapi_symbols_enabled) {
@@ -92,6 +143,8 @@ SymtabAPISymbols::getSymbols(const AddressBuffer& abuffer,
         return;
     } 
 
+    boost::mutex::scoped_lock lock(*symtab_mutex);
+
     KrellInstitute::Core::Address image_offset(symtab->imageOffset());
     KrellInstitute::Core::Address image_length(symtab->imageLength());
     AddressRange image_range(image_offset,image_offset+image_length);
@@ -103,20 +156,14 @@ SymtabAPISymbols::getSymbols(const AddressBuffer& abuffer,
     }
 #endif
 
-    KrellInstitute::Core::Address base(0);
-    if ( (image_range.getBegin() - lorange.getBegin()) < 0 ) {
-	base = lorange.getBegin();
-    }
-
     std::vector <Dyninst::SymtabAPI::Function *>fsyms;
+    bool complete = true;
 
     // Make sure we get the full filename
-    if(symtab) {
-       symtab->setTruncateLinePaths(false);
-    }
-
+    symtab->setTruncateLinePaths(false);
 
-    if(symtab && !symtab->getAllFunctions(fsyms)) {
+    if(!symtab->getAllFunctions(fsyms)) {
+	complete = false;
 #ifndef NDEBUG
 	if(is_debug_symtabapi_symbols_enabled) {
 	    std::cerr << "Dyninst::SymtabAPI::Symbol::getAllFunctions unable to get functions\n`"
@@ -128,189 +175,63 @@ SymtabAPISymbols::getSymbols(const AddressBuffer& abuffer,
 
     }
 
-#ifndef NDEBUG
-    std::stringstream output;
-#endif
-
-    std::set<Address>::iterator ai_begin = addresses.equal_range(lorange.getBegin()).first;
-    std::set<Address>::iterator ai_end = addresses.equal_range(lorange.getEnd()).second;
-    std::set<KrellInstitute::Core::Address> function_begin_addresses;
-    std::vector <Function *>::iterator fsit;
-    
-    for(fsit = fsyms.begin(); fsit != fsyms.end(); ++fsit) {
-	int sym_size = (*fsit)->getSize();
-	KrellInstitute::Core::Address begin((*fsit)->getOffset());
-	KrellInstitute::Core::Address end(begin + sym_size);
-
-	// don't let an invalid range through...
-	if (begin >= end) continue;
-
-	AddressRange frange(begin,end);
-
-	for (ai=ai_begin; ai!=ai_end; ++ai)
-	{
-	    // normalize address for testing range from symtabapi.
-	    KrellInstitute::Core::Address theAddr(*ai - base.getValue()) ; 
-	    if (frange.doesContain( theAddr )) {
-
-		std::string fname =
-			(*fsit)->getFirstSymbol()->getMangledName();
-// DEBUG
-#ifndef NDEBUG
-		if(is_debug_symtabapi_symbols_detailed_enabled) {
-	            output << "SymtabAPISymbols::getSymbols: ADDING FUNCTION " << fname
-		    << " " << frange
-		    << " pc:" << *ai
-		    << " adjusted pc:" << theAddr
-		    << std::endl;
-		}
-#endif
-		//st.addFunction(begin+base,end+base,fname);
-		st.addFunction(begin,end,base,fname);
-
-		// Record the function begin addresses, This allows the
-		// cli and gui to focus on or display the first
-		// statement of a function.
-		// The function begin addresses will be processed later
-		// for statement info and added to our statements.
-		function_begin_addresses.insert(begin);
-		break;
-	    }
-	}
-    }
-
-#ifndef NDEBUG
-    if(is_debug_symtabapi_symbols_detailed_enabled) {
-	std::cerr << output.str();
-        output.clear();
-    }
-#endif
-
-
     std::vector <Module *>mods;
-    AddressRange module_range;
-    std::string module_name;
-    if(symtab && !symtab->getAllModules(mods)) {
+    if(!symtab->getAllModules(mods)) {
+	complete = false;
 	std::cerr << "SymtabAPISymbols::getSymbols: getAllModules unable to get all modules  "
 	    << Symtab::printError(Symtab::getLastSymtabError()).c_str()
 	    << std::endl;
-    } else {
-// DEBUG
-#ifndef NDEBUG
-        if(is_debug_symtabapi_symbols_detailed_enabled) {
-	    for(unsigned i = 0; i< mods.size();i++){
-	        module_range =
-		   AddressRange(mods[i]->addr(),
-				mods[i]->addr() + symtab->imageLength());
-	        module_name = mods[i]->fullName();
-	        std::cerr << "SymtabAPISymbols::getSymbols: getAllModules for " << mods[i]->fullName()
-		    << " Range " << module_range
-		    << std::endl;
-	    }
-	}
-#endif
     }
 
-// DEBUG
-#ifndef NDEBUG
-    if(is_debug_symtabapi_symbols_enabled) {
-
-        std::cerr << "SymtabAPISymbols::getSymbols: image_offset:" << image_offset
-	<< " image_length:" << image_length
-	<< " image_range:" << image_range << std::endl;
-
-	std::cerr << "USING BASE OFFSET " << base << std::endl;
+    // Rather than matching each function against each sampled address, and
+    // looking up the source lines of each sampled address in each module,
+    // all the functions and statements of this linked object are gathered
+    // once into a (possibly cached) entry. It is sorted by address so that
+    // SymbolCache::getSymbols can match them against the sorted sampled
+    // addresses in a single walk.
+    cache.setImage(symtab->imageOffset(), symtab->imageLength());
+    for(std::vector<Function *>::iterator fi = fsyms.begin();
+	fi != fsyms.end(); ++fi) {
+	cache.addFunction((*fi)->getOffset(),
+			  (*fi)->getOffset() + (*fi)->getSize(),
+			  (*fi)->getFirstSymbol()->getMangledName());
     }
-#endif
 
-    for (ai=ai_begin; ai!=ai_end; ++ai)
-    {
-	// normalize address for testing range from symtabapi.
-	KrellInstitute::Core::Address theAddr(*ai - base.getValue()) ; 
-	Offset myoffset = theAddr.getValue();
-
-	for(unsigned i = 0; i< mods.size();i++) {
-	    std::vector< Dyninst::SymtabAPI::Statement *> mylines;
-	    mods[i]->getSourceLines(mylines,myoffset);
-	    if (mylines.size() > 0) {
-		for (std::vector<Dyninst::SymtabAPI::Statement *>::iterator si = mylines.begin();
-		     si != mylines.end(); si++) {
+    for(unsigned i = 0; i < mods.size(); i++) {
 // DEBUG
 #ifndef NDEBUG
-		    if(is_debug_symtabapi_symbols_detailed_enabled) {
-			output << "SymtabAPISymbols::getSymbols: SAMPLE Address:" << theAddr + base
-			<< " " << (*si)->getFile()
-			<< ":" << (*si)->getLine()
-			<< ":" << (int) (*si)->getColumn()
-			<< ":" << KrellInstitute::Core::Address((*si)->startAddr()) +base
-			<< ":" << KrellInstitute::Core::Address((*si)->endAddr()) +base
-			<< std::endl;
-		    }
+	if(is_debug_symtabapi_symbols_detailed_enabled) {
+	    std::cerr << "SymtabAPISymbols::getSymbols: getAllModules for " << mods[i]->fullName()
+		<< std::endl;
+	}
 #endif
-		    // add the base offset back when recording statement.
-		    st.addStatement(KrellInstitute::Core::Address((*si)->startAddr()) +base,
-				KrellInstitute::Core::Address((*si)->endAddr()) +base,
-				(*si)->getFile(),
-				(*si)->getLine(),
-				(int) (*si)->getColumn()
-				);
-		}
-	    }
-	} // mods loop
-    } // sampled addresses loop
-
-#ifndef NDEBUG
-    if(is_debug_symtabapi_symbols_detailed_enabled) {
-	std::cerr << output.str();
-        output.clear();
+	std::vector< Dyninst::SymtabAPI::Statement *> lines;
+	if(!mods[i]->getStatements(lines)) {
+	    complete = false;
+	}
+	for(std::vector<Dyninst::SymtabAPI::Statement *>::iterator
+		si = lines.begin(); si != lines.end(); ++si) {
+	    cache.addStatement((*si)->startAddr(), (*si)->endAddr(),
+			       (*si)->getFile(), (*si)->getLine(),
+			       (int) (*si)->getColumn());
+	}
     }
-#endif
 
-    // Find any statements for the beginning of a function that
-    // contained a valid sample address.
-    for(std::set<KrellInstitute::Core::Address>::const_iterator fi = function_begin_addresses.begin();
-			                                      fi != function_begin_addresses.end();
-			                                      ++fi) {
-	// Lookup address by subtracting base offset.
-	KrellInstitute::Core::Address theAddr(*fi - base.getValue()) ; 
-	Offset myoffset = theAddr.getValue();
-        for(unsigned i = 0; i< mods.size();i++) {
-	    std::vector< Dyninst::SymtabAPI::Statement *> mylines;
-	    mods[i]->getSourceLines(mylines,myoffset);
-	    if (mylines.size() > 0) {
-		for(std::vector<Dyninst::SymtabAPI::Statement *>::iterator si = mylines.begin();
-			si != mylines.end(); si++) {
+    lock.unlock();
 
+    // Only cache what was parsed completely, so that a transient failure to
+    // parse isn't remembered for good.
+    if (!cache.store(complete) && cache.isEnabled()) {
 // DEBUG
 #ifndef NDEBUG
-	 	    if(is_debug_symtabapi_symbols_detailed_enabled) {
-			output << "SymtabAPISymbols::getSymbols: FUNCTION BEGIN"
-				  << " " << (*si)->getFile()
-				  << ":" << (*si)->getLine()
-				  << ":" << (int) (*si)->getColumn()
-				  << ":" << KrellInstitute::Core::Address((*si)->startAddr()) +base
-				  << ":" << KrellInstitute::Core::Address((*si)->endAddr()) +base
-				  << std::endl;
-		    }
+	if(is_debug_symtabapi_symbols_enabled) {
+	    std::cerr << "SymtabAPISymbols::getSymbols: Could not cache symbols for "
+		<< objname << std::endl;
+	}
 #endif
-
-		    // add the base offset back when recording statement.
-		    st.addStatement(KrellInstitute::Core::Address((*si)->startAddr()) +base,
-				KrellInstitute::Core::Address((*si)->endAddr()) +base,
-				(*si)->getFile(),
-				(*si)->getLine(),
-				(int) (*si)->getColumn()
-				);
-		}
-	    }
-	} // mods loop
-    } // function begin statement loop
-#ifndef NDEBUG
-    if(is_debug_symtabapi_symbols_detailed_enabled) {
-	std::cerr << output.str();
-        output.clear();
     }
-#endif
+
+    cache.getSymbols(abuffer, linkedobject, st);
 }
 
 
@@ -327,8 +248,9 @@ SymtabAPISymbols::getDepenentLibs(const std::string& objname,
 	   std::vector<std::string>& dependencies)
 {
     Symtab *symtab;
-    bool err = Symtab::openFile(symtab, objname);
-    if (symtab) {
+    boost::shared_ptr<boost::mutex> symtab_mutex = openSymtab(objname, symtab);
+    if (symtab_mutex) {
+	boost::mutex::scoped_lock lock(*symtab_mutex);
 	dependencies = symtab->getDependencies();
     }
 }
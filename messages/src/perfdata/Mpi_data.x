@@ -48,7 +48,7 @@ struct CBTF_mpit_event {
     int destination;   /**< Destination rank (in MPI_COMM_WORLD). */
     uint64_t size;     /**< Number of bytes sent. */
     int tag;           /**< Tag of the message (if any). */
-    int communicator;  /**< Communicator used. */
+    int communicator;  /**< Identifier of the communicator used. */
     int datatype;      /**< Data type of the message. */
     int retval;        /**< Enumerated return value. */
 
@@ -38,6 +38,45 @@ extern void cbtf_collector_send(const CBTF_DataHeader* header,
 
 
 
+/**
+ * Called by the collector to hand off performance data to the background
+ * flusher, which encodes and sends it asynchronously. Only available with
+ * offline (fileio) collection when CBTF_ASYNC_FLUSH is set in the environment.
+ * The data must not be modified until the flusher clears the in-flight flag.
+ * Currently only used by the pcsamp collector.
+ *
+ * @param header       Performance data header to apply to this data.
+ * @param xdrproc      XDR procedure for the passed data structure.
+ * @param data         Pointer to the data structure to be sent.
+ * @param in_flight    Flag set while the data is owned by the flusher.
+ * @return             Boolean "true" if the data was handed off, or "false"
+ *                     if it must instead be sent with cbtf_collector_send().
+ */
+extern bool cbtf_collector_send_async(const CBTF_DataHeader* header,
+                                      const xdrproc_t xdrproc,
+                                      const void* data,
+                                      volatile bool* in_flight);
+
+
+
+/**
+ * Called by the collector, when it stops, to wait until all of the performance
+ * data it handed off with cbtf_collector_send_async() was sent. Must not be
+ * called from within a signal handler.
+ */
+extern void cbtf_collector_wait_async();
+
+
+
+/**
+ * Called by the collector when performance data of the calling thread was sent
+ * by another thread, such as the raw event encoder, on its behalf. Only used
+ * with offline (fileio) collection.
+ */
+extern void cbtf_collector_data_sent();
+
+
+
 /**
  * A short string, provided by the collector and containing only lower-case
  * letters, that uniquely identifies this collector. E.g. "pcsamp".
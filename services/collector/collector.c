@@ -53,6 +53,7 @@
 #if defined(CBTF_SERVICE_USE_FILEIO)
 #include "KrellInstitute/Services/Fileio.h"
 #include "KrellInstitute/Services/Send.h"
+#include <pthread.h>
 #endif
 #include "KrellInstitute/Services/Time.h"
 #include "KrellInstitute/Services/TLS.h"
@@ -104,6 +105,43 @@ static struct {
  */
 bool connected_to_mrnet;
 
+#if defined(CBTF_SERVICE_USE_FILEIO)
+/**
+ * Background flusher used when CBTF_ASYNC_FLUSH is set in the environment.
+ * Started once per process by the first thread to start sampling. Only the
+ * pcsamp collector hands off data to it; the others always send synchronously.
+ */
+static pthread_once_t flusher_once = PTHREAD_ONCE_INIT;
+static bool flusher_started = false;
+
+/* The flusher thread doesn't exist in the child of a fork, so re-create it. */
+static void restart_flusher()
+{
+    if (flusher_started) {
+	monitor_disable_new_threads();
+	flusher_started = CBTF_StartFlusher();
+	monitor_enable_new_threads();
+    }
+}
+
+static void start_flusher()
+{
+    if (getenv("CBTF_ASYNC_FLUSH") == NULL) {
+	return;
+    }
+
+    /* The flusher thread must not itself be sampled */
+    monitor_disable_new_threads();
+    flusher_started = CBTF_StartFlusher();
+    monitor_enable_new_threads();
+
+    /* Registered after the flusher's own fork handlers so it runs after them */
+    if (flusher_started) {
+	pthread_atfork(NULL, NULL, restart_flusher);
+    }
+}
+#endif
+
 /* debug flags */
 #ifndef NDEBUG
 static bool IsCollectorDebugEnabled = false;
@@ -568,6 +606,61 @@ void cbtf_collector_send(const CBTF_DataHeader* header,
 #endif
 }
 
+bool cbtf_collector_send_async(const CBTF_DataHeader* header,
+                               const xdrproc_t xdrproc, const void* data,
+                               volatile bool* in_flight)
+{
+#if defined(CBTF_SERVICE_USE_FILEIO)
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    Assert(tls != NULL);
+
+    if (!CBTF_SendToFlusher(header, xdrproc, data, in_flight)) {
+	return false;
+    }
+    tls->sent_data = true;
+
+#if defined(CBTF_SERVICE_USE_OFFLINE)
+    cbtf_offline_sent_data(1);
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+void cbtf_collector_wait_async()
+{
+#if defined(CBTF_SERVICE_USE_FILEIO)
+    CBTF_DrainFlusher();
+#endif
+}
+
+void cbtf_collector_data_sent()
+{
+#if defined(CBTF_SERVICE_USE_FILEIO)
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    Assert(tls != NULL);
+
+    tls->sent_data = true;
+
+#if defined(CBTF_SERVICE_USE_OFFLINE)
+    cbtf_offline_sent_data(1);
+#endif
+#endif
+}
+
 
 
 /**
@@ -702,6 +795,12 @@ void cbtf_timer_service_start_sampling(const char* arguments)
  */
     if (strcmp(cbtf_collector_unique_id,"overview")) {
 	CBTF_SetSendToFile(&(tls->header), cbtf_collector_unique_id, "openss-data");
+
+	/* Hand off data to the background flusher if requested */
+	pthread_once(&flusher_once, start_flusher);
+	if (flusher_started) {
+	    CBTF_RegisterFlusherThread();
+	}
     }
     tls->sent_data = false;
 #endif
@@ -711,6 +810,9 @@ void cbtf_timer_service_start_sampling(const char* arguments)
 	fprintf(stderr,"[%d,%d] cbtf_timer_service_start_sampling calls cbtf_collector_start.\n",getpid(),monitor_get_thread_num());
     }
 #endif
+    /* Choose the tick source here rather than within a function wrapper */
+    CBTF_InitializeTicks();
+
     /* Begin collection */
     tls->sampling_status = CBTF_Monitor_Started;
     cbtf_collector_start(&tls->header);
@@ -762,7 +864,13 @@ void cbtf_timer_service_stop_sampling(const char* arguments)
     tls->sampling_status = CBTF_Monitor_Finished;
 
 #if defined(CBTF_SERVICE_USE_FILEIO)
+    /* Wait for any data handed off to the background flusher */
+    CBTF_UnregisterFlusherThread();
+
     cbtf_offline_finish();
+
+    /* Write out any data still buffered and release this thread's file */
+    CBTF_CloseSendToFile();
 #else
 
     if (tls->sent_attached_to_threads) {
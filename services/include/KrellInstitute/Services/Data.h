@@ -79,22 +79,102 @@ typedef struct {
 
 } CBTF_HWCPCData;
 
+/**
+ * Number of entries in a stack trace hash table indexing a tracing buffer of
+ * the given size. Every stack trace occupies at least one buffer entry so the
+ * hash table can never fill up.
+ */
+#define CBTF_StackTraceHashTableSize(bufsize) ((bufsize) + ((bufsize) / 4))
+
 /** Type representing StackTrace sampling data. */
 #define CBTF_ST_BufferSize  1024
 #define CBTF_ST_MAXFRAMES 32
+#define CBTF_ST_HashTableSize CBTF_StackTraceHashTableSize(CBTF_ST_BufferSize)
 typedef struct {
     uint64_t addr_begin;  /**< Beginning of gathered data's address range. */
     uint64_t addr_end;    /**< End of gathered data's address range. */
 
+    uint16_t length;  /**< Actual used length of the stacktraces and count arrays. */
+
     uint64_t stacktraces[CBTF_ST_BufferSize];    /**< Stack trace (PC) addresses. */
     uint8_t  count[CBTF_ST_BufferSize]; /**< count value greater than 0 is top */
                                         /**< of stack. A count of 255 indicates */
                                 /**< another instance of this stack may */
                                 /**< exist in buffer bt. */
 
+    /** Hash table mapping stack traces to the index of their top. */
+    unsigned hash_table[CBTF_ST_HashTableSize];
+
 } CBTF_StackTraceData;
 
 bool CBTF_UpdatePCData(uint64_t, CBTF_PCData*);
 bool CBTF_UpdateHWCPCData(uint64_t, CBTF_HWCPCData*, long long* );
+bool CBTF_UpdateStackTraceBuffer(const uint64_t*, unsigned, CBTF_StackTraceData*);
+
+bool CBTF_FindStackTrace(const uint64_t*, unsigned, const uint64_t*, unsigned,
+			 const uint8_t*, const unsigned*, unsigned, unsigned*);
+void CBTF_AddStackTrace(const uint64_t*, unsigned, unsigned,
+			unsigned*, unsigned);
+
+uint64_t CBTF_HashStackTrace(const uint64_t*, unsigned);
+bool CBTF_FindHashedStackTrace(uint64_t, const uint64_t*, unsigned,
+			       const uint64_t*, unsigned, const uint8_t*,
+			       const unsigned*, unsigned, unsigned*);
+void CBTF_AddHashedStackTrace(uint64_t, unsigned, unsigned,
+			      unsigned*, unsigned);
+
+void CBTF_SetTracedFunctions(const char*, const char* const*, unsigned,
+			     uint64_t*);
+
+/** Maximum number of frames in the stack trace of a raw event. */
+#define CBTF_RawEventMaxFrames 64
+/** Number of collector defined arguments of a raw event. */
+#define CBTF_RawEventArgCount 8
+
+/**
+ * Type representing a raw traced event, written by a function wrapper into its
+ * thread's raw event ring and encoded later by the raw event encoder thread.
+ */
+typedef struct {
+    uint64_t time;             /**< Start time of the call. */
+    uint64_t function;         /**< Address of the traced function. */
+    uint64_t stacktrace_hash;  /**< Set by the encoder thread. */
+    uint32_t stacktrace_size;  /**< Number of frames in the stack trace. */
+    uint32_t reserved;
+    uint64_t args[CBTF_RawEventArgCount];  /**< Collector defined arguments. */
+    uint64_t stacktrace[CBTF_RawEventMaxFrames];  /**< Stack trace. */
+} CBTF_RawEvent;
+
+/** Encoder of the raw events of one thread, called on the encoder thread. */
+typedef void (*CBTF_RawEventEncoder)(void*, const CBTF_RawEvent*);
+
+bool CBTF_StartRawEventEncoder();
+bool CBTF_RegisterRawEventThread(CBTF_RawEventEncoder, void*);
+void CBTF_UnregisterRawEventThread();
+CBTF_RawEvent* CBTF_BeginRawEvent();
+void CBTF_CommitRawEvent();
+
+/** Number of stack trace entries in the tracing buffer of a raw trace. */
+#define CBTF_RawTraceStackTraceBufferSize (CBTF_BlobSizeFactor * 384)
+/** Number of event entries in the tracing buffer of a raw trace. */
+#define CBTF_RawTraceEventBufferSize (CBTF_BlobSizeFactor * 415)
+
+/**
+ * Type representing one traced call in the tracing buffer of a raw trace. Has
+ * the same layout as the CBTF_io_event and CBTF_mpi_event types.
+ */
+typedef struct {
+    uint64_t start_time;  /**< Start time of the call. */
+    uint64_t stop_time;   /**< End time of the call. */
+    uint16_t stacktrace;  /**< Index of the stack trace. */
+} CBTF_RawTraceEvent;
+
+/** Tracing buffer filled by the raw event encoder for one traced thread. */
+typedef struct CBTF_RawTrace CBTF_RawTrace;
+
+CBTF_RawTrace* CBTF_StartRawTrace(const CBTF_DataHeader*, xdrproc_t);
+bool CBTF_RecordRawTraceEvent(uint64_t, uint64_t, uint64_t,
+			      unsigned, unsigned);
+bool CBTF_StopRawTrace(CBTF_RawTrace*);
 
 #endif
@@ -34,5 +34,19 @@ void CBTF_EventSetSendToFile(CBTF_EventHeader*, const char*, const char*);
 void CBTF_SetSendToFile(CBTF_DataHeader*, const char*, const char*);
 
 int CBTF_SendToFile(const unsigned, const void*);
+void CBTF_FlushSendToFile();
+void CBTF_CloseSendToFile();
+void* CBTF_OpenSendToFileHandle();
+void CBTF_CloseSendToFileHandle(void*);
+int CBTF_SendToFileHandle(void*, const unsigned, const void*);
+void CBTF_Data_SendToFileHandle(void*, const CBTF_DataHeader*,
+				const xdrproc_t, const void*);
+
+bool CBTF_StartFlusher();
+bool CBTF_RegisterFlusherThread();
+void CBTF_UnregisterFlusherThread();
+bool CBTF_SendToFlusher(const CBTF_DataHeader*, const xdrproc_t,
+			const void*, volatile bool*);
+void CBTF_DrainFlusher();
 
 #endif
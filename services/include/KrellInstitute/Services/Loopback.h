@@ -0,0 +1,59 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Declaration of the CBTFW Runtime Loopback.
+ *
+ * The loopback transport implements the same functions as the MRNet transport
+ * (see MRNet.h) but, instead of sending each tagged message to the frontend of
+ * an MRNet tree, hands it to a handler within the same process. A tool linked
+ * against it can feed the messages straight into an in-process component
+ * network.
+ *
+ */
+
+#ifndef _CBTF_Runtime_Loopback_
+#define _CBTF_Runtime_Loopback_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Handler of the messages sent through the loopback transport. Called on the
+ * sending thread, one message at a time. The message contents are only valid
+ * for the duration of the call.
+ *
+ * @param context    Context given when the handler was set.
+ * @param tag        Tag for the message.
+ * @param size       Size (in bytes) of the message.
+ * @param data       Pointer to the message contents.
+ */
+typedef void (*CBTF_Loopback_Handler)(void* context, int tag, uint32_t size,
+                                      const void* data);
+
+void CBTF_Loopback_SetHandler(CBTF_Loopback_Handler handler, void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
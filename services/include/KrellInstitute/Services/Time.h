@@ -36,6 +36,21 @@
 #include <inttypes.h>
 #endif
 
+/**
+ * Type representing the calibration against which all the ticks of one data
+ * blob are converted, so that they are all converted consistently.
+ */
+typedef struct {
+    uint64_t ticks;       /**< Tick at the calibration point. */
+    uint64_t time;        /**< Time at the calibration point. */
+    double ns_per_tick;   /**< Tick rate. */
+} CBTF_TickCalibration;
+
 uint64_t CBTF_GetTime();
+void CBTF_InitializeTicks();
+uint64_t CBTF_GetTicks();
+void CBTF_GetTickCalibration(CBTF_TickCalibration*);
+uint64_t CBTF_TicksToTime(const CBTF_TickCalibration*, uint64_t);
+uint64_t CBTF_TicksToDuration(const CBTF_TickCalibration*, uint64_t);
 
 #endif
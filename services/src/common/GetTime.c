@@ -19,7 +19,21 @@
 
 /** @file
  *
- * Definition of the CBTF_GetTime() function.
+ * Definition of the CBTF_GetTime() function and of the tick based timestamp
+ * service used by the tracing function wrappers.
+ *
+ * A tick is read with a single instruction from the invariant time stamp
+ * counter when the kernel itself uses it as its clock source, and otherwise
+ * from CLOCK_MONOTONIC_RAW through the vDSO. The source is chosen, and the
+ * process-wide calibration point taken, by CBTF_InitializeTicks() when the
+ * collector starts; reading a tick never waits or does any I/O. Ticks are
+ * converted to the time returned by CBTF_GetTime() only when a data blob is
+ * encoded, all of them against a single snapshot of a per-thread calibration
+ * anchored to CLOCK_REALTIME and re-anchored once per calibration interval.
+ * Converted times are thus as comparable across processes and hosts
+ * as CLOCK_REALTIME itself. The tick rate is measured against CLOCK_MONOTONIC,
+ * which is slewed like CLOCK_REALTIME but never stepped, so that steps of
+ * CLOCK_REALTIME only move the anchors.
  *
  */
 
@@ -30,7 +44,46 @@
 #include "KrellInstitute/Services/Assert.h"
 #include "KrellInstitute/Services/Time.h"
 
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+/** Interval after which a thread re-anchors its calibration (in ns). */
+#define CBTF_CalibrationInterval 1000000000ULL
+
+/** Span after which the measured tick rate is no longer provisional (in ns). */
+#define CBTF_CalibrationSpan 1000000ULL
+
+/** Number of attempts at reading a tick and the time back to back. */
+#define CBTF_CalibrationAttempts 5
+
+/** Type defining a calibration point and the tick rate around it. */
+typedef struct {
+    uint64_t ticks;       /**< Ticks at the calibration point. */
+    uint64_t time;        /**< CLOCK_REALTIME at the calibration point. */
+    uint64_t monotonic;   /**< CLOCK_MONOTONIC at the calibration point. */
+    double ns_per_tick;   /**< Tick rate (zero if not yet calibrated). */
+    bool provisional;     /**< Was the rate measured over a short span? */
+} Calibration;
+
+/** Source of the ticks. */
+typedef enum { Uninitialized = 0, TimeStampCounter, MonotonicRaw } Source;
+
+static Source source = Uninitialized;
+
+/** Process-wide calibration point from which tick rates are measured. */
+static Calibration base;
+static pthread_once_t base_once = PTHREAD_ONCE_INIT;
+
+/** Calibration of this thread. */
+static __thread Calibration calibration;
 
 
 
@@ -56,3 +109,282 @@ uint64_t CBTF_GetTime()
     return ((uint64_t)(now.tv_sec) * (uint64_t)(1000000000)) +
 	(uint64_t)(now.tv_nsec);
 }
+
+
+
+/** Read the given clock in nanoseconds. */
+static inline uint64_t read_clock(clockid_t clock)
+{
+    struct timespec now;
+
+    Assert(clock_gettime(clock, &now) == 0);
+    return ((uint64_t)(now.tv_sec) * (uint64_t)(1000000000)) +
+	(uint64_t)(now.tv_nsec);
+}
+
+
+
+/** Read a tick from the given source. */
+static inline uint64_t read_ticks(Source from)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (from == TimeStampCounter)
+	return __rdtsc();
+#endif
+    return read_clock(CLOCK_MONOTONIC_RAW);
+}
+
+
+
+/**
+ * Test if the time stamp counter can be used. It must be invariant (constant
+ * rate, running in all power states) and the kernel must trust it enough to
+ * use it as its own clock source, which rules out unsynchronized counters
+ * between sockets and unreliable counters under virtualization.
+ */
+static bool use_time_stamp_counter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax, ebx, ecx, edx;
+    char clocksource[32] = "";
+    const char* requested = getenv("CBTF_TIME_SOURCE");
+    FILE* file;
+
+    if ((requested != NULL) && (strcmp(requested, "tsc") != 0))
+	return false;
+
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+	!(edx & (1 << 8)))
+	return false;
+
+    file = fopen("/sys/devices/system/clocksource/clocksource0/"
+		 "current_clocksource", "r");
+    if (file == NULL)
+	return false;
+    if (fgets(clocksource, sizeof(clocksource), file) == NULL)
+	clocksource[0] = '\0';
+    fclose(file);
+
+    return strncmp(clocksource, "tsc", 3) == 0;
+#else
+    return false;
+#endif
+}
+
+
+
+/**
+ * Take a calibration point. Reads both clocks between two ticks, retrying a few
+ * times to keep the reads whose ticks are the closest together.
+ */
+static void take_calibration_point(Source from, Calibration* point)
+{
+    uint64_t best = ~0ULL;
+    unsigned i;
+
+    for (i = 0; i < CBTF_CalibrationAttempts; ++i) {
+	uint64_t before = read_ticks(from);
+	uint64_t time = CBTF_GetTime();
+	uint64_t monotonic = read_clock(CLOCK_MONOTONIC);
+	uint64_t after = read_ticks(from);
+
+	if ((after - before) < best) {
+	    best = after - before;
+	    point->ticks = before + ((after - before) / 2);
+	    point->time = time;
+	    point->monotonic = monotonic;
+	}
+    }
+}
+
+
+
+/**
+ * Choose the tick source, unless it was already chosen, and return the source.
+ * Never waits for another thread choosing it.
+ */
+static Source choose_source(Source chosen)
+{
+    Source expected = Uninitialized;
+
+    __atomic_compare_exchange_n(&source, &expected, chosen, false,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&source, __ATOMIC_ACQUIRE);
+}
+
+
+
+/**
+ * Take the process-wide calibration point. Ticks read before the collector
+ * started, if any, were read from CLOCK_MONOTONIC_RAW, which needs no I/O to
+ * be chosen.
+ */
+static void take_base()
+{
+    take_calibration_point(choose_source(MonotonicRaw), &base);
+}
+
+
+
+/**
+ * Re-anchor the calling thread's calibration. The tick rate is measured from
+ * the process-wide calibration point to a new point taken now, and thus gets
+ * more precise as the process runs. Never waits for time to pass: a rate
+ * measured less than a calibration span after the process-wide point is only
+ * provisional, and is measured again at the next conversion. Being anchored
+ * next to the ticks being converted, such a rate costs little precision.
+ */
+static void recalibrate()
+{
+    Calibration point;
+
+    take_calibration_point(source, &point);
+
+    point.ns_per_tick = (point.ticks > base.ticks) ?
+	((double)(point.monotonic - base.monotonic) /
+	 (double)(point.ticks - base.ticks)) :
+	0.0;
+    point.provisional = (point.monotonic - base.monotonic) <
+	CBTF_CalibrationSpan;
+    calibration = point;
+}
+
+
+
+/**
+ * Get the calling thread's calibration, re-anchoring it when it is too far
+ * from the given tick or its rate is only provisional.
+ */
+static inline const Calibration* get_calibration(uint64_t ticks)
+{
+    int64_t distance;
+
+    pthread_once(&base_once, take_base);
+
+    distance = (int64_t)(ticks - calibration.ticks);
+
+    if ((calibration.ns_per_tick == 0.0) || calibration.provisional ||
+	((llabs(distance) * calibration.ns_per_tick) >
+	 CBTF_CalibrationInterval))
+	recalibrate();
+
+    return &calibration;
+}
+
+
+
+/**
+ * Initialize the ticks.
+ *
+ * Chooses the source of the ticks and takes the process-wide calibration point.
+ * Choosing the time stamp counter involves reading the kernel's clock source,
+ * so this must be called when the collector starts, from outside of a signal
+ * handler or function wrapper. Does nothing once the ticks are initialized.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_InitializeTicks()
+{
+    if (__atomic_load_n(&source, __ATOMIC_ACQUIRE) == Uninitialized)
+	choose_source(use_time_stamp_counter() ? TimeStampCounter :
+		      MonotonicRaw);
+
+    pthread_once(&base_once, take_base);
+}
+
+
+
+/**
+ * Get the current tick.
+ *
+ * Returns a timestamp that is much cheaper to read than CBTF_GetTime(), for
+ * use within the function wrappers. Ticks are only meaningful to the calling
+ * process and must be converted with CBTF_TicksToTime() or CBTF_TicksToDuration()
+ * when they are sent.
+ *
+ * @note    This function does not allocate memory, take any locks, wait or do
+ *          any I/O and is therefore safe to call from within a function wrapper
+ *          or a signal handler.
+ *
+ * @return    Current tick.
+ *
+ * @ingroup RuntimeAPI
+ */
+uint64_t CBTF_GetTicks()
+{
+    Source from = __atomic_load_n(&source, __ATOMIC_RELAXED);
+
+    /* Without I/O, only CLOCK_MONOTONIC_RAW can be chosen here */
+    if (__builtin_expect(from == Uninitialized, 0))
+	from = choose_source(MonotonicRaw);
+
+    return read_ticks(from);
+}
+
+
+
+/**
+ * Get a tick calibration.
+ *
+ * Takes a snapshot of the calling thread's calibration, re-anchored next to
+ * the current tick if necessary, against which every tick of a data blob about
+ * to be sent is then converted. Converting the start and stop ticks of a call
+ * against the same snapshot guarantees that the call doesn't end before it
+ * starts, even if the calibration is re-anchored in between.
+ *
+ * @retval snapshot    Tick calibration.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_GetTickCalibration(CBTF_TickCalibration* snapshot)
+{
+    const Calibration* c;
+
+    Assert(snapshot != NULL);
+
+    c = get_calibration(CBTF_GetTicks());
+    snapshot->ticks = c->ticks;
+    snapshot->time = c->time;
+    snapshot->ns_per_tick = c->ns_per_tick;
+}
+
+
+
+/**
+ * Convert a tick to a time.
+ *
+ * Converts a tick returned by CBTF_GetTicks() to the time CBTF_GetTime() would
+ * have returned at that tick.
+ *
+ * @param snapshot    Tick calibration from CBTF_GetTickCalibration().
+ * @param ticks       Tick to be converted.
+ * @return            Time at that tick.
+ *
+ * @ingroup RuntimeAPI
+ */
+uint64_t CBTF_TicksToTime(const CBTF_TickCalibration* snapshot, uint64_t ticks)
+{
+    return snapshot->time +
+	(int64_t)((double)(int64_t)(ticks - snapshot->ticks) *
+		  snapshot->ns_per_tick);
+}
+
+
+
+/**
+ * Convert a number of ticks to a duration.
+ *
+ * Converts the difference between two ticks returned by CBTF_GetTicks() to a
+ * number of nanoseconds.
+ *
+ * @param snapshot    Tick calibration from CBTF_GetTickCalibration().
+ * @param ticks       Number of ticks to be converted.
+ * @return            Duration of that many ticks (in nanoseconds).
+ *
+ * @ingroup RuntimeAPI
+ */
+uint64_t CBTF_TicksToDuration(const CBTF_TickCalibration* snapshot,
+			      uint64_t ticks)
+{
+    return (uint64_t)((double)ticks * snapshot->ns_per_tick);
+}
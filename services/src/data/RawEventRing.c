@@ -0,0 +1,457 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the raw event rings and of the raw event encoder thread.
+ *
+ * The tracing collectors normally deduplicate stack traces, fill their XDR
+ * shaped tracing buffers and encode and send those buffers from within the
+ * function wrappers. With raw event rings, a wrapper only unwinds its stack
+ * directly into a fixed size record of its thread's single-producer/single-
+ * consumer ring and publishes it. A single encoder thread per process drains
+ * the rings, hashes each stack trace and hands the record to the encoder
+ * registered by the owning thread, which performs the deduplication, encoding
+ * and sending off the traced thread's critical path.
+ *
+ */
+
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+#include "KrellInstitute/Services/TLS.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <stdbool.h>
+
+/** Number of raw events each ring can hold. Must be a power of two. */
+#define CBTF_RawEventRingSize 128
+
+/** Time slept while waiting for the encoder to catch up (in nanoseconds). */
+#define CBTF_RawEventPollInterval 50000
+
+/** Maximum time a pending raw event waits for the encoder (in nanoseconds). */
+#define CBTF_RawEventEncodeInterval 1000000
+
+/** Type defining the ring of raw events of one thread. */
+typedef struct Ring {
+
+    CBTF_RawEvent events[CBTF_RawEventRingSize];
+
+    /** Next event to be written. Only written by the owning thread. */
+    unsigned head __attribute__((aligned(64)));
+
+    /** Next event to be encoded. Only written by the encoder thread. */
+    unsigned tail __attribute__((aligned(64)));
+
+    /** Encoder of the owning thread and its context. */
+    CBTF_RawEventEncoder encoder;
+    void* context;
+
+    /** Is this ring owned by a thread? */
+    bool owned;
+
+    /** Next ring in the list of all rings. */
+    struct Ring* next;
+
+} Ring;
+
+/** List of all rings. Rings are never freed, only reused. */
+static Ring* rings = NULL;
+
+/** Serializes the modification of the list of rings. */
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Posted when an event is committed to an empty ring or a ring is half full. */
+static sem_t wakeup;
+
+/** Is the encoder thread running? */
+static bool running = false;
+
+/** Type defining the items stored in thread-local storage. */
+typedef struct {
+
+    Ring* ring;  /**< Ring owned by this thread (or NULL). */
+
+} TLS;
+
+#ifdef USE_EXPLICIT_TLS
+
+/**
+ * Thread-local storage key.
+ *
+ * Key used for looking up our thread-local storage. This key <em>must</em>
+ * be globally unique across the entire Open|SpeedShop code base.
+ */
+static const uint32_t TLSKey = 0xFEEDF1A6;
+
+#else
+
+/** Thread-local storage. */
+static __thread TLS the_tls;
+
+#endif
+
+
+
+/** Sleep for one poll interval. */
+static void poll_wait()
+{
+    struct timespec ts = { 0, CBTF_RawEventPollInterval };
+    nanosleep(&ts, NULL);
+}
+
+
+
+/**
+ * Wait for a ring to be empty.
+ *
+ * @param ring    Ring to be drained.
+ */
+static void drain_ring(Ring* ring)
+{
+    if(__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head)
+	sem_post(&wakeup);
+
+    while(__atomic_load_n(&running, __ATOMIC_ACQUIRE) &&
+	  (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head))
+	poll_wait();
+}
+
+
+
+/**
+ * Encoder thread.
+ *
+ * Sleeps until an event is committed to an empty ring. Then waits at most one
+ * encode interval, or until a ring is half full or a thread waits for its ring
+ * to be drained, and passes every raw event pending in any ring to the ring's
+ * encoder. Only sleeps without a timeout once all the rings are empty, so that
+ * an idle process is never woken while events are still encoded in batches.
+ */
+static void* encoder(void* arg)
+{
+    sigset_t signals;
+    struct timespec deadline;
+    bool pending = false;
+    Ring* ring;
+
+    (void)arg;
+
+    /* Never take the sampling signals on this thread */
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    while(true) {
+	if(!pending)
+	    while((sem_wait(&wakeup) == -1) && (errno == EINTR));
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += CBTF_RawEventEncodeInterval;
+	if(deadline.tv_nsec >= 1000000000) {
+	    deadline.tv_sec += 1;
+	    deadline.tv_nsec -= 1000000000;
+	}
+	while((sem_timedwait(&wakeup, &deadline) == -1) && (errno == EINTR));
+
+	pending = false;
+	for(ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+	    ring != NULL;
+	    ring = ring->next) {
+
+	    unsigned head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	    while(ring->tail != head) {
+		CBTF_RawEvent* event =
+		    &ring->events[ring->tail % CBTF_RawEventRingSize];
+
+		event->stacktrace_hash =
+		    CBTF_HashStackTrace(event->stacktrace,
+					event->stacktrace_size);
+		(*ring->encoder)(ring->context, event);
+
+		/* Release the event to the owning thread */
+		__atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_SEQ_CST);
+	    }
+
+	    /*
+	     * Both the head and the tail are sequentially consistent, so that
+	     * either this sees an event committed after the loop above or the
+	     * committing thread sees the ring empty and posts the semaphore.
+	     */
+	    if(__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) != ring->tail)
+		pending = true;
+	}
+    }
+
+    return NULL;
+}
+
+
+
+/** Drain the calling thread's ring before a fork. */
+static void prepare_fork_handler()
+{
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls != NULL) && (tls->ring != NULL))
+	drain_ring(tls->ring);
+}
+
+
+
+/** The encoder thread does not exist in the child of a fork. */
+static void child_fork_handler()
+{
+    running = false;
+}
+
+
+
+/** Drain all rings at process exit. */
+static void exit_handler()
+{
+    Ring* ring;
+
+    for(ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+	ring != NULL;
+	ring = ring->next)
+	drain_ring(ring);
+}
+
+
+
+/**
+ * Start the raw event encoder thread.
+ *
+ * Starts the per-process encoder thread if it isn't already running. Must be
+ * called from outside of a signal handler.
+ *
+ * @return    Boolean "true" if the encoder thread is running.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_StartRawEventEncoder()
+{
+    static bool handlers_registered = false;
+    pthread_t thread;
+
+    if(running)
+	return true;
+
+    if(sem_init(&wakeup, 0, 0) != 0)
+	return false;
+
+    if(pthread_create(&thread, NULL, encoder, NULL) != 0)
+	return false;
+    pthread_detach(thread);
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+
+    if(!handlers_registered) {
+	pthread_atfork(prepare_fork_handler, NULL, child_fork_handler);
+	atexit(exit_handler);
+	handlers_registered = true;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Register the calling thread with the raw event encoder.
+ *
+ * Gives the calling thread a raw event ring. Every raw event committed by the
+ * calling thread is later passed, on the encoder thread and in the order in
+ * which the events were committed, to the given encoder along with the given
+ * context. The calling thread must not access the context until it has been
+ * unregistered. Must be called from outside of a signal handler.
+ *
+ * @param encoder    Encoder of the calling thread's raw events.
+ * @param context    Context passed to the encoder.
+ * @return           Boolean "true" if the calling thread was registered.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_RegisterRawEventThread(CBTF_RawEventEncoder encoder, void* context)
+{
+    Ring* ring;
+
+    /* Create and access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+    if(tls == NULL) {
+	tls = malloc(sizeof(TLS));
+	Assert(tls != NULL);
+	tls->ring = NULL;
+	CBTF_SetTLS(TLSKey, tls);
+    }
+#else
+    TLS* tls = &the_tls;
+#endif
+    Assert(tls != NULL);
+
+    if(!running || (tls->ring != NULL))
+	return false;
+
+    /* Reuse a ring released by an exited thread or map a new one */
+    pthread_mutex_lock(&rings_mutex);
+    for(ring = rings; ring != NULL; ring = ring->next)
+	if(!ring->owned)
+	    break;
+    if(ring == NULL) {
+	ring = mmap(NULL, sizeof(Ring), PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ring == MAP_FAILED) {
+	    pthread_mutex_unlock(&rings_mutex);
+	    return false;
+	}
+	ring->next = rings;
+	__atomic_store_n(&rings, ring, __ATOMIC_RELEASE);
+    }
+    ring->encoder = encoder;
+    ring->context = context;
+    ring->owned = true;
+    pthread_mutex_unlock(&rings_mutex);
+
+    tls->ring = ring;
+    return true;
+}
+
+
+
+/**
+ * Unregister the calling thread from the raw event encoder.
+ *
+ * Waits for all of the calling thread's raw events to be encoded and then
+ * releases its ring for reuse by other threads. Afterwards the calling thread
+ * may again access the context it registered.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_UnregisterRawEventThread()
+{
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls == NULL) || (tls->ring == NULL))
+	return;
+
+    drain_ring(tls->ring);
+
+    pthread_mutex_lock(&rings_mutex);
+    tls->ring->owned = false;
+    pthread_mutex_unlock(&rings_mutex);
+    tls->ring = NULL;
+}
+
+
+
+/**
+ * Begin a raw event.
+ *
+ * Returns the next free record of the calling thread's ring, into which the
+ * caller writes the event before publishing it with CBTF_CommitRawEvent(). If
+ * the ring is full, yields to the encoder thread until it frees a record.
+ *
+ * @note    This function does not allocate memory or take any locks and is
+ *          therefore safe to call from within a function wrapper.
+ *
+ * @return    Record to be filled, or NULL if the calling thread isn't
+ *            registered or the encoder thread isn't running, in which case
+ *            the caller must record the event itself.
+ *
+ * @ingroup RuntimeAPI
+ */
+CBTF_RawEvent* CBTF_BeginRawEvent()
+{
+    Ring* ring;
+
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls == NULL) || (tls->ring == NULL) ||
+       !__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	return NULL;
+    ring = tls->ring;
+
+    /* Wait for a free record */
+    while((ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) ==
+	  CBTF_RawEventRingSize) {
+	if(!__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	    return NULL;
+	sem_post(&wakeup);
+	sched_yield();
+    }
+
+    return &ring->events[ring->head % CBTF_RawEventRingSize];
+}
+
+
+
+/**
+ * Commit a raw event.
+ *
+ * Publishes the record returned by the preceding CBTF_BeginRawEvent() to the
+ * encoder thread, waking it if the calling thread's ring was empty or is now
+ * half full.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_CommitRawEvent()
+{
+    Ring* ring;
+    unsigned head, tail;
+
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+    Assert((tls != NULL) && (tls->ring != NULL));
+    ring = tls->ring;
+
+    head = ring->head + 1;
+    __atomic_store_n(&ring->head, head, __ATOMIC_SEQ_CST);
+
+    /* See encoder() for why no event can be left behind in the ring */
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST);
+    if(((head - tail) == 1) || ((head - tail) == (CBTF_RawEventRingSize / 2)))
+	sem_post(&wakeup);
+}
+
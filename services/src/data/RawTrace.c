@@ -0,0 +1,336 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the raw traces.
+ *
+ * A raw trace is the tracing buffer which the raw event encoder thread fills,
+ * on behalf of one traced thread, from the raw events committed by that thread.
+ * It is shared by the tracing collectors whose trace data blob consists of
+ * stack traces and of events with the layout of CBTF_RawTraceEvent, such as
+ * the io and mpi collectors. The mem collector's events carry the arguments and
+ * results of each call as well, so it still records them itself. Only the stack
+ * deduplication, encoding and sending move to the encoder thread; the stack is
+ * still unwound by the traced thread, the only one on which it exists.
+ *
+ * Each raw trace sends its data blobs through a private "send-to" file handle
+ * which only the encoder thread writes, so that the traced thread's own sends
+ * never need to wait for the encoder.
+ *
+ */
+
+#include "KrellInstitute/Services/Assert.h"
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+#include "KrellInstitute/Services/Fileio.h"
+#include "KrellInstitute/Services/Time.h"
+#include "KrellInstitute/Services/Unwind.h"
+#include "monitor.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/** Number of entries in the stack trace hash table of a raw trace. */
+#define CBTF_RawTraceHashTableSize \
+	CBTF_StackTraceHashTableSize(CBTF_RawTraceStackTraceBufferSize)
+
+/** Type defining the tracing buffer filled for one traced thread. */
+struct CBTF_RawTrace {
+
+    CBTF_DataHeader header;  /**< Header for following data blob. */
+
+    /** Actual data blob, laid out as the collector's trace data blob. */
+    struct {
+	struct {
+	    u_int stacktraces_len;
+	    uint64_t* stacktraces_val;
+	} stacktraces;
+	struct {
+	    u_int events_len;
+	    CBTF_RawTraceEvent* events_val;
+	} events;
+    } data;
+
+    xdrproc_t xdrproc;  /**< XDR procedure of the collector's data blob. */
+    void* handle;       /**< Private handle of the "send-to" file. */
+    bool sent;          /**< Has any data been sent? */
+
+    /** Stack traces. */
+    uint64_t stacktraces[CBTF_RawTraceStackTraceBufferSize];
+    /** Stack trace hash table. */
+    unsigned hash_table[CBTF_RawTraceHashTableSize];
+    /** Traced calls. */
+    CBTF_RawTraceEvent events[CBTF_RawTraceEventBufferSize];
+
+};
+
+
+
+/**
+ * Initialize the data blob and tracing buffer of a raw trace.
+ *
+ * @param trace    Raw trace to be initialized.
+ */
+static void initialize_trace(CBTF_RawTrace* trace)
+{
+    trace->header.time_begin = CBTF_GetTime();
+    trace->header.time_end = 0;
+    trace->header.addr_begin = ~0;
+    trace->header.addr_end = 0;
+
+    trace->data.stacktraces.stacktraces_val = trace->stacktraces;
+    trace->data.stacktraces.stacktraces_len = 0;
+    trace->data.events.events_val = trace->events;
+    trace->data.events.events_len = 0;
+
+    memset(trace->hash_table, 0, sizeof(trace->hash_table));
+}
+
+
+
+/**
+ * Send the data blob of a raw trace and re-initialize its tracing buffer. The
+ * start and stop ticks of every event are converted to times here, against the
+ * same calibration.
+ *
+ * @param trace    Raw trace to be sent.
+ */
+static void send_trace(CBTF_RawTrace* trace)
+{
+    CBTF_TickCalibration calibration;
+    unsigned i;
+
+    CBTF_GetTickCalibration(&calibration);
+    for(i = 0; i < trace->data.events.events_len; ++i) {
+	CBTF_RawTraceEvent* event = &trace->events[i];
+
+	event->start_time = CBTF_TicksToTime(&calibration, event->start_time);
+	event->stop_time = CBTF_TicksToTime(&calibration, event->stop_time);
+
+	/* The event may predate the (re-)initialization of the tracing buffer */
+	if(event->start_time < trace->header.time_begin)
+	    trace->header.time_begin = event->start_time;
+    }
+
+    trace->header.time_end = CBTF_GetTime();
+    trace->header.rank = monitor_mpi_comm_rank();
+
+    CBTF_Data_SendToFileHandle(trace->handle, &trace->header,
+			       trace->xdrproc, &trace->data);
+    trace->sent = true;
+
+    initialize_trace(trace);
+}
+
+
+
+/**
+ * Encode a raw event.
+ *
+ * Called on the raw event encoder thread for each event committed by the
+ * traced thread. Deduplicates the event's stack trace, adds the event to the
+ * tracing buffer and sends the tracing buffer whenever it fills up.
+ *
+ * @param context    Raw trace of the traced thread.
+ * @param event      Raw event to be encoded. The start and stop times of the
+ *                   call, in ticks, are its time and its first argument. They
+ *                   are converted to times when the tracing buffer is sent.
+ */
+static void encode_event(void* context, const CBTF_RawEvent* event)
+{
+    CBTF_RawTrace* trace = context;
+    unsigned entry = 0, i;
+
+    if(!CBTF_FindHashedStackTrace(event->stacktrace_hash,
+				  event->stacktrace, event->stacktrace_size,
+				  trace->stacktraces,
+				  trace->data.stacktraces.stacktraces_len, NULL,
+				  trace->hash_table, CBTF_RawTraceHashTableSize,
+				  &entry)) {
+
+	/* Send events if there is insufficient room for this stack trace */
+	if((trace->data.stacktraces.stacktraces_len +
+	    event->stacktrace_size + 1) >= CBTF_RawTraceStackTraceBufferSize)
+	    send_trace(trace);
+
+	/* Add the stack trace, zero terminated, to the tracing buffer */
+	entry = trace->data.stacktraces.stacktraces_len;
+	for(i = 0; i < event->stacktrace_size; ++i) {
+	    trace->stacktraces[entry + i] = event->stacktrace[i];
+	    if(event->stacktrace[i] < trace->header.addr_begin)
+		trace->header.addr_begin = event->stacktrace[i];
+	    if(event->stacktrace[i] > trace->header.addr_end)
+		trace->header.addr_end = event->stacktrace[i];
+	}
+	trace->stacktraces[entry + event->stacktrace_size] = 0;
+	trace->data.stacktraces.stacktraces_len += (event->stacktrace_size + 1);
+
+	CBTF_AddHashedStackTrace(event->stacktrace_hash,
+				 event->stacktrace_size, entry,
+				 trace->hash_table, CBTF_RawTraceHashTableSize);
+    }
+
+    trace->events[trace->data.events.events_len].start_time = event->time;
+    trace->events[trace->data.events.events_len].stop_time = event->args[0];
+    trace->events[trace->data.events.events_len].stacktrace = entry;
+    trace->data.events.events_len++;
+
+    /* Send events if the tracing buffer is now filled with events */
+    if(trace->data.events.events_len == CBTF_RawTraceEventBufferSize)
+	send_trace(trace);
+}
+
+
+
+/**
+ * Start a raw trace.
+ *
+ * Creates a raw trace for the calling thread and registers the calling thread
+ * with the raw event encoder, which must already be running. The raw trace's
+ * data blobs are sent, with the given header, to the calling thread's current
+ * "send-to" file through a handle private to the encoder thread. Must be called
+ * from outside of a signal handler.
+ *
+ * @param header     Performance data header to apply to the data blobs. Its
+ *                   identifier is copied.
+ * @param xdrproc    XDR procedure of the collector's trace data blob.
+ * @return           Raw trace of the calling thread, or NULL if the calling
+ *                   thread must record its events itself.
+ *
+ * @ingroup RuntimeAPI
+ */
+CBTF_RawTrace* CBTF_StartRawTrace(const CBTF_DataHeader* header,
+				  xdrproc_t xdrproc)
+{
+    CBTF_RawTrace* trace;
+
+    /* Check preconditions */
+    Assert(header != NULL);
+    Assert(xdrproc != NULL);
+
+    trace = mmap(NULL, sizeof(CBTF_RawTrace), PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(trace == MAP_FAILED)
+	return NULL;
+
+    memcpy(&trace->header, header, sizeof(CBTF_DataHeader));
+    trace->header.id = strdup(header->id);
+    trace->xdrproc = xdrproc;
+    trace->handle = CBTF_OpenSendToFileHandle();
+    trace->sent = false;
+    initialize_trace(trace);
+
+    if((trace->header.id == NULL) || (trace->handle == NULL) ||
+       !CBTF_RegisterRawEventThread(encode_event, trace)) {
+	CBTF_CloseSendToFileHandle(trace->handle);
+	free(trace->header.id);
+	munmap(trace, sizeof(CBTF_RawTrace));
+	return NULL;
+    }
+
+    return trace;
+}
+
+
+
+/**
+ * Record a traced call through the raw trace of the calling thread.
+ *
+ * Unwinds the stack directly into a raw event and commits it, leaving the
+ * deduplication, encoding and sending to the raw event encoder thread.
+ *
+ * @note    This function does not allocate memory or take any locks and is
+ *          therefore safe to call from within a function wrapper.
+ *
+ * @param function       Address of the traced function.
+ * @param start_time     Start time of the call (in ticks).
+ * @param stop_time      End time of the call (in ticks).
+ * @param skip_frames    Number of frames of the caller to be skipped, as for
+ *                       CBTF_GetStackTraceFromContext() when called directly
+ *                       by the caller.
+ * @param max_frames     Maximum number of frames in the stack trace.
+ * @return               Boolean "true" if the call was recorded, or "false" if
+ *                       the calling thread must record it itself.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_RecordRawTraceEvent(uint64_t function,
+			      uint64_t start_time, uint64_t stop_time,
+			      unsigned skip_frames, unsigned max_frames)
+{
+    CBTF_RawEvent* event = CBTF_BeginRawEvent();
+    unsigned stacktrace_size = 0;
+
+    if(event == NULL)
+	return false;
+
+    /* Skip this function's own frame as well */
+    if(max_frames > CBTF_RawEventMaxFrames)
+	max_frames = CBTF_RawEventMaxFrames;
+    CBTF_GetStackTraceFromContext(NULL, FALSE, skip_frames + 1, max_frames,
+				  &stacktrace_size, event->stacktrace);
+
+    /* A stack that could not be unwound is recorded as the function alone */
+    if(stacktrace_size == 0)
+	stacktrace_size = 1;
+    event->stacktrace[0] = function;
+    event->stacktrace_size = stacktrace_size;
+    event->function = function;
+    event->time = start_time;
+    event->args[0] = stop_time;
+
+    CBTF_CommitRawEvent();
+    return true;
+}
+
+
+
+/**
+ * Stop a raw trace.
+ *
+ * Unregisters the calling thread from the raw event encoder, sends whatever
+ * the encoder has not yet sent, and destroys the raw trace. Must be called by
+ * the thread which started the raw trace.
+ *
+ * @param trace    Raw trace of the calling thread.
+ * @return         Boolean "true" if the raw trace sent any data.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_StopRawTrace(CBTF_RawTrace* trace)
+{
+    bool sent;
+
+    /* Check preconditions */
+    Assert(trace != NULL);
+
+    /* The encoder no longer touches the raw trace once this returns */
+    CBTF_UnregisterRawEventThread();
+
+    if(trace->data.events.events_len > 0)
+	send_trace(trace);
+    sent = trace->sent;
+
+    CBTF_CloseSendToFileHandle(trace->handle);
+    free(trace->header.id);
+    munmap(trace, sizeof(CBTF_RawTrace));
+
+    return sent;
+}
@@ -0,0 +1,263 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the CBTF_HashStackTrace(), CBTF_FindStackTrace() and
+ * CBTF_AddStackTrace() functions.
+ *
+ */
+
+#include <stdint.h>
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+
+
+
+/**
+ * Hash a stack trace.
+ *
+ * Computes a 64-bit FNV-1a style hash over the frames of a stack trace. The
+ * number of frames is folded into the initial value so that a stack trace and
+ * its prefixes hash differently. The hash can be computed once and passed to
+ * CBTF_FindHashedStackTrace() and CBTF_AddHashedStackTrace().
+ *
+ * @param stacktrace         Frames of the stack trace.
+ * @param stacktrace_size    Number of frames in the stack trace.
+ * @return                   Hash of the stack trace.
+ *
+ * @ingroup RuntimeAPI
+ */
+uint64_t CBTF_HashStackTrace(const uint64_t* stacktrace,
+			     unsigned stacktrace_size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL ^ stacktrace_size;
+    unsigned i;
+
+    for(i = 0; i < stacktrace_size; ++i) {
+	hash ^= stacktrace[i];
+	hash *= 0x100000001b3ULL;
+    }
+
+    return hash ^ (hash >> 32);
+}
+
+
+
+/**
+ * Test for a stack trace match.
+ *
+ * Compares the stack trace against the one stored at the given entry of the
+ * tracing buffer. When a count array is passed the buffer uses the sampling
+ * layout, in which the top of each stack has a non-zero count and a count of
+ * 255 marks a stack at the count limit. Otherwise each stack in the buffer is
+ * terminated by a zero frame.
+ */
+static inline bool match_stacktrace(const uint64_t* stacktrace,
+				    unsigned stacktrace_size,
+				    const uint64_t* buffer,
+				    unsigned buffer_len,
+				    const uint8_t* count,
+				    unsigned entry)
+{
+    unsigned i;
+
+    if((entry + stacktrace_size) > buffer_len)
+	return false;
+
+    if(count != NULL) {
+	if(count[entry] == 255)
+	    return false;
+	if(((entry + stacktrace_size) < buffer_len) &&
+	   (count[entry + stacktrace_size] == 0))
+	    return false;
+    } else {
+	if(((entry + stacktrace_size) >= buffer_len) ||
+	   (buffer[entry + stacktrace_size] != 0))
+	    return false;
+    }
+
+    for(i = 0; i < stacktrace_size; ++i)
+	if(buffer[entry + i] != stacktrace[i])
+	    return false;
+
+    return true;
+}
+
+
+
+/**
+ * Find stack trace.
+ *
+ * Searches the tracing buffer for an existing stack trace matching the passed
+ * stack trace. Rather than scanning the whole buffer, the hash table built up
+ * by CBTF_AddStackTrace() is probed with a simple linear probe, making the
+ * cost of the search proportional to the number of frames rather than to the
+ * fill level of the buffer.
+ *
+ * @note    This function does not allocate memory or take any locks and is
+ *          therefore safe to call from within a signal handler or from a
+ *          function wrapper.
+ *
+ * @param stacktrace         Stack trace to be found.
+ * @param stacktrace_size    Number of frames in the stack trace.
+ * @param buffer             Tracing buffer to be searched.
+ * @param buffer_len         Actual used length of the tracing buffer.
+ * @param count              Count array for the sampling layout, or NULL when
+ *                           stacks in the buffer are zero terminated.
+ * @param hash_table         Hash table mapping stack traces to buffer index.
+ * @param hash_table_size    Number of entries in the hash table.
+ * @retval entry             Index of the first frame of the matching stack.
+ * @return                   Boolean "true" if a match was found, "false"
+ *                           otherwise.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_FindStackTrace(const uint64_t* stacktrace,
+			 unsigned stacktrace_size,
+			 const uint64_t* buffer,
+			 unsigned buffer_len,
+			 const uint8_t* count,
+			 const unsigned* hash_table,
+			 unsigned hash_table_size,
+			 unsigned* entry)
+{
+    return CBTF_FindHashedStackTrace(
+	CBTF_HashStackTrace(stacktrace, stacktrace_size),
+	stacktrace, stacktrace_size, buffer, buffer_len, count,
+	hash_table, hash_table_size, entry
+	);
+}
+
+
+
+/**
+ * Find stack trace with a known hash.
+ *
+ * Identical to CBTF_FindStackTrace() except that the hash of the stack trace,
+ * as computed by CBTF_HashStackTrace(), is passed in rather than recomputed.
+ *
+ * @param hash               Hash of the stack trace.
+ * @param stacktrace         Stack trace to be found.
+ * @param stacktrace_size    Number of frames in the stack trace.
+ * @param buffer             Tracing buffer to be searched.
+ * @param buffer_len         Actual used length of the tracing buffer.
+ * @param count              Count array for the sampling layout, or NULL when
+ *                           stacks in the buffer are zero terminated.
+ * @param hash_table         Hash table mapping stack traces to buffer index.
+ * @param hash_table_size    Number of entries in the hash table.
+ * @retval entry             Index of the first frame of the matching stack.
+ * @return                   Boolean "true" if a match was found, "false"
+ *                           otherwise.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_FindHashedStackTrace(uint64_t hash,
+			       const uint64_t* stacktrace,
+			       unsigned stacktrace_size,
+			       const uint64_t* buffer,
+			       unsigned buffer_len,
+			       const uint8_t* count,
+			       const unsigned* hash_table,
+			       unsigned hash_table_size,
+			       unsigned* entry)
+{
+    unsigned bucket;
+
+    /* Empty stack traces are never indexed */
+    if(stacktrace_size == 0)
+	return false;
+
+    bucket = hash % hash_table_size;
+    while(hash_table[bucket] > 0) {
+	if(match_stacktrace(stacktrace, stacktrace_size, buffer, buffer_len,
+			    count, hash_table[bucket] - 1)) {
+	    *entry = hash_table[bucket] - 1;
+	    return true;
+	}
+	bucket = (bucket + 1) % hash_table_size;
+    }
+
+    return false;
+}
+
+
+
+/**
+ * Add stack trace.
+ *
+ * Records in the hash table that the passed stack trace has been added to the
+ * tracing buffer at the given entry. The hash table must be cleared whenever
+ * the tracing buffer is emptied and must have at least one more entry than the
+ * maximum number of stack traces that can be stored in the tracing buffer.
+ * Use CBTF_StackTraceHashTableSize() to size it.
+ *
+ * @param stacktrace         Stack trace that was added.
+ * @param stacktrace_size    Number of frames in the stack trace.
+ * @param entry              Index of the first frame of the stack trace in the
+ *                           tracing buffer.
+ * @param hash_table         Hash table to be updated.
+ * @param hash_table_size    Number of entries in the hash table.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_AddStackTrace(const uint64_t* stacktrace,
+			unsigned stacktrace_size,
+			unsigned entry,
+			unsigned* hash_table,
+			unsigned hash_table_size)
+{
+    CBTF_AddHashedStackTrace(CBTF_HashStackTrace(stacktrace, stacktrace_size),
+			     stacktrace_size, entry,
+			     hash_table, hash_table_size);
+}
+
+
+
+/**
+ * Add stack trace with a known hash.
+ *
+ * Identical to CBTF_AddStackTrace() except that the hash of the stack trace,
+ * as computed by CBTF_HashStackTrace(), is passed in rather than recomputed.
+ *
+ * @param hash               Hash of the stack trace that was added.
+ * @param stacktrace_size    Number of frames in the stack trace.
+ * @param entry              Index of the first frame of the stack trace in the
+ *                           tracing buffer.
+ * @param hash_table         Hash table to be updated.
+ * @param hash_table_size    Number of entries in the hash table.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_AddHashedStackTrace(uint64_t hash,
+			      unsigned stacktrace_size,
+			      unsigned entry,
+			      unsigned* hash_table,
+			      unsigned hash_table_size)
+{
+    unsigned bucket;
+
+    if(stacktrace_size == 0)
+	return;
+
+    bucket = hash % hash_table_size;
+    while(hash_table[bucket] > 0)
+	bucket = (bucket + 1) % hash_table_size;
+
+    hash_table[bucket] = entry + 1;
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the CBTF_SetTracedFunctions() function.
+ *
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+
+
+
+/**
+ * Parse a list of traced functions.
+ *
+ * Parses a list of traced functions, separated by colons or commas, into a
+ * bitmask indexed the same as the given table of traceable function names.
+ * Called once when collection starts so that testing whether a function is
+ * traced is a single bit test. Names that are not in the table are silently
+ * ignored.
+ *
+ * @param traced    List of traced functions.
+ * @param names     Names of the traceable functions.
+ * @param count     Number of traceable functions.
+ * @retval mask     Bitmask of traced functions, holding at least
+ *                  (count + 63) / 64 words.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_SetTracedFunctions(const char* traced, const char* const* names,
+			     unsigned count, uint64_t* mask)
+{
+    char list[PATH_MAX];
+    char *saveptr, *token;
+    unsigned i;
+
+    memset(mask, 0, ((count + 63) / 64) * sizeof(uint64_t));
+
+    strncpy(list, traced, sizeof(list) - 1);
+    list[sizeof(list) - 1] = '\0';
+
+    for(token = strtok_r(list, ":,", &saveptr);
+	token != NULL;
+	token = strtok_r(NULL, ":,", &saveptr)) {
+	for(i = 0; i < count; ++i) {
+	    if(strcmp(token, names[i]) == 0) {
+		mask[i / 64] |= (uint64_t)1 << (i % 64);
+		break;
+	    }
+	}
+    }
+}
@@ -19,141 +19,83 @@
 
 /** @file
  *
- * Stack trace function (uses libunwind).
+ * Definition of the CBTF_UpdateStackTraceBuffer() function.
  *
  */
 
-//#include "libunwind.h"
+#include <stdint.h>
 #include "KrellInstitute/Services/Common.h"
-#include <stdbool.h>
+#include "KrellInstitute/Services/Data.h"
 
-bool cmp_samplebuffer(int framecount,
-		      int *stackindex,
-		      int countbuflen,
-		      uint64_t *databuf,
-		      uint64_t *countbuf,
-		      uint64_t *framebuf)
-{
-    int i,j;
-    bool found = false;
-    /* search individual stacks via count/indexing array */
-    for (i = 0; i < countbuflen ; i++ )
-    {
-        /* a count > 0 indexes the top of stack in the data buffer. */
-        /* a count == 255 indicates this stack is at the count limit. */
-        if (countbuf[i] == 0) {
-            continue;
-        }
-        if (countbuf[i] == 255) {
-            found = false;
-            continue;
-        }
-
-        /* see if the stack addresses match */
-        for (j = 0; j < framecount ; j++ )
-        {
-            if ( databuf[i+j] != framebuf[j] ) {
-                   found = false;
-                   break;
-            }
-        }
 
-        if ( j == framecount) {
-            found = true;
-            *stackindex = i;
-            return found;
-        }
-    }
-    return found;
-}
 
-static void update_samplebuffer(int framecount,
-				int *databuflen,
-				int *countbuflen,
-				uint64_t *hdr_addr_begin,
-				uint64_t *hdr_addr_end,
-				uint64_t *framebuf,
-				uint64_t *countbuf,
-				uint64_t *databuf)
+/**
+ * Update stack trace buffer.
+ *
+ * Updates the specified stack trace sampling data buffer with the passed stack
+ * trace. The frames of each unique stack trace are stored once, with the count
+ * of its samples kept at the top of the stack. All other entries of a stack
+ * have a count of zero. A stack whose count reaches 255 is never matched again
+ * and a new instance of the stack is started instead.
+ *
+ * @note    Existing stack traces are located through the hash table maintained
+ *          by CBTF_FindStackTrace() and CBTF_AddStackTrace() rather than by
+ *          scanning the buffer. This function does not allocate memory or take
+ *          any locks and is therefore safe to call from within a signal handler.
+ *
+ * @note    Unlike CBTF_UpdatePCData(), a "true" return means the stack trace
+ *          was NOT added. The caller is expected to send and re-initialize the
+ *          buffer (clearing its length, address range and hash table) and then
+ *          call this function again with the same stack trace.
+ *
+ * @param stacktrace         Stack trace to be added.
+ * @param stacktrace_size    Number of frames in the stack trace.
+ * @param buffer             Stack trace sampling data buffer to be updated.
+ * @return                   Boolean "true" if the buffer has no room for the
+ *                           stack trace, "false" otherwise.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_UpdateStackTraceBuffer(const uint64_t* stacktrace,
+				 unsigned stacktrace_size,
+				 CBTF_StackTraceData* buffer)
 {
-        /* add frames to sample buffer, compute addresss range */
-        int i;
-        for (i = 0; i < framecount ; i++)
-        {
-            /* always add address to buffer bt */
-            databuf[*databuflen] = framebuf[i];
-
-            /* top of stack indicated by a positive count. */
-            /* all other elements are 0 */
-            if (i > 0 ) {
-                countbuf[*countbuflen] = 0;
-            } else {
-                countbuf[*countbuflen] = 1;
-            }
-
-            if (framebuf[i] < *hdr_addr_begin ) {
-                *hdr_addr_begin = framebuf[i];
-            }
-            if (framebuf[i] > *hdr_addr_end ) {
-                *hdr_addr_end = framebuf[i];
-            }
-            *databuflen++;
-            *countbuflen++;
-        }
-}
+    unsigned entry, i;
 
-void CBTF_UpdateStackTraceBuffer(int framecount,
-				   int bufsize,
-				   int *stackindex,
-				   int *databuflen,
-				   int *countbuflen,
-				   uint64_t *hdr_addr_begin,
-				   uint64_t *hdr_addr_end,
-				   uint64_t *framebuf,
-				   uint64_t *countbuf,
-				   uint64_t *databuf)
-{
-    bool stack_already_exists =
-		cmp_samplebuffer(framecount,stackindex,*countbuflen,databuf,countbuf,framebuf);
+    if(stacktrace_size == 0)
+	return false;
+    if(stacktrace_size > CBTF_ST_BufferSize)
+	stacktrace_size = CBTF_ST_BufferSize;
 
-    /* if the stack already exisits in the buffer, update its count
-     * and return. If the stack is already at the count limit, cmp_samplebuffer
-     * will return false so a new stack entry will be created even though
-     * the stack may already exist in the buffer.
-     * Otherwise, add the new stack to the buffer
-    */
-    if (stack_already_exists && countbuf[*stackindex] < 255 ) {
-        /* update count for this stack */
-        countbuf[*stackindex] = countbuf[*stackindex] + 1;
-        return;
+    /* Increment count for an existing instance of this stack if found */
+    if(CBTF_FindStackTrace(stacktrace, stacktrace_size,
+			   buffer->stacktraces, buffer->length, buffer->count,
+			   buffer->hash_table, CBTF_ST_HashTableSize, &entry)) {
+	buffer->count[entry]++;
+	return false;
     }
 
-    /* Will this stack trace fit into the sample buffer? */
-    /* update_samplebuffer adds the 0 stack termination marker and */
-    /* updates tls.data.bt.bt_len. */
+    /* Indicate to the caller if the sample buffer has no room for the stack */
+    if((buffer->length + stacktrace_size) > CBTF_ST_BufferSize)
+	return true;
 
-    int buflen = *databuflen + framecount;
-    if ( buflen <= bufsize) {
-        update_samplebuffer(framecount,
-			    databuflen,
-                            countbuflen,
-                            hdr_addr_begin,
-                            hdr_addr_end,
-                            framebuf,
-                            countbuf,
-                            databuf);
-    } else {
-        /* sample buffer has no room for these stack frames.*/
-        /* send the current sample buffer. (will init a new buffer) */
-        //send_samples();
+    /* Otherwise add a new instance of this stack to the sample buffer */
+    entry = buffer->length;
+    for(i = 0; i < stacktrace_size; ++i) {
+	buffer->stacktraces[entry + i] = stacktrace[i];
+	buffer->count[entry + i] = (i == 0) ? 1 : 0;
 
-        update_samplebuffer(framecount,
-			    databuflen,
-                            countbuflen,
-                            hdr_addr_begin,
-                            hdr_addr_end,
-                            framebuf,
-                            countbuf,
-                            databuf);
+	/* Update the address interval in the sample buffer */
+	if(stacktrace[i] < buffer->addr_begin)
+	    buffer->addr_begin = stacktrace[i];
+	if(stacktrace[i] > buffer->addr_end)
+	    buffer->addr_end = stacktrace[i];
     }
+    buffer->length += stacktrace_size;
+
+    /* Update the hash table with this new stack */
+    CBTF_AddStackTrace(stacktrace, stacktrace_size, entry,
+		       buffer->hash_table, CBTF_ST_HashTableSize);
+
+    return false;
 }
@@ -0,0 +1,535 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the background flusher used for asynchronous sending of
+ * performance data to the "send-to" file.
+ *
+ * Each thread that sends asynchronously owns a single-producer/single-consumer
+ * ring of pending sends. Handing off a buffer only copies its header into the
+ * ring and posts a semaphore, both of which are async-signal-safe, so that the
+ * sampling signal handlers never perform the XDR encoding or file I/O. A single
+ * flusher thread per process drains the rings, encodes each buffer and writes
+ * it to the owning thread's "send-to" file through a private handle with its
+ * own file descriptor, so that the owning thread's buffered handle is never
+ * touched by the flusher.
+ *
+ * Blobs sent directly by the owning thread may be buffered, and so may reach
+ * the file after blobs it later hands off. Each blob carries its own header,
+ * so readers do not depend on their order.
+ *
+ */
+
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Messages/DataHeader.h"
+#include "KrellInstitute/Services/Fileio.h"
+#include "KrellInstitute/Services/TLS.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <stdbool.h>
+
+/** Number of pending sends each ring can hold. Must be a power of two. */
+#define CBTF_FlusherRingSize 4
+
+/** Size of the flusher's encoding buffer. Matches CBTF_Data_Send(). */
+#define CBTF_FlusherEncodingBufferSize (CBTF_BlobSizeFactor * 15 * 1024)
+
+/** Time slept while waiting for the flusher to catch up (in nanoseconds). */
+#define CBTF_FlusherPollInterval 50000
+
+/** Type defining a pending send. */
+typedef struct {
+
+    CBTF_DataHeader header;   /**< Copy of the data blob's header. */
+    xdrproc_t xdrproc;        /**< XDR procedure for the data. */
+    const void* data;         /**< Data structure to be sent. */
+    volatile bool* in_flight; /**< Cleared once the data has been sent. */
+
+} Slot;
+
+/** Type defining the ring of pending sends of one thread. */
+typedef struct Ring {
+
+    Slot slots[CBTF_FlusherRingSize];
+
+    /** Next slot to be filled. Only written by the owning thread. */
+    unsigned head;
+
+    /** Next slot to be sent. Only written by the flusher thread. */
+    unsigned tail;
+
+    /** Private handle on the "send-to" file of the owning thread. */
+    void* handle;
+
+    /** Is this ring owned by a thread? */
+    bool owned;
+
+    /** Next ring in the list of all rings. */
+    struct Ring* next;
+
+} Ring;
+
+/** List of all rings. Rings are never freed, only reused. */
+static Ring* rings = NULL;
+
+/** Serializes the modification of the list of rings. */
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Posted whenever a send is added to any ring. */
+static sem_t wakeup;
+
+/** Is the flusher thread running? */
+static bool running = false;
+
+/** Buffer into which the flusher thread encodes data. */
+static char* encoding_buffer = NULL;
+
+/** Type defining the items stored in thread-local storage. */
+typedef struct {
+
+    Ring* ring;  /**< Ring owned by this thread (or NULL). */
+
+} TLS;
+
+#ifdef USE_EXPLICIT_TLS
+
+/**
+ * Thread-local storage key.
+ *
+ * Key used for looking up our thread-local storage. This key <em>must</em>
+ * be globally unique across the entire Open|SpeedShop code base.
+ */
+static const uint32_t TLSKey = 0xFEEDF1A5;
+
+#else
+
+/** Thread-local storage. */
+static __thread TLS the_tls;
+
+#endif
+
+
+
+/** Sleep for one poll interval. Async-signal-safe. */
+static void poll_wait()
+{
+    struct timespec ts = { 0, CBTF_FlusherPollInterval };
+    nanosleep(&ts, NULL);
+}
+
+
+
+/**
+ * Encode and send one pending send.
+ *
+ * @param slot    Pending send.
+ * @param handle  "Send-to" file to which the data is written.
+ */
+static void send_slot(Slot* slot, void* handle)
+{
+    unsigned size;
+    XDR xdrs;
+
+    /* Create an XDR stream using the encoding buffer */
+    xdrmem_create(&xdrs, encoding_buffer, CBTF_FlusherEncodingBufferSize,
+		  XDR_ENCODE);
+
+    /* Encode the performance data header and data to this stream */
+    Assert(xdr_CBTF_DataHeader(&xdrs, (void*)&slot->header) == TRUE);
+    Assert((*slot->xdrproc)(&xdrs, (void*)slot->data) == TRUE);
+
+    /* Get the encoded size */
+    size = xdr_getpos(&xdrs);
+
+    /* Close the XDR stream */
+    xdr_destroy(&xdrs);
+
+    /* Send the data */
+    Assert(CBTF_SendToFileHandle(handle, size, encoding_buffer) == 1);
+}
+
+
+
+/**
+ * Send the oldest pending send of a ring and release it to the owning thread.
+ *
+ * @param ring    Ring whose oldest pending send is to be sent.
+ */
+static void send_next(Ring* ring)
+{
+    Slot* slot = &ring->slots[ring->tail % CBTF_FlusherRingSize];
+
+    send_slot(slot, ring->handle);
+
+    /* Release the buffer and then the slot to the owning thread */
+    __atomic_store_n(slot->in_flight, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+
+
+/**
+ * Wait for a ring to be empty. When the flusher thread isn't running, nothing
+ * else will send what is pending, so it is sent by the calling thread instead.
+ *
+ * @param ring    Ring to be drained.
+ */
+static void drain_ring(Ring* ring)
+{
+    while(__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != ring->head) {
+	if(__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	    poll_wait();
+	else
+	    send_next(ring);
+    }
+}
+
+
+
+/**
+ * Flusher thread.
+ *
+ * Waits for sends to be posted and then sends everything pending in all rings.
+ */
+static void* flusher(void* arg)
+{
+    sigset_t signals;
+    Ring* ring;
+
+    (void)arg;
+
+    /* Never take the sampling signals on this thread */
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    while(true) {
+	while((sem_wait(&wakeup) == -1) && (errno == EINTR));
+
+	for(ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+	    ring != NULL;
+	    ring = ring->next) {
+
+	    unsigned head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	    while(ring->tail != head)
+		send_next(ring);
+	}
+    }
+
+    return NULL;
+}
+
+
+
+/** Drain the calling thread's ring before a fork. */
+static void prepare_fork_handler()
+{
+    CBTF_DrainFlusher();
+}
+
+
+
+/**
+ * Neither the flusher thread nor the threads owning the rings, except for the
+ * forking thread, exist in the child of a fork. The rings of the other threads
+ * are released and their pending sends dropped. The forking thread's ring,
+ * drained before the fork, gets a handle on the forking thread's "send-to" file
+ * in the child, since the "send-to" file handlers, which run first, released
+ * the parent's. The flusher thread is re-created by CBTF_StartFlusher().
+ */
+static void child_fork_handler()
+{
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+    Ring* self = (tls != NULL) ? tls->ring : NULL;
+    Ring* ring;
+
+    running = false;
+    pthread_mutex_init(&rings_mutex, NULL);
+
+    for(ring = rings; ring != NULL; ring = ring->next) {
+	ring->head = ring->tail = 0;
+	if(ring == self) {
+	    ring->handle = CBTF_OpenSendToFileHandle();
+	    ring->owned = (ring->handle != NULL);
+	    if(!ring->owned)
+		tls->ring = NULL;
+	} else {
+	    ring->handle = NULL;
+	    ring->owned = false;
+	}
+    }
+}
+
+
+
+/**
+ * Drain all rings at process exit.
+ *
+ * Registered after the "send-to" file handlers so that it runs before them.
+ */
+static void exit_handler()
+{
+    Ring* ring;
+
+    for(ring = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+	ring != NULL;
+	ring = ring->next)
+	drain_ring(ring);
+}
+
+
+
+/**
+ * Start the flusher thread.
+ *
+ * Starts the per-process flusher thread if it isn't already running, such as in
+ * the child of a fork. Must be called from outside of a signal handler, and
+ * after the calling thread has set its "send-to" file.
+ *
+ * @return    Boolean "true" if the flusher thread is running.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_StartFlusher()
+{
+    static bool handlers_registered = false;
+    pthread_t thread;
+
+    if(running)
+	return true;
+
+    if(encoding_buffer == NULL) {
+	void* buffer = mmap(NULL, CBTF_FlusherEncodingBufferSize,
+			    PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(buffer == MAP_FAILED)
+	    return false;
+	encoding_buffer = buffer;
+    }
+
+    if(sem_init(&wakeup, 0, 0) != 0)
+	return false;
+
+    if(pthread_create(&thread, NULL, flusher, NULL) != 0)
+	return false;
+    pthread_detach(thread);
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+
+    if(!handlers_registered) {
+	pthread_atfork(prepare_fork_handler, NULL, child_fork_handler);
+	atexit(exit_handler);
+	handlers_registered = true;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Register the calling thread with the flusher.
+ *
+ * Gives the calling thread a ring through which it can hand off sends to the
+ * flusher thread using CBTF_SendToFlusher(). Must be called from outside of a
+ * signal handler and after the calling thread has set its "send-to" file, and
+ * the calling thread must be unregistered before changing its "send-to" file.
+ *
+ * @return    Boolean "true" if the calling thread was registered.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_RegisterFlusherThread()
+{
+    Ring* ring;
+
+    /* Create and access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+    if(tls == NULL) {
+	tls = malloc(sizeof(TLS));
+	Assert(tls != NULL);
+	tls->ring = NULL;
+	CBTF_SetTLS(TLSKey, tls);
+    }
+#else
+    TLS* tls = &the_tls;
+#endif
+    Assert(tls != NULL);
+
+    if(!running)
+	return false;
+
+    if(tls->ring != NULL)
+	return true;
+
+    /* Reuse a ring released by an exited thread or map a new one */
+    pthread_mutex_lock(&rings_mutex);
+    for(ring = rings; ring != NULL; ring = ring->next)
+	if(!ring->owned)
+	    break;
+    if(ring == NULL) {
+	ring = mmap(NULL, sizeof(Ring), PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ring == MAP_FAILED) {
+	    pthread_mutex_unlock(&rings_mutex);
+	    return false;
+	}
+	ring->next = rings;
+	__atomic_store_n(&rings, ring, __ATOMIC_RELEASE);
+    }
+    ring->handle = CBTF_OpenSendToFileHandle();
+    ring->owned = (ring->handle != NULL);
+    pthread_mutex_unlock(&rings_mutex);
+
+    if(ring->handle == NULL)
+	return false;
+
+    tls->ring = ring;
+    return true;
+}
+
+
+
+/**
+ * Unregister the calling thread from the flusher.
+ *
+ * Waits for all of the calling thread's pending sends to complete and then
+ * closes the flusher's handle and releases the ring for reuse by other threads.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_UnregisterFlusherThread()
+{
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls == NULL) || (tls->ring == NULL))
+	return;
+
+    drain_ring(tls->ring);
+    CBTF_CloseSendToFileHandle(tls->ring->handle);
+
+    pthread_mutex_lock(&rings_mutex);
+    tls->ring->handle = NULL;
+    tls->ring->owned = false;
+    pthread_mutex_unlock(&rings_mutex);
+    tls->ring = NULL;
+}
+
+
+
+/**
+ * Send performance data through the flusher.
+ *
+ * Hands off performance data to the flusher thread, which encodes it and sends
+ * it to the calling thread's "send-to" file. The header is copied, but the data
+ * structure (and anything it points to) must not be modified until the flusher
+ * has cleared the in-flight flag. Never waits: if the flusher isn't running or
+ * the calling thread's ring is full, the caller must send the data itself.
+ *
+ * @note    This function does not allocate memory, take any locks or wait and
+ *          is therefore safe to call from within a signal handler.
+ *
+ * @param header       Performance data header to apply to this data.
+ * @param xdrproc      XDR procedure for the passed data structure.
+ * @param data         Pointer to the data structure to be sent.
+ * @param in_flight    Flag set here and cleared once the data has been sent.
+ * @return             Boolean "true" if the data was handed off, or "false"
+ *                     if the calling thread must send the data itself.
+ *
+ * @ingroup RuntimeAPI
+ */
+bool CBTF_SendToFlusher(const CBTF_DataHeader* header, const xdrproc_t xdrproc,
+			const void* data, volatile bool* in_flight)
+{
+    Ring* ring;
+    Slot* slot;
+
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls == NULL) || (tls->ring == NULL) ||
+       !__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+	return false;
+    ring = tls->ring;
+
+    /* Don't wait for a free slot */
+    if((ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) ==
+       CBTF_FlusherRingSize)
+	return false;
+
+    slot = &ring->slots[ring->head % CBTF_FlusherRingSize];
+    memcpy(&slot->header, header, sizeof(CBTF_DataHeader));
+    slot->xdrproc = xdrproc;
+    slot->data = data;
+    slot->in_flight = in_flight;
+    *in_flight = true;
+
+    /* Publish the slot and wake the flusher */
+    __atomic_store_n(&ring->head, ring->head + 1, __ATOMIC_RELEASE);
+    sem_post(&wakeup);
+
+    return true;
+}
+
+
+
+/**
+ * Wait for the calling thread's pending sends.
+ *
+ * Returns once everything handed off by the calling thread was sent, after
+ * which the data handed off may again be modified. Sends whatever the flusher
+ * thread, if it isn't running, left pending. Returns immediately if the calling
+ * thread isn't registered with the flusher. Waits, so must only be called when
+ * collection stops or at exit, and never from within a signal handler.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_DrainFlusher()
+{
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls != NULL) && (tls->ring != NULL))
+	drain_ring(tls->ring);
+}
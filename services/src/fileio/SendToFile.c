@@ -19,25 +19,34 @@
 
 /** @file
  *
- * Definition of the CBTF_SetSendToFile() and CBTF_SendToFile() functions.
+ * Definition of the CBTF_SetSendToFile(), CBTF_SendToFile(),
+ * CBTF_OpenSendToFileHandle(), CBTF_CloseSendToFileHandle(),
+ * CBTF_SendToFileHandle(), CBTF_Data_SendToFileHandle(), CBTF_FlushSendToFile()
+ * and CBTF_CloseSendToFile() functions.
  *
  */
 
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Messages/DataHeader.h"
 #include "KrellInstitute/Messages/EventHeader.h"
+#include "KrellInstitute/Services/Fileio.h"
 #include "KrellInstitute/Services/Path.h"
 #include "KrellInstitute/Services/TLS.h"
 
+#include <alloca.h>
 #include <errno.h>
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <string.h>
 #include <libgen.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <stdbool.h>
 
@@ -45,14 +54,69 @@
 // record the executable path once here.
 static char* executable_path = NULL;
 
-/** Type defining the items stored in thread-local storage. */
-typedef struct {
+/**
+ * Size of the per-thread write-behind buffer. Sized to hold several of the
+ * largest blobs CBTF_Data_Send() can encode so that blobs are coalesced into
+ * few large writes.
+ */
+#define CBTF_SendToFileBufferSize (CBTF_BlobSizeFactor * 64 * 1024)
+
+/**
+ * Type defining a "send-to" file handle.
+ *
+ * Each thread has its own handle, and other threads (such as the background
+ * flusher) may open private handles on the same file. Every handle is kept in
+ * a process-wide list so that all of them can be flushed at process exit. The
+ * buffer and descriptor of a handle are only used while holding its lock, with
+ * all signals blocked, so that neither a sampling signal arriving during an
+ * append nor the exit handler running on another thread can interleave with a
+ * send.
+ */
+typedef struct Handle {
 
     /** Path of the file to which data should be written. **/
     char path[PATH_MAX];
 
+    /** Host, thread and suffix from which path is derived (with the pid). */
+    char host[HOST_NAME_MAX];
+    uint64_t posix_tid;
+    char suffix[NAME_MAX];
+
+    /** Persistent file descriptor for path (valid if is_open is true). */
+    int fd;
+    bool is_open;
+
+    /** Write-behind buffer of encoded blobs not yet written to path. */
+    char* buffer;
+    unsigned buffer_len;
+
+    /** Held while the descriptor or buffer are in use. */
+    bool lock;
+
+    /** Is this handle in use? Released handles are reused. */
+    bool in_use;
+
+    /** Next handle in the list of all handles. */
+    struct Handle* next;
+
+} Handle;
+
+/** List of all handles. Handles are never freed, only reused. */
+static Handle* handles = NULL;
+
+/** Serializes the modification of the list of handles. */
+static pthread_mutex_t handles_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** Type defining the items stored in thread-local storage. */
+typedef struct {
+
+    Handle* handle;  /**< Handle of this thread's "send-to" file (or NULL). */
+
 } TLS;
 
+/** Registration of the fork and exit flush handlers. */
+static pthread_once_t handlers_once = PTHREAD_ONCE_INIT;
+
 #ifdef USE_EXPLICIT_TLS
 
 /**
@@ -72,44 +136,271 @@ static __thread TLS the_tls;
 
 
 
+/** Access the calling thread's handle (or NULL). */
+static Handle* thread_handle()
+{
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+    return (tls != NULL) ? tls->handle : NULL;
+#else
+    return the_tls.handle;
+#endif
+}
+
+
+
 /**
- * Set the "send-to" file.
+ * Lock a handle.
  *
- * Set the name of the file to which subsequent CBTF_SendToFile() calls will
- * write their data. The name is not specified directly. It is derived from the
- * unique identifier of the collector writing the data, the identifier of the
- * process/thread making the call, the process' executable name, and a suffix
- * provided by the caller. Insures that the specified file exists.
+ * Blocks all signals for the calling thread before spinning on the lock, so
+ * that a signal handler can never find the lock held by its own thread.
  *
- * @param unique_id    Unique identifier of the collector writing data.
- * @param suffix       File suffix to be used.
+ * @param handle    Handle to be locked.
+ * @retval saved    Signal mask to be restored by unlock_handle().
+ */
+static void lock_handle(Handle* handle, sigset_t* saved)
+{
+    sigset_t all;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, saved);
+    while(__atomic_test_and_set(&handle->lock, __ATOMIC_ACQUIRE))
+	sched_yield();
+}
+
+
+
+/**
+ * Unlock a handle.
  *
- * @ingroup RuntimeAPI
+ * @param handle    Handle to be unlocked.
+ * @param saved     Signal mask saved by lock_handle().
  */
+static void unlock_handle(Handle* handle, const sigset_t* saved)
+{
+    __atomic_clear(&handle->lock, __ATOMIC_RELEASE);
+    pthread_sigmask(SIG_SETMASK, saved, NULL);
+}
 
-static void __CBTF_SetSendToFile(const char* host, uint64_t pid, uint64_t posix_tid,
-			  const char* unique_id, const char* suffix)
+
+
+/**
+ * Get an unused handle.
+ *
+ * Reuses a handle released by CBTF_CloseSendToFile() or maps a new one. Uses
+ * mmap rather than malloc since the mem collector may be wrapping malloc.
+ *
+ * @return    Handle, or NULL if none could be mapped.
+ */
+static Handle* acquire_handle()
 {
+    Handle* handle;
+
+    pthread_mutex_lock(&handles_mutex);
+    for(handle = handles; handle != NULL; handle = handle->next)
+	if(!handle->in_use)
+	    break;
+    if(handle == NULL) {
+	handle = mmap(NULL, sizeof(Handle), PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(handle == MAP_FAILED) {
+	    pthread_mutex_unlock(&handles_mutex);
+	    return NULL;
+	}
+	handle->next = handles;
+	__atomic_store_n(&handles, handle, __ATOMIC_RELEASE);
+    }
+    handle->is_open = false;
+    handle->buffer = NULL;
+    handle->buffer_len = 0;
+    handle->in_use = true;
+    pthread_mutex_unlock(&handles_mutex);
 
-    /* Access our thread-local storage */
-#ifdef USE_EXPLICIT_TLS
-    // FIXME. Use the real __libc_malloc here in case some other tool
-    // is wrapping malloc.
-    TLS* tls = malloc(sizeof(TLS));
-    Assert(tls != NULL);
-    CBTF_SetTLS(TLSKey, tls);
-#else
-    TLS* tls = &the_tls;
-#endif
-    Assert(tls != NULL);
+    return handle;
+}
+
+
+
+/**
+ * Write all of the given I/O vectors to a file descriptor.
+ *
+ * Retries partial and interrupted writes. Only async-signal-safe calls are
+ * made since this can be reached from within a sampling signal handler.
+ *
+ * @param fd        File descriptor to write to.
+ * @param iov       I/O vectors to be written (modified).
+ * @param iovcnt    Number of I/O vectors.
+ * @return          Boolean "true" if all the data was written.
+ */
+static bool write_all(int fd, struct iovec* iov, int iovcnt)
+{
+    while(iovcnt > 0) {
+	ssize_t written = writev(fd, iov, iovcnt);
+	if(written < 0) {
+	    if(errno == EINTR)
+		continue;
+	    return false;
+	}
+
+	/* Skip past the fully written vectors and adjust the partial one */
+	while((iovcnt > 0) && ((size_t)written >= iov->iov_len)) {
+	    written -= iov->iov_len;
+	    ++iov;
+	    --iovcnt;
+	}
+	if(iovcnt > 0) {
+	    iov->iov_base = (char*)iov->iov_base + written;
+	    iov->iov_len -= written;
+	}
+    }
+    return true;
+}
 
-    /* Check preconditions */
-    Assert(unique_id != NULL);
-    Assert(suffix != NULL);
 
+
+/**
+ * Flush the write-behind buffer of a handle. The handle must be locked.
+ *
+ * @param handle    Handle whose buffer is to be flushed.
+ */
+static void flush_locked(Handle* handle)
+{
+    struct iovec iov;
+
+    if(!handle->is_open || (handle->buffer_len == 0))
+	return;
+
+    iov.iov_base = handle->buffer;
+    iov.iov_len = handle->buffer_len;
+    Assert(write_all(handle->fd, &iov, 1));
+    handle->buffer_len = 0;
+}
+
+
+
+/**
+ * Flush the write-behind buffer of a handle.
+ *
+ * @param handle    Handle whose buffer is to be flushed (or NULL).
+ */
+static void flush_handle(Handle* handle)
+{
+    sigset_t saved;
+
+    if(handle == NULL)
+	return;
+
+    lock_handle(handle, &saved);
+    flush_locked(handle);
+    unlock_handle(handle, &saved);
+}
+
+
+
+/**
+ * Flush and close the file of a handle and unmap its buffer.
+ *
+ * @param handle    Handle whose file is to be closed (or NULL).
+ */
+static void close_handle(Handle* handle)
+{
+    sigset_t saved;
+    char* buffer;
+
+    if(handle == NULL)
+	return;
+
+    lock_handle(handle, &saved);
+    flush_locked(handle);
+    if(handle->is_open)
+	close(handle->fd);
+    handle->is_open = false;
+    buffer = handle->buffer;
+    handle->buffer = NULL;
+    unlock_handle(handle, &saved);
+
+    if(buffer != NULL)
+	munmap(buffer, CBTF_SendToFileBufferSize);
+}
+
+
+
+/** Flush the forking thread's buffer. */
+static void prepare_fork_handler()
+{
+    CBTF_FlushSendToFile();
+}
+
+
+
+/**
+ * The child process must not append to its parent's files, nor write the
+ * data buffered by its parent's threads. The data buffered by the forking
+ * thread is discarded and its path is cleared, so that its next send derives
+ * a file of its own from the child's pid. Only the forking thread exists in
+ * the child, so the handles of the parent's other threads are released.
+ */
+static void child_fork_handler()
+{
+    Handle* self = thread_handle();
+    Handle* handle;
+
+    pthread_mutex_init(&handles_mutex, NULL);
+    for(handle = handles; handle != NULL; handle = handle->next) {
+	__atomic_clear(&handle->lock, __ATOMIC_RELAXED);
+	if(!handle->in_use)
+	    continue;
+	if(handle->is_open)
+	    close(handle->fd);
+	handle->is_open = false;
+	handle->buffer_len = 0;
+	handle->path[0] = '\0';
+	if(handle != self) {
+	    if(handle->buffer != NULL)
+		munmap(handle->buffer, CBTF_SendToFileBufferSize);
+	    handle->buffer = NULL;
+	    handle->in_use = false;
+	}
+    }
+}
+
+
+
+/** Flush the buffers of every thread's handle at process exit. */
+static void exit_handler()
+{
+    Handle* handle;
+
+    CBTF_DrainFlusher();
+    for(handle = __atomic_load_n(&handles, __ATOMIC_ACQUIRE);
+	handle != NULL;
+	handle = handle->next)
+	if(handle->in_use)
+	    flush_handle(handle);
+}
+
+
+
+/** Register the fork and exit flush handlers. Called once per process. */
+static void register_handlers()
+{
+    pthread_atfork(prepare_fork_handler, NULL, child_fork_handler);
+    atexit(exit_handler);
+}
+
+
+
+/**
+ * Derive the path of the file of a handle from its host, thread and suffix and
+ * the given process, and insure the directory containing it exists.
+ *
+ * @param handle    Handle whose path is to be derived.
+ * @param pid       Identifier of the process writing the file.
+ */
+static void derive_path(Handle* handle, uint64_t pid)
+{
     char* cbtf_rawdata_dir = NULL;
     char dir_path[PATH_MAX];
-    int fd;
 
     bool IsFileioDebugEndabled = false;
     IsFileioDebugEndabled = (getenv("CBTF_DEBUG_FILEIO_SERVICE") != NULL);
@@ -135,20 +426,21 @@ static void __CBTF_SetSendToFile(const char* host, uint64_t pid, uint64_t posix_
 
     sprintf(dir_path, "%s/cbtf-rawdata-%s-%lu",
 	    (cbtf_rawdata_dir != NULL) ? cbtf_rawdata_dir : "/tmp",
-	     host,pid);
+	     handle->host,pid);
 
     char *exe_name = basename(executable_path);
-    if(posix_tid == 0) {
-	sprintf(tls->path, "%s/%s-%lu", dir_path, exe_name, pid);
-	sprintf(tls->path, "%s.%s", tls->path, suffix);
+    if(handle->posix_tid == 0) {
+	sprintf(handle->path, "%s/%s-%lu", dir_path, exe_name, pid);
+	sprintf(handle->path, "%s.%s", handle->path, handle->suffix);
     } else {
-	sprintf(tls->path, "%s/%s-%lu-%lu", dir_path, exe_name, pid, posix_tid);
-	sprintf(tls->path, "%s.%s", tls->path, suffix);
+	sprintf(handle->path, "%s/%s-%lu-%lu", dir_path, exe_name, pid,
+		handle->posix_tid);
+	sprintf(handle->path, "%s.%s", handle->path, handle->suffix);
     }
 
 
     if ( IsFileioDebugEndabled ) {
-	fprintf(stderr,"__CBTF_SetSendToFile ready for %s\n",tls->path);
+	fprintf(stderr,"__CBTF_SetSendToFile ready for %s\n",handle->path);
     }
 
     /* Insure the directory path to contain the file exists */
@@ -193,15 +485,89 @@ static void __CBTF_SetSendToFile(const char* host, uint64_t pid, uint64_t posix_
     } 
         
 #endif
+}
 
 
-#if 1
-    /* Insure the file itself exists */
-    fd = open(tls->path, O_CREAT | O_APPEND,
-	      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
-    if(fd >= 0)
-	close(fd);
+
+/**
+ * Set the "send-to" file.
+ *
+ * Set the name of the file to which subsequent CBTF_SendToFile() calls will
+ * write their data. The name is not specified directly. It is derived from the
+ * unique identifier of the collector writing the data, the identifier of the
+ * process/thread making the call, the process' executable name, and a suffix
+ * provided by the caller. Insures that the specified file exists.
+ *
+ * @param unique_id    Unique identifier of the collector writing data.
+ * @param suffix       File suffix to be used.
+ *
+ * @ingroup RuntimeAPI
+ */
+
+static void __CBTF_SetSendToFile(const char* host, uint64_t pid, uint64_t posix_tid,
+			  const char* unique_id, const char* suffix)
+{
+
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+    if (tls == NULL) {
+	// FIXME. Use the real __libc_malloc here in case some other tool
+	// is wrapping malloc.
+	tls = malloc(sizeof(TLS));
+	Assert(tls != NULL);
+	memset(tls, 0, sizeof(TLS));
+	CBTF_SetTLS(TLSKey, tls);
+    }
+#else
+    TLS* tls = &the_tls;
 #endif
+    Assert(tls != NULL);
+
+    /* Write out anything buffered for the previous "send-to" file */
+    close_handle(tls->handle);
+    pthread_once(&handlers_once, register_handlers);
+    if (tls->handle == NULL) {
+	tls->handle = acquire_handle();
+    }
+    Assert(tls->handle != NULL);
+    Handle* handle = tls->handle;
+
+    /* Check preconditions */
+    Assert(unique_id != NULL);
+    Assert(suffix != NULL);
+
+    int fd;
+
+    strncpy(handle->host, host, sizeof(handle->host) - 1);
+    handle->host[sizeof(handle->host) - 1] = '\0';
+    handle->posix_tid = posix_tid;
+    strncpy(handle->suffix, suffix, sizeof(handle->suffix) - 1);
+    handle->suffix[sizeof(handle->suffix) - 1] = '\0';
+    derive_path(handle, pid);
+
+
+    /*
+     * Allocate the write-behind buffer. Use mmap rather than malloc since the
+     * mem collector may be wrapping malloc.
+     */
+    void* buffer = mmap(NULL, CBTF_SendToFileBufferSize,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    /* Insure the file itself exists and keep it open for CBTF_SendToFile() */
+    fd = open(handle->path, O_WRONLY | O_CREAT | O_APPEND,
+	      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+
+    sigset_t saved;
+    lock_handle(handle, &saved);
+    if(fd >= 0) {
+	handle->fd = fd;
+	handle->is_open = true;
+    }
+    handle->buffer = (buffer != MAP_FAILED) ? buffer : NULL;
+    handle->buffer_len = 0;
+    unlock_handle(handle, &saved);
 }
 
 
@@ -221,33 +587,24 @@ void CBTF_SetSendToFile(CBTF_DataHeader* header, const char* unique_id,
 
 
 /**
- * Send performance data to a file.
- *
- * Sends performance data to the current "send-to" file previously specified by
- * CBTF_SetSendToFile(). Any header generation and data encoding is performed
- * by the caller. Here the data is treated purely as a buffer of bytes to be
- * sent.
- *
- * @param size    Size of the data to be sent (in bytes).
- * @param data    Pointer to the data to be sent.
- * @return        Integer "1" if succeeded or "0" if failed.
+ * Send performance data to the file of the given handle.
  *
- * @ingroup RuntimeAPI
+ * @param handle    Handle of the file to be written (or NULL).
+ * @param size      Size of the data to be sent (in bytes).
+ * @param data      Pointer to the data to be sent.
+ * @return          Integer "1" if succeeded or "0" if failed.
  */
-int CBTF_SendToFile(const unsigned size, const void* data)
+static int send_to_file(Handle* handle, const unsigned size, const void* data)
 {
     unsigned encoded_size;
     char buffer[8]; /* Large enough to encode one 32-bit unsigned integer */
+    struct iovec iov[3];
+    sigset_t saved;
     XDR xdrs;
-    int fd;
 
-    /* Access our thread-local storage */
-#ifdef USE_EXPLICIT_TLS
-    TLS* tls = CBTF_GetTLS(TLSKey);
-#else
-    TLS* tls = &the_tls;
-#endif
-    Assert(tls != NULL);
+    /* Fail if the file was closed by CBTF_CloseSendToFile() */
+    if(handle == NULL)
+	return 0;
     
     /* Create an XDR stream using the encoding buffer */
     xdrmem_create(&xdrs, buffer, sizeof(buffer), XDR_ENCODE);
@@ -261,35 +618,249 @@ int CBTF_SendToFile(const unsigned size, const void* data)
     /* Close the XDR stream */
     xdr_destroy(&xdrs);
 
-#if 0
-    /* Insure the file itself exists */
-    fd = open(tls->path, O_CREAT | O_APPEND,
-	      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
-    if(fd >= 0)
-	close(fd);
-#endif
-    /* Open the file for writing */
-    Assert((fd = open(tls->path, O_WRONLY | O_APPEND)) >= 0);
-    //Assert((fd = open(tls->path, O_CREAT | O_APPEND)) >= 0);
+    lock_handle(handle, &saved);
 
-    /* Write the size of the data to be sent */
-    Assert(write(fd, buffer, encoded_size) == encoded_size);
-    
-    /* Write the data */
-    Assert(write(fd, data, size) == size);
+    /* Reopen the file if it was closed (e.g. in the child of a fork) */
+    if(!handle->is_open) {
+	if(handle->path[0] == '\0')
+	    derive_path(handle, getpid());
+	Assert((handle->fd = open(handle->path, O_WRONLY | O_CREAT | O_APPEND,
+				  S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH)) >= 0);
+	handle->is_open = true;
+    }
 
-/* fsync call taken out due to slow processing time reported at LLNL */
-/* via Matt Legendre for a LLNL user. */
-#if 0
-    /* Flush the data to disk. We could also test for fsyncdata
-     * and use that as our fsync vi a #define.
+    /* Append the size and data to the write-behind buffer if they fit */
+    if((handle->buffer != NULL) &&
+       ((handle->buffer_len + encoded_size + size) <= CBTF_SendToFileBufferSize)) {
+	memcpy(handle->buffer + handle->buffer_len, buffer, encoded_size);
+	memcpy(handle->buffer + handle->buffer_len + encoded_size, data, size);
+	handle->buffer_len += encoded_size + size;
+	unlock_handle(handle, &saved);
+	return 1;
+    }
+
+    /*
+     * Otherwise write the buffered data, the size and the data with a single
+     * writev. The fsync call was taken out due to slow processing time
+     * reported at LLNL via Matt Legendre for a LLNL user.
      */
-    Assert(fsync(fd) == 0);
-#endif
-    
-    /* Close the file */
-    Assert(close(fd) == 0);
+    iov[0].iov_base = handle->buffer;
+    iov[0].iov_len = handle->buffer_len;
+    iov[1].iov_base = buffer;
+    iov[1].iov_len = encoded_size;
+    iov[2].iov_base = (void*)data;
+    iov[2].iov_len = size;
+    Assert(write_all(handle->fd, iov, 3));
+    handle->buffer_len = 0;
+
+    unlock_handle(handle, &saved);
 
     /* Indicate success to the caller */
     return 1;
 }
+
+
+
+/**
+ * Send performance data to a file.
+ *
+ * Sends performance data to the current "send-to" file previously specified by
+ * CBTF_SetSendToFile(). Any header generation and data encoding is performed
+ * by the caller. Here the data is treated purely as a buffer of bytes to be
+ * sent. Never waits for the data handed off to the background flusher, which
+ * reaches the file through a descriptor of its own, in no particular order
+ * with this data.
+ *
+ * @param size    Size of the data to be sent (in bytes).
+ * @param data    Pointer to the data to be sent.
+ * @return        Integer "1" if succeeded or "0" if failed.
+ *
+ * @ingroup RuntimeAPI
+ */
+int CBTF_SendToFile(const unsigned size, const void* data)
+{
+    return send_to_file(thread_handle(), size, data);
+}
+
+
+
+/**
+ * Open a private "send-to" file handle.
+ *
+ * Opens a handle with its own file descriptor on the calling thread's current
+ * "send-to" file, for use by another thread (such as the background flusher or
+ * the raw event encoder) sending data on behalf of the calling thread. Only the
+ * thread using the handle ever touches it. Sends through it are not buffered,
+ * so they are in the file once CBTF_SendToFileHandle() returns.
+ *
+ * @return    Handle to the calling thread's "send-to" file, or NULL if the
+ *            calling thread has no "send-to" file.
+ *
+ * @ingroup RuntimeAPI
+ */
+void* CBTF_OpenSendToFileHandle()
+{
+    Handle* self = thread_handle();
+    Handle* handle;
+    sigset_t saved;
+    int fd;
+
+    if(self == NULL)
+	return NULL;
+
+    /* Derive the path if it was cleared (i.e. in the child of a fork) */
+    lock_handle(self, &saved);
+    if(self->path[0] == '\0')
+	derive_path(self, getpid());
+    unlock_handle(self, &saved);
+
+    fd = open(self->path, O_WRONLY | O_CREAT | O_APPEND,
+	      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    if(fd < 0)
+	return NULL;
+
+    handle = acquire_handle();
+    if(handle == NULL) {
+	close(fd);
+	return NULL;
+    }
+    strcpy(handle->path, self->path);
+    handle->fd = fd;
+    handle->is_open = true;
+
+    return handle;
+}
+
+
+
+/**
+ * Close a private "send-to" file handle.
+ *
+ * Closes a handle opened by CBTF_OpenSendToFileHandle() and releases it for
+ * reuse.
+ *
+ * @param handle    Handle to be closed.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_CloseSendToFileHandle(void* handle)
+{
+    if(handle == NULL)
+	return;
+
+    close_handle((Handle*)handle);
+
+    pthread_mutex_lock(&handles_mutex);
+    ((Handle*)handle)->in_use = false;
+    pthread_mutex_unlock(&handles_mutex);
+}
+
+
+
+/**
+ * Send performance data to a file on behalf of another thread.
+ *
+ * Identical to CBTF_SendToFile() except that the data is sent to the "send-to"
+ * file identified by a handle obtained from CBTF_OpenSendToFileHandle().
+ *
+ * @param handle    Handle of the "send-to" file.
+ * @param size      Size of the data to be sent (in bytes).
+ * @param data      Pointer to the data to be sent.
+ * @return          Integer "1" if succeeded or "0" if failed.
+ *
+ * @ingroup RuntimeAPI
+ */
+int CBTF_SendToFileHandle(void* handle, const unsigned size, const void* data)
+{
+    return send_to_file((Handle*)handle, size, data);
+}
+
+
+
+/**
+ * Send performance data to a file on behalf of another thread.
+ *
+ * Encodes the performance data header and data structure exactly as done by
+ * CBTF_Data_Send() and sends the result to the "send-to" file identified by a
+ * handle obtained from CBTF_OpenSendToFileHandle(). Used by the raw event
+ * encoder thread to send the tracing buffers it fills for the traced threads.
+ *
+ * @param handle     Handle of the "send-to" file.
+ * @param header     Performance data header to apply to this data.
+ * @param xdrproc    XDR procedure for the passed data structure.
+ * @param data       Pointer to the data structure to be sent.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_Data_SendToFileHandle(void* handle, const CBTF_DataHeader* header,
+				const xdrproc_t xdrproc, const void* data)
+{
+    const size_t EncodingBufferSize = (CBTF_BlobSizeFactor * 15 * 1024);
+    unsigned size;
+    char* buffer = alloca(EncodingBufferSize);
+    XDR xdrs;
+
+    /* Check preconditions */
+    Assert(handle != NULL);
+    Assert(header != NULL);
+    Assert(xdrproc != NULL);
+    Assert(data != NULL);
+
+    xdrmem_create(&xdrs, buffer, EncodingBufferSize, XDR_ENCODE);
+    Assert(xdr_CBTF_DataHeader(&xdrs, (void*)header) == TRUE);
+    Assert((*xdrproc)(&xdrs, (void*)data) == TRUE);
+    size = xdr_getpos(&xdrs);
+    xdr_destroy(&xdrs);
+
+    Assert(send_to_file((Handle*)handle, size, buffer) == 1);
+}
+
+
+
+/**
+ * Flush performance data to the "send-to" file.
+ *
+ * Writes any performance data buffered by CBTF_SendToFile() for the calling
+ * thread to its current "send-to" file. Called automatically before a fork,
+ * and for every thread at process exit.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_FlushSendToFile()
+{
+    flush_handle(thread_handle());
+}
+
+
+
+/**
+ * Close the "send-to" file.
+ *
+ * Writes any performance data buffered for the calling thread, closes its
+ * "send-to" file and releases the file descriptor and buffer for reuse by
+ * other threads. Called when collection stops for the thread, so that threads
+ * which exit do not leak them. Further sends fail until CBTF_SetSendToFile()
+ * is called again.
+ *
+ * @ingroup RuntimeAPI
+ */
+void CBTF_CloseSendToFile()
+{
+    /* Access our thread-local storage */
+#ifdef USE_EXPLICIT_TLS
+    TLS* tls = CBTF_GetTLS(TLSKey);
+#else
+    TLS* tls = &the_tls;
+#endif
+
+    if((tls == NULL) || (tls->handle == NULL))
+	return;
+
+    CBTF_DrainFlusher();
+    close_handle(tls->handle);
+
+    pthread_mutex_lock(&handles_mutex);
+    tls->handle->in_use = false;
+    pthread_mutex_unlock(&handles_mutex);
+    tls->handle = NULL;
+}
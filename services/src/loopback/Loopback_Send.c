@@ -0,0 +1,121 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the loopback send functions. These replace the MRNET LW send
+ * functions of MRNet_Send.c, sharing their message encoding, but deliver each
+ * message to the handler set by CBTF_Loopback_SetHandler() instead of an MRNet
+ * stream. Messages sent while no handler is set are dropped.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Loopback.h"
+#include "KrellInstitute/Messages/DataHeader.h"
+#include "KrellInstitute/Messages/ToolMessageTags.h"
+
+#include <rpc/rpc.h>
+
+#include "MRNet_Encode.h"
+
+/** Handler, and its context, to which the messages are delivered. */
+static CBTF_Loopback_Handler loopback_handler = NULL;
+static void* loopback_context = NULL;
+
+/** Mutex serializing the delivery of messages to the handler. */
+static pthread_mutex_t loopback_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+void CBTF_Loopback_SetHandler(CBTF_Loopback_Handler handler, void* context)
+{
+    pthread_mutex_lock(&loopback_mutex);
+    loopback_handler = handler;
+    loopback_context = context;
+    pthread_mutex_unlock(&loopback_mutex);
+}
+
+
+
+/* There is no tree to connect to. */
+int CBTF_MRNet_LW_connect (const int con_rank)
+{
+    return 1;
+}
+
+
+
+void CBTF_MRNet_LW_sendToFrontend(const int tag, const int size, void *data)
+{
+    pthread_mutex_lock(&loopback_mutex);
+    if (loopback_handler != NULL) {
+	(*loopback_handler)(loopback_context, tag, (uint32_t)size, data);
+    }
+    pthread_mutex_unlock(&loopback_mutex);
+}
+
+
+
+void CBTF_MRNet_Send(const int tag, const xdrproc_t xdrproc, const void* data)
+{
+    unsigned size = 0;
+    char* contents = CBTF_MRNet_EncodeMessage(xdrproc, data, &size);
+
+    if (contents == NULL) {
+	fprintf(stderr, "CBTF_MRNet_Send: cannot encode message\n");
+	return;
+    }
+
+    CBTF_MRNet_LW_sendToFrontend(tag, size, contents);
+}
+
+
+
+/*
+ * Performance data is sent as an XDR encoded CBTF_Protocol_Blob whose contents
+ * are the XDR encoded header and data, as it is by the MRNet transport.
+ */
+void CBTF_MRNet_Send_PerfData(const CBTF_DataHeader* header,
+                              const xdrproc_t xdrproc, const void* data)
+{
+    unsigned size = 0;
+    char* contents = CBTF_MRNet_EncodePerfData(header, xdrproc, data, &size);
+
+    if (contents == NULL) {
+	fprintf(stderr, "CBTF_MRNet_Send_PerfData: cannot encode message\n");
+	return;
+    }
+
+    CBTF_MRNet_LW_sendToFrontend(CBTF_PROTOCOL_TAG_PERFORMANCE_DATA,
+				 size, contents);
+}
+
+
+
+/* Every message was delivered when it was sent. */
+void CBTF_Waitfor_MRNet_Shutdown()
+{
+}
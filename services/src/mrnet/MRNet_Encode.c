@@ -0,0 +1,248 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Definition of the message encoding functions shared by the MRNet and loopback
+ * transports.
+ *
+ * Each thread encodes its messages into its own encoding buffer. The buffer is
+ * grown to the size of the largest message the thread has encoded, and is
+ * mapped rather than allocated since messages may be sent from a signal
+ * handler. A message is encoded into the buffer as it is, and only when it
+ * doesn't fit is its encoded size computed and the buffer grown to fit it.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "KrellInstitute/Services/Common.h"
+#include "MRNet_Encode.h"
+
+/** Type defining the encoding buffer of a thread. */
+typedef struct {
+    char* buffer;  /**< Encoding buffer (or NULL). */
+    size_t size;   /**< Size (in bytes) of the encoding buffer. */
+} EncodingBuffer;
+
+static pthread_key_t encoding_buffer_key;
+static pthread_once_t encoding_buffer_once = PTHREAD_ONCE_INIT;
+
+
+
+static void free_encoding_buffer(void* arg)
+{
+    EncodingBuffer* encoding = arg;
+
+    if (encoding->buffer != NULL) {
+	munmap(encoding->buffer, encoding->size);
+    }
+    munmap(encoding, sizeof(EncodingBuffer));
+}
+
+
+
+static void create_encoding_buffer_key()
+{
+    pthread_key_create(&encoding_buffer_key, free_encoding_buffer);
+}
+
+
+
+/*
+ * Get the calling thread's encoding buffer, grown to at least the given size
+ * and to at least a page, and its actual size. Returns NULL, with a size of 0,
+ * if there is no buffer of that size.
+ */
+static char* get_encoding_buffer(size_t size, size_t* actual_size)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    EncodingBuffer* encoding;
+    void* buffer;
+
+    *actual_size = 0;
+
+    pthread_once(&encoding_buffer_once, create_encoding_buffer_key);
+
+    encoding = pthread_getspecific(encoding_buffer_key);
+    if (encoding == NULL) {
+	encoding = mmap(NULL, sizeof(EncodingBuffer), PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (encoding == MAP_FAILED) {
+	    return NULL;
+	}
+	encoding->buffer = NULL;
+	encoding->size = 0;
+	pthread_setspecific(encoding_buffer_key, encoding);
+    }
+
+    size = (size > 0) ? ((size + page_size - 1) & ~(page_size - 1)) : page_size;
+    if (encoding->size < size) {
+	buffer = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer == MAP_FAILED) {
+	    return NULL;
+	}
+	if (encoding->buffer != NULL) {
+	    munmap(encoding->buffer, encoding->size);
+	}
+	encoding->buffer = buffer;
+	encoding->size = size;
+    }
+
+    *actual_size = encoding->size;
+    return encoding->buffer;
+}
+
+
+
+/*
+ * Encode an optional performance data header and a message into the given
+ * buffer, returning whether they fit.
+ */
+static bool_t encode(char* buffer, size_t capacity,
+		     const CBTF_DataHeader* header,
+		     const xdrproc_t xdrproc, const void* data, unsigned* size)
+{
+    bool_t encoded;
+    XDR xdrs;
+
+    xdrmem_create(&xdrs, buffer, capacity, XDR_ENCODE);
+    encoded = ((header == NULL) ||
+	       xdr_CBTF_DataHeader(&xdrs, (void*)header)) &&
+	(*xdrproc)(&xdrs, (void*)data);
+    *size = xdr_getpos(&xdrs);
+    xdr_destroy(&xdrs);
+
+    return encoded;
+}
+
+
+
+/* Compute the encoded size of an optional performance data header and message. */
+static size_t encoded_size(const CBTF_DataHeader* header,
+			   const xdrproc_t xdrproc, const void* data)
+{
+    size_t size = xdr_sizeof(xdrproc, (void*)data);
+
+    if (header != NULL) {
+	size += xdr_sizeof((xdrproc_t)xdr_CBTF_DataHeader, (void*)header);
+    }
+    return size;
+}
+
+
+
+char* CBTF_MRNet_EncodeMessage(const xdrproc_t xdrproc, const void* data,
+			       unsigned* size)
+{
+    size_t available;
+    char* buffer;
+
+    /* Check preconditions */
+    Assert(xdrproc != NULL);
+    Assert(size != NULL);
+
+    buffer = get_encoding_buffer(0, &available);
+    if ((buffer == NULL) ||
+	!encode(buffer, available, NULL, xdrproc, data, size)) {
+	buffer = get_encoding_buffer(encoded_size(NULL, xdrproc, data),
+				     &available);
+	if (buffer == NULL) {
+	    *size = 0;
+	    return NULL;
+	}
+	Assert(encode(buffer, available, NULL, xdrproc, data, size) == TRUE);
+    }
+
+    return buffer;
+}
+
+
+
+/*
+ * A blob is encoded as its length followed by each of its bytes widened to a
+ * whole XDR unit. The header and data are encoded once, at the end of the
+ * encoding buffer, and then widened in place, producing the same message as
+ * encoding the blob without encoding it again.
+ */
+char* CBTF_MRNet_EncodePerfData(const CBTF_DataHeader* header,
+				const xdrproc_t xdrproc, const void* data,
+				unsigned* size)
+{
+    size_t available, capacity;
+    unsigned contents_size, i;
+    char* buffer;
+    char* contents;
+    XDR xdrs;
+
+    /* Check preconditions */
+    Assert(header != NULL);
+    Assert(xdrproc != NULL);
+    Assert(data != NULL);
+    Assert(size != NULL);
+
+    buffer = get_encoding_buffer(0, &available);
+    if (buffer != NULL) {
+	capacity = (available / BYTES_PER_XDR_UNIT) - 1;
+	contents = buffer + BYTES_PER_XDR_UNIT +
+	    ((BYTES_PER_XDR_UNIT - 1) * capacity);
+    }
+
+    if ((buffer == NULL) ||
+	!encode(contents, capacity, header, xdrproc, data, &contents_size)) {
+	buffer = get_encoding_buffer(
+	    BYTES_PER_XDR_UNIT * (1 + encoded_size(header, xdrproc, data)),
+	    &available
+	    );
+	if (buffer == NULL) {
+	    *size = 0;
+	    return NULL;
+	}
+	capacity = (available / BYTES_PER_XDR_UNIT) - 1;
+	contents = buffer + BYTES_PER_XDR_UNIT +
+	    ((BYTES_PER_XDR_UNIT - 1) * capacity);
+	Assert(encode(contents, capacity, header, xdrproc, data,
+		      &contents_size) == TRUE);
+    }
+
+    xdrmem_create(&xdrs, buffer, BYTES_PER_XDR_UNIT, XDR_ENCODE);
+    Assert(xdr_u_int(&xdrs, &contents_size) == TRUE);
+    xdr_destroy(&xdrs);
+
+    /*
+     * Widen each byte into its XDR unit. The i'th unit ends before the i+1'th
+     * byte of the contents, so no byte is overwritten before being read.
+     */
+    for (i = 0; i < contents_size; ++i) {
+	char byte = contents[i];
+	char* unit = buffer + (BYTES_PER_XDR_UNIT * (1 + i));
+
+	unit[0] = unit[1] = unit[2] = 0;
+	unit[3] = byte;
+    }
+
+    *size = BYTES_PER_XDR_UNIT * (1 + contents_size);
+    return buffer;
+}
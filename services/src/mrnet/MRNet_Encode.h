@@ -0,0 +1,61 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/**
+ * @file Declaration of the message encoding functions shared by the MRNet
+ *       and loopback transports.
+ */
+
+#pragma once
+
+#include <rpc/rpc.h>
+
+#include "KrellInstitute/Messages/DataHeader.h"
+
+/*
+ * Encode a message.
+ *
+ * @param xdrproc    XDR procedure for the message.
+ * @param data       Message to be encoded.
+ * @retval size      Size (in bytes) of the encoded message.
+ *
+ * @return           Pointer to the encoded message, in the calling thread's
+ *                   encoding buffer. Only valid until the calling thread
+ *                   encodes another message. Null if the encoding buffer
+ *                   couldn't be allocated.
+ */
+char* CBTF_MRNet_EncodeMessage(const xdrproc_t xdrproc, const void* data,
+                               unsigned* size);
+
+/*
+ * Encode a performance data message: a CBTF_Protocol_Blob whose contents are
+ * the encoded header and data.
+ *
+ * @param header     Performance data header to apply to the data.
+ * @param xdrproc    XDR procedure for the data.
+ * @param data       Data to be encoded.
+ * @retval size      Size (in bytes) of the encoded message.
+ *
+ * @return           Pointer to the encoded message, in the calling thread's
+ *                   encoding buffer. Only valid until the calling thread
+ *                   encodes another message. Null if the encoding buffer
+ *                   couldn't be allocated.
+ */
+char* CBTF_MRNet_EncodePerfData(const CBTF_DataHeader* header,
+                                const xdrproc_t xdrproc, const void* data,
+                                unsigned* size);
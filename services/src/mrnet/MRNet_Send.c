@@ -28,19 +28,23 @@
 #endif
 
 #include <pthread.h>
+#include <signal.h>
+#include <time.h>
 
 #include "KrellInstitute/Services/Common.h"
 #include "KrellInstitute/Messages/DataHeader.h"
 #include "KrellInstitute/Messages/EventHeader.h"
 #include "KrellInstitute/Messages/Blob.h"
 #include "KrellInstitute/Messages/ToolMessageTags.h"
-#include "monitor.h" // monitor_get_thread_num
+#include "monitor.h" // monitor_get_thread_num, monitor_disable_new_threads
 
 #include <rpc/rpc.h>
 #include "mrnet_lightweight/MRNet.h"
 
 #include "KrellInstitute/CBTF/Impl/MessageTags.h"
 
+#include "MRNet_Encode.h"
+
 #if defined(ENABLE_CBTF_MRNET_PLAYBACK)
 #include "playback.h"
 #endif
@@ -55,6 +59,26 @@ static int mrnet_connected = 0;
 static pthread_mutex_t mrnet_connected_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t mrnet_connected_cond = PTHREAD_COND_INITIALIZER;
 
+/*
+ * Opt-in coalescing of the stream flushes of performance data messages. When
+ * CBTF_MRNET_COALESCE is set to a number of bytes, performance data messages
+ * are sent without being flushed until that many bytes are pending, until the
+ * oldest pending message is CBTF_MRNET_COALESCE_MSECS milliseconds old, or
+ * until any other message (such as a thread termination) is sent. The age of
+ * the pending messages is enforced by a timer thread, so that the messages of
+ * a stream that goes idle are not held until shutdown.
+ */
+static size_t coalesce_bytes = 0;
+static uint64_t coalesce_interval = 100000000; /* ns */
+static size_t pending_bytes = 0;
+static unsigned pending_messages = 0;
+static uint64_t pending_since = 0;
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pending_cond;
+static pthread_t coalesce_timer;
+static bool coalesce_timer_running = false;
+static bool coalesce_timer_stopping = false;
+
 #ifndef NDEBUG
 static bool IsMRNetDebugEnabled = false;
 #endif
@@ -117,6 +141,168 @@ static int CBTF_MRNet_getParentInfo(const char* file, int rank, char* phost, cha
 
 
 
+static uint64_t CBTF_MRNet_now()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec;
+}
+
+
+
+static void CBTF_MRNet_configureCoalescing()
+{
+    const char* bytes = getenv("CBTF_MRNET_COALESCE");
+    const char* msecs = getenv("CBTF_MRNET_COALESCE_MSECS");
+
+    if (bytes != NULL) {
+	coalesce_bytes = strtoul(bytes, NULL, 10);
+    }
+    if (msecs != NULL) {
+	coalesce_interval = strtoull(msecs, NULL, 10) * 1000000;
+    }
+
+#ifndef NDEBUG
+    if (IsMRNetDebugEnabled && (coalesce_bytes > 0)) {
+	fprintf(stderr,"CBTF_MRNet_LW_connect: coalescing flushes up to %lu bytes, %lu ms\n",
+		(unsigned long)coalesce_bytes,
+		(unsigned long)(coalesce_interval / 1000000));
+    }
+#endif
+}
+
+
+
+/*
+ * Lock pending_mutex with every signal blocked, so that a message sent by a
+ * signal handler interrupting this thread can't deadlock on the mutex.
+ */
+static void CBTF_MRNet_lockPending(sigset_t* saved)
+{
+    sigset_t signals;
+
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, saved);
+    pthread_mutex_lock(&pending_mutex);
+}
+
+
+
+static void CBTF_MRNet_unlockPending(const sigset_t* saved)
+{
+    pthread_mutex_unlock(&pending_mutex);
+    pthread_sigmask(SIG_SETMASK, saved, NULL);
+}
+
+
+
+/* Flush the messages pending on the stream. Called with pending_mutex held. */
+static void CBTF_MRNet_flushPending(Stream_t* stream)
+{
+    if (pending_messages == 0) {
+	return;
+    }
+
+#ifndef NDEBUG
+    if (IsMRNetDebugEnabled) {
+	fprintf(stderr,"[%d,%d] CBTF_MRNet_flushPending: flushes %u messages, %lu bytes\n",
+		getpid(),monitor_get_thread_num(),pending_messages,
+		(unsigned long)pending_bytes);
+    }
+#endif
+
+    if (Stream_flush(stream) == -1) {
+	fprintf(stderr, "BE: stream::flush() failure\n");
+    }
+    pending_messages = 0;
+    pending_bytes = 0;
+}
+
+
+
+/*
+ * Timer thread flushing the pending messages once the oldest of them is
+ * coalesce_interval old, or right away when asked to stop.
+ */
+static void* CBTF_MRNet_coalesceTimer(void* arg)
+{
+    sigset_t signals;
+
+    (void)arg;
+
+    /* Never take the sampling signals on this thread */
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    pthread_mutex_lock(&pending_mutex);
+    while (!coalesce_timer_stopping) {
+	uint64_t deadline = pending_since + coalesce_interval;
+
+	if (pending_messages == 0) {
+	    pthread_cond_wait(&pending_cond, &pending_mutex);
+	} else if (CBTF_MRNet_now() >= deadline) {
+	    CBTF_MRNet_flushPending(
+		Network_get_Stream(CBTF_MRNet_netPtr, stream_id));
+	} else {
+	    struct timespec timeout;
+
+	    timeout.tv_sec = deadline / 1000000000;
+	    timeout.tv_nsec = deadline % 1000000000;
+	    pthread_cond_timedwait(&pending_cond, &pending_mutex, &timeout);
+	}
+    }
+    pthread_mutex_unlock(&pending_mutex);
+
+    return NULL;
+}
+
+
+
+static void CBTF_MRNet_startCoalesceTimer()
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&pending_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    /* The timer thread must not itself be sampled */
+    monitor_disable_new_threads();
+    coalesce_timer_running = (pthread_create(&coalesce_timer, NULL,
+					     CBTF_MRNet_coalesceTimer,
+					     NULL) == 0);
+    monitor_enable_new_threads();
+
+    if (!coalesce_timer_running) {
+	fprintf(stderr, "CBTF_MRNet_LW_connect: coalescing without a timer\n");
+    }
+}
+
+
+
+/* Flush the pending messages and stop the timer thread. */
+static void CBTF_MRNet_stopCoalescing(Stream_t* stream)
+{
+    sigset_t saved;
+
+    CBTF_MRNet_lockPending(&saved);
+    CBTF_MRNet_flushPending(stream);
+    coalesce_timer_stopping = true;
+    if (coalesce_timer_running) {
+	pthread_cond_signal(&pending_cond);
+    }
+    CBTF_MRNet_unlockPending(&saved);
+
+    if (coalesce_timer_running) {
+	pthread_join(coalesce_timer, NULL);
+	coalesce_timer_running = false;
+    }
+}
+
+
+
 int CBTF_MRNet_LW_connect (const int con_rank)
 {
     pthread_mutex_lock(&mrnet_connected_mutex);
@@ -258,8 +444,13 @@ int CBTF_MRNet_LW_connect (const int con_rank)
 #if defined(ENABLE_CBTF_MRNET_PLAYBACK)
     playback_configure(Network_get_LocalRank(CBTF_MRNet_netPtr));
 #endif
+
+    CBTF_MRNet_configureCoalescing();
+    if (coalesce_bytes > 0) {
+	CBTF_MRNet_startCoalesceTimer();
+    }
     
-    mrnet_connected = 1;
+    __atomic_store_n(&mrnet_connected, 1, __ATOMIC_RELEASE);
     pthread_cond_broadcast(&mrnet_connected_cond);
     pthread_mutex_unlock(&mrnet_connected_mutex);
 
@@ -278,14 +469,18 @@ void CBTF_MRNet_LW_sendToFrontend(const int tag, const int size, void *data)
     /*
      * No need to repeatedly check mrnet_connected within a while loop as is
      * typical with a condition variable because it is only ever set once by
-     * CBTF_MRNet_LW_connect() above.
+     * CBTF_MRNet_LW_connect() above. Once connected, the mutex isn't taken,
+     * so that a signal handler interrupting this thread can send too.
      */
-    pthread_mutex_lock(&mrnet_connected_mutex);
-    if (!mrnet_connected)
+    if (!__atomic_load_n(&mrnet_connected, __ATOMIC_ACQUIRE))
     {
-        pthread_cond_wait(&mrnet_connected_cond, &mrnet_connected_mutex);
+        pthread_mutex_lock(&mrnet_connected_mutex);
+        if (!mrnet_connected)
+        {
+            pthread_cond_wait(&mrnet_connected_cond, &mrnet_connected_mutex);
+        }
+        pthread_mutex_unlock(&mrnet_connected_mutex);
     }
-    pthread_mutex_unlock(&mrnet_connected_mutex);
 
 #if defined(ENABLE_CBTF_MRNET_PLAYBACK)
     if (playback_intercept(tag, (uint32_t)size, data))
@@ -302,34 +497,60 @@ void CBTF_MRNet_LW_sendToFrontend(const int tag, const int size, void *data)
 #endif
 
     Stream_t* CBTF_MRNet_stream = Network_get_Stream(CBTF_MRNet_netPtr,stream_id);
-    if ( (Stream_send(CBTF_MRNet_stream, tag, fmt_str, data, size) == -1) ||
-          Stream_flush(CBTF_MRNet_stream) == -1 ) {
-        fprintf(stderr, "BE: stream::send() failure\n");
-    }
 
+    if (coalesce_bytes == 0) {
+	if ( (Stream_send(CBTF_MRNet_stream, tag, fmt_str, data, size) == -1) ||
+	      Stream_flush(CBTF_MRNet_stream) == -1 ) {
+	    fprintf(stderr, "BE: stream::send() failure\n");
+	}
+    } else {
+	sigset_t saved;
+
+	CBTF_MRNet_lockPending(&saved);
+
+	if (Stream_send(CBTF_MRNet_stream, tag, fmt_str, data, size) == -1) {
+	    fprintf(stderr, "BE: stream::send() failure\n");
+	} else {
+	    if (pending_messages++ == 0) {
+		pending_since = CBTF_MRNet_now();
+		if (coalesce_timer_running) {
+		    pthread_cond_signal(&pending_cond);
+		}
+	    }
+	    pending_bytes += size;
+	}
+
+	/* Anything but performance data is flushed right away, with the
+	 * performance data sent before it.
+	 */
+	if ((tag != CBTF_PROTOCOL_TAG_PERFORMANCE_DATA) ||
+	    (pending_bytes >= coalesce_bytes) ||
+	    ((CBTF_MRNet_now() - pending_since) >= coalesce_interval)) {
+	    CBTF_MRNet_flushPending(CBTF_MRNet_stream);
+	}
+
+	CBTF_MRNet_unlockPending(&saved);
+    }
 
-    fflush(stdout);
-    fflush(stderr);
+    /* stdio isn't async-signal-safe, and this may run in a signal handler */
+#ifndef NDEBUG
+    if (IsMRNetDebugEnabled) {
+	fflush(stdout);
+	fflush(stderr);
+    }
+#endif
 }
 
 
 
 void CBTF_MRNet_Send(const int tag, const xdrproc_t xdrproc, const void* data)
 {
-    unsigned size=0,dm_size=0;
-    char* dm_contents = NULL;
-
-    for(size = 1024; dm_contents == NULL; size *= 2) {
-        char* buffer = alloca(size);
-        XDR xdrs;
-        xdrmem_create(&xdrs, buffer, size, XDR_ENCODE);
+    unsigned dm_size = 0;
+    char* dm_contents = CBTF_MRNet_EncodeMessage(xdrproc, data, &dm_size);
 
-
-        if ((*xdrproc)(&xdrs, (void*)data) == TRUE) {
-            dm_size = xdr_getpos(&xdrs);
-            dm_contents = buffer;
-        }
-        xdr_destroy(&xdrs);
+    if (dm_contents == NULL) {
+	fprintf(stderr, "CBTF_MRNet_Send: cannot encode message\n");
+	return;
     }
 
 #ifndef NDEBUG
@@ -344,34 +565,31 @@ void CBTF_MRNet_Send(const int tag, const xdrproc_t xdrproc, const void* data)
 
 
 
+/*
+ * Performance data is sent as an XDR encoded CBTF_Protocol_Blob whose contents
+ * are the XDR encoded header and data.
+ */
 void CBTF_MRNet_Send_PerfData(const CBTF_DataHeader* header,
                               const xdrproc_t xdrproc, const void* data)
 {
-    const size_t EncodingBufferSize = (CBTF_BlobSizeFactor * 15 * 1024);
-    unsigned size;
-    char* buffer = NULL;
-    XDR xdrs;
-
-    /* Check preconditions */
-    Assert(header != NULL);
-    Assert(xdrproc != NULL);
-    Assert(data != NULL);
-
-    buffer = alloca(EncodingBufferSize);
-
-    xdrmem_create(&xdrs, buffer, EncodingBufferSize, XDR_ENCODE);
-    Assert(xdr_CBTF_DataHeader(&xdrs, (void*)header) == TRUE);
-    Assert((*xdrproc)(&xdrs, (void*)data) == TRUE);
-    size = xdr_getpos(&xdrs);
-    xdr_destroy(&xdrs);
-
-    /* send it as a blob */
-    CBTF_Protocol_Blob blob;
-    blob.data.data_val = (uint8_t*) buffer;
-    blob.data.data_len = size;
-
-    CBTF_MRNet_Send(CBTF_PROTOCOL_TAG_PERFORMANCE_DATA,
-                 (xdrproc_t) xdr_CBTF_Protocol_Blob, &blob);
+    unsigned size = 0;
+    char* buffer = CBTF_MRNet_EncodePerfData(header, xdrproc, data, &size);
+
+    if (buffer == NULL) {
+	fprintf(stderr, "CBTF_MRNet_Send_PerfData: cannot encode message\n");
+	return;
+    }
+
+#ifndef NDEBUG
+    if (IsMRNetDebugEnabled) {
+	fprintf(stderr,"[%d,%d] CBTF_MRNet_Send_PerfData: sends message tag:%d size: %d\n",
+		getpid(),monitor_get_thread_num(),CBTF_PROTOCOL_TAG_PERFORMANCE_DATA,
+		size);
+    }
+#endif
+
+    CBTF_MRNet_LW_sendToFrontend(CBTF_PROTOCOL_TAG_PERFORMANCE_DATA,
+				 size, buffer);
 }
 
 
@@ -394,6 +612,14 @@ void CBTF_Waitfor_MRNet_Shutdown()
 	Stream_t* stream = Network_get_Stream(CBTF_MRNet_netPtr,stream_id);
 	int tag = 0;
 
+	/* flush any performance data still pending */
+	CBTF_MRNet_stopCoalescing(stream);
+
+#if defined(ENABLE_CBTF_MRNET_PLAYBACK)
+	/* index and close any playback being recorded */
+	playback_finish();
+#endif
+
 	/* wait for FE to request the shutdown */
 	do {
 	    //fprintf(stderr,"CBTF_Waitfor_MRNet_Shutdown WAIT FOR FE request of shutdown %d\n",getpid());
@@ -18,17 +18,32 @@
 
 /** @file Definition of the playback globals and functions. */
 
+/*
+ * Playback files hold the messages sent by one MRNet rank. The original format
+ * is simply a sequence of records, each being the time, tag and size of the
+ * message followed by its contents. The current format starts with a header
+ * holding a magic number, the format version, the rank and the offset of the
+ * index, follows with the same sequence of records, and ends with an index of
+ * the records grouped by tag and sending thread, followed by a footer locating
+ * the index. A file whose recording was interrupted has no index, and is read
+ * sequentially just like a file in the original format.
+ */
+
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <pthread.h>
 #include <rpc/xdr.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "KrellInstitute/Messages/LinkedObjectEvents.h"
@@ -42,6 +57,74 @@ void CBTF_MRNet_LW_sendToFrontend(const int, const int, void*);
 
 
 
+/** Magic numbers identifying the header and footer of a playback file. */
+static const char PlaybackMagic[8] = { 'C','B','T','F','P','B','0','2' };
+static const char PlaybackIndexMagic[8] = { 'C','B','T','F','P','B','I','X' };
+
+/** Current version of the playback file format. */
+#define PlaybackVersion 2
+
+/** Size (in bytes) of the buffer used when recording a playback. */
+#define PlaybackBufferSize (1024 * 1024)
+
+/** Header at the start of a playback file. */
+typedef struct {
+    char magic[8];     /**< PlaybackMagic */
+    uint32_t version;  /**< PlaybackVersion */
+    uint32_t rank;     /**< MRNet rank of the recorded process */
+    uint64_t index;    /**< Offset of the index, or 0 if not yet written */
+} PlaybackHeader;
+
+/** Header of each recorded message, followed by the message contents. */
+typedef struct {
+    uint64_t time;     /**< Time at which the message was recorded */
+    int32_t tag;       /**< Tag for the message */
+    uint32_t size;     /**< Size (in bytes) of the message */
+} PlaybackRecord;
+
+/**
+ * Group of the index. Gives the number of messages with a given tag sent by a
+ * given thread, where their offsets start in the index, and the interval of
+ * time over which they were recorded.
+ */
+typedef struct {
+    int32_t tag;       /**< Tag for the messages */
+    uint32_t thread;   /**< Thread (id) that sent the messages */
+    uint32_t count;    /**< Number of messages */
+    uint32_t first;    /**< Index of the first of their offsets */
+    uint64_t begin;    /**< Time at which the first message was recorded */
+    uint64_t end;      /**< Time at which the last message was recorded */
+} PlaybackIndexGroup;
+
+/**
+ * Footer at the end of a playback file. The index starts at the given offset,
+ * with the groups followed by the offsets of the records of each group, in
+ * the order they were recorded.
+ */
+typedef struct {
+    uint64_t offset;   /**< Offset of the index */
+    uint32_t groups;   /**< Number of groups in the index */
+    uint32_t records;  /**< Number of records in the index */
+    char magic[8];     /**< PlaybackIndexMagic */
+} PlaybackFooter;
+
+/** Record, as seen by the index, of one recorded message. */
+typedef struct {
+    uint64_t offset;
+    uint64_t time;
+    int32_t tag;
+    uint32_t thread;
+} PlaybackEntry;
+
+/** Pacing of the replay of a playback. */
+typedef struct {
+    bool is_first;
+    uint64_t first_time;
+    struct timespec start;
+} PlaybackPacing;
+
+
+
 /** Is the recording of a playback enabled? */
 static bool do_record_playback = false;
 
@@ -51,6 +134,15 @@ static bool do_replay_playback = false;
 /** Should the recorded delay between each message be ignored? */
 static bool no_playback_delay = false;
 
+/** Speed-up of the replay relative to the recorded delays. */
+static double playback_speed = 1.0;
+
+/** Is this rank outside of the replayed ranks, replaying only its threads? */
+static bool skip_replay = false;
+
+/** Selection of the replayed messages. */
+static PlaybackSelection playback_selection;
+
 /** Mutex insuring only one thread enters playback_intercept() at a time. */
 static pthread_mutex_t playback_mutex;
 static pthread_mutexattr_t playback_mutexattr;
@@ -61,6 +153,203 @@ static char playback_directory[PATH_MAX] = "";
 /** Path of the playback file. */
 static char playback_file[PATH_MAX] = "";
 
+/** File descriptor of the playback being recorded, and its owning process. */
+static int playback_fd = -1;
+static pid_t playback_pid = 0;
+
+/** Buffer of the playback being recorded. */
+static char playback_buffer[PlaybackBufferSize];
+static size_t playback_buffered = 0;
+
+/** Offset of the next record of the playback being recorded. */
+static uint64_t playback_offset = 0;
+
+/** Entries of the index of the playback being recorded. */
+static PlaybackEntry* playback_entries = NULL;
+static uint32_t playback_entries_count = 0;
+static uint32_t playback_entries_capacity = 0;
+
+
+
+/**
+ * Write the specified data to the playback file.
+ *
+ * @param data    Pointer to the data.
+ * @param size    Size (in bytes) of the data.
+ */
+static void write_fully(const void* data, size_t size)
+{
+    const char* ptr = data;
+
+    while (size > 0)
+    {
+        ssize_t n = write(playback_fd, ptr, size);
+
+        if ((n == -1) && (errno == EINTR))
+        {
+            continue;
+        }
+
+        Assert(n > 0);
+        ptr += n;
+        size -= n;
+    }
+}
+
+
+
+/** Flush the buffer of the playback being recorded. */
+static void flush_playback()
+{
+    write_fully(playback_buffer, playback_buffered);
+    playback_buffered = 0;
+}
+
+
+
+/**
+ * Append the specified data to the playback being recorded.
+ *
+ * @param data    Pointer to the data.
+ * @param size    Size (in bytes) of the data.
+ */
+static void write_playback(const void* data, size_t size)
+{
+    if ((playback_buffered + size) > PlaybackBufferSize)
+    {
+        flush_playback();
+    }
+
+    if (size > PlaybackBufferSize)
+    {
+        write_fully(data, size);
+    }
+    else
+    {
+        memcpy(playback_buffer + playback_buffered, data, size);
+        playback_buffered += size;
+    }
+}
+
+
+
+/**
+ * Create the playback file and write its header.
+ *
+ * @param rank    MRNet rank of this process.
+ * @return        Boolean flag indicating if the file was created.
+ */
+static bool open_playback(uint32_t rank)
+{
+    static bool is_registered = false;
+    PlaybackHeader header;
+
+    playback_fd = open(playback_file, O_WRONLY | O_CREAT | O_EXCL, 0644);
+
+    if (playback_fd == -1)
+    {
+        fprintf(stderr, "[CBTF/MRNet Playback] "
+                "Playback file \"%s\" couldn't be created!\n",
+                playback_file);
+        fflush(stderr);
+        return false;
+    }
+
+    playback_pid = getpid();
+    playback_buffered = 0;
+    playback_entries_count = 0;
+
+    memcpy(header.magic, PlaybackMagic, sizeof(header.magic));
+    header.version = PlaybackVersion;
+    header.rank = rank;
+    header.index = 0;
+    write_playback(&header, sizeof(header));
+    playback_offset = sizeof(header);
+
+    if (!is_registered)
+    {
+        is_registered = true;
+        atexit(playback_finish);
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Parse a selection of tags from the specified comma-separated list.
+ *
+ * @param list         List of tags.
+ * @param selection    Selection to be filled in.
+ */
+static void parse_tags(const char* list, PlaybackSelection* selection)
+{
+    char* end = NULL;
+
+    while ((*list != '\0') && (selection->tags_count < PlaybackMaxTags))
+    {
+        long tag = strtol(list, &end, 10);
+
+        if (end == list)
+        {
+            break;
+        }
+
+        selection->tags[selection->tags_count++] = (int32_t)tag;
+        list = (*end == ',') ? end + 1 : end;
+    }
+}
+
+
+
+/**
+ * Parse a time window from the specified "begin:end" string, in seconds after
+ * the first message. Either bound may be omitted.
+ *
+ * @param window       Time window.
+ * @param selection    Selection to be filled in.
+ */
+static void parse_window(const char* window, PlaybackSelection* selection)
+{
+    const char* separator = strchr(window, ':');
+
+    if (window[0] != ':')
+    {
+        selection->begin = (uint64_t)(strtod(window, NULL) * 1000000000.0);
+    }
+
+    if ((separator != NULL) && (separator[1] != '\0'))
+    {
+        selection->end = (uint64_t)(strtod(separator + 1, NULL) * 1000000000.0);
+    }
+}
+
+
+
+/**
+ * Get the playback selection specified by the environment.
+ *
+ * @param selection    Selection to be filled in.
+ */
+void playback_get_selection(PlaybackSelection* selection)
+{
+    memset(selection, 0, sizeof(PlaybackSelection));
+
+    if (getenv("CBTF_MRNET_PLAYBACK_TAGS") != NULL)
+    {
+        parse_tags(getenv("CBTF_MRNET_PLAYBACK_TAGS"), selection);
+    }
+
+    if (getenv("CBTF_MRNET_PLAYBACK_WINDOW") != NULL)
+    {
+        parse_window(getenv("CBTF_MRNET_PLAYBACK_WINDOW"), selection);
+    }
+
+    /* The frontend waits for every attached thread to terminate */
+    selection->lifecycle = true;
+}
+
 
 
 /**
@@ -69,6 +358,13 @@ static char playback_file[PATH_MAX] = "";
  * Determine if the sent messages should be recorded for future playback, or
  * replayed from an existing playback. And if so perform any necessary setup.
  *
+ * The replay can be limited to the ranks given by CBTF_MRNET_PLAYBACK_RANKS
+ * ("first-last"), to the tags listed by CBTF_MRNET_PLAYBACK_TAGS and to the
+ * time window given by CBTF_MRNET_PLAYBACK_WINDOW ("begin:end" in seconds),
+ * and sped up by the factor CBTF_MRNET_PLAYBACK_SPEED. The thread attach and
+ * state change messages are always replayed, including by the other ranks, so
+ * that the frontend still sees every thread terminate.
+ *
  * @param rank    MRNet rank of this process.
  */
 void playback_configure(uint32_t rank)
@@ -136,6 +432,35 @@ void playback_configure(uint32_t rank)
         }
     }
 
+    if (do_record_playback)
+    {
+        do_record_playback = open_playback(rank);
+    }
+
+    if (do_replay_playback)
+    {
+        const char* speed = getenv("CBTF_MRNET_PLAYBACK_SPEED");
+        const char* ranks = getenv("CBTF_MRNET_PLAYBACK_RANKS");
+
+        if ((speed != NULL) && (strtod(speed, NULL) > 0.0))
+        {
+            playback_speed = strtod(speed, NULL);
+        }
+
+        if (ranks != NULL)
+        {
+            char* end = NULL;
+            unsigned long first = strtoul(ranks, &end, 10);
+            unsigned long last = (*end == '-') ? 
+                strtoul(end + 1, NULL, 10) : first;
+
+            skip_replay = (rank < first) || (rank > last);
+        }
+
+        playback_get_selection(&playback_selection);
+        playback_selection.rehome = playback_directory;
+    }
+
     pthread_mutexattr_init(&playback_mutexattr);
     pthread_mutexattr_settype(&playback_mutexattr, PTHREAD_MUTEX_RECURSIVE_NP);
     pthread_mutex_init(&playback_mutex, &playback_mutexattr);
@@ -237,6 +562,9 @@ void copyfile(const char* source)
 
 
 
+
+
+
 /**
  * Record the specified message to the previously configured playback file.
  *
@@ -246,7 +574,18 @@ void copyfile(const char* source)
  */
 static void record_to_playback(int32_t tag, uint32_t size, void* data)
 {
-    uint64_t time = CBTF_GetTime();
+    PlaybackRecord record;
+    PlaybackEntry* entry = NULL;
+
+    /* A forked child must leave its parent's playback file alone. */
+    if ((playback_fd == -1) || (playback_pid != getpid()))
+    {
+        return;
+    }
+
+    record.time = CBTF_GetTime();
+    record.tag = tag;
+    record.size = size;
 
     if (tag == CBTF_PROTOCOL_TAG_LINKED_OBJECT_GROUP)
     {
@@ -269,111 +608,553 @@ static void record_to_playback(int32_t tag, uint32_t size, void* data)
         xdr_free((xdrproc_t)xdr_CBTF_Protocol_LinkedObjectGroup,
                  (char*)&group);
     }
-    
-    FILE* fp = fopen(playback_file, "a+");
 
-    Assert(fp != NULL);
+    write_playback(&record, sizeof(record));
+    write_playback(data, size);
 
-    Assert(fwrite(&time, sizeof(uint64_t), 1, fp) == 1);
-    Assert(fwrite(&tag, sizeof(int32_t), 1, fp) == 1);
-    Assert(fwrite(&size, sizeof(uint32_t), 1, fp) == 1);
-    Assert(fwrite(data, size, 1, fp) == 1);
+    if (playback_entries_count == playback_entries_capacity)
+    {
+        playback_entries_capacity = (playback_entries_capacity == 0) ?
+            1024 : (2 * playback_entries_capacity);
+        playback_entries = realloc(
+            playback_entries, playback_entries_capacity * sizeof(PlaybackEntry)
+            );
+        Assert(playback_entries != NULL);
+    }
+
+    entry = &playback_entries[playback_entries_count++];
+    entry->offset = playback_offset;
+    entry->time = record.time;
+    entry->tag = tag;
+    entry->thread = (uint32_t)syscall(SYS_gettid);
+
+    playback_offset += sizeof(record) + size;
+}
+
+
+
+/** Compare two index entries by tag, thread, and then offset. */
+static int compare_entries(const void* lhs, const void* rhs)
+{
+    const PlaybackEntry* a = lhs;
+    const PlaybackEntry* b = rhs;
+
+    if (a->tag != b->tag)
+    {
+        return (a->tag < b->tag) ? -1 : 1;
+    }
+    if (a->thread != b->thread)
+    {
+        return (a->thread < b->thread) ? -1 : 1;
+    }
+    if (a->offset != b->offset)
+    {
+        return (a->offset < b->offset) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+
+/** Write the index, and the footer, of the playback being recorded. */
+static void write_index()
+{
+    PlaybackFooter footer;
+    uint32_t i, first;
+
+    footer.offset = playback_offset;
+    footer.groups = 0;
+    footer.records = playback_entries_count;
+    memcpy(footer.magic, PlaybackIndexMagic, sizeof(footer.magic));
+
+    qsort(playback_entries, playback_entries_count, sizeof(PlaybackEntry),
+          compare_entries);
+
+    for (i = 0, first = 0; i < playback_entries_count; ++i)
+    {
+        const PlaybackEntry* entry = &playback_entries[i];
+        const PlaybackEntry* next = &playback_entries[i + 1];
+
+        if (((i + 1) == playback_entries_count) ||
+            (next->tag != entry->tag) || (next->thread != entry->thread))
+        {
+            PlaybackIndexGroup group;
+            uint32_t j;
+
+            group.tag = entry->tag;
+            group.thread = entry->thread;
+            group.count = i + 1 - first;
+            group.first = first;
+            group.begin = playback_entries[first].time;
+            group.end = playback_entries[first].time;
+
+            for (j = first; j <= i; ++j)
+            {
+                if (playback_entries[j].time < group.begin)
+                {
+                    group.begin = playback_entries[j].time;
+                }
+                if (playback_entries[j].time > group.end)
+                {
+                    group.end = playback_entries[j].time;
+                }
+            }
+
+            write_playback(&group, sizeof(group));
+            footer.groups++;
+            first = i + 1;
+        }
+    }
+
+    for (i = 0; i < playback_entries_count; ++i)
+    {
+        write_playback(&playback_entries[i].offset, sizeof(uint64_t));
+    }
+
+    write_playback(&footer, sizeof(footer));
+}
+
+
+
+/**
+ * Finish the recording of a playback.
+ *
+ * Writes the index of the recorded messages at the end of the playback file
+ * and closes it. Called when the MRNet connection is shut down, and at exit.
+ */
+void playback_finish()
+{
+    if (playback_fd == -1)
+    {
+        return;
+    }
+
+    Assert(pthread_mutex_lock(&playback_mutex) == 0);
+
+    if ((playback_fd != -1) && (playback_pid == getpid()))
+    {
+        uint64_t index = playback_offset;
+
+        write_index();
+        flush_playback();
+
+        Assert(pwrite(playback_fd, &index, sizeof(index),
+                      offsetof(PlaybackHeader, index)) == sizeof(index));
+    }
+
+    if (playback_fd != -1)
+    {
+        Assert(close(playback_fd) == 0);
+        playback_fd = -1;
+    }
+
+    free(playback_entries);
+    playback_entries = NULL;
+    playback_entries_count = 0;
+    playback_entries_capacity = 0;
+    playback_buffered = 0;
     
-    Assert(fclose(fp) == 0);
+    Assert(pthread_mutex_unlock(&playback_mutex) == 0);
 }
 
 
 
 /**
- * Replay all messages from the previously configured playback file.
+ * Rehome the linked objects of the specified linked object group into the
+ * specified directory.
+ *
+ * @param directory    Directory into which the linked objects are rehomed.
+ * @param size         Size (in bytes) of the message. Updated to the size
+ *                     of the rehomed message.
+ * @param data         Pointer to the message contents.
+ * @return             Pointer to the rehomed message contents. Must be
+ *                     released by the caller with free().
  */
-static void replay_from_playback()
+static void* rehome(const char* directory, uint32_t* size, const void* data)
 {
-    bool is_first = true;
-    uint64_t previous_time = 0;
-    FILE* fp = fopen(playback_file, "r");
+    XDR xdr;
+    CBTF_Protocol_LinkedObjectGroup group;
+    uint32_t capacity = *size;
+    void* rehomed_data = NULL;
+
+    xdrmem_create(&xdr, (char*)data, *size, XDR_DECODE);
+    memset(&group, 0, sizeof(CBTF_Protocol_LinkedObjectGroup));
+    xdr_CBTF_Protocol_LinkedObjectGroup(&xdr, &group);
+    xdr_destroy(&xdr);
+
+    int i;
+    for (i = 0; i < group.linkedobjects.linkedobjects_len; ++i)
+    {
+        char** original = &(
+            group.linkedobjects.linkedobjects_val[i].linked_object.path
+            );
+        
+        char rehomed[PATH_MAX] = "";
+        sprintf(rehomed, "%s%s", directory, *original);
 
-    Assert(fp != NULL);
+        free(*original);
+        *original = strdup(rehomed);
 
-    while (true)
+        capacity += strlen(directory) + 4 /* XDR padding */;
+    }
+
+    rehomed_data = malloc(capacity);
+    Assert(rehomed_data != NULL);
+
+    xdrmem_create(&xdr, rehomed_data, capacity, XDR_ENCODE);
+    Assert(xdr_CBTF_Protocol_LinkedObjectGroup(&xdr, &group) == TRUE);
+    *size = xdr_getpos(&xdr);
+    xdr_destroy(&xdr);
+
+    xdr_free((xdrproc_t)xdr_CBTF_Protocol_LinkedObjectGroup, (char*)&group);
+
+    return rehomed_data;
+}
+
+
+
+/** Is the specified tag selected? */
+static bool is_tag_selected(const PlaybackSelection* selection, int32_t tag)
+{
+    unsigned i;
+
+    if (selection->tags_count == 0)
     {
-        uint64_t time = 0;
-        int32_t tag = 0;
-        uint32_t size = 0;
+        return true;
+    }
 
-        if (fread(&time, sizeof(uint64_t), 1, fp) < 1)
+    for (i = 0; i < selection->tags_count; ++i)
+    {
+        if (selection->tags[i] == tag)
         {
-            break;
+            return true;
         }
+    }
+
+    return false;
+}
+
+
+
+/**
+ * Is the specified tag that of a thread lifecycle message selected regardless
+ * of the tags and window?
+ */
+static bool is_lifecycle_selected(const PlaybackSelection* selection,
+                                  int32_t tag)
+{
+    return selection->lifecycle &&
+        ((tag == CBTF_PROTOCOL_TAG_ATTACHED_TO_THREADS) ||
+         (tag == CBTF_PROTOCOL_TAG_THREADS_STATE_CHANGED));
+}
+
+
+
+/**
+ * Does the specified interval (in nanoseconds after the first message) overlap
+ * the time window of the selection?
+ */
+static bool is_time_selected(const PlaybackSelection* selection,
+                             uint64_t begin, uint64_t end)
+{
+    return (end >= selection->begin) &&
+        ((selection->end == 0) || (begin <= selection->end));
+}
+
+
+
+/** Compare two offsets. */
+static int compare_offsets(const void* lhs, const void* rhs)
+{
+    const uint64_t a = *(const uint64_t*)lhs;
+    const uint64_t b = *(const uint64_t*)rhs;
+
+    return (a < b) ? -1 : ((a > b) ? 1 : 0);
+}
+
+
+
+/**
+ * Read the selected messages from a playback file.
+ *
+ * The file is mapped into memory. When it has an index, only the groups with
+ * the selected tags that overlap the selected window are visited. Otherwise
+ * the records are scanned in sequence, ending at the first truncated record.
+ *
+ * @param path         Path of the playback file.
+ * @param selection    Selection of the messages to be visited.
+ * @param visitor      Visitor called for each selected message.
+ * @param context      Context passed to the visitor.
+ *
+ * @return             Boolean flag indicating if the file could be read.
+ */
+bool playback_read(const char* path, const PlaybackSelection* selection,
+                   PlaybackVisitor visitor, void* context)
+{
+    struct stat status;
+    const char* base = NULL;
+    uint64_t length = 0, begin = 0, end = 0, base_time = 0;
+    uint64_t* offsets = NULL;
+    size_t offsets_count = 0, offsets_capacity = 0, i;
+    PlaybackFooter footer;
+    bool is_indexed = false;
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    if (fstat(fd, &status) == -1)
+    {
+        close(fd);
+        return false;
+    }
+
+    length = status.st_size;
+
+    if (length == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
 
-        if (fread(&tag, sizeof(int32_t), 1, fp) < 1)
+    end = length;
+
+    if ((length >= sizeof(PlaybackMagic)) &&
+        (memcmp(base, PlaybackMagic, sizeof(PlaybackMagic)) == 0))
+    {
+        PlaybackHeader header;
+
+        memset(&header, 0, sizeof(header));
+        memcpy(&header, base,
+               (length < sizeof(header)) ? length : sizeof(header));
+        begin = sizeof(PlaybackHeader);
+
+        if ((header.index >= begin) && (header.index <= length))
         {
-            break;
+            end = header.index;
         }
 
-        if (fread(&size, sizeof(uint32_t), 1, fp) < 1)
+        if (length >= (begin + sizeof(PlaybackFooter)))
         {
-            break;
+            memcpy(&footer, base + length - sizeof(footer), sizeof(footer));
+
+            is_indexed =
+                (memcmp(footer.magic, PlaybackIndexMagic,
+                        sizeof(PlaybackIndexMagic)) == 0) &&
+                (footer.offset >= begin) &&
+                ((footer.offset == end) || (end == length)) &&
+                ((footer.offset +
+                  footer.groups * (uint64_t)sizeof(PlaybackIndexGroup) +
+                  footer.records * (uint64_t)sizeof(uint64_t) +
+                  sizeof(PlaybackFooter)) == length);
         }
+    }
+
+    if (is_indexed)
+    {
+        const char* groups = base + footer.offset;
+        const char* group_offsets = 
+            groups + footer.groups * sizeof(PlaybackIndexGroup);
+        PlaybackIndexGroup group;
 
-        void* data = malloc(size);
+        end = footer.offset;
 
-        if (fread(data, size, 1, fp) < 1)
+        for (i = 0; i < footer.groups; ++i)
         {
-            free(data);
-            break;
+            memcpy(&group, groups + i * sizeof(group), sizeof(group));
+            if ((i == 0) || (group.begin < base_time))
+            {
+                base_time = group.begin;
+            }
         }
 
-        if (!is_first && !no_playback_delay)
+        offsets = malloc((footer.records + 1) * sizeof(uint64_t));
+        Assert(offsets != NULL);
+        
+        for (i = 0; i < footer.groups; ++i)
         {
-            usleep((time - previous_time) / 1000 /* us/ns */);
+            memcpy(&group, groups + i * sizeof(group), sizeof(group));
+
+            if ((!is_lifecycle_selected(selection, group.tag) &&
+                 (!is_tag_selected(selection, group.tag) ||
+                  !is_time_selected(selection, group.begin - base_time,
+                                    group.end - base_time))) ||
+                ((group.first + (uint64_t)group.count) > footer.records) ||
+                ((offsets_count + group.count) > footer.records))
+            {
+                continue;
+            }
+
+            memcpy(offsets + offsets_count,
+                   group_offsets + group.first * sizeof(uint64_t),
+                   group.count * sizeof(uint64_t));
+            offsets_count += group.count;
         }
 
-        is_first = false;
-        previous_time = time;
+        qsort(offsets, offsets_count, sizeof(uint64_t), compare_offsets);
+    }
+    else
+    {
+        uint64_t offset = begin;
+        PlaybackRecord record;
+
+        madvise((void*)base, length, MADV_SEQUENTIAL);
 
-        if (tag == CBTF_PROTOCOL_TAG_LINKED_OBJECT_GROUP)
+        while ((offset + sizeof(record)) <= end)
         {
-            XDR xdr;
-            CBTF_Protocol_LinkedObjectGroup group;
-            
-            xdrmem_create(&xdr, data, size, XDR_DECODE);
-            memset(&group, 0, sizeof(CBTF_Protocol_LinkedObjectGroup));
-            xdr_CBTF_Protocol_LinkedObjectGroup(&xdr, &group);
-            xdr_destroy(&xdr);
+            memcpy(&record, base + offset, sizeof(record));
 
-            int i;
-            for (i = 0; i < group.linkedobjects.linkedobjects_len; ++i)
+            if ((offset + sizeof(record) + record.size) > end)
             {
-                char** original = &(
-                    group.linkedobjects.linkedobjects_val[i].linked_object.path
-                    );
-                
-                char rehomed[PATH_MAX] = "";
-                sprintf(rehomed, "%s%s", playback_directory, *original);
+                break;
+            }
 
-                free(*original);
-                *original = strdup(rehomed);
+            if (offset == begin)
+            {
+                base_time = record.time;
             }
 
-            free(data);
-            size *= 2; /* Should be more than enough for re-encoding */
-            data = malloc(size);
-            
-            xdrmem_create(&xdr, data, size, XDR_ENCODE);
-            xdr_CBTF_Protocol_LinkedObjectGroup(&xdr, &group);
-            size = xdr_getpos(&xdr);
-            xdr_destroy(&xdr);
+            if (is_lifecycle_selected(selection, record.tag) ||
+                is_tag_selected(selection, record.tag))
+            {
+                if (offsets_count == offsets_capacity)
+                {
+                    offsets_capacity = (offsets_capacity == 0) ?
+                        1024 : (2 * offsets_capacity);
+                    offsets = realloc(offsets,
+                                      offsets_capacity * sizeof(uint64_t));
+                    Assert(offsets != NULL);
+                }
+
+                offsets[offsets_count++] = offset;
+            }
 
-            xdr_free((xdrproc_t)xdr_CBTF_Protocol_LinkedObjectGroup,
-                     (char*)&group);
+            offset += sizeof(record) + record.size;
         }
-        
-        CBTF_MRNet_LW_sendToFrontend(tag, (int)size, data);
-        free(data);
     }
-        
-    Assert(fclose(fp) == 0);
+
+    for (i = 0; i < offsets_count; ++i)
+    {
+        PlaybackRecord record;
+        uint32_t size = 0;
+        const void* data = NULL;
+        void* rehomed_data = NULL;
+
+        if ((offsets[i] < begin) || ((offsets[i] + sizeof(record)) > end))
+        {
+            continue;
+        }
+
+        memcpy(&record, base + offsets[i], sizeof(record));
+
+        if ((offsets[i] + sizeof(record) + record.size) > end)
+        {
+            continue;
+        }
+
+        if (record.time < base_time)
+        {
+            record.time = base_time;
+        }
+
+        if (!is_lifecycle_selected(selection, record.tag) &&
+            !is_time_selected(selection, record.time - base_time,
+                              record.time - base_time))
+        {
+            continue;
+        }
+
+        size = record.size;
+        data = base + offsets[i] + sizeof(record);
+
+        if ((selection->rehome != NULL) &&
+            (record.tag == CBTF_PROTOCOL_TAG_LINKED_OBJECT_GROUP))
+        {
+            rehomed_data = rehome(selection->rehome, &size, data);
+            data = rehomed_data;
+        }
+
+        (*visitor)(context, record.time, record.tag, size, data);
+
+        free(rehomed_data);
+    }
+
+    free(offsets);
+    munmap((void*)base, length);
+    
+    return true;
+}
+
+
+
+/**
+ * Send the specified message from the playback being replayed, after waiting
+ * for its recorded delay (scaled by the playback speed) since the first one.
+ */
+static void replay_message(void* context, uint64_t time, int32_t tag,
+                           uint32_t size, const void* data)
+{
+    PlaybackPacing* pacing = context;
+
+    if (pacing->is_first)
+    {
+        pacing->is_first = false;
+        pacing->first_time = time;
+        clock_gettime(CLOCK_MONOTONIC, &pacing->start);
+    }
+    else if (!no_playback_delay)
+    {
+        uint64_t delay = (uint64_t)((time - pacing->first_time) /
+                                    playback_speed);
+        struct timespec deadline = pacing->start;
+
+        deadline.tv_sec += delay / 1000000000;
+        deadline.tv_nsec += delay % 1000000000;
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                               &deadline, NULL) == EINTR);
+    }
+
+    CBTF_MRNet_LW_sendToFrontend(tag, (int)size, (void*)data);
+}
+
+
+
+/**
+ * Replay the selected messages from the previously configured playback file.
+ */
+static void replay_from_playback()
+{
+    PlaybackSelection selection = playback_selection;
+    PlaybackPacing pacing;
+
+    /* Outside of the replayed ranks only the thread lifecycle is replayed */
+    if (skip_replay)
+    {
+        selection.tags_count = 2;
+        selection.tags[0] = CBTF_PROTOCOL_TAG_ATTACHED_TO_THREADS;
+        selection.tags[1] = CBTF_PROTOCOL_TAG_THREADS_STATE_CHANGED;
+    }
+
+    pacing.is_first = true;
+    Assert(playback_read(playback_file, &selection,
+                         replay_message, &pacing));
 }
 
 
@@ -20,8 +20,39 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
+/** Maximum number of tags in a playback selection. */
+#define PlaybackMaxTags 16
+
+/** Selection of the messages read from a playback file. */
+typedef struct {
+    unsigned tags_count;             /**< Number of selected tags (0 for all) */
+    int32_t tags[PlaybackMaxTags];   /**< Selected tags */
+    uint64_t begin;                  /**< Window begin (ns after first message) */
+    uint64_t end;                    /**< Window end (ns after first message,
+                                          or 0 for none) */
+    const char* rehome;              /**< Directory into which linked objects
+                                          are rehomed, or NULL for none */
+    bool lifecycle;                  /**< Select the thread attach and state
+                                          change messages regardless of the
+                                          tags and window */
+} PlaybackSelection;
+
+/*
+ * Visitor of the messages read from a playback file.
+ *
+ * @param context    Context given to playback_read().
+ * @param time       Time at which the message was recorded.
+ * @param tag        Tag for the message.
+ * @param size       Size (in bytes) of the message.
+ * @param data       Pointer to the message contents. Only valid for the
+ *                   duration of the call.
+ */
+typedef void (*PlaybackVisitor)(void* context, uint64_t time, int32_t tag,
+                                uint32_t size, const void* data);
+
 /*
  * Configure the playback mechanism.
  *
@@ -46,3 +77,34 @@ void playback_configure(uint32_t rank);
  *                message should be squelched because replay is enabled.
  */
 bool playback_intercept(int32_t tag, uint32_t size, void* data);
+
+/*
+ * Finish the recording of a playback.
+ *
+ * Writes the index of the recorded messages at the end of the playback file
+ * and closes it. Called when the MRNet connection is shut down, and at exit.
+ */
+void playback_finish();
+
+/*
+ * Get the playback selection specified by the environment.
+ *
+ * @param selection    Selection to be filled in.
+ */
+void playback_get_selection(PlaybackSelection* selection);
+
+/*
+ * Read the selected messages from a playback file.
+ *
+ * Reads both the original and the indexed playback file formats, visiting
+ * the selected messages in the order they were recorded.
+ *
+ * @param path         Path of the playback file.
+ * @param selection    Selection of the messages to be visited.
+ * @param visitor      Visitor called for each selected message.
+ * @param context      Context passed to the visitor.
+ *
+ * @return             Boolean flag indicating if the file could be read.
+ */
+bool playback_read(const char* path, const PlaybackSelection* selection,
+                   PlaybackVisitor visitor, void* context);
@@ -0,0 +1,121 @@
+/**
+ ** msgrate-mpi.c
+ **
+ ** Measures the small message rate of a halo exchange. Ranks are paired (0 with
+ ** 1, 2 with 3, and so on) and, for a number of iterations, each rank posts a
+ ** window of nonblocking receives and sends to its partner before waiting for
+ ** all of them. Rank 0 reports the number of messages per second and the time
+ ** per message, which is where the per-call cost of the MPI collector wrappers
+ ** shows when the program is run with and without them.
+ **
+ ** Each iteration alternates between MPI_DOUBLE and a derived datatype that is
+ ** created, committed and freed every few iterations with a varying size, so
+ ** that datatype handles get reused. Every message carries its expected length
+ ** and the receiver checks it with MPI_Get_count().
+ **
+ ** Usage: msgrate [iterations] [window] [message size in doubles]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+
+
+static const int DefaultIterations = 10000;  /* Number of iterations        */
+static const int DefaultWindow = 64;         /* Messages in flight per rank */
+static const int DefaultMessageSize = 8;     /* Message size (in doubles)   */
+static const int TypeLifetime = 16;          /* Iterations per derived type */
+
+
+
+int main(int argc, char* argv[])
+{
+    int iterations, window, size, rank, ranks, partner, i, j, count;
+    int errors = 0, total_errors = 0, block = 1;
+    double *send_buffer, *recv_buffer, start, elapsed;
+    MPI_Request* requests;
+    MPI_Status* statuses;
+    MPI_Datatype derived = MPI_DATATYPE_NULL;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+    iterations = (argc > 1) ? atoi(argv[1]) : DefaultIterations;
+    window = (argc > 2) ? atoi(argv[2]) : DefaultWindow;
+    size = (argc > 3) ? atoi(argv[3]) : DefaultMessageSize;
+
+    if((ranks % 2) != 0) {
+	if(rank == 0)
+	    fprintf(stderr, "msgrate needs an even number of ranks\n");
+	MPI_Finalize();
+	return 1;
+    }
+    partner = (rank % 2 == 0) ? rank + 1 : rank - 1;
+
+    send_buffer = malloc(window * size * sizeof(double));
+    recv_buffer = malloc(window * size * sizeof(double));
+    requests = malloc(2 * window * sizeof(MPI_Request));
+    statuses = malloc(2 * window * sizeof(MPI_Status));
+    for(i = 0; i < window * size; ++i)
+	send_buffer[i] = rank;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    start = MPI_Wtime();
+
+    for(i = 0; i < iterations; ++i) {
+	MPI_Datatype datatype = MPI_DOUBLE;
+	int elements = size;
+
+	/* Replace the derived datatype, with a new block size, now and then */
+	if((i % TypeLifetime) == 0) {
+	    if(derived != MPI_DATATYPE_NULL)
+		MPI_Type_free(&derived);
+	    block = (block % size) + 1;
+	    MPI_Type_contiguous(block, MPI_DOUBLE, &derived);
+	    MPI_Type_commit(&derived);
+	}
+	if((i % 2) == 1) {
+	    datatype = derived;
+	    elements = size / block;
+	}
+
+	for(j = 0; j < window; ++j)
+	    MPI_Irecv(&recv_buffer[j * size], elements, datatype, partner, j,
+		      MPI_COMM_WORLD, &requests[j]);
+	for(j = 0; j < window; ++j)
+	    MPI_Isend(&send_buffer[j * size], elements, datatype, partner, j,
+		      MPI_COMM_WORLD, &requests[window + j]);
+	MPI_Waitall(2 * window, requests, statuses);
+
+	for(j = 0; j < window; ++j) {
+	    MPI_Get_count(&statuses[j], datatype, &count);
+	    if(count != elements)
+		errors++;
+	}
+    }
+
+    elapsed = MPI_Wtime() - start;
+    MPI_Reduce(&errors, &total_errors, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if(rank == 0) {
+	double messages = (double)iterations * window * 2;
+	printf("%d ranks, %d iterations, window %d, %d doubles\n",
+	       ranks, iterations, window, size);
+	printf("%.0f messages/s per rank, %.1f ns per message\n",
+	       messages / elapsed, elapsed * 1e9 / messages);
+	if(total_errors > 0)
+	    printf("%d messages received with the wrong count\n", total_errors);
+    }
+
+    if(derived != MPI_DATATYPE_NULL)
+	MPI_Type_free(&derived);
+    free(send_buffer);
+    free(recv_buffer);
+    free(requests);
+    free(statuses);
+
+    MPI_Finalize();
+    return (total_errors > 0) ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Benchmark of merging the address buffers of the children of a CP node, as
+ * done by AddressAggregator::addressBufferHandler. Compares adding each child
+ * buffer one address at a time, merging each child's sorted counts as it
+ * arrives, and the k-way merge of all the children at once.
+ *
+ * Usage: benchAddressMerge [children [addresses-per-child]]
+ *
+ * The defaults of 64 children with 1M addresses each need several GB of
+ * memory; pass smaller sizes on small machines.
+ *
+ */
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include "KrellInstitute/Core/AddressBuffer.hpp"
+
+using namespace KrellInstitute::Core;
+
+
+
+namespace {
+
+    double now()
+    {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+    }
+
+    // Children sample overlapping code, so draw from a shared address range
+    // a few times larger than any single child's buffer.
+    void fillChild(AddressBuffer& buffer, unsigned addresses, unsigned seed)
+    {
+	srand(seed);
+	uint64_t range = 4 * static_cast<uint64_t>(addresses);
+	while (buffer.addresscounts.size() < addresses) {
+	    uint64_t r = (static_cast<uint64_t>(rand()) << 16) ^ rand();
+	    buffer.updateAddressCounts(0x400000 + 4 * (r % range),
+				       1 + (rand() % 100));
+	}
+    }
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    unsigned children = (argc > 1) ? atoi(argv[1]) : 64;
+    unsigned addresses = (argc > 2) ? atoi(argv[2]) : 1000000;
+
+    std::vector<AddressBuffer> buffers(children);
+    for (unsigned i = 0; i < children; ++i) {
+	fillChild(buffers[i], addresses, i + 1);
+    }
+
+    std::cout << children << " children x " << addresses
+	      << " addresses" << std::endl;
+
+    // The previous handler: one tree search and insert per child address.
+    AddressBuffer single;
+    double t = now();
+    for (unsigned i = 0; i < children; ++i) {
+	AddressCounts::const_iterator aci;
+	for (aci = buffers[i].addresscounts.begin();
+	     aci != buffers[i].addresscounts.end(); ++aci) {
+	    single.updateAddressCounts(aci->first.getValue(), aci->second);
+	}
+    }
+    double t_single = now() - t;
+    std::cout << "per address  " << t_single << " s  merged size "
+	      << single.addresscounts.size() << std::endl;
+
+    // A sorted merge of each child as it arrives.
+    AddressBuffer arrival;
+    t = now();
+    for (unsigned i = 0; i < children; ++i) {
+	arrival.updateAddressCounts(buffers[i]);
+    }
+    double t_arrival = now() - t;
+    std::cout << "on arrival   " << t_arrival << " s  merged size "
+	      << arrival.addresscounts.size() << std::endl;
+
+    std::vector<const AddressBuffer*> pointers;
+    for (unsigned i = 0; i < children; ++i) {
+	pointers.push_back(&buffers[i]);
+    }
+    AddressBuffer merged;
+    t = now();
+    merged.updateAddressCounts(pointers);
+    double t_merged = now() - t;
+    std::cout << "k-way merge  " << t_merged << " s  merged size "
+	      << merged.addresscounts.size() << std::endl;
+
+    if ((arrival.addresscounts != single.addresscounts) ||
+	(merged.addresscounts != single.addresscounts)) {
+	std::cerr << "merged address counts differ" << std::endl;
+	return 1;
+    }
+
+    std::cout << "speedup on arrival " << (t_single / t_arrival)
+	      << "x  k-way " << (t_single / t_merged) << "x" << std::endl;
+    return 0;
+}
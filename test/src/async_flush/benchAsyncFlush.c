@@ -0,0 +1,259 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Perturbation benchmark for the background flusher. Runs the force kernel of
+ * test/programs/nbody under a SIGPROF sampler that sends PC sampling blobs the
+ * way the pcsamp collector does, first without sampling, then sending from the
+ * signal handler and finally handing off to the flusher. Reports the run time
+ * of the kernel and the time spent sending inside the signal handler.
+ *
+ * Every sample is given a distinct address so that the sampling buffer fills
+ * as quickly as possible, and a high resolution POSIX timer is used rather
+ * than ITIMER_PROF, which makes this a worst case for the send path.
+ *
+ */
+
+#include <math.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "KrellInstitute/Messages/DataHeader.h"
+#include "KrellInstitute/Messages/PCSamp_data.h"
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+#include "KrellInstitute/Services/Fileio.h"
+#include "KrellInstitute/Services/Send.h"
+
+/* Same problem size as test/programs/nbody on a single processor. */
+#define NumParticles 2500
+#define NumIterations 60
+
+/** Sampling interval (in microseconds). */
+#define SamplingInterval 50
+
+typedef struct {
+    double mass;
+    double x, y, z;
+} particle_t;
+
+typedef enum { None, Sync, Async } mode_t_;
+
+static const char* ModeNames[] = { "none", "sync", "async" };
+
+static particle_t particles[NumParticles];
+static double tfx[NumParticles], tfy[NumParticles], tfz[NumParticles];
+
+/* Sampler state, mirroring the pcsamp collector's double buffering. */
+static mode_t_ mode;
+static CBTF_DataHeader header;
+static CBTF_pcsamp_data blobs[2];
+static CBTF_PCData buffers[2];
+static volatile bool in_flight[2];
+static unsigned current;
+static uint64_t samples, sends, send_ns, max_send_ns;
+
+static uint64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void initialize_data()
+{
+    blobs[current].pc.pc_val = buffers[current].pc;
+    blobs[current].count.count_val = buffers[current].count;
+    buffers[current].addr_begin = ~0UL;
+    buffers[current].addr_end = 0;
+    buffers[current].length = 0;
+    memset(buffers[current].hash_table, 0, sizeof(buffers[current].hash_table));
+}
+
+static void send_samples()
+{
+    uint64_t t = now();
+
+    header.addr_begin = buffers[current].addr_begin;
+    header.addr_end = buffers[current].addr_end;
+    blobs[current].pc.pc_len = buffers[current].length;
+    blobs[current].count.count_len = buffers[current].length;
+
+    if((mode == Async) && !in_flight[current ^ 1] &&
+       CBTF_SendToFlusher(&header, (xdrproc_t)xdr_CBTF_pcsamp_data,
+			  &blobs[current], &in_flight[current])) {
+	current ^= 1;
+    } else {
+	CBTF_Data_Send(&header, (xdrproc_t)xdr_CBTF_pcsamp_data,
+		       &blobs[current]);
+    }
+    initialize_data();
+
+    t = now() - t;
+    send_ns += t;
+    if(t > max_send_ns)
+	max_send_ns = t;
+    sends++;
+}
+
+static void sampler(int sig)
+{
+    samples++;
+    if(CBTF_UpdatePCData(0x400000 + (samples * 16), &buffers[current]))
+	send_samples();
+}
+
+/** Force kernel of test/programs/nbody for a single processor. */
+static double nbody()
+{
+    double f_max = 0.0;
+    int iteration, i, j;
+
+    srand(1);
+    for(i = 0; i < NumParticles; i++) {
+	particles[i].mass = 1.0 + (rand() % 100);
+	particles[i].x = rand() % 10000;
+	particles[i].y = rand() % 10000;
+	particles[i].z = rand() % 10000;
+    }
+
+    for(iteration = 0; iteration < NumIterations; iteration++) {
+	for(i = 0; i < NumParticles; i++) {
+	    double r_min = 1.0E96;
+	    double fx = 0.0, fy = 0.0, fz = 0.0, f;
+
+	    for(j = 0; j < NumParticles; j++) {
+		double rx = particles[i].x - particles[j].x;
+		double ry = particles[i].y - particles[j].y;
+		double rz = particles[i].z - particles[j].z;
+		double r = (rx * rx) + (ry * ry) + (rz * rz);
+
+		if(r > 0.0) {
+		    if(r < r_min)
+			r_min = r;
+		    fx -= particles[j].mass * (rx / r);
+		    fy -= particles[j].mass * (ry / r);
+		    fz -= particles[j].mass * (rz / r);
+		}
+	    }
+
+	    tfx[i] = fx;
+	    tfy[i] = fy;
+	    tfz[i] = fz;
+	    f = sqrt((fx * fx) + (fy * fy) + (fz * fz)) / r_min;
+	    if(f > f_max)
+		f_max = f;
+	}
+	for(i = 0; i < NumParticles; i++) {
+	    particles[i].x += tfx[i] * 1.0E-6;
+	    particles[i].y += tfy[i] * 1.0E-6;
+	    particles[i].z += tfz[i] * 1.0E-6;
+	}
+    }
+
+    return f_max;
+}
+
+static uint64_t run(timer_t timerid, mode_t_ m)
+{
+    struct itimerspec timer;
+    uint64_t t;
+
+    mode = m;
+    current = 0;
+    samples = sends = send_ns = max_send_ns = 0;
+    initialize_data();
+
+    memset(&timer, 0, sizeof(timer));
+    if(mode != None) {
+	timer.it_interval.tv_nsec = SamplingInterval * 1000;
+	timer.it_value.tv_nsec = SamplingInterval * 1000;
+    }
+
+    t = now();
+    timer_settime(timerid, 0, &timer, NULL);
+    nbody();
+    memset(&timer, 0, sizeof(timer));
+    timer_settime(timerid, 0, &timer, NULL);
+    CBTF_DrainFlusher();
+    CBTF_FlushSendToFile();
+    t = now() - t;
+
+    printf("%-5s  %8.3f s  samples %7lu  sends %5lu  "
+	   "mean send %8.1f us  max send %8.1f us\n",
+	   ModeNames[mode], (double)t / 1e9,
+	   (unsigned long)samples, (unsigned long)sends,
+	   sends ? ((double)send_ns / sends) / 1e3 : 0.0,
+	   (double)max_send_ns / 1e3);
+
+    return t;
+}
+
+int main(int argc, char* argv[])
+{
+    char dir[] = "/tmp/cbtf-flusher-XXXXXX";
+    uint64_t t_none, t_sync, t_async;
+    struct sigaction action;
+    struct sigevent event;
+    timer_t timerid;
+
+    if(mkdtemp(dir) == NULL) {
+	perror("mkdtemp");
+	return 1;
+    }
+    setenv("CBTF_RAWDATA_DIR", dir, 1);
+
+    CBTF_InitializeDataHeader(0, 1, &header);
+    header.id = "pcsamp";
+    header.posix_tid = 0;
+    blobs[0].interval = blobs[1].interval = SamplingInterval * 1000;
+    CBTF_SetSendToFile(&header, "pcsamp", "openss-data");
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = sampler;
+    sigaction(SIGPROF, &action, NULL);
+
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if(timer_create(CLOCK_MONOTONIC, &event, &timerid) != 0) {
+	perror("timer_create");
+	return 1;
+    }
+
+    t_none = run(timerid, None);
+    t_sync = run(timerid, Sync);
+
+    if(!CBTF_StartFlusher() || !CBTF_RegisterFlusherThread()) {
+	fprintf(stderr, "could not start the flusher\n");
+	return 1;
+    }
+    t_async = run(timerid, Async);
+    CBTF_UnregisterFlusherThread();
+
+    printf("perturbation: sync %+.2f%%  async %+.2f%%\n",
+	   100.0 * ((double)t_sync - t_none) / t_none,
+	   100.0 * ((double)t_async - t_none) / t_none);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Drives CBTF_Data_Send() through the fileio service in a loop and reports
+ * the number of write system calls per blob and the achieved bandwidth. The
+ * written file is read back to verify that every blob arrived intact.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <libgen.h>
+#include "KrellInstitute/Messages/DataHeader.h"
+#include "KrellInstitute/Messages/PCSamp_data.h"
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+#include "KrellInstitute/Services/Fileio.h"
+#include "KrellInstitute/Services/Send.h"
+
+/** Number of blobs sent by the benchmark. */
+#define NumBlobs 20000
+
+/** Number of PC addresses in each blob. */
+#define PCsPerBlob 64
+
+static uint64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** Number of write system calls made so far by this process. */
+static uint64_t write_syscalls()
+{
+    char line[128];
+    uint64_t value = 0;
+    FILE* fp = fopen("/proc/self/io", "r");
+
+    if(fp == NULL)
+	return 0;
+    while(fgets(line, sizeof(line), fp) != NULL)
+	if(sscanf(line, "syscw: %lu", &value) == 1)
+	    break;
+    fclose(fp);
+    return value;
+}
+
+/** Count the size-prefixed blobs in the file written by the fileio service. */
+static unsigned count_blobs(const char* path, uint64_t* bytes)
+{
+    unsigned blobs = 0;
+    unsigned char prefix[4];
+    FILE* fp = fopen(path, "r");
+
+    *bytes = 0;
+    if(fp == NULL)
+	return 0;
+    while(fread(prefix, 1, sizeof(prefix), fp) == sizeof(prefix)) {
+	unsigned size = ((unsigned)prefix[0] << 24) | (prefix[1] << 16) |
+			(prefix[2] << 8) | prefix[3];
+	if(fseek(fp, size, SEEK_CUR) != 0)
+	    break;
+	*bytes += sizeof(prefix) + size;
+	blobs++;
+    }
+    fclose(fp);
+    return blobs;
+}
+
+int main(int argc, char* argv[])
+{
+    char dir[] = "/tmp/cbtf-fileio-XXXXXX";
+    char path[PATH_MAX];
+    uint64_t pc[PCsPerBlob];
+    uint8_t count[PCsPerBlob];
+    CBTF_DataHeader header;
+    CBTF_pcsamp_data data;
+    uint64_t t, syscalls, bytes;
+    unsigned i, blobs;
+
+    if(mkdtemp(dir) == NULL) {
+	perror("mkdtemp");
+	return 1;
+    }
+    setenv("CBTF_RAWDATA_DIR", dir, 1);
+
+    CBTF_InitializeDataHeader(0, 1, &header);
+    header.id = "pcsamp";
+    header.posix_tid = 0;
+    CBTF_SetSendToFile(&header, "pcsamp", "openss-data");
+
+    for(i = 0; i < PCsPerBlob; ++i) {
+	pc[i] = 0x400000 + (i * 16);
+	count[i] = 1 + (i % 8);
+    }
+    data.interval = 10000000;
+    data.pc.pc_len = PCsPerBlob;
+    data.pc.pc_val = pc;
+    data.count.count_len = PCsPerBlob;
+    data.count.count_val = count;
+
+    syscalls = write_syscalls();
+    t = now();
+    for(i = 0; i < NumBlobs; ++i) {
+	header.time_begin = i;
+	header.time_end = i + 1;
+	CBTF_Data_Send(&header, (xdrproc_t)xdr_CBTF_pcsamp_data, &data);
+    }
+    CBTF_FlushSendToFile();
+    t = now() - t;
+    syscalls = write_syscalls() - syscalls;
+
+    snprintf(path, sizeof(path), "%s/cbtf-rawdata-%s-%lu/%s-%lu.openss-data",
+	     dir, header.host, (unsigned long)header.pid,
+	     basename(strdup(CBTF_GetExecutablePath())), (unsigned long)header.pid);
+    blobs = count_blobs(path, &bytes);
+
+    printf("blobs: %u\n", blobs);
+    printf("write syscalls per blob: %.4f\n", (double)syscalls / NumBlobs);
+    printf("bytes/sec: %.0f\n", (double)bytes / ((double)t / 1e9));
+
+    if(blobs != NumBlobs) {
+	fprintf(stderr, "expected %u blobs in %s, found %u\n",
+		NumBlobs, path, blobs);
+	return 1;
+    }
+
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,493 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * End-to-end benchmark of the collection pipeline, without an MRNet tree.
+ * Replays the cbtf-mrnet-playback-<rank> files of a playback directory (as
+ * recorded with CBTF_MRNET_RECORD_PLAYBACK) as fast as possible through the
+ * send functions of the loopback transport, CBTF_MRNet_Send() and, for the
+ * performance data, CBTF_MRNet_Send_PerfData(), so that every message is
+ * encoded again as the collectors encode it. The messages are delivered by
+ * the loopback transport into an in-process copy of the leaf CP filter network
+ * of the collectors: AddressAggregator, LinkedObjectComponent and
+ * ThreadEventComponent, plus ResolveSymbols when SymbolPlugin was built. Each
+ * recording plays one backend of the leaf CP, and the messages of all of them
+ * are interleaved in the order they were recorded.
+ *
+ * The recordings are read, and their linked objects rehomed to the playback
+ * directory, before the replay starts. Both playback file formats are read,
+ * and the messages can be selected with CBTF_MRNET_PLAYBACK_TAGS and
+ * CBTF_MRNET_PLAYBACK_WINDOW as for the replay of a playback. Reports the messages and performance
+ * data blobs delivered per second and the peak RSS of the process.
+ *
+ * Usage: benchLoopbackPlayback <playback directory> [component directory]
+ *
+ */
+
+#include <sys/resource.h>
+#include <rpc/rpc.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/shared_ptr.hpp>
+#include <KrellInstitute/CBTF/BoostExts.hpp>
+#include <KrellInstitute/CBTF/Component.hpp>
+#include <KrellInstitute/CBTF/Type.hpp>
+#include <KrellInstitute/CBTF/ValueSink.hpp>
+#include <KrellInstitute/CBTF/ValueSource.hpp>
+#include <KrellInstitute/CBTF/Impl/MRNet.hpp>
+
+#include "KrellInstitute/Core/AddressBuffer.hpp"
+#include "KrellInstitute/Messages/Blob.h"
+#include "KrellInstitute/Messages/LinkedObjectEvents.h"
+#include "KrellInstitute/Messages/ThreadEvents.h"
+#include "KrellInstitute/Messages/ToolMessageTags.h"
+#include "KrellInstitute/Services/Loopback.h"
+
+extern "C" {
+#include "KrellInstitute/Messages/DataHeader.h"
+#include "KrellInstitute/Services/MRNet.h"
+#include "playback.h"
+}
+
+using namespace KrellInstitute::CBTF;
+using namespace KrellInstitute::Core;
+
+
+
+namespace {
+
+    double now()
+    {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+    }
+
+    /**
+     * One message of a recording. The contents of performance data are those
+     * of its blob, whose header is decoded once the recordings are read.
+     */
+    struct Message
+    {
+	uint64_t time;
+	int32_t tag;
+	std::vector<char> data;
+	CBTF_DataHeader header;
+	uint32_t offset;
+
+	bool operator<(const Message& other) const
+	{
+	    return time < other.time;
+	}
+    };
+
+    /** Append one message of a recording. */
+    void append(void* context, uint64_t time, int32_t tag, uint32_t size,
+		const void* data)
+    {
+	std::vector<Message>* messages =
+	    static_cast<std::vector<Message>*>(context);
+	const char* contents = static_cast<const char*>(data);
+
+	Message message;
+	message.time = time;
+	message.tag = tag;
+	message.data.assign(contents, contents + size);
+	memset(&message.header, 0, sizeof(message.header));
+	message.offset = 0;
+	messages->push_back(message);
+    }
+
+    /** Contents of a message that are encoded as they are. */
+    struct RawContents
+    {
+	u_int size;
+	char* data;
+    };
+
+    /** Encode the contents of a message as they are. */
+    bool_t xdr_RawContents(XDR* xdrs, RawContents* contents)
+    {
+	return xdr_opaque(xdrs, contents->data, contents->size);
+    }
+
+    /**
+     * Unwrap a recorded performance data message into the contents of its
+     * blob and decode the header with which they begin.
+     *
+     * @return    Boolean flag indicating if the message could be unwrapped.
+     */
+    bool unwrap(Message& message)
+    {
+	CBTF_Protocol_Blob blob;
+	memset(&blob, 0, sizeof(blob));
+
+	XDR xdrs;
+	xdrmem_create(&xdrs, message.data.empty() ? NULL : &message.data[0],
+		      message.data.size(), XDR_DECODE);
+	bool_t decoded = xdr_CBTF_Protocol_Blob(&xdrs, &blob);
+	xdr_destroy(&xdrs);
+	if (!decoded) {
+	    return false;
+	}
+	message.data.assign(blob.data.data_val,
+			    blob.data.data_val + blob.data.data_len);
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_Blob),
+		 reinterpret_cast<char*>(&blob));
+
+	xdrmem_create(&xdrs, message.data.empty() ? NULL : &message.data[0],
+		      message.data.size(), XDR_DECODE);
+	decoded = xdr_CBTF_DataHeader(&xdrs, &message.header);
+	message.offset = xdr_getpos(&xdrs);
+	xdr_destroy(&xdrs);
+	return decoded;
+    }
+
+    /** Send one message through the send functions of the transport. */
+    void send(Message& message)
+    {
+	RawContents contents;
+	contents.size = message.data.size() - message.offset;
+	contents.data = message.data.empty() ? NULL :
+	    &message.data[message.offset];
+
+	if (message.tag == CBTF_PROTOCOL_TAG_PERFORMANCE_DATA) {
+	    CBTF_MRNet_Send_PerfData(
+		&message.header,
+		reinterpret_cast<xdrproc_t>(xdr_RawContents), &contents
+		);
+	} else {
+	    CBTF_MRNet_Send(
+		message.tag,
+		reinterpret_cast<xdrproc_t>(xdr_RawContents), &contents
+		);
+	}
+    }
+
+    /** Free the decoded contents of a message along with the message. */
+    template <typename T>
+    struct XDRDeleter
+    {
+	xdrproc_t xdrproc;
+
+	void operator()(T* message) const
+	{
+	    xdr_free(xdrproc, reinterpret_cast<char*>(message));
+	    delete message;
+	}
+    };
+
+    /** Decode a message as the MRNet converters would. */
+    template <typename T>
+    boost::shared_ptr<T> decode(xdrproc_t xdrproc, uint32_t size,
+				const void* data)
+    {
+	T* message = new T();
+	memset(message, 0, sizeof(T));
+
+	XDR xdrs;
+	xdrmem_create(&xdrs, const_cast<char*>(static_cast<const char*>(data)),
+		      size, XDR_DECODE);
+	(*xdrproc)(&xdrs, message);
+	xdr_destroy(&xdrs);
+
+	XDRDeleter<T> deleter = { xdrproc };
+	return boost::shared_ptr<T>(message, deleter);
+    }
+
+    /** Create a value source connected to an input of a component. */
+    template <typename T>
+    boost::shared_ptr<ValueSource<T> > source(Component::Instance& component,
+					      const std::string& input)
+    {
+	boost::shared_ptr<ValueSource<T> > value = ValueSource<T>::instantiate();
+	Component::Instance value_component =
+	    boost::reinterpret_pointer_cast<Component>(value);
+	Component::connect(value_component, "value", component, input);
+	return value;
+    }
+
+    /** Create a value sink connected to an output of a component. */
+    template <typename T>
+    boost::shared_ptr<ValueSink<T> > sink(Component::Instance& component,
+					  const std::string& output)
+    {
+	boost::shared_ptr<ValueSink<T> > value = ValueSink<T>::instantiate();
+	Component::Instance value_component =
+	    boost::reinterpret_pointer_cast<Component>(value);
+	Component::connect(component, output, value_component, "value");
+	return value;
+    }
+
+    /**
+     * In-process leaf CP filter network, wired as the Filter network of the
+     * collectors' XML, with a value source for each incoming upstream.
+     */
+    struct Network
+    {
+	boost::shared_ptr<ValueSource<
+	    boost::shared_ptr<CBTF_Protocol_AttachedToThreads> > > attached;
+	boost::shared_ptr<ValueSource<
+	    boost::shared_ptr<CBTF_Protocol_ThreadsStateChanged> > > state;
+	boost::shared_ptr<ValueSource<
+	    boost::shared_ptr<CBTF_Protocol_LinkedObjectGroup> > > group;
+	boost::shared_ptr<ValueSource<
+	    boost::shared_ptr<CBTF_Protocol_LoadedLinkedObject> > > loaded;
+	boost::shared_ptr<ValueSource<
+	    boost::shared_ptr<CBTF_Protocol_UnloadedLinkedObject> > > unloaded;
+	boost::shared_ptr<ValueSource<
+	    boost::shared_ptr<CBTF_Protocol_Blob> > > blobs;
+
+	boost::shared_ptr<ValueSink<bool> > finished;
+	boost::shared_ptr<ValueSink<AddressBuffer> > buffer;
+
+	uint64_t delivered;
+	uint64_t delivered_blobs;
+	uint64_t ignored;
+    };
+
+    /** Deliver a message from the loopback transport to the network. */
+    void deliver(void* context, int tag, uint32_t size, const void* data)
+    {
+	Network* network = static_cast<Network*>(context);
+
+	network->delivered++;
+	switch (tag) {
+
+	case CBTF_PROTOCOL_TAG_ATTACHED_TO_THREADS:
+	    *network->attached = decode<CBTF_Protocol_AttachedToThreads>(
+		reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_AttachedToThreads),
+		size, data
+		);
+	    break;
+
+	case CBTF_PROTOCOL_TAG_THREADS_STATE_CHANGED:
+	    *network->state = decode<CBTF_Protocol_ThreadsStateChanged>(
+		reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_ThreadsStateChanged),
+		size, data
+		);
+	    break;
+
+	case CBTF_PROTOCOL_TAG_LINKED_OBJECT_GROUP:
+	    *network->group = decode<CBTF_Protocol_LinkedObjectGroup>(
+		reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_LinkedObjectGroup),
+		size, data
+		);
+	    break;
+
+	case CBTF_PROTOCOL_TAG_LOADED_LINKED_OBJECT:
+	    *network->loaded = decode<CBTF_Protocol_LoadedLinkedObject>(
+		reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_LoadedLinkedObject),
+		size, data
+		);
+	    break;
+
+	case CBTF_PROTOCOL_TAG_UNLOADED_LINKED_OBJECT:
+	    *network->unloaded = decode<CBTF_Protocol_UnloadedLinkedObject>(
+		reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_UnloadedLinkedObject),
+		size, data
+		);
+	    break;
+
+	case CBTF_PROTOCOL_TAG_PERFORMANCE_DATA:
+	    network->delivered_blobs++;
+	    *network->blobs = decode<CBTF_Protocol_Blob>(
+		reinterpret_cast<xdrproc_t>(xdr_CBTF_Protocol_Blob), size, data
+		);
+	    break;
+
+	default:
+	    network->ignored++;
+	    break;
+
+	}
+    }
+
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+	std::cerr << "Usage: " << argv[0]
+		  << " <playback directory> [component directory]" << std::endl;
+	return 1;
+    }
+
+    std::string directory = argv[1];
+    boost::filesystem::path components = (argc > 2) ? argv[2] : COMPONENTDIR;
+
+    // Read every recording up front so that only the pipeline is timed
+    std::vector<Message> messages;
+    unsigned backends = 0;
+    uint64_t bytes = 0;
+
+    PlaybackSelection selection;
+    playback_get_selection(&selection);
+    selection.rehome = directory.c_str();
+
+    boost::filesystem::directory_iterator end;
+    for (boost::filesystem::directory_iterator
+	     i(directory); i != end; ++i) {
+	if (i->path().filename().string().find("cbtf-mrnet-playback-") != 0) {
+	    continue;
+	}
+	if (!playback_read(i->path().string().c_str(), &selection,
+			   append, &messages)) {
+	    std::cerr << "Playback file " << i->path()
+		      << " couldn't be opened!" << std::endl;
+	    return 1;
+	}
+	backends++;
+    }
+
+    if (backends == 0) {
+	std::cerr << "No playback files found in \"" << directory << "\"!"
+		  << std::endl;
+	return 1;
+    }
+
+    std::stable_sort(messages.begin(), messages.end());
+    for (std::vector<Message>::iterator
+	     i = messages.begin(); i != messages.end(); ++i) {
+	bytes += i->data.size();
+	if ((i->tag == CBTF_PROTOCOL_TAG_PERFORMANCE_DATA) && !unwrap(*i)) {
+	    std::cerr << "Performance data recorded at " << i->time
+		      << " couldn't be decoded!" << std::endl;
+	    return 1;
+	}
+    }
+
+    // Make the components behave as on a leaf CP with one child per recording
+    Impl::TheTopologyInfo.IsFrontend = false;
+    Impl::TheTopologyInfo.MaxLeafDistance = 1;
+    Impl::TheTopologyInfo.NumChildren = backends;
+
+    Component::registerPlugin(components / "AggregationPlugin.so");
+    Component::registerPlugin(components / "LinkedObjectPlugin.so");
+    Component::registerPlugin(components / "ThreadPlugin.so");
+
+    Component::Instance aggregator =
+	Component::instantiate(Type("AddressAggregator"));
+    Component::Instance linkedobject =
+	Component::instantiate(Type("LinkedObjectComponent"));
+    Component::Instance threadevent =
+	Component::instantiate(Type("ThreadEventComponent"));
+
+    Component::connect(threadevent, "ThreadNameVecOut",
+		       aggregator, "threadnames");
+    Component::connect(threadevent, "Threads_finished",
+		       aggregator, "finished");
+    Component::connect(threadevent, "ThreadNameVecOut",
+		       linkedobject, "threadnames");
+    Component::connect(threadevent, "Threads_finished",
+		       threadevent, "finished");
+
+    Component::Instance symbols;
+    bool resolve = boost::filesystem::exists(components / "SymbolPlugin.so");
+    if (resolve) {
+	Component::registerPlugin(components / "SymbolPlugin.so");
+	symbols = Component::instantiate(Type("ResolveSymbols"));
+	Component::connect(linkedobject, "linkedobjectvec_out",
+			   symbols, "linkedobjectvecin");
+	Component::connect(aggregator, "Aggregatorout", symbols, "abufferin");
+	Component::connect(aggregator, "ThreadAddrBufMap",
+			   symbols, "threadaddrbufmap");
+	Component::connect(threadevent, "Threads_finished",
+			   symbols, "finished");
+    }
+
+    Network network;
+    network.attached =
+	source<boost::shared_ptr<CBTF_Protocol_AttachedToThreads> >(
+	    threadevent, "threads"
+	    );
+    network.state =
+	source<boost::shared_ptr<CBTF_Protocol_ThreadsStateChanged> >(
+	    threadevent, "threadstate"
+	    );
+    network.group =
+	source<boost::shared_ptr<CBTF_Protocol_LinkedObjectGroup> >(
+	    linkedobject, "group"
+	    );
+    network.loaded =
+	source<boost::shared_ptr<CBTF_Protocol_LoadedLinkedObject> >(
+	    linkedobject, "loaded"
+	    );
+    network.unloaded =
+	source<boost::shared_ptr<CBTF_Protocol_UnloadedLinkedObject> >(
+	    linkedobject, "unloaded"
+	    );
+    network.blobs =
+	source<boost::shared_ptr<CBTF_Protocol_Blob> >(
+	    aggregator, "cbtf_protocol_blob"
+	    );
+    network.finished = sink<bool>(threadevent, "Threads_finished");
+    network.buffer = sink<AddressBuffer>(aggregator, "Aggregatorout");
+    network.delivered = 0;
+    network.delivered_blobs = 0;
+    network.ignored = 0;
+
+    CBTF_Loopback_SetHandler(deliver, &network);
+
+    double t = now();
+    for (std::vector<Message>::iterator
+	     i = messages.begin(); i != messages.end(); ++i) {
+	send(*i);
+    }
+    t = now() - t;
+
+    CBTF_Loopback_SetHandler(NULL, NULL);
+
+    for (std::vector<Message>::iterator
+	     i = messages.begin(); i != messages.end(); ++i) {
+	xdr_free(reinterpret_cast<xdrproc_t>(xdr_CBTF_DataHeader),
+		 reinterpret_cast<char*>(&i->header));
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    bool finished = *network.finished;
+    AddressBuffer buffer = *network.buffer;
+
+    printf("%u backends, %lu messages (%lu blobs, %.1f MB)%s\n", backends,
+	   static_cast<unsigned long>(network.delivered),
+	   static_cast<unsigned long>(network.delivered_blobs), bytes / 1e6,
+	   resolve ? "" : ", without ResolveSymbols");
+    printf("replay %8.3f s  %10.0f messages/s  %10.0f blobs/s  %8.1f MB/s\n",
+	   t, network.delivered / t, network.delivered_blobs / t,
+	   bytes / 1e6 / t);
+    printf("peak RSS %8.1f MB\n", usage.ru_maxrss / 1024.0);
+    printf("%lu unique addresses, %lu messages ignored, threads %s\n",
+	   static_cast<unsigned long>(buffer.addresscounts.size()),
+	   static_cast<unsigned long>(network.ignored),
+	   finished ? "finished" : "NOT FINISHED");
+
+    return (network.delivered == messages.size()) ? 0 : 1;
+}
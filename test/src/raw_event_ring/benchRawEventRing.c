@@ -0,0 +1,263 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Benchmark for the raw event rings. Makes a stream of simulated IO calls and
+ * records an event for each of them the way the io collector does, first not
+ * at all, then inline (stack trace deduplication, event buffering, encoding
+ * and sending on the traced thread) and finally through the raw event ring of
+ * the traced thread. Reports the mean and maximum time added to each call on
+ * the traced thread. The stack traces are synthetic and are not unwound, so
+ * that only the cost of recording is measured.
+ *
+ * Also checks that the encoder thread encoded every event, in order.
+ *
+ * Usage: benchRawEventRing [events]
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "KrellInstitute/Messages/DataHeader.h"
+#include "KrellInstitute/Messages/IO_data.h"
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+#include "KrellInstitute/Services/Fileio.h"
+#include "KrellInstitute/Services/Send.h"
+
+/* Same buffer sizes as the io collector. */
+#define StackTraceBufferSize (CBTF_BlobSizeFactor * 384)
+#define StackTraceHashTableSize \
+	CBTF_StackTraceHashTableSize(StackTraceBufferSize)
+#define EventBufferSize (CBTF_BlobSizeFactor * 415)
+
+/** Number of distinct call sites and their stack depth. */
+#define NumCallSites 16
+#define StackDepth 24
+
+/** Number of iterations of the busy loop simulating the IO call itself. */
+#define CallWork 500
+
+typedef enum { None, Inline, Raw } mode_t_;
+
+static const char* ModeNames[] = { "none", "inline", "raw" };
+
+/** Tracing buffer, as in the io collector. */
+typedef struct {
+    CBTF_DataHeader header;
+    CBTF_io_trace_data data;
+    void* handle;
+    uint64_t stacktraces[StackTraceBufferSize];
+    unsigned hash_table[StackTraceHashTableSize];
+    CBTF_io_event events[EventBufferSize];
+    uint64_t last_time;
+    uint64_t encoded;
+    bool in_order;
+} Trace;
+
+static Trace trace;
+static uint64_t callsites[NumCallSites][StackDepth];
+
+static uint64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void initialize_trace(Trace* t)
+{
+    t->data.stacktraces.stacktraces_val = t->stacktraces;
+    t->data.stacktraces.stacktraces_len = 0;
+    t->data.events.events_val = t->events;
+    t->data.events.events_len = 0;
+    memset(t->hash_table, 0, sizeof(t->hash_table));
+}
+
+static void send_trace(Trace* t, bool other_thread)
+{
+    if(other_thread)
+	CBTF_Data_SendToFileHandle(t->handle, &t->header,
+				   (xdrproc_t)xdr_CBTF_io_trace_data, &t->data);
+    else
+	CBTF_Data_Send(&t->header, (xdrproc_t)xdr_CBTF_io_trace_data, &t->data);
+    initialize_trace(t);
+}
+
+/** Add one event to a tracing buffer, as io_record_event() does. */
+static void add_event(Trace* t, uint64_t hash, const uint64_t* stacktrace,
+		      unsigned stacktrace_size, uint64_t start, uint64_t stop,
+		      bool other_thread)
+{
+    unsigned entry = 0, i;
+
+    if(!CBTF_FindHashedStackTrace(hash, stacktrace, stacktrace_size,
+				  t->stacktraces,
+				  t->data.stacktraces.stacktraces_len, NULL,
+				  t->hash_table, StackTraceHashTableSize,
+				  &entry)) {
+	if((t->data.stacktraces.stacktraces_len + stacktrace_size + 1) >=
+	   StackTraceBufferSize)
+	    send_trace(t, other_thread);
+	entry = t->data.stacktraces.stacktraces_len;
+	for(i = 0; i < stacktrace_size; ++i)
+	    t->stacktraces[entry + i] = stacktrace[i];
+	t->stacktraces[entry + stacktrace_size] = 0;
+	t->data.stacktraces.stacktraces_len += (stacktrace_size + 1);
+	CBTF_AddHashedStackTrace(hash, stacktrace_size, entry,
+				 t->hash_table, StackTraceHashTableSize);
+    }
+
+    t->events[t->data.events.events_len].start_time = start;
+    t->events[t->data.events.events_len].stop_time = stop;
+    t->events[t->data.events.events_len].stacktrace = entry;
+    t->data.events.events_len++;
+    if(t->data.events.events_len == EventBufferSize)
+	send_trace(t, other_thread);
+}
+
+/** Encoder of the traced thread's raw events. */
+static void encode(void* context, const CBTF_RawEvent* event)
+{
+    Trace* t = context;
+
+    if(event->time != t->last_time + 1)
+	t->in_order = false;
+    t->last_time = event->time;
+    t->encoded++;
+
+    add_event(t, event->stacktrace_hash, event->stacktrace,
+	      event->stacktrace_size, event->time, event->args[0], true);
+}
+
+/** Simulate the work done by an IO call. */
+static void call()
+{
+    volatile unsigned i;
+
+    for(i = 0; i < CallWork; ++i);
+}
+
+/** Record the event of one call. */
+static void record(mode_t_ mode, uint64_t i)
+{
+    const uint64_t* stacktrace = callsites[i % NumCallSites];
+    CBTF_RawEvent* raw;
+
+    switch(mode) {
+
+    case None:
+	break;
+
+    case Inline:
+	add_event(&trace, CBTF_HashStackTrace(stacktrace, StackDepth),
+		  stacktrace, StackDepth, i, i, false);
+	break;
+
+    case Raw:
+	raw = CBTF_BeginRawEvent();
+	memcpy(raw->stacktrace, stacktrace, StackDepth * sizeof(uint64_t));
+	raw->stacktrace_size = StackDepth;
+	raw->function = stacktrace[0];
+	raw->time = i;
+	raw->args[0] = i;
+	CBTF_CommitRawEvent();
+	break;
+
+    }
+}
+
+static uint64_t run(mode_t_ mode, uint64_t events, uint64_t baseline)
+{
+    uint64_t i, t, e, max = 0;
+
+    initialize_trace(&trace);
+    trace.last_time = 0;
+    trace.encoded = 0;
+    trace.in_order = true;
+    if((mode == Raw) && !CBTF_RegisterRawEventThread(encode, &trace)) {
+	fprintf(stderr, "could not register with the encoder\n");
+	exit(1);
+    }
+
+    t = now();
+    for(i = 1; i <= events; ++i) {
+	e = now();
+	call();
+	record(mode, i);
+	e = now() - e;
+	if(e > max)
+	    max = e;
+    }
+    if(mode == Raw)
+	CBTF_UnregisterRawEventThread();
+    if(trace.data.events.events_len > 0)
+	send_trace(&trace, false);
+    t = now() - t;
+
+    printf("%-6s  %8.3f s  added %8.1f ns/call  max call %8.1f us\n",
+	   ModeNames[mode], (double)t / 1e9,
+	   ((double)t - (double)baseline) / events, (double)max / 1e3);
+
+    return t;
+}
+
+int main(int argc, char* argv[])
+{
+    char dir[] = "/tmp/cbtf-rawevents-XXXXXX";
+    uint64_t events = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    uint64_t t_none;
+    unsigned i, j;
+
+    if(mkdtemp(dir) == NULL) {
+	perror("mkdtemp");
+	return 1;
+    }
+    setenv("CBTF_RAWDATA_DIR", dir, 1);
+
+    srand(1);
+    for(i = 0; i < NumCallSites; ++i)
+	for(j = 0; j < StackDepth; ++j)
+	    callsites[i][j] = 0x400000 + (rand() % 0x100000);
+
+    CBTF_InitializeDataHeader(0, 1, &trace.header);
+    trace.header.id = "io";
+    trace.header.posix_tid = 0;
+    CBTF_SetSendToFile(&trace.header, "io", "openss-data");
+    trace.handle = CBTF_OpenSendToFileHandle();
+
+    t_none = run(None, events, 0);
+    run(Inline, events, t_none);
+
+    if(!CBTF_StartRawEventEncoder()) {
+	fprintf(stderr, "could not start the encoder\n");
+	return 1;
+    }
+    run(Raw, events, t_none);
+    CBTF_CloseSendToFileHandle(trace.handle);
+    CBTF_FlushSendToFile();
+
+    printf("raw events encoded %lu/%lu%s\n", (unsigned long)trace.encoded,
+	   (unsigned long)events, trace.in_order ? "" : "  OUT OF ORDER");
+
+    return ((trace.encoded == events) && trace.in_order) ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Unit test for CBTF_UpdateStackTraceBuffer(). Fills the stack trace sampling
+ * buffer used by the usertime and hwctime collectors with known stack traces
+ * and checks the resulting counts, the count limit, that only exact matches
+ * are merged and that a full buffer is reported without being overrun. A
+ * pseudo-random sample stream is then checked against a linear reference.
+ *
+ * Exits with a non-zero status if any check fails.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+
+#define Check(expr)							\
+    do {								\
+	if(!(expr)) {							\
+	    fprintf(stderr, "%s:%d: check failed: %s\n",		\
+		    __FILE__, __LINE__, #expr);				\
+	    failures++;							\
+	}								\
+    } while(0)
+
+static unsigned failures = 0;
+
+/* Extra entries past the end of the buffer that must never be written */
+static struct {
+    CBTF_StackTraceData buffer;
+    uint64_t guard[CBTF_ST_MAXFRAMES];
+} data;
+
+static void initialize_data()
+{
+    data.buffer.addr_begin = ~0;
+    data.buffer.addr_end = 0;
+    data.buffer.length = 0;
+    memset(data.buffer.hash_table, 0, sizeof(data.buffer.hash_table));
+}
+
+/** Build a deterministic stack trace of the given size. */
+static void make_stack(unsigned id, unsigned size, uint64_t* stacktrace)
+{
+    unsigned i;
+    for(i = 0; i < size; ++i)
+	stacktrace[i] = 0x400000 + (id * 0x1000) + (i * 0x10);
+}
+
+/** Find the count of the stack trace by linear search, -1 if not present. */
+static int linear_count(const uint64_t* stacktrace, unsigned size,
+			unsigned instance)
+{
+    unsigned entry, i;
+
+    for(entry = 0; entry < data.buffer.length; ++entry) {
+	if(data.buffer.count[entry] == 0)
+	    continue;
+	if((entry + size) > data.buffer.length)
+	    continue;
+	if(((entry + size) < data.buffer.length) &&
+	   (data.buffer.count[entry + size] == 0))
+	    continue;
+	for(i = 0; i < size; ++i)
+	    if(data.buffer.stacktraces[entry + i] != stacktrace[i])
+		break;
+	if((i == size) && (instance-- == 0))
+	    return data.buffer.count[entry];
+    }
+
+    return -1;
+}
+
+static void test_counts()
+{
+    uint64_t a[3], b[8];
+    unsigned i;
+
+    initialize_data();
+    make_stack(1, 3, a);
+    make_stack(2, 8, b);
+
+    for(i = 0; i < 10; ++i)
+	Check(!CBTF_UpdateStackTraceBuffer(a, 3, &data.buffer));
+    Check(data.buffer.length == 3);
+    Check(linear_count(a, 3, 0) == 10);
+
+    /* Interleaving another stack does not disturb the first */
+    for(i = 0; i < 4; ++i) {
+	Check(!CBTF_UpdateStackTraceBuffer(b, 8, &data.buffer));
+	Check(!CBTF_UpdateStackTraceBuffer(a, 3, &data.buffer));
+    }
+    Check(data.buffer.length == 11);
+    Check(linear_count(a, 3, 0) == 14);
+    Check(linear_count(b, 8, 0) == 4);
+
+    /* The address range covers every frame */
+    Check(data.buffer.addr_begin == a[0]);
+    Check(data.buffer.addr_end == b[7]);
+
+    /* Empty stacks are ignored */
+    Check(!CBTF_UpdateStackTraceBuffer(a, 0, &data.buffer));
+    Check(data.buffer.length == 11);
+}
+
+static void test_exact_match()
+{
+    uint64_t a[6];
+
+    initialize_data();
+    make_stack(3, 6, a);
+
+    /* Prefixes and extensions of a stack are distinct stacks */
+    Check(!CBTF_UpdateStackTraceBuffer(a, 4, &data.buffer));
+    Check(!CBTF_UpdateStackTraceBuffer(a, 5, &data.buffer));
+    Check(!CBTF_UpdateStackTraceBuffer(a, 6, &data.buffer));
+    Check(!CBTF_UpdateStackTraceBuffer(a, 5, &data.buffer));
+    Check(data.buffer.length == 15);
+    Check(linear_count(a, 4, 0) == 1);
+    Check(linear_count(a, 5, 0) == 2);
+    Check(linear_count(a, 6, 0) == 1);
+}
+
+static void test_count_limit()
+{
+    uint64_t a[5];
+    unsigned i;
+
+    initialize_data();
+    make_stack(4, 5, a);
+
+    for(i = 0; i < 600; ++i)
+	Check(!CBTF_UpdateStackTraceBuffer(a, 5, &data.buffer));
+    Check(data.buffer.length == 15);
+    Check(linear_count(a, 5, 0) == 255);
+    Check(linear_count(a, 5, 1) == 255);
+    Check(linear_count(a, 5, 2) == 90);
+}
+
+static void test_full()
+{
+    uint64_t a[7], snapshot[CBTF_ST_BufferSize];
+    unsigned id, length;
+
+    initialize_data();
+    memset(data.guard, 0, sizeof(data.guard));
+
+    /* Fill with distinct 7 frame stacks until the buffer reports full */
+    for(id = 0; ; ++id) {
+	make_stack(100 + id, 7, a);
+	if(CBTF_UpdateStackTraceBuffer(a, 7, &data.buffer))
+	    break;
+    }
+    Check(id == (CBTF_ST_BufferSize / 7));
+    Check(data.buffer.length == (id * 7));
+
+    /* A full buffer is left untouched but existing stacks still count */
+    length = data.buffer.length;
+    memcpy(snapshot, data.buffer.stacktraces, sizeof(snapshot));
+    Check(CBTF_UpdateStackTraceBuffer(a, 7, &data.buffer));
+    Check(data.buffer.length == length);
+    Check(memcmp(snapshot, data.buffer.stacktraces, sizeof(snapshot)) == 0);
+    make_stack(100, 7, a);
+    Check(!CBTF_UpdateStackTraceBuffer(a, 7, &data.buffer));
+    Check(linear_count(a, 7, 0) == 2);
+
+    /* A stack that exactly fills the remaining entries is accepted */
+    make_stack(999, CBTF_ST_BufferSize - length, a);
+    Check(!CBTF_UpdateStackTraceBuffer(a, CBTF_ST_BufferSize - length,
+				       &data.buffer));
+    Check(data.buffer.length == CBTF_ST_BufferSize);
+    Check(CBTF_UpdateStackTraceBuffer(a, 1, &data.buffer));
+
+    /* Nothing was written past the end of the buffer */
+    for(id = 0; id < CBTF_ST_MAXFRAMES; ++id)
+	Check(data.guard[id] == 0);
+
+    /* After the caller flushes the same stack can be added */
+    initialize_data();
+    Check(!CBTF_UpdateStackTraceBuffer(a, 1, &data.buffer));
+    Check(data.buffer.length == 1);
+}
+
+static void test_stream()
+{
+    uint64_t stacks[64][CBTF_ST_MAXFRAMES];
+    unsigned sizes[64], expected[64], total[64];
+    unsigned seed = 12345, flushes = 0, i, j, k;
+
+    memset(total, 0, sizeof(total));
+    for(i = 0; i < 64; ++i) {
+	sizes[i] = 1 + (i % CBTF_ST_MAXFRAMES);
+	make_stack(i % 40, sizes[i], stacks[i]);
+    }
+
+    initialize_data();
+    memset(expected, 0, sizeof(expected));
+    for(i = 0; i < 200000; ++i) {
+	seed = (seed * 1103515245) + 12345;
+	k = (seed >> 16) % 64;
+
+	if(CBTF_UpdateStackTraceBuffer(stacks[k], sizes[k], &data.buffer)) {
+	    /* Flush, checking every stack against the linear reference */
+	    for(j = 0; j < 64; ++j) {
+		unsigned instance, sum = 0;
+		int count;
+		for(instance = 0;
+		    (count = linear_count(stacks[j], sizes[j], instance)) > 0;
+		    ++instance)
+		    sum += count;
+		Check(sum == expected[j]);
+		total[j] += sum;
+	    }
+	    flushes++;
+	    initialize_data();
+	    memset(expected, 0, sizeof(expected));
+	    Check(!CBTF_UpdateStackTraceBuffer(stacks[k], sizes[k],
+					       &data.buffer));
+	}
+	expected[k]++;
+    }
+    Check(flushes > 0);
+}
+
+int main(int argc, char* argv[])
+{
+    test_counts();
+    test_exact_match();
+    test_count_limit();
+    test_full();
+    test_stream();
+
+    if(failures > 0) {
+	printf("%u checks failed\n", failures);
+	return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Microbenchmark comparing the per-event cost of the linear stack trace search
+ * formerly used by the tracing collectors against CBTF_FindStackTrace() at
+ * several tracing buffer fill levels.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "KrellInstitute/Services/Common.h"
+#include "KrellInstitute/Services/Data.h"
+
+/** Same tracing buffer sizing as the io, mpi, mem and pthreads collectors. */
+#define StackTraceBufferSize (CBTF_BlobSizeFactor * 384)
+#define StackTraceHashTableSize \
+	CBTF_StackTraceHashTableSize(StackTraceBufferSize)
+#define MaxFramesPerStackTrace 64
+
+/** Number of lookups timed for each fill level. */
+#define Iterations 200000
+
+static uint64_t buffer[StackTraceBufferSize];
+static unsigned buffer_len = 0;
+static unsigned hash_table[StackTraceHashTableSize];
+
+/** Start of each stack trace stored in the buffer and its size. */
+static unsigned stack_start[StackTraceBufferSize];
+static unsigned stack_size[StackTraceBufferSize];
+static unsigned num_stacks = 0;
+
+static uint64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** The linear search that the tracing collectors used before. */
+static unsigned linear_search(const uint64_t* stacktrace,
+			      unsigned stacktrace_size)
+{
+    unsigned start, i;
+
+    for(start = 0, i = 0;
+	(i < stacktrace_size) && ((start + i) < buffer_len);
+	++i)
+	if(stacktrace[i] != buffer[start + i]) {
+	    for(start += i; (buffer[start] != 0) && (start < buffer_len); ++start);
+	    ++start;
+	    i = 0;
+	}
+
+    return (i == stacktrace_size) ? start : ~0U;
+}
+
+/** Fill the tracing buffer with unique stack traces to the given percent. */
+static void fill_buffer(unsigned percent)
+{
+    unsigned target = (StackTraceBufferSize * percent) / 100;
+    unsigned i;
+
+    memset(buffer, 0, sizeof(buffer));
+    memset(hash_table, 0, sizeof(hash_table));
+    buffer_len = 0;
+    num_stacks = 0;
+
+    srand(percent);
+    while(buffer_len < target) {
+	unsigned size = 8 + (rand() % 24);
+	if((buffer_len + size + 1) >= StackTraceBufferSize)
+	    break;
+
+	/* Share the outer frames, as real call paths from main() do */
+	for(i = 0; i < size; ++i)
+	    buffer[buffer_len + i] = (i < size - 4) ?
+		0x400000 + (i * 0x40) : 0x7f0000000000ULL + (rand() & 0xfffff0);
+	buffer[buffer_len + size] = 0;
+
+	CBTF_AddStackTrace(&buffer[buffer_len], size, buffer_len,
+			   hash_table, StackTraceHashTableSize);
+	stack_start[num_stacks] = buffer_len;
+	stack_size[num_stacks] = size;
+	num_stacks++;
+	buffer_len += size + 1;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    static const unsigned fill[] = { 10, 50, 90 };
+    uint64_t stacktrace[MaxFramesPerStackTrace];
+    unsigned f, n, entry;
+
+    printf("%-6s %-8s %14s %14s\n", "fill", "stacks", "linear ns/evt", "hash ns/evt");
+
+    for(f = 0; f < sizeof(fill) / sizeof(fill[0]); ++f) {
+	uint64_t t, linear_ns, hash_ns;
+	unsigned errors = 0;
+
+	fill_buffer(fill[f]);
+
+	t = now();
+	for(n = 0; n < Iterations; ++n) {
+	    unsigned s = (n * 7919) % num_stacks;
+	    memcpy(stacktrace, &buffer[stack_start[s]],
+		   stack_size[s] * sizeof(uint64_t));
+	    if(linear_search(stacktrace, stack_size[s]) != stack_start[s])
+		errors++;
+	}
+	linear_ns = now() - t;
+
+	t = now();
+	for(n = 0; n < Iterations; ++n) {
+	    unsigned s = (n * 7919) % num_stacks;
+	    memcpy(stacktrace, &buffer[stack_start[s]],
+		   stack_size[s] * sizeof(uint64_t));
+	    if(!CBTF_FindStackTrace(stacktrace, stack_size[s],
+				    buffer, buffer_len, NULL,
+				    hash_table, StackTraceHashTableSize,
+				    &entry) || (entry != stack_start[s]))
+		errors++;
+	}
+	hash_ns = now() - t;
+
+	printf("%3u%%   %-8u %14.1f %14.1f\n", fill[f], num_stacks,
+	       (double)linear_ns / Iterations, (double)hash_ns / Iterations);
+
+	if(errors > 0) {
+	    fprintf(stderr, "%u lookups returned the wrong stack trace\n", errors);
+	    return 1;
+	}
+    }
+
+    return 0;
+}
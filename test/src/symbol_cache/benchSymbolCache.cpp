@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+//
+// This library is free software; you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation; either version 2.1 of the License, or (at your option)
+// any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation, Inc.,
+// 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+////////////////////////////////////////////////////////////////////////////////
+
+/** @file
+ *
+ * Benchmark for the symbol cache. Resolves sampled addresses in linked objects
+ * with SymtabAPISymbols, first against an empty cache directory (cold: the
+ * linked object is parsed and its cache entry written) and then against the
+ * populated one (warm: the entry is mapped), and reports both times.
+ *
+ * The linked objects are those mapped into a running test/programs binary,
+ * found in /proc/<pid>/maps, or else those mapped into this benchmark (libc,
+ * libstdc++, the Dyninst and CBTF libraries). Each of them is given a number
+ * of uniformly distributed sampled addresses.
+ *
+ * Also parses all of the linked objects, without a cache, on one and then on
+ * several worker threads, as ResolveSymbols does, and reports both times. Each
+ * runs in a child process so that SymtabAPI hasn't already opened the objects.
+ *
+ * Usage: benchSymbolCache [pid [samples [threads]]]
+ *
+ */
+
+#include "KrellInstitute/Core/AddressBuffer.hpp"
+#include "KrellInstitute/Core/LinkedObjectEntry.hpp"
+#include "KrellInstitute/Core/SymbolTable.hpp"
+#include "KrellInstitute/Core/SymtabAPISymbols.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace KrellInstitute::Core;
+
+namespace {
+
+    double now()
+    {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+    }
+
+    /** Find the address range of each file mapped into a process. */
+    std::map<std::string, AddressRange> getMappedObjects(const std::string& pid)
+    {
+	std::map<std::string, std::pair<uint64_t, uint64_t> > ranges;
+	std::ifstream maps(("/proc/" + pid + "/maps").c_str());
+	std::string line;
+	while (std::getline(maps, line)) {
+	    std::istringstream fields(line);
+	    std::string range, perms, offset, device, inode, path;
+	    fields >> range >> perms >> offset >> device >> inode >> path;
+	    if (path.empty() || (path[0] != '/')) {
+		continue;
+	    }
+
+	    uint64_t begin = strtoull(range.c_str(), NULL, 16);
+	    uint64_t end = strtoull(range.substr(range.find('-') + 1).c_str(),
+				    NULL, 16);
+	    if (ranges.find(path) == ranges.end()) {
+		ranges[path] = std::make_pair(begin, end);
+	    } else {
+		ranges[path].first = std::min(ranges[path].first, begin);
+		ranges[path].second = std::max(ranges[path].second, end);
+	    }
+	}
+
+	std::map<std::string, AddressRange> objects;
+	for (std::map<std::string, std::pair<uint64_t, uint64_t> >::iterator
+		 i = ranges.begin(); i != ranges.end(); ++i) {
+	    objects.insert(std::make_pair(
+		i->first, AddressRange(i->second.first, i->second.second)
+		));
+	}
+	return objects;
+    }
+
+    double resolve(const LinkedObjectEntry& lo, const AddressBuffer& abuffer,
+		   unsigned& functions, unsigned& statements)
+    {
+	SymtabAPISymbols symbols;
+	SymbolTable st(lo.getAddressRange());
+
+	double t = now();
+	symbols.getSymbols(abuffer, lo, st);
+	t = now() - t;
+
+	functions = st.getFunctions().size();
+	statements = st.getStatements().size();
+	return t;
+    }
+
+    /** Linked object and the addresses sampled within it. */
+    struct Sampled
+    {
+	LinkedObjectEntry lo;
+	AddressBuffer abuffer;
+    };
+
+    /**
+     * Resolve the next unresolved linked object until there are none left,
+     * as ResolveSymbols::resolveWorker does.
+     */
+    void parseWorker(const std::vector<Sampled>& sampled,
+		     unsigned& next, boost::mutex& next_mutex)
+    {
+	SymtabAPISymbols symbols;
+	while (true) {
+	    unsigned n;
+	    {
+		boost::mutex::scoped_lock lock(next_mutex);
+		if (next >= sampled.size()) {
+		    return;
+		}
+		n = next++;
+	    }
+	    SymbolTable st(sampled[n].lo.getAddressRange());
+	    symbols.getSymbols(sampled[n].abuffer, sampled[n].lo, st);
+	}
+    }
+
+    /**
+     * Time parsing every linked object, without a cache, on the given number
+     * of worker threads. Runs in a child process so that none of the linked
+     * objects was already opened by SymtabAPI.
+     */
+    double parse(const std::vector<Sampled>& sampled, unsigned threads)
+    {
+	int fds[2];
+	if (pipe(fds) != 0) {
+	    return -1.0;
+	}
+
+	pid_t child = fork();
+	if (child == 0) {
+	    setenv("CBTF_SYMBOL_CACHE_DIR", "", 1);
+
+	    unsigned next = 0;
+	    boost::mutex next_mutex;
+	    boost::thread_group workers;
+	    double t = now();
+	    for (unsigned i = 0; i < threads; ++i) {
+		workers.create_thread(boost::bind(parseWorker,
+						  boost::cref(sampled),
+						  boost::ref(next),
+						  boost::ref(next_mutex)));
+	    }
+	    workers.join_all();
+	    t = now() - t;
+
+	    ssize_t written = write(fds[1], &t, sizeof(t));
+	    _exit((written == sizeof(t)) ? 0 : 1);
+	}
+
+	double t = -1.0;
+	close(fds[1]);
+	if ((child < 0) || (read(fds[0], &t, sizeof(t)) != sizeof(t))) {
+	    t = -1.0;
+	}
+	close(fds[0]);
+	if (child > 0) {
+	    waitpid(child, NULL, 0);
+	}
+	return t;
+    }
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string pid = (argc > 1) ? argv[1] : "self";
+    unsigned samples = (argc > 2) ? atoi(argv[2]) : 10000;
+    unsigned threads = (argc > 3) ? atoi(argv[3]) :
+	boost::thread::hardware_concurrency();
+    if (threads < 1) {
+	threads = 1;
+    }
+
+    char dir[] = "/tmp/cbtf-symbols-XXXXXX";
+    if (mkdtemp(dir) == NULL) {
+	perror("mkdtemp");
+	return 1;
+    }
+    setenv("CBTF_SYMBOL_CACHE_DIR", dir, 1);
+
+    std::map<std::string, AddressRange> objects = getMappedObjects(pid);
+
+    std::vector<Sampled> sampled(objects.size());
+    srand(1);
+
+    unsigned n = 0;
+    for (std::map<std::string, AddressRange>::iterator
+	     i = objects.begin(); i != objects.end(); ++i, ++n) {
+	sampled[n].lo.path = i->first;
+	sampled[n].lo.addr_begin = i->second.getBegin();
+	sampled[n].lo.addr_end = i->second.getEnd();
+
+	uint64_t width = i->second.getEnd() - i->second.getBegin();
+	for (unsigned s = 0; s < samples; ++s) {
+	    uint64_t r = (static_cast<uint64_t>(rand()) << 31) ^ rand();
+	    sampled[n].abuffer.updateAddressCounts(
+		i->second.getBegin().getValue() + (r % width), 1
+		);
+	}
+    }
+
+    double serial = parse(sampled, 1);
+    double parallel = parse(sampled, threads);
+    printf("parse %u objects  1 thread %.3f s  %u threads %.3f s  "
+	   "speedup %.1fx\n",
+	   static_cast<unsigned>(sampled.size()), serial, threads, parallel,
+	   (parallel > 0.0) ? (serial / parallel) : 0.0);
+
+    double cold_total = 0.0, warm_total = 0.0;
+    bool mismatch = false;
+
+    for (std::vector<Sampled>::const_iterator
+	     i = sampled.begin(); i != sampled.end(); ++i) {
+	const LinkedObjectEntry& lo = i->lo;
+	const AddressBuffer& abuffer = i->abuffer;
+
+	unsigned cold_functions, cold_statements;
+	unsigned warm_functions, warm_statements;
+	double cold = resolve(lo, abuffer, cold_functions, cold_statements);
+	double warm = resolve(lo, abuffer, warm_functions, warm_statements);
+	cold_total += cold;
+	warm_total += warm;
+
+	if ((cold_functions != warm_functions) ||
+	    (cold_statements != warm_statements)) {
+	    mismatch = true;
+	}
+
+	printf("%-60s  cold %9.3f ms  warm %9.3f ms  functions %6u  "
+	       "statements %7u%s\n",
+	       lo.path.c_str(), cold * 1e3, warm * 1e3,
+	       cold_functions, cold_statements,
+	       ((cold_functions != warm_functions) ||
+		(cold_statements != warm_statements)) ? "  MISMATCH" : "");
+    }
+
+    printf("total %u objects  cold %.3f s  warm %.3f s  speedup %.1fx\n",
+	   static_cast<unsigned>(objects.size()), cold_total, warm_total,
+	   (warm_total > 0.0) ? (cold_total / warm_total) : 0.0);
+    printf("cache entries left in %s\n", dir);
+
+    return mismatch ? 1 : 0;
+}
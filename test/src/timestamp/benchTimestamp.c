@@ -0,0 +1,227 @@
+/*******************************************************************************
+** Copyright (c) 2019 The Krell Institute. All Rights Reserved.
+**
+** This library is free software; you can redistribute it and/or modify it under
+** the terms of the GNU Lesser General Public License as published by the Free
+** Software Foundation; either version 2.1 of the License, or (at your option)
+** any later version.
+**
+** This library is distributed in the hope that it will be useful, but WITHOUT
+** ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+** FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+** details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this library; if not, write to the Free Software Foundation, Inc.,
+** 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*******************************************************************************/
+
+/** @file
+ *
+ * Benchmark for the timestamp service. Reports the time taken by the pair of
+ * timestamps read by a function wrapper, first with CBTF_GetTime() as before
+ * and then with CBTF_GetTicks(), both without and with the conversion done
+ * later when the event is encoded.
+ *
+ * Also checks that converted ticks stay within a tolerance of CBTF_GetTime(),
+ * across several calibration intervals, when converted by another thread than
+ * the one that read them, and in a forked process, and that ticks converted
+ * against the same calibration never go backwards. Converted timestamps from
+ * different processes (or ranks) are then as alignable as CLOCK_REALTIME.
+ *
+ * Usage: benchTimestamp [calls] [seconds]
+ *
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "KrellInstitute/Services/Time.h"
+
+/** Maximum difference allowed between a converted tick and the time (in ns). */
+#define Tolerance 100000
+
+/** Number of threads converting ticks read by the main thread. */
+#define NumThreads 4
+
+static uint64_t now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+typedef enum { GetTime, GetTicks, GetTicksAndConvert } mode_t_;
+
+static const char* ModeNames[] = {
+    "CBTF_GetTime", "CBTF_GetTicks", "CBTF_GetTicks + CBTF_TicksToTime"
+};
+
+static volatile uint64_t sink;
+
+/** Time the timestamps of a number of simulated wrapper calls. */
+static void run(mode_t_ mode, uint64_t calls)
+{
+    CBTF_TickCalibration calibration;
+    uint64_t i, t, start, stop;
+
+    t = now();
+    CBTF_GetTickCalibration(&calibration);
+    for(i = 0; i < calls; ++i) {
+	switch(mode) {
+	case GetTime:
+	    start = CBTF_GetTime();
+	    stop = CBTF_GetTime();
+	    break;
+	case GetTicks:
+	    start = CBTF_GetTicks();
+	    stop = CBTF_GetTicks();
+	    break;
+	case GetTicksAndConvert:
+	    start = CBTF_TicksToTime(&calibration, CBTF_GetTicks());
+	    stop = CBTF_TicksToTime(&calibration, CBTF_GetTicks());
+	    break;
+	}
+	sink += stop - start;
+    }
+    t = now() - t;
+
+    printf("%-34s %8.1f ns/call\n", ModeNames[mode], (double)t / calls);
+}
+
+/** Tick read by the main thread and converted by the other threads. */
+static uint64_t shared_ticks, shared_time;
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool done;
+
+static uint64_t difference(uint64_t a, uint64_t b)
+{
+    return (a > b) ? (a - b) : (b - a);
+}
+
+/** Convert the ticks shared by the main thread, returning the worst error. */
+static void* convert(void* arg)
+{
+    uint64_t* worst = arg;
+
+    while(!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+	uint64_t ticks, time;
+
+	pthread_mutex_lock(&shared_lock);
+	ticks = shared_ticks;
+	time = shared_time;
+	pthread_mutex_unlock(&shared_lock);
+
+	if(ticks != 0) {
+	    CBTF_TickCalibration calibration;
+	    uint64_t error;
+
+	    CBTF_GetTickCalibration(&calibration);
+	    error = difference(CBTF_TicksToTime(&calibration, ticks), time);
+	    if(error > *worst)
+		*worst = error;
+	}
+	usleep(100);
+    }
+
+    return NULL;
+}
+
+/**
+ * Check converted ticks against the time for a number of seconds, returning
+ * the worst error of this thread and of the converting threads, or an error
+ * above the tolerance if converted ticks ever went backwards.
+ */
+static uint64_t check(unsigned seconds)
+{
+    pthread_t threads[NumThreads];
+    uint64_t worst[NumThreads + 1] = { 0 };
+    uint64_t end = now() + seconds * 1000000000ULL, error;
+    uint64_t first = CBTF_GetTicks(), previous = first;
+    bool backwards = false;
+    unsigned i;
+
+    done = false;
+    shared_ticks = 0;
+    for(i = 0; i < NumThreads; ++i)
+	pthread_create(&threads[i], NULL, convert, &worst[i + 1]);
+
+    while(now() < end) {
+	uint64_t before = CBTF_GetTime();
+	uint64_t ticks = CBTF_GetTicks();
+	uint64_t after = CBTF_GetTime();
+
+	/* Only keep samples that were not preempted */
+	if((after - before) < (Tolerance / 10)) {
+	    uint64_t time = before + (after - before) / 2;
+	    CBTF_TickCalibration calibration;
+
+	    pthread_mutex_lock(&shared_lock);
+	    shared_ticks = ticks;
+	    shared_time = time;
+	    pthread_mutex_unlock(&shared_lock);
+
+	    CBTF_GetTickCalibration(&calibration);
+	    error = difference(CBTF_TicksToTime(&calibration, ticks), time);
+	    if(error > worst[0])
+		worst[0] = error;
+
+	    /* Spans several calibration intervals, as the events of a blob may */
+	    if((CBTF_TicksToTime(&calibration, first) >
+		CBTF_TicksToTime(&calibration, previous)) ||
+	       (CBTF_TicksToTime(&calibration, previous) >
+		CBTF_TicksToTime(&calibration, ticks)))
+		backwards = true;
+	    previous = ticks;
+	}
+	usleep(1000);
+    }
+
+    __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+    for(i = 0; i < NumThreads; ++i)
+	pthread_join(threads[i], NULL);
+
+    for(i = 1; i <= NumThreads; ++i)
+	if(worst[i] > worst[0])
+	    worst[0] = worst[i];
+    if(backwards) {
+	printf("converted ticks went backwards\n");
+	worst[0] = Tolerance;
+    }
+    return worst[0];
+}
+
+int main(int argc, char* argv[])
+{
+    uint64_t calls = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000;
+    unsigned seconds = (argc > 2) ? strtoul(argv[2], NULL, 10) : 3;
+    uint64_t worst;
+    int status;
+    pid_t child;
+
+    CBTF_InitializeTicks();
+
+    run(GetTime, calls);
+    run(GetTicks, calls);
+    run(GetTicksAndConvert, calls);
+
+    child = fork();
+    if(child == 0)
+	_exit((check(seconds) < Tolerance) ? 0 : 1);
+
+    worst = check(seconds);
+    printf("worst conversion error %8.1f us\n", (double)worst / 1e3);
+
+    if((waitpid(child, &status, 0) != child) ||
+       !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+	printf("forked process conversion error above tolerance\n");
+	return 1;
+    }
+
+    return (worst < Tolerance) ? 0 : 1;
+}